@@ -0,0 +1,470 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#if			defined __linux__
+/*============================================================================*/
+/* For "struct ucred". */
+#define	_GNU_SOURCE
+/*----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <stdio_ext.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "Daemon.h"
+/*============================================================================*/
+/*
+The client passes its standard input, output and error to the daemon together
+with its working directory and its arguments, so a conversion behaves exactly
+as if it ran in the client, "-" included. A request changes the working
+directory and the standard streams of the process serving it, so the requests
+are served by worker processes, not threads. Each worker keeps its own context
+from one request to the next. A client slow to send its input holds up only the
+worker serving it: when all of them are busy the daemon starts a spare one,
+which exits after a while without requests.
+
+Request:	a uint32_t with the length of the rest, carrying the three descriptors,
+			then the working directory and the arguments, each one ending in '\0'.
+Reply:		an int32_t with the result.
+*/
+#define	DAEMON_MAX_REQUEST		65536
+#define	DAEMON_MAX_ARGUMENTS	256
+/* Seconds a client has to send its request once connected. */
+#define	DAEMON_TIMEOUT			5
+#define	DAEMON_MAX_WORKERS		64
+/* Seconds a spare worker waits for a request before exiting. */
+#define	DAEMON_SPARE_IDLE		60
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	pid_t					Pid;
+	int						Busy;
+	int						Spare;
+	} worker_t;
+/*============================================================================*/
+static void SocketAddress( struct sockaddr_un *Address )
+	{
+	const char	*p;
+
+	memset( Address, 0, sizeof *Address );
+	Address->sun_family	= AF_UNIX;
+
+	if(( p = getenv( "PCADSCH_SOCKET" )) != NULL )
+		snprintf( Address->sun_path, sizeof Address->sun_path, "%s", p );
+	else if(( p = getenv( "XDG_RUNTIME_DIR" )) != NULL )
+		snprintf( Address->sun_path, sizeof Address->sun_path, "%s/PCADSch2KiCAD.socket", p );
+	else
+		snprintf( Address->sun_path, sizeof Address->sun_path, "/tmp/PCADSch2KiCAD-%u.socket", (unsigned)getuid() );
+	}
+/*============================================================================*/
+/* Tells whether the process at the other end of "Fd" runs as the same user as this one. */
+static int IsSameUser( int Fd )
+	{
+	struct ucred	Credentials;
+	socklen_t		Length	= sizeof Credentials;
+
+	return getsockopt( Fd, SOL_SOCKET, SO_PEERCRED, &Credentials, &Length ) == 0 && Length == sizeof Credentials && Credentials.uid == getuid();
+	}
+/*============================================================================*/
+/* A daemon run by someone else would get our files, so it is as good as no daemon. */
+static int Connect( void )
+	{
+	struct sockaddr_un	Address;
+	int					Fd;
+
+	SocketAddress( &Address );
+
+	if(( Fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 )) < 0 )
+		return -1;
+
+	if( connect( Fd, (struct sockaddr*)&Address, sizeof Address ) != 0 || !IsSameUser( Fd ))
+		{
+		close( Fd );
+		return -1;
+		}
+
+	return Fd;
+	}
+/*============================================================================*/
+static int ReadAll( int Fd, void *Buffer, size_t Length )
+	{
+	char		*p	= Buffer;
+	ssize_t		n;
+
+	while( Length > 0 )
+		{
+		if(( n = read( Fd, p, Length )) < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return -1;
+		p		+= n;
+		Length	-= n;
+		}
+
+	return 0;
+	}
+/*============================================================================*/
+static int WriteAll( int Fd, const void *Buffer, size_t Length )
+	{
+	const char	*p	= Buffer;
+	ssize_t		n;
+
+	while( Length > 0 )
+		{
+		if(( n = write( Fd, p, Length )) < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return -1;
+		p		+= n;
+		Length	-= n;
+		}
+
+	return 0;
+	}
+/*============================================================================*/
+/* Prepares "Message" to carry the length of the request and, in "Control", three descriptors. */
+static void SetupMessage( struct msghdr *Message, struct iovec *Vector, uint32_t *Length, char *Control, size_t ControlSize )
+	{
+	memset( Message, 0, sizeof *Message );
+	memset( Control, 0, ControlSize );
+
+	Vector->iov_base		= Length;
+	Vector->iov_len			= sizeof *Length;
+	Message->msg_iov		= Vector;
+	Message->msg_iovlen		= 1;
+	Message->msg_control	= Control;
+	Message->msg_controllen	= ControlSize;
+	}
+/*============================================================================*/
+int ForwardToDaemon( int ArgC, char *ArgV[], int *Result )
+	{
+	static const int	Descriptors[3]	= { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+	char				Request[DAEMON_MAX_REQUEST];
+	char				Control[CMSG_SPACE( sizeof Descriptors )];
+	struct msghdr		Message;
+	struct iovec		Vector;
+	struct cmsghdr		*Header;
+	uint32_t			Length;
+	int32_t				Reply;
+	size_t				Size;
+	int					Fd, i;
+
+	if( getcwd( Request, sizeof Request ) == NULL )
+		return -1;
+
+	for( Size = strlen( Request ) + 1, i = 1; i < ArgC; Size += strlen( ArgV[i++] ) + 1 )
+		{
+		if( Size + strlen( ArgV[i] ) + 1 > sizeof Request )
+			return -1;
+		strcpy( &Request[Size], ArgV[i] );
+		}
+
+	if(( Fd = Connect()) < 0 )
+		return -1;
+
+	Length	= Size;
+
+	SetupMessage( &Message, &Vector, &Length, Control, sizeof Control );
+	Header				= CMSG_FIRSTHDR( &Message );
+	Header->cmsg_level	= SOL_SOCKET;
+	Header->cmsg_type	= SCM_RIGHTS;
+	Header->cmsg_len	= CMSG_LEN( sizeof Descriptors );
+	memcpy( CMSG_DATA( Header ), Descriptors, sizeof Descriptors );
+
+	if( sendmsg( Fd, &Message, MSG_NOSIGNAL ) != sizeof Length )
+		{
+		close( Fd );
+		return -1;
+		}
+
+	/* From here on the request belongs to the daemon, it is not run again here. */
+	if( WriteAll( Fd, Request, Size ) != 0 || ReadAll( Fd, &Reply, sizeof Reply ) != 0 )
+		{
+		fprintf( stderr, "\nError: The daemon did not reply.\n\n" );
+		Reply	= -1;
+		}
+
+	close( Fd );
+
+	*Result	= Reply;
+
+	return 0;
+	}
+/*============================================================================*/
+static void ServeRequest( int Fd, const char *Program, runfunc_t Run, pcadsch_t *Context )
+	{
+	char				Request[DAEMON_MAX_REQUEST+1], *ArgV[DAEMON_MAX_ARGUMENTS+1], *p;
+	int					Descriptors[3]	= { -1, -1, -1 }, Saved[3], ArgC, i;
+	char				Control[CMSG_SPACE( sizeof Descriptors )];
+	struct msghdr		Message;
+	struct iovec		Vector;
+	struct cmsghdr		*Header;
+	uint32_t			Length;
+	int32_t				Reply	= -1;
+
+	SetupMessage( &Message, &Vector, &Length, Control, sizeof Control );
+
+	if( recvmsg( Fd, &Message, MSG_CMSG_CLOEXEC ) != sizeof Length )
+		return;
+
+	if(( Header = CMSG_FIRSTHDR( &Message )) != NULL && Header->cmsg_level == SOL_SOCKET && Header->cmsg_type == SCM_RIGHTS && Header->cmsg_len == CMSG_LEN( sizeof Descriptors ))
+		memcpy( Descriptors, CMSG_DATA( Header ), sizeof Descriptors );
+
+	if( Descriptors[0] >= 0 && Length > 0 && Length <= DAEMON_MAX_REQUEST && ReadAll( Fd, Request, Length ) == 0 )
+		{
+		Request[Length]	= '\0';
+
+		/* The working directory comes first, then the arguments. */
+		ArgV[0]	= (char*)Program;
+		for( ArgC = 1, p = Request + strlen( Request ) + 1; p < Request + Length && ArgC < DAEMON_MAX_ARGUMENTS; p += strlen( p ) + 1 )
+			ArgV[ArgC++]	= p;
+		ArgV[ArgC]	= NULL;
+
+		if( chdir( Request ) != 0 )
+			dprintf( Descriptors[2], "\nError: The daemon could not change to \"%s\".\n\n", Request );
+		else
+			{
+			fflush( stdout );
+			fflush( stderr );
+			for( i = 0; i < 3; i++ )
+				{
+				Saved[i]	= dup( i );
+				dup2( Descriptors[i], i );
+				}
+
+			Reply	= Run( ArgC, ArgV, Context );
+
+			fflush( stdout );
+			fflush( stderr );
+			/*
+			Whatever is left in the buffer of "stdin" was the client's, and so is the
+			position glibc remembers for it, which flushing the empty buffer forgets.
+			*/
+			__fpurge( stdin );
+			fflush( stdin );
+			clearerr( stdin );
+			clearerr( stdout );
+			clearerr( stderr );
+			for( i = 0; i < 3; i++ )
+				{
+				dup2( Saved[i], i );
+				close( Saved[i] );
+				}
+			}
+		}
+
+	WriteAll( Fd, &Reply, sizeof Reply );
+
+	for( i = 0; i < 3; i++ )
+		if( Descriptors[i] >= 0 )
+			close( Descriptors[i] );
+	}
+/*============================================================================*/
+/*
+Serves requests until accepting fails or, if it is a spare, until it waits too
+long for one. It tells the daemon through "Report" when it takes a request, with
+its process ID, and when it is done with it, with its process ID negated. The
+listener does not block, all the workers are woken by a new connection.
+*/
+static void RunWorker( int Listener, int Report, int Spare, const char *Program, runfunc_t Run )
+	{
+	struct timeval	Timeout	= { DAEMON_TIMEOUT, 0 };
+	struct pollfd	Poll	= { Listener, POLLIN, 0 };
+	pcadsch_t		*Context;
+	pid_t			Self	= getpid(), Done = -Self;
+	int				Fd, n;
+
+	if(( Context = PCADSchCreate()) == NULL )
+		{
+		fprintf( stderr, "\nError: Not enough memory.\n\n" );
+		return;
+		}
+
+	while(( n = poll( &Poll, 1, Spare ? DAEMON_SPARE_IDLE * 1000 : -1 )) > 0 || ( n < 0 && errno == EINTR ))
+		{
+		if(( Fd = accept4( Listener, NULL, NULL, SOCK_CLOEXEC )) < 0 )
+			{
+			if( errno == EAGAIN || errno == EINTR || errno == ECONNABORTED )
+				continue;
+			break;
+			}
+
+		write( Report, &Self, sizeof Self );
+
+		/* The requests run with our rights on the client's files, only our own user may make them. */
+		if( !IsSameUser( Fd ))
+			fprintf( stderr, "Refused a request from another user.\n" );
+		else if( setsockopt( Fd, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof Timeout ) == 0 )
+			ServeRequest( Fd, Program, Run, Context );
+		close( Fd );
+
+		write( Report, &Done, sizeof Done );
+		}
+
+	PCADSchDestroy( Context );
+	}
+/*============================================================================*/
+static int StartWorker( worker_t *Worker, int Listener, int Report[2], int Spare, const char *Program, runfunc_t Run )
+	{
+	pid_t	Daemon	= getpid(), Pid;
+
+	fflush( stdout );
+	fflush( stderr );
+
+	if(( Pid = fork()) < 0 )
+		return -1;
+
+	if( Pid == 0 )
+		{
+		/* The workers go with the daemon. */
+		prctl( PR_SET_PDEATHSIG, SIGTERM );
+		if( getppid() != Daemon )
+			exit( -1 );
+		close( Report[0] );
+		RunWorker( Listener, Report[1], Spare, Program, Run );
+		exit( -1 );
+		}
+
+	Worker->Pid		= Pid;
+	Worker->Busy	= 0;
+	Worker->Spare	= Spare;
+
+	return 0;
+	}
+/*============================================================================*/
+static worker_t *FindWorker( worker_t *Workers, pid_t Pid )
+	{
+	int	i;
+
+	for( i = 0; i < DAEMON_MAX_WORKERS && Workers[i].Pid != Pid; i++ )
+		{}
+
+	return i < DAEMON_MAX_WORKERS ? &Workers[i] : NULL;
+	}
+/*============================================================================*/
+int RunDaemon( const char *Program, runfunc_t Run )
+	{
+	struct sockaddr_un	Address;
+	worker_t			Workers[DAEMON_MAX_WORKERS], *Worker;
+	struct pollfd		Poll;
+	mode_t				Mask;
+	pid_t				Pid;
+	long				NumBase;
+	int					Listener, Report[2], Fd, Result, Status, Running = 0, Busy = 0;
+
+	if(( Fd = Connect()) >= 0 )
+		{
+		close( Fd );
+		fprintf( stderr, "\nError: The daemon is already running.\n\n" );
+		return -1;
+		}
+
+	SocketAddress( &Address );
+
+	/* A socket left by a daemon that did not exit cleanly. */
+	unlink( Address.sun_path );
+
+	if(( Listener = socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 )) < 0 )
+		{
+		fprintf( stderr, "\nError: Could not create the socket.\n\n" );
+		return -1;
+		}
+
+	/* The socket is created accessible only to its owner, there is no window for others to connect. */
+	Mask	= umask( 0177 );
+	Result	= bind( Listener, (struct sockaddr*)&Address, sizeof Address );
+	umask( Mask );
+
+	if( Result != 0 || listen( Listener, 16 ) != 0 || pipe2( Report, O_CLOEXEC ) != 0 )
+		{
+		fprintf( stderr, "\nError: Could not listen on \"%s\".\n\n", Address.sun_path );
+		close( Listener );
+		return -1;
+		}
+
+	/* A client going away must not take the daemon with it. */
+	signal( SIGPIPE, SIG_IGN );
+
+	if(( NumBase = sysconf( _SC_NPROCESSORS_ONLN )) < 2 )
+		NumBase	= 2;
+	if( NumBase > DAEMON_MAX_WORKERS / 2 )
+		NumBase	= DAEMON_MAX_WORKERS / 2;
+
+	memset( Workers, 0, sizeof Workers );
+
+	for( ; Running < NumBase && StartWorker( &Workers[Running], Listener, Report, 0, Program, Run ) == 0; Running++ )
+		{}
+
+	fprintf( stderr, "Listening on \"%s\" with %d workers.\n", Address.sun_path, Running );
+
+	Poll.fd		= Report[0];
+	Poll.events	= POLLIN;
+
+	/* The exits are looked for once a second, a worker killed by a signal is replaced unless it was a spare. */
+	while( Running > 0 )
+		{
+		if( poll( &Poll, 1, 1000 ) > 0 && read( Report[0], &Pid, sizeof Pid ) == sizeof Pid && ( Worker = FindWorker( Workers, Pid < 0 ? -Pid : Pid )) != NULL && Worker->Busy != ( Pid > 0 ))
+			{
+			Worker->Busy	= Pid > 0;
+			Busy		   += Pid > 0 ? 1 : -1;
+			}
+
+		while(( Pid = waitpid( -1, &Status, WNOHANG )) > 0 )
+			{
+			if(( Worker = FindWorker( Workers, Pid )) == NULL )
+				continue;
+			Busy	-= Worker->Busy;
+			Running--;
+			if( WIFSIGNALED( Status ) && !Worker->Spare && StartWorker( Worker, Listener, Report, 0, Program, Run ) == 0 )
+				Running++;
+			else
+				Worker->Pid	= 0;
+			}
+
+		if( Busy >= Running && Running > 0 && ( Worker = FindWorker( Workers, 0 )) != NULL && StartWorker( Worker, Listener, Report, 1, Program, Run ) == 0 )
+			Running++;
+		}
+
+	close( Report[0] );
+	close( Report[1] );
+	close( Listener );
+	unlink( Address.sun_path );
+
+	return -1;
+	}
+/*============================================================================*/
+#endif	/*	defined __linux__ */
+/*============================================================================*/
@@ -0,0 +1,43 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#if			!defined __DAEMON_H__
+#define __DAEMON_H__
+/*============================================================================*/
+#include "PCADSch.h"
+/*============================================================================*/
+#if			defined __linux__
+/*============================================================================*/
+/* Runs the command line in "ArgV", with "Context" shared by the requests served by the same worker. */
+typedef int (*runfunc_t)( int ArgC, char *ArgV[], pcadsch_t *Context );
+/*============================================================================*/
+int	RunDaemon		( const char *Program, runfunc_t Run );
+/* Returns non-zero if there is no daemon running, "*Result" is what it returned otherwise. */
+int	ForwardToDaemon	( int ArgC, char *ArgV[], int *Result );
+/*============================================================================*/
+#endif	/*	defined __linux__ */
+/*============================================================================*/
+#endif	/*	!defined __DAEMON_H__ */
+/*============================================================================*/
@@ -0,0 +1,283 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#if			defined __linux__
+#include <pthread.h>
+#endif	/*	defined __linux__ */
+#include "Diagnostics.h"
+#include "OutputFile.h"
+/*============================================================================*/
+typedef struct
+	{
+	pcadsch_diagnostic_t	Diagnostic;
+	/* Its template, in "Kinds". */
+	unsigned				Kind;
+	} diagnostic_t;
+/*----------------------------------------------------------------------------*/
+/* The messages made from the same template, "Last" is the last one kept. */
+typedef struct
+	{
+	pcadsch_severity_t		Severity;
+	const char				*Template;
+	unsigned				Examples;
+	unsigned long			More;
+	size_t					Last;
+	} diagnostickind_t;
+/*----------------------------------------------------------------------------*/
+struct diagnostics_tag
+	{
+#if			defined __linux__
+	/* The sheet workers report into the same list, a message is matched to its template and counted while holding it. */
+	pthread_mutex_t			Mutex;
+#endif	/*	defined __linux__ */
+	size_t					NumMessages;
+	size_t					Allocated;
+	diagnostic_t			*Messages;
+	unsigned				NumKinds;
+	unsigned				AllocatedKinds;
+	diagnostickind_t		*Kinds;
+	};
+/*============================================================================*/
+static const char	*SeverityNames[][2]	=
+	{
+	[PCADSCH_SEVERITY_WARNING]	= { "Warning",	"warning" },
+	[PCADSCH_SEVERITY_ERROR]	= { "Error",	"error" }
+	};
+/*============================================================================*/
+static void Lock( diagnostics_t *Diagnostics )
+	{
+#if			defined __linux__
+	pthread_mutex_lock( &Diagnostics->Mutex );
+#endif	/*	defined __linux__ */
+	}
+/*============================================================================*/
+static void Unlock( diagnostics_t *Diagnostics )
+	{
+#if			defined __linux__
+	pthread_mutex_unlock( &Diagnostics->Mutex );
+#endif	/*	defined __linux__ */
+	}
+/*============================================================================*/
+diagnostics_t *CreateDiagnostics( void )
+	{
+	diagnostics_t	*Diagnostics;
+
+	if(( Diagnostics = calloc( 1, sizeof( diagnostics_t ))) == NULL )
+		return NULL;
+
+#if			defined __linux__
+	pthread_mutex_init( &Diagnostics->Mutex, NULL );
+#endif	/*	defined __linux__ */
+
+	return Diagnostics;
+	}
+/*============================================================================*/
+void ReleaseDiagnostics( diagnostics_t *Diagnostics )
+	{
+	if( Diagnostics == NULL )
+		return;
+
+#if			defined __linux__
+	pthread_mutex_destroy( &Diagnostics->Mutex );
+#endif	/*	defined __linux__ */
+	free( Diagnostics->Messages );
+	free( Diagnostics->Kinds );
+	free( Diagnostics );
+	}
+/*============================================================================*/
+void ResetDiagnostics( diagnostics_t *Diagnostics )
+	{
+	Lock( Diagnostics );
+	Diagnostics->NumMessages	= 0;
+	Diagnostics->NumKinds		= 0;
+	Unlock( Diagnostics );
+	}
+/*============================================================================*/
+static void WriteDiagnostic( FILE *File, const pcadsch_diagnostic_t *Diagnostic, int Json )
+	{
+	if( Json )
+		{
+		fprintf( File, "{\"severity\":\"%s\",", SeverityNames[Diagnostic->Severity][1] );
+		if( Diagnostic->LineNumber > 0 )
+			fprintf( File, "\"line\":%u,\"column\":%u,", Diagnostic->LineNumber, Diagnostic->Column );
+		fprintf( File, "\"message\":" );
+		WriteJSONString( File, Diagnostic->Message );
+		fprintf( File, ",\"count\":%lu,\"more\":%lu}\n", Diagnostic->Count, Diagnostic->More );
+		return;
+		}
+
+	if( Diagnostic->LineNumber > 0 )
+		fprintf( File, "%s in line %u column %u: %s", SeverityNames[Diagnostic->Severity][0], Diagnostic->LineNumber, Diagnostic->Column, Diagnostic->Message );
+	else
+		fprintf( File, "%s: %s", SeverityNames[Diagnostic->Severity][0], Diagnostic->Message );
+	if( Diagnostic->Count > 1 )
+		fprintf( File, " (%lu times)", Diagnostic->Count );
+	fprintf( File, "\n" );
+
+	if( Diagnostic->More > 0 )
+		fprintf( File, "%s: %lu more like the above\n", SeverityNames[Diagnostic->Severity][0], Diagnostic->More );
+	}
+/*============================================================================*/
+/* What cannot be kept for lack of memory is written right away. */
+void Diagnose( const cookie_t *Cookie, pcadsch_severity_t Severity, unsigned LineNumber, unsigned Column, unsigned long Count, const char *Template, const char *Message )
+	{
+	diagnostics_t			*Diagnostics	= Cookie->Diagnostics;
+	pcadsch_diagnostic_t	Diagnostic		= { Severity, LineNumber, Column, Count, 0 };
+	diagnostickind_t		*Kind;
+	diagnostic_t			*Messages;
+	size_t					Length, i;
+	unsigned				k;
+
+	/* Some messages end with a new line of their own. */
+	snprintf( Diagnostic.Message, sizeof Diagnostic.Message, "%s", Message );
+	for( Length = strlen( Diagnostic.Message ); Length > 0 && isspace( (unsigned char)Diagnostic.Message[Length-1] ); )
+		Diagnostic.Message[--Length]	= '\0';
+
+	if( Diagnostics == NULL )
+		{
+		WriteDiagnostic( stderr, &Diagnostic, 0 );
+		return;
+		}
+
+	Lock( Diagnostics );
+
+	for( k = 0; k < Diagnostics->NumKinds; k++ )
+		if( Diagnostics->Kinds[k].Severity == Severity && strcmp( Diagnostics->Kinds[k].Template, Template ) == 0 )
+			break;
+
+	if( k >= Diagnostics->NumKinds )
+		{
+		if( Diagnostics->NumKinds >= Diagnostics->AllocatedKinds )
+			{
+			unsigned	Allocated	= Diagnostics->AllocatedKinds > 0 ? 2 * Diagnostics->AllocatedKinds : 16;
+
+			if(( Kind = realloc( Diagnostics->Kinds, Allocated * sizeof( diagnostickind_t ))) == NULL )
+				{
+				Unlock( Diagnostics );
+				WriteDiagnostic( stderr, &Diagnostic, 0 );
+				return;
+				}
+			Diagnostics->Kinds			= Kind;
+			Diagnostics->AllocatedKinds	= Allocated;
+			}
+
+		Kind			= &Diagnostics->Kinds[Diagnostics->NumKinds++];
+		Kind->Severity	= Severity;
+		Kind->Template	= Template;
+		Kind->Examples	= 0;
+		Kind->More		= 0;
+		}
+
+	Kind	= &Diagnostics->Kinds[k];
+
+	/* The same message again is only counted, at the position of the first one. */
+	for( i = 0; i < Diagnostics->NumMessages; i++ )
+		if( Diagnostics->Messages[i].Kind == k && strcmp( Diagnostics->Messages[i].Diagnostic.Message, Diagnostic.Message ) == 0 )
+			{
+			Diagnostics->Messages[i].Diagnostic.Count	+= Count;
+			Unlock( Diagnostics );
+			return;
+			}
+
+	if( Kind->Examples >= MAX_DIAGNOSTIC_EXAMPLES )
+		{
+		Kind->More	+= Count;
+		Unlock( Diagnostics );
+		return;
+		}
+
+	if( Diagnostics->NumMessages >= Diagnostics->Allocated )
+		{
+		size_t	Allocated	= Diagnostics->Allocated > 0 ? 2 * Diagnostics->Allocated : 64;
+
+		if(( Messages = realloc( Diagnostics->Messages, Allocated * sizeof( diagnostic_t ))) == NULL )
+			{
+			Unlock( Diagnostics );
+			WriteDiagnostic( stderr, &Diagnostic, 0 );
+			return;
+			}
+		Diagnostics->Messages	= Messages;
+		Diagnostics->Allocated	= Allocated;
+		}
+
+	Kind->Examples++;
+	Kind->Last		= Diagnostics->NumMessages;
+	Diagnostics->Messages[Diagnostics->NumMessages].Diagnostic	= Diagnostic;
+	Diagnostics->Messages[Diagnostics->NumMessages].Kind		= k;
+	Diagnostics->NumMessages++;
+
+	Unlock( Diagnostics );
+	}
+/*============================================================================*/
+/* The count of the messages not kept goes with the last one kept from the same template. */
+static void GetDiagnostic( const diagnostics_t *Diagnostics, size_t i, pcadsch_diagnostic_t *Diagnostic )
+	{
+	const diagnostickind_t	*Kind	= &Diagnostics->Kinds[Diagnostics->Messages[i].Kind];
+
+	*Diagnostic			= Diagnostics->Messages[i].Diagnostic;
+	Diagnostic->More	= Kind->Last == i ? Kind->More : 0;
+	}
+/*============================================================================*/
+int ListDiagnostics( diagnostics_t *Diagnostics, pcadsch_diagnostic_t *List, int Max )
+	{
+	size_t	i;
+	int		Result;
+
+	Lock( Diagnostics );
+
+	for( i = 0; i < Diagnostics->NumMessages && (int)i < Max; i++ )
+		GetDiagnostic( Diagnostics, i, &List[i] );
+	Result	= Diagnostics->NumMessages;
+
+	Unlock( Diagnostics );
+
+	return Result;
+	}
+/*============================================================================*/
+int FlushDiagnostics( diagnostics_t *Diagnostics, FILE *File, int Json )
+	{
+	pcadsch_diagnostic_t	Diagnostic;
+	size_t					i;
+
+	Lock( Diagnostics );
+
+	for( i = 0; i < Diagnostics->NumMessages; i++ )
+		{
+		GetDiagnostic( Diagnostics, i, &Diagnostic );
+		WriteDiagnostic( File, &Diagnostic, Json );
+		}
+
+	Diagnostics->NumMessages	= 0;
+	Diagnostics->NumKinds		= 0;
+
+	Unlock( Diagnostics );
+
+	return ferror( File ) ? -1 : 0;
+	}
+/*============================================================================*/
@@ -0,0 +1,58 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#if			!defined __DIAGNOSTICS_H__
+#define __DIAGNOSTICS_H__
+/*============================================================================*/
+#include <stdio.h>
+#include "PCADParser.h"
+/*============================================================================*/
+/*
+The warnings and errors found during a call, kept until it returns and then
+written at once. Those made from the same template are counted together: the
+same message found again is only counted, and after MAX_DIAGNOSTIC_EXAMPLES
+different ones the rest are only counted too. The sheet workers share the
+diagnostics of the context. While "Cookie->Diagnostics" is NULL the messages are
+written to the standard error as they come.
+*/
+typedef struct diagnostics_tag	diagnostics_t;
+/*----------------------------------------------------------------------------*/
+#define	MAX_DIAGNOSTIC_EXAMPLES		32
+/*============================================================================*/
+diagnostics_t	*CreateDiagnostics	( void );
+void			ReleaseDiagnostics	( diagnostics_t *Diagnostics );
+/* Forgets the messages kept so far. */
+void			ResetDiagnostics	( diagnostics_t *Diagnostics );
+
+/* Adds "Count" times the "Message" made from "Template", "LineNumber" is zero if it is not related to the input. */
+void			Diagnose			( const cookie_t *Cookie, pcadsch_severity_t Severity, unsigned LineNumber, unsigned Column, unsigned long Count, const char *Template, const char *Message );
+
+/* Copies up to "Max" messages, in the order they were found, and returns how many there are. */
+int				ListDiagnostics		( diagnostics_t *Diagnostics, pcadsch_diagnostic_t *List, int Max );
+/* Writes the messages kept, as text or as one JSON object per line, and forgets them. */
+int				FlushDiagnostics	( diagnostics_t *Diagnostics, FILE *File, int Json );
+/*============================================================================*/
+#endif	/*	!defined __DIAGNOSTICS_H__ */
+/*============================================================================*/
@@ -32,12 +32,14 @@
 #include "KiCADOutputSchematic.h"
 #include "PCADStructs.h"
 #include "Parser.h"
+#include "OutputFile.h"
+#include "Trace.h"
 /*=============================================================================*/
 typedef struct
 	{
 	char				*SheetName;
 	cookie_t			*Cookie;
-	FILE				*File;
+	const pcadsch_writer_t	*Writer;
 	pcad_dimmension_t	DefaultLineWidth;
 	pcad_dimmension_t	PolygonBorderWidth;
 	int					PolygonExtraVertex;
@@ -116,34 +118,106 @@ static const char *FormatLabel( const char *Label, char *Buffer, size_t BufferSi
 	return Buffer;
 	}
 /*=============================================================================*/
+/* Room for the longest number, "-2147.483648", and its terminator. */
+typedef char	coordinate_t[16];
+/* How many coordinates are moved and formatted at a time. */
+#define	COORDINATE_BATCH	128
+/* The same limit as "VOutputFormatted". */
+#define	MAX_INDENT			19
+/*=============================================================================*/
+/* Formats millionths with at least "FracDigs" (and at least one) fractional digits, the trailing zeros are dropped. */
+static int FormatMillionths( pcad_real_t v, unsigned FracDigs, char *Buffer )
+	{
+	char		Digits[10], *p = Digits + sizeof Digits;
+	uint32_t	Magnitude, Int, Frac;
+	int			Length = 0, Dig, i;
+
+	if( v < 0 )
+		Buffer[Length++]	= '-';
+	Magnitude	= v < 0 ? -(uint32_t)v : (uint32_t)v;
+
+	Int		= Magnitude / 1000000u;
+	Frac	= Magnitude % 1000000u;
+
+	for( Dig = 6; Dig > 1 && Dig > FracDigs && Frac % 10 == 0; Dig-- )
+		Frac /= 10;
+
+	do
+		{
+		*--p	= '0' + Int % 10;
+		Int	   /= 10;
+		}
+	while( Int != 0 );
+
+	memcpy( &Buffer[Length], p, Digits + sizeof Digits - p );
+	Length += Digits + sizeof Digits - p;
+
+	Buffer[Length++]	= '.';
+	for( i = Dig; i > 0; i-- )
+		{
+		Buffer[Length+i-1]	= '0' + Frac % 10;
+		Frac			   /= 10;
+		}
+	Length += Dig;
+
+	Buffer[Length]	= '\0';
+
+	return Length;
+	}
+/*=============================================================================*/
 static int FormatReal( const parameters_t *Params, unsigned FracDigs, pcad_dimmension_t Origin, pcad_real_t Scale, pcad_real_t v, char *Buffer, size_t BufferSize )
 	{
-	int			Sign;
-	uint32_t	Int;
-	uint32_t	Frac;
-	int			Res, Dig;
+	if( BufferSize < sizeof( coordinate_t ))
+		ErrorOutput( Params->Cookie, -1, "Invalid number" );
 
 	if( Scale < 0 )
 		v	= Origin - v;
 	else
 		v	= v - Origin;
 
-	Sign	= v < 0;
+	return FormatMillionths( v, FracDigs, Buffer );
+	}
+/*=============================================================================*/
+/* The same as "FormatReal" for up to COORDINATE_BATCH values at once. */
+static void FormatCoordinates( pcad_dimmension_t Origin, pcad_real_t Scale, const pcad_dimmension_t *Values, size_t Count, coordinate_t *Text )
+	{
+	pcad_real_t	Moved[COORDINATE_BATCH];
+	pcad_real_t	Sign	= Scale < 0 ? -1 : 1;
+	pcad_real_t	Offset	= Scale < 0 ? Origin : -Origin;
+	size_t		i;
+
+	/* Without branches, so the compiler is free to vectorize it. */
+	for( i = 0; i < Count; i++ )
+		Moved[i]	= Sign * Values[i] + Offset;
 
-	Int		= abs( v ) / 1000000ul;
-	Frac	= abs( v ) % 1000000ul;
+	for( i = 0; i < Count; i++ )
+		FormatMillionths( Moved[i], 0, Text[i] );
+	}
+/*=============================================================================*/
+static char *Splice( char *p, const char *s )
+	{
+	while(( *p = *s++ ) != '\0' )
+		p++;
 
-	for( Dig = 6; Dig > 1 && Dig > FracDigs && Frac % 10 == 0 /*&& Frac >= 100*/; Dig-- )
-		Frac /= 10;
+	return p;
+	}
+/*=============================================================================*/
+static char *Indent( char *p, unsigned Level )
+	{
+	if( Level > MAX_INDENT )
+		Level	= MAX_INDENT;
 
-	Res	= snprintf( Buffer, BufferSize, "%s%u.%0*u", Sign ? "-" : "", Int, Dig, Frac );
-	if( Res <= 0 || Res >= BufferSize )
-		{
-		fclose( Params->Cookie->File );
-		ErrorOutput( Params->Cookie, -1, "Invalid number" );
-		}
+	memset( p, '\t', Level );
+
+	return p + Level;
+	}
+/*=============================================================================*/
+static void OutputBytes( const parameters_t *Params, const char *Data, size_t Length )
+	{
+	if( Length > 0 && Params->Writer->Write( Params->Writer->UserData, Data, Length ) != 0 )
+		ErrorOutput( Params->Cookie, -1, "Error writing the output" );
 
-	return Res;
+	Params->Cookie->Stats.BytesWritten	+= Length;
 	}
 /*=============================================================================*/
 static int OutputToFile( const parameters_t *Params, unsigned Level, const char *s, ... )
@@ -153,8 +227,7 @@ static int OutputToFile( const parameters_t *Params, unsigned Level, const char
 
 	va_start( ap, s );
 
-	fprintf( Params->File, "%.*s", Level, "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t" );
-	CharsWritten	= vfprintf( Params->File, s, ap );
+	CharsWritten	= VOutputFormatted( Params->Cookie, Params->Writer, Level, s, ap );
 
 	va_end( ap );
 
@@ -168,102 +241,186 @@ static const char *JustifyKiCAD[]	=
 	" (justify left top)",		" (justify top)",		" (justify right top)"
 	};
 /*=============================================================================*/
-static pcad_busentry_t *FindBusEntry( const pcad_sheet_t *Sheet, const pcad_point_t *p, const pcad_point_t *p2 )
+/*
+Where the bus entries of a sheet end up: the wires that meet them move them to
+where KiCAD expects them, and give them their end style. Kept apart from the
+sheet, that the emitters only read.
+*/
+typedef struct
 	{
-	int	i;
+	size_t					Count;
+	pcad_dimmension_t		*x;
+	pcad_dimmension_t		*y;
+	pcad_enum_endstyle_t	*Style;
+	} busentries_t;
+/*=============================================================================*/
+/* Returns the index of the bus entry at "p" facing "p2", or -1 if there is none. */
+static ssize_t FindBusEntry( const pcad_sheetgeometry_t *Geometry, const busentries_t *BusEntries, const pcad_point_t *p, const pcad_point_t *p2 )
+	{
+	size_t	i;
 
-	for( i = 0; i < Sheet->numbusentries; i++ )
+	COUNT( Finds[PCADSCH_FIND_BUSENTRY].Calls, 1 );
+	for( i = 0; i < BusEntries->Count; i++ )
 		{
-		const pcad_busentry_t	*be	= Sheet->viobusentries[i];
-
-		if( p->x == be->point.x && p->y == be->point.y && (
-				( be->orient == PCAD_ORIENT_RIGHT && p2->x > p->x ) ||
-				( be->orient == PCAD_ORIENT_LEFT && p2->x < p->x ) ||
-				( be->orient == PCAD_ORIENT_UP && p2->y > p->y ) ||
-				( be->orient == PCAD_ORIENT_DOWN && p2->y < p->y )))
-			return Sheet->viobusentries[i];
+		COUNT( Finds[PCADSCH_FIND_BUSENTRY].Probes, 1 );
+		if( p->x == BusEntries->x[i] && p->y == BusEntries->y[i] && (
+				( Geometry->busentryorient[i] == PCAD_ORIENT_RIGHT && p2->x > p->x ) ||
+				( Geometry->busentryorient[i] == PCAD_ORIENT_LEFT && p2->x < p->x ) ||
+				( Geometry->busentryorient[i] == PCAD_ORIENT_UP && p2->y > p->y ) ||
+				( Geometry->busentryorient[i] == PCAD_ORIENT_DOWN && p2->y < p->y )))
+			return i;
 		}
 
-	return NULL;
+	return -1;
 	}
 /*=============================================================================*/
-static int OutputWire( const parameters_t *Params, unsigned Level, const pcad_sheet_t *Sheet, const pcad_wire_t *Wire )
+/* The bus entry is moved to the adjusted endpoint, and takes the style of the wire end, it is output after the wires. */
+static void MoveBusEntry( busentries_t *BusEntries, ssize_t Index, const pcad_point_t *Point, pcad_enum_endstyle_t Style )
 	{
-	char			x1[32], y1[32], x2[32], y2[32];
-	pcad_busentry_t	*be1, *be2;
-	pcad_point_t	pt1, pt2;
-
-	pt1	= Wire->pt1;
-	pt2	= Wire->pt2;
+	BusEntries->x[Index]		= Point->x;
+	BusEntries->y[Index]		= Point->y;
+	BusEntries->Style[Index]	= Style;
+	}
+/*=============================================================================*/
+/* Moves the ends "pt1" and "pt2" of the wire that meet bus entries, and the bus entries with them, to where KiCAD expects them. */
+static int AdjustWire( const cookie_t *Cookie, const pcad_sheetgeometry_t *Geometry, busentries_t *BusEntries, size_t Index, pcad_point_t *pt1, pcad_point_t *pt2 )
+	{
+	ssize_t		be1, be2;
 
-	if( Wire->endstyle1 != PCAD_ENDSTYLE_NONE && ( be1 = FindBusEntry( Sheet, &pt1, &pt2 )) && be1 != NULL )
+	if( Geometry->wireendstyle1[Index] != PCAD_ENDSTYLE_NONE && ( be1 = FindBusEntry( Geometry, BusEntries, pt1, pt2 )) >= 0 )
 		{
-		if( pt2.x == pt1.x )
+		if( pt2->x == pt1->x )
 			{
-			if( pt2.y > pt1.y + 2540000 )
-				pt1.y += 2540000;
-			else if( pt2.y < pt1.y - 2540000 )
-				pt1.y -= 2540000;
+			if( pt2->y > pt1->y + 2540000 )
+				pt1->y += 2540000;
+			else if( pt2->y < pt1->y - 2540000 )
+				pt1->y -= 2540000;
 			}
-		else if( pt2.y == pt1.y )
+		else if( pt2->y == pt1->y )
 			{
-			if( pt2.x > pt1.x + 2540000 )
-				pt1.x += 2540000;
-			else if( pt2.x < pt1.x - 2540000 )
-				pt1.x -= 2540000;
+			if( pt2->x > pt1->x + 2540000 )
+				pt1->x += 2540000;
+			else if( pt2->x < pt1->x - 2540000 )
+				pt1->x -= 2540000;
 			else
-				WarningOutput( "Wire too short, won't adjust endpoint at (%.3f,%.3f) ", pt1.x / 1.0e6, pt1.y / 1.0e6 );
+				WarningOutput( Cookie, "Wire too short, won't adjust endpoint at (%.3f,%.3f) ", pt1->x / 1.0e6, pt1->y / 1.0e6 );
 			}
 		else
-			WarningOutput( "Wire meets bus non-perpendicularly, won't adjust endpoint at (%.3f,%.3f) ", pt1.x / 1.0e6, pt1.y / 1.0e6 );
-		be1->point	= pt1;
-		/* We must copy the style from the wire endpoint to the busentry, because it will be output later and we will need that information. */
-		be1->style	= Wire->endstyle1;
+			WarningOutput( Cookie, "Wire meets bus non-perpendicularly, won't adjust endpoint at (%.3f,%.3f) ", pt1->x / 1.0e6, pt1->y / 1.0e6 );
+		MoveBusEntry( BusEntries, be1, pt1, Geometry->wireendstyle1[Index] );
 		}
 
-	if( Wire->endstyle2 != PCAD_ENDSTYLE_NONE && ( be2 = FindBusEntry( Sheet, &pt2, &pt1 )) && be2 != NULL )
+	if( Geometry->wireendstyle2[Index] != PCAD_ENDSTYLE_NONE && ( be2 = FindBusEntry( Geometry, BusEntries, pt2, pt1 )) >= 0 )
 		{
-		if( pt1.x == pt2.x )
+		if( pt1->x == pt2->x )
 			{
-			if( pt1.y > pt2.y + 2540000 )
-				pt2.y += 2540000;
-			else if( pt1.y < pt2.y - 2540000 )
-				pt2.y -= 2540000;
+			if( pt1->y > pt2->y + 2540000 )
+				pt2->y += 2540000;
+			else if( pt1->y < pt2->y - 2540000 )
+				pt2->y -= 2540000;
 			}
-		else if( pt1.y == pt2.y )
+		else if( pt1->y == pt2->y )
 			{
-			if( pt1.x > pt2.x + 2540000 )
-				pt2.x += 2540000;
-			else if( pt1.x < pt2.x - 2540000 )
-				pt2.x -= 2540000;
+			if( pt1->x > pt2->x + 2540000 )
+				pt2->x += 2540000;
+			else if( pt1->x < pt2->x - 2540000 )
+				pt2->x -= 2540000;
 			else
-				WarningOutput( "Wire too short, won't adjust endpoint at (%.3f,%.3f) ", pt2.x / 1.0e6, pt2.y / 1.0e6 );
+				WarningOutput( Cookie, "Wire too short, won't adjust endpoint at (%.3f,%.3f) ", pt2->x / 1.0e6, pt2->y / 1.0e6 );
 			}
 		else
-			WarningOutput( "Wire meets bus non-perpendicularly, won't adjust endpoint at (%.3f,%.3f) ", pt2.x / 1.0e6, pt2.y / 1.0e6 );
-		be2->point	= pt2;
-		/* We must copy the style from the wire endpoint to the busentry, because it will be output later and we will need that information. */
-		be2->style	= Wire->endstyle2;
+			WarningOutput( Cookie, "Wire meets bus non-perpendicularly, won't adjust endpoint at (%.3f,%.3f) ", pt2->x / 1.0e6, pt2->y / 1.0e6 );
+		MoveBusEntry( BusEntries, be2, pt2, Geometry->wireendstyle2[Index] );
 		}
 
-	FormatReal( Params, 0, Params->OriginX, Params->ScaleX, pt1.x, x1, sizeof x1 );
-	FormatReal( Params, 0, Params->OriginY, Params->ScaleY, pt1.y, y1, sizeof y1 );
-	FormatReal( Params, 0, Params->OriginX, Params->ScaleX, pt2.x, x2, sizeof x2 );
-	FormatReal( Params, 0, Params->OriginY, Params->ScaleY, pt2.y, y2, sizeof y2 );
+	return 0;
+	}
+/*=============================================================================*/
+/*
+The wires and junctions are the bulk of a sheet, their coordinates are adjusted
+and formatted a batch at a time and the lines are spliced together and written
+at once. The wires are adjusted in order, each seeing the bus entries as the
+wires before it left them.
+*/
+static int OutputWires( const parameters_t *Params, unsigned Level, const pcad_sheet_t *Sheet, busentries_t *BusEntries )
+	{
+	const pcad_sheetgeometry_t	*Geometry	= Sheet->geometry;
+	pcad_dimmension_t			wx1[COORDINATE_BATCH], wy1[COORDINATE_BATCH], wx2[COORDINATE_BATCH], wy2[COORDINATE_BATCH];
+	coordinate_t				x1[COORDINATE_BATCH], y1[COORDINATE_BATCH], x2[COORDINATE_BATCH], y2[COORDINATE_BATCH];
+	char						Lines[COORDINATE_BATCH * ( MAX_INDENT + 4 * sizeof( coordinate_t ) + 64 )], *p;
+	pcad_point_t				pt1, pt2;
+	size_t						i, j, Count;
+
+	for( i = 0; i < Geometry->numwires; i += Count )
+		{
+		Count	= Geometry->numwires - i < COORDINATE_BATCH ? Geometry->numwires - i : COORDINATE_BATCH;
+
+		for( j = 0; j < Count; j++ )
+			{
+			pt1.x	= Geometry->wirex1[i+j];
+			pt1.y	= Geometry->wirey1[i+j];
+			pt2.x	= Geometry->wirex2[i+j];
+			pt2.y	= Geometry->wirey2[i+j];
+
+			AdjustWire( Params->Cookie, Geometry, BusEntries, i + j, &pt1, &pt2 );
+
+			wx1[j]	= pt1.x;
+			wy1[j]	= pt1.y;
+			wx2[j]	= pt2.x;
+			wy2[j]	= pt2.y;
+			}
 
-	OutputToFile( Params, Level, "(wire (pts (xy %s %s) (xy %s %s)) (stroke (width 0) (type default)))\n", x1, y1, x2, y2 );
+		FormatCoordinates( Params->OriginX, Params->ScaleX, wx1, Count, x1 );
+		FormatCoordinates( Params->OriginY, Params->ScaleY, wy1, Count, y1 );
+		FormatCoordinates( Params->OriginX, Params->ScaleX, wx2, Count, x2 );
+		FormatCoordinates( Params->OriginY, Params->ScaleY, wy2, Count, y2 );
+
+		for( j = 0, p = Lines; j < Count; j++ )
+			{
+			p	= Indent( p, Level );
+			p	= Splice( p, "(wire (pts (xy " );
+			p	= Splice( p, x1[j] );
+			p	= Splice( p, " " );
+			p	= Splice( p, y1[j] );
+			p	= Splice( p, ") (xy " );
+			p	= Splice( p, x2[j] );
+			p	= Splice( p, " " );
+			p	= Splice( p, y2[j] );
+			p	= Splice( p, ")) (stroke (width 0) (type default)))\n" );
+			}
+
+		OutputBytes( Params, Lines, p - Lines );
+		}
 
 	return 0;
 	}
 /*=============================================================================*/
-static int OutputJunction( const parameters_t *Params, unsigned Level, const pcad_junction_t *Junction )
+static int OutputJunctions( const parameters_t *Params, unsigned Level, const pcad_sheet_t *Sheet )
 	{
-	char	x[32], y[32];
+	const pcad_sheetgeometry_t	*Geometry	= Sheet->geometry;
+	coordinate_t				x[COORDINATE_BATCH], y[COORDINATE_BATCH];
+	char						Lines[COORDINATE_BATCH * ( MAX_INDENT + 2 * sizeof( coordinate_t ) + 64 )], *p;
+	size_t						i, j, Count;
 
-	FormatReal( Params, 0, Params->OriginX, Params->ScaleX, Junction->point.x, x, sizeof x );
-	FormatReal( Params, 0, Params->OriginY, Params->ScaleY, Junction->point.y, y, sizeof y );
+	for( i = 0; i < Geometry->numjunctions; i += Count )
+		{
+		Count	= Geometry->numjunctions - i < COORDINATE_BATCH ? Geometry->numjunctions - i : COORDINATE_BATCH;
 
-	OutputToFile( Params, Level, "(junction (at %s %s) (diameter 0) (color 0 0 0 0))\n", x, y );
+		FormatCoordinates( Params->OriginX, Params->ScaleX, &Geometry->junctionx[i], Count, x );
+		FormatCoordinates( Params->OriginY, Params->ScaleY, &Geometry->junctiony[i], Count, y );
+
+		for( j = 0, p = Lines; j < Count; j++ )
+			{
+			p	= Indent( p, Level );
+			p	= Splice( p, "(junction (at " );
+			p	= Splice( p, x[j] );
+			p	= Splice( p, " " );
+			p	= Splice( p, y[j] );
+			p	= Splice( p, ") (diameter 0) (color 0 0 0 0))\n" );
+			}
+
+		OutputBytes( Params, Lines, p - Lines );
+		}
 
 	return 0;
 	}
@@ -281,11 +438,11 @@ static int OutputPort( const parameters_t *Params, unsigned Level, const pcad_po
 
 	i	= Port->porttype;
 	if( i >= PCAD_PORTTYPE_NOANGLE_DBL_HORZ )
-		WarningOutput( "KiCAD does not support 2-pins port type \"%s\", please review the resulting circuit.\n", PortTypes.items[Port->porttype] );
+		WarningOutput( Params->Cookie, "KiCAD does not support 2-pins port type \"%s\", please review the resulting circuit.\n", PortTypes.items[Port->porttype] );
 	else if( i >= PCAD_PORTTYPE_NOANGLE_DBL_HORZ )
-		WarningOutput( "KiCAD does not have vertical port \"%s\", horizontal model used.\n", PortTypes.items[Port->porttype] );
+		WarningOutput( Params->Cookie, "KiCAD does not have vertical port \"%s\", horizontal model used.\n", PortTypes.items[Port->porttype] );
 	else if( i >= PCAD_PORTTYPE_VERTLINE_SGL_HORZ )
-		WarningOutput( "KiCAD does not have port \"%s\", passive model used.\n", PortTypes.items[Port->porttype] );
+		WarningOutput( Params->Cookie, "KiCAD does not have port \"%s\", passive model used.\n", PortTypes.items[Port->porttype] );
 
 	if(( i %= 6 ) >= LENGTH( PortShapeKiCAD ))
 		i	= 0;
@@ -460,9 +617,13 @@ static pcad_comppin_t *FindPin( const parameters_t *Params, unsigned PartNumber,
 	{
 	int	i;
 
+	COUNT( Finds[PCADSCH_FIND_PIN].Calls, 1 );
 	for( i = 0; i < CompDef->numcomppins; i++ )
+		{
+		COUNT( Finds[PCADSCH_FIND_PIN].Probes, 1 );
 		if( CompDef->viocomppins[i]->partnum == PartNumber && CompDef->viocomppins[i]->sympinnum == PinNumber )
 			return CompDef->viocomppins[i];
+		}
 
 	return NULL;
 	}
@@ -530,10 +691,7 @@ static int OutputPin( const parameters_t *Params, unsigned Level, const pcad_pin
 	GraphStyle	= GraphStyles[Pin->insideedgestyle&1][Pin->outsideedgestyle&3];
 
 	if(( CompPin = FindPin( Params, PartNumber, PinNumber, CompDef )) == NULL )
-		{
-		fclose( Params->Cookie->File );
 		ErrorOutput( Params->Cookie, -1, "CompPin not found" );
-		}
 
 	if( CompPin->pinname == NULL )
 		OutputToFile( Params, Level, "(pin %s %s (at %s %s %s) (length %s) (number \"%s\" (effects (font (size 1.27 1.27)))))\n", PinTypes[PinType&15] /*IsPower ? "power_out" : "passive"*/, GraphStyle, x, y, Angle, Length, CompPin->pinnumber );
@@ -547,9 +705,13 @@ static const pcad_compdef_t *FindCompDef( const pcad_schematicfile_t *Schematic,
 	{
 	int i;
 
+	COUNT( Finds[PCADSCH_FIND_COMPDEF].Calls, 1 );
 	for( i = 0; i < Schematic->library.numcompdefs; i++ )
+		{
+		COUNT( Finds[PCADSCH_FIND_COMPDEF].Probes, 1 );
 		if( stricmp( Name, Schematic->library.viocompdefs[i]->name ) == 0 )
 			return Schematic->library.viocompdefs[i];
+		}
 
 	return NULL;
 	}
@@ -563,8 +725,8 @@ static int OutputPolygon( const parameters_t *Params, unsigned Level, const pcad
 
 	for( i = 0; i < Polygon->numpoints; i++ )
 		{
-		FormatReal( Params, 0, Params->OriginX, Params->ScaleX, Polygon->viopoints[i]->x, x, sizeof x );
-		FormatReal( Params, 0, Params->OriginY, Params->ScaleY, Polygon->viopoints[i]->y, y, sizeof y );
+		FormatReal( Params, 0, Params->OriginX, Params->ScaleX, Polygon->points[i].x, x, sizeof x );
+		FormatReal( Params, 0, Params->OriginY, Params->ScaleY, Polygon->points[i].y, y, sizeof y );
 		OutputToFile( Params, 0, " (xy %s %s)", x, y );
 		}
 
@@ -572,8 +734,8 @@ static int OutputPolygon( const parameters_t *Params, unsigned Level, const pcad
 
 	if( Params->PolygonExtraVertex )
 		{
-		FormatReal( Params, 0, Params->OriginX, Params->ScaleX, Polygon->viopoints[0]->x, x, sizeof x );
-		FormatReal( Params, 0, Params->OriginY, Params->ScaleY, Polygon->viopoints[0]->y, y, sizeof y );
+		FormatReal( Params, 0, Params->OriginX, Params->ScaleX, Polygon->points[0].x, x, sizeof x );
+		FormatReal( Params, 0, Params->OriginY, Params->ScaleY, Polygon->points[0].y, y, sizeof y );
 		OutputToFile( Params, 0, " (xy %s %s)) (stroke (width %s) (type default)) (fill (type outline)))\n", x, y, Width );
 		}
 	else
@@ -799,7 +961,7 @@ static int OutputSymbolDef( const parameters_t *Params, unsigned Level, unsigned
 	OutputToFile( &LocalParams, Level, "(symbol \"%s_%u_%u\"\n", FormatName( CompDef->name, Buffer, sizeof Buffer ), partNum, altType + 1 );
 
 	if( altType == PCAD_ALTTYPE_IEEE )
-		WarningOutput( "Symbol %s has IEEE alternate, it is not supported by KiCAD.", CompDef->name );
+		WarningOutput( Params->Cookie, "Symbol %s has IEEE alternate, it is not supported by KiCAD.", CompDef->name );
 
 	for( i = 0; i < SymbolDef->numlines; i++ )
 		OutputLine( &LocalParams, Level + 1, SymbolDef->violines[i] );
@@ -833,9 +995,13 @@ static pcad_symboldef_t *FindSymbolDef( const pcad_schematicfile_t *Schematic, c
 	{
 	int i;
 
+	COUNT( Finds[PCADSCH_FIND_SYMBOLDEF].Calls, 1 );
 	for( i = 0; i < Schematic->library.numsymboldefs; i++ )
+		{
+		COUNT( Finds[PCADSCH_FIND_SYMBOLDEF].Probes, 1 );
 		if( stricmp( Name, Schematic->library.viosymboldefs[i]->name ) == 0 )
 			break;
+		}
 	if( i < Schematic->library.numsymboldefs )
 		return Schematic->library.viosymboldefs[i];
 
@@ -846,9 +1012,13 @@ static pcad_symboldef_t *FindSymbolDefByOriginalName( const pcad_schematicfile_t
 	{
 	int i;
 
+	COUNT( Finds[PCADSCH_FIND_SYMBOLDEF_BY_ORIGINAL_NAME].Calls, 1 );
 	for( i = 0; i < Schematic->library.numsymboldefs; i++ )
+		{
+		COUNT( Finds[PCADSCH_FIND_SYMBOLDEF_BY_ORIGINAL_NAME].Probes, 1 );
 		if( stricmp( Name, Schematic->library.viosymboldefs[i]->originalname ) == 0 )
 			break;
+		}
 	if( i < Schematic->library.numsymboldefs )
 		return Schematic->library.viosymboldefs[i];
 
@@ -859,11 +1029,18 @@ static const pcad_attr_t *FindAttrInNetList( const pcad_netlist_t *NetList, cons
 	{
 	int i, j;
 
+	COUNT( Finds[PCADSCH_FIND_ATTR_IN_NETLIST].Calls, 1 );
 	for( i = 0; i < NetList->numcompinsts; i++ )
+		{
+		COUNT( Finds[PCADSCH_FIND_ATTR_IN_NETLIST].Probes, 1 );
 		if( stricmp( CompName, NetList->viocompinsts[i]->originalname ) == 0 )
 			for( j = 0; j < NetList->viocompinsts[i]->numattrs; j++ )
+				{
+				COUNT( Finds[PCADSCH_FIND_ATTR_IN_NETLIST].Probes, 1 );
 				if( stricmp( Name, NetList->viocompinsts[i]->vioattrs[j]->name ) == 0 )
 					return NetList->viocompinsts[i]->vioattrs[j];
+				}
+		}
 
 	return NULL;
 	}
@@ -938,14 +1115,21 @@ static int OutputCompDef( const parameters_t *Params, unsigned Level, const pcad
 /*=============================================================================*/
 static int OutputLibrary( const parameters_t *Params, unsigned Level, const pcad_schematicfile_t *Schematic, const pcad_library_t *Library )
 	{
-	int i;
+	double	Start	= TraceStart( Params->Cookie ), SymbolStart;
+	int		i;
 
 	OutputToFile( Params, Level, "(lib_symbols\n" );
 
 	for( i = 0; i < Library->numcompdefs; i++ )
+		{
+		SymbolStart	= TraceStart( Params->Cookie );
 		OutputCompDef( Params, Level + 1, Schematic, Library, Library->viocompdefs[i] );
+		TraceSpan( Params->Cookie, SymbolStart, "emit", "symbol \"%s\"", Library->viocompdefs[i]->name );
+		}
 
 	OutputToFile( Params, Level, ")\n" );
+
+	TraceSpan( Params->Cookie, Start, "emit", "lib_symbols" );
 	return 0;
 	}
 /*=============================================================================*/
@@ -953,9 +1137,13 @@ static const pcad_attr_t *FindAttr( const pcad_attr_t * const *Attributes, size_
 	{
 	int i;
 
+	COUNT( Finds[PCADSCH_FIND_ATTR].Calls, 1 );
 	for( i = 0; i < NumAttributes; i++ )
+		{
+		COUNT( Finds[PCADSCH_FIND_ATTR].Probes, 1 );
 		if( stricmp( Name, Attributes[i]->name ) == 0 )
 			return Attributes[i];
+		}
 
 	return NULL;
 	}
@@ -964,9 +1152,13 @@ static pcad_compinst_t *FindCompInst( const pcad_netlist_t *NetList, const char
 	{
 	int i;
 
+	COUNT( Finds[PCADSCH_FIND_COMPINST].Calls, 1 );
 	for( i = 0; i < NetList->numcompinsts; i++ )
+		{
+		COUNT( Finds[PCADSCH_FIND_COMPINST].Probes, 1 );
 		if( stricmp( Name, NetList->viocompinsts[i]->name ) == 0 )
 			break;
+		}
 	if( i < NetList->numcompinsts )
 		return NetList->viocompinsts[i];
 
@@ -991,22 +1183,13 @@ static int OutputSymbol( const parameters_t *Params, unsigned Level, const pcad_
 	FormatReal( Params, 0, 0,				1,				Symbol->rotation, Angle, sizeof Angle );
 
 	if(( SymbolDef = FindSymbolDef( Schematic, Symbol->symbolref )) == NULL )
-		{
-		fclose( Params->Cookie->File );
 		ErrorOutput( Params->Cookie, -1, "SymbolDef \"%s\" not found", Symbol->symbolref );
-		}
 
 	if(( CompInst = FindCompInst( &Schematic->netlist, Symbol->refdesref )) == NULL )
-		{
-		fclose( Params->Cookie->File );
 		ErrorOutput( Params->Cookie, -1, "CompInst \"%s\" not found", Symbol->refdesref );
-		}
 
 	if(( CompDef = FindCompDef( Schematic, CompInst->compref )) == NULL )
-		{
-		fclose( Params->Cookie->File );
 		ErrorOutput( Params->Cookie, -1, "CompDef \"%s\" not found", CompInst->compref );
-		}
 
 	IsPower = CompDef->compheader.comptype == PCAD_COMPTYPE_POWER;
 
@@ -1146,7 +1329,7 @@ static int OutputBus( const parameters_t *Params, unsigned Level, const pcad_bus
 	return 0;
 	}
 /*=============================================================================*/
-static int OutputBusEntry( const parameters_t *Params, unsigned Level, const pcad_busentry_t *BusEntry )
+static int OutputBusEntry( const parameters_t *Params, unsigned Level, const pcad_busentry_t *BusEntry, const busentries_t *BusEntries, size_t Index )
 	{
 	static const char	*Orientations[][4]	=
 		{
@@ -1156,12 +1339,12 @@ static int OutputBusEntry( const parameters_t *Params, unsigned Level, const pca
 		};
 	char	x[32], y[32] /*, Width[32]*/;
 
-	FormatReal( Params, 0, Params->OriginX, Params->ScaleX, BusEntry->point.x, x, sizeof x );
-	FormatReal( Params, 0, Params->OriginY, Params->ScaleY, BusEntry->point.y, y, sizeof y );
+	FormatReal( Params, 0, Params->OriginX, Params->ScaleX, BusEntries->x[Index], x, sizeof x );
+	FormatReal( Params, 0, Params->OriginY, Params->ScaleY, BusEntries->y[Index], y, sizeof y );
 
 	if( Params->StraightBusEntries )
 		OutputToFile( Params, Level, "(bus_entry (at %s %s) (size %s) (stroke (width 0) (type default)))\n", x, y, Orientations[0][BusEntry->orient % LENGTH( Orientations[0] )]);
-	else switch( BusEntry->style )
+	else switch( BusEntries->Style[Index] )
 		{
 		case PCAD_ENDSTYLE_TWOLEADS:
 			OutputToFile( Params, Level, "(bus_entry (at %s %s) (size %s) (stroke (width 0) (type default)))\n", x, y, Orientations[1][BusEntry->orient % LENGTH( Orientations[0] )]);
@@ -1179,7 +1362,31 @@ static int OutputBusEntry( const parameters_t *Params, unsigned Level, const pca
 /*=============================================================================*/
 static int OutputSchematic( const parameters_t *Params, unsigned Level, const pcad_schematicfile_t *Schematic, const pcad_sheet_t *Sheet )
 	{
-	int i;
+	const pcad_sheetgeometry_t	*Geometry	= Sheet->geometry;
+	busentries_t				BusEntries;
+	jmp_buf						Caller;
+	int							i;
+
+	BusEntries.Count	= Geometry->numbusentries;
+	if(( BusEntries.x = malloc( BusEntries.Count * ( 2 * sizeof *BusEntries.x + sizeof *BusEntries.Style ) + 1 )) == NULL )
+		ErrorOutput( Params->Cookie, -1, "Not enough memory" );
+	BusEntries.y		= BusEntries.x + BusEntries.Count;
+	BusEntries.Style	= (pcad_enum_endstyle_t*)( BusEntries.y + BusEntries.Count );
+
+	memcpy( BusEntries.x, Geometry->busentryx, BusEntries.Count * sizeof *BusEntries.x );
+	memcpy( BusEntries.y, Geometry->busentryy, BusEntries.Count * sizeof *BusEntries.y );
+	for( i = 0; i < BusEntries.Count; i++ )
+		BusEntries.Style[i]	= Sheet->viobusentries[i]->style;
+
+	/* The bus entries are released if anything goes wrong, and the error passed on. */
+	memcpy( Caller, Params->Cookie->JumpBuffer, sizeof Caller );
+
+	if( setjmp( Params->Cookie->JumpBuffer ) != 0 )
+		{
+		free( BusEntries.x );
+		memcpy( Params->Cookie->JumpBuffer, Caller, sizeof Caller );
+		longjmp( Params->Cookie->JumpBuffer, Params->Cookie->LastError.Code );
+		}
 
 	for( i = 0; i < Sheet->numsymbols; i++ )
 		OutputSymbol( Params, Level, Schematic, Sheet->viosymbols[i] );
@@ -1187,14 +1394,12 @@ static int OutputSchematic( const parameters_t *Params, unsigned Level, const pc
 	for( i = 0; i < Sheet->numbuses; i++ )
 		OutputBus( Params, Level, Sheet->viobuses[i] );
 
-	for( i = 0; i < Sheet->numwires; i++ )
-		OutputWire( Params, Level, Sheet, Sheet->viowires[i] );
+	OutputWires( Params, Level, Sheet, &BusEntries );
 
 	for( i = 0; i < Sheet->numbusentries; i++ )
-		OutputBusEntry( Params, Level, Sheet->viobusentries[i] );
+		OutputBusEntry( Params, Level, Sheet->viobusentries[i], &BusEntries, i );
 
-	for( i = 0; i < Sheet->numjunctions; i++ )
-		OutputJunction( Params, Level, Sheet->viojunctions[i] );
+	OutputJunctions( Params, Level, Sheet );
 
 	for( i = 0; i < Sheet->numports; i++ )
 		OutputPort( Params, Level, Sheet->vioports[i] );
@@ -1214,6 +1419,9 @@ static int OutputSchematic( const parameters_t *Params, unsigned Level, const pc
 	for( i = 0; i < Sheet->numieeesymbols; i++ )
 		OutputIEEESymbol( Params, Level, Sheet->vioieeesymbols[i] );
 
+	memcpy( Params->Cookie->JumpBuffer, Caller, sizeof Caller );
+	free( BusEntries.x );
+
 	return 0;
 	}
 /*=============================================================================*/
@@ -1224,7 +1432,7 @@ typedef struct
 	pcad_dimmension_t	Height;
 	} papersize_t;
 /*=============================================================================*/
-static papersize_t MetricPapers[]	=
+static const papersize_t MetricPapers[]	=
 	{
 	[0] = { "A0",		1189000000,	841000000 },
 	[1] = { "A1",		 841000000,	594000000 },
@@ -1234,7 +1442,7 @@ static papersize_t MetricPapers[]	=
 	[5] = { "A5",		 210000000,	148000000 }
 	};
 /*=============================================================================*/
-static papersize_t AmericanPapers[]	=
+static const papersize_t AmericanPapers[]	=
 	{
 	[0] = { "E",		1117600000,	863600000 },
 	[1] = { "D",		 863600000,	558800000 },
@@ -1243,7 +1451,7 @@ static papersize_t AmericanPapers[]	=
 	[4] = { "A",		 279400000,	215900000 }
 	};
 /*=============================================================================*/
-static papersize_t OtherPapers[]	=
+static const papersize_t OtherPapers[]	=
 	{
 	[0] = { "USLedger",	 432000000,	279000000 },
 	[1] = { "USLegal",	 356000000,	216000000 },
@@ -1353,6 +1561,7 @@ static int OutputSheet( parameters_t *Params, unsigned Level, const pcad_schemat
 	pcad_dimmension_t		OriginX, OriginY;
 	pcad_extent_t			TitleExtent = { .extentx = 0, .extenty = 0 };
 	const pcad_titlesheet_t	*TitleSheet;
+	double					Start;
 
 	/* The sheet has its own border settings... */
 	if( Sheet->titlesheet.border.width != 0 && Sheet->titlesheet.border.height != 0 )
@@ -1405,38 +1614,81 @@ static int OutputSheet( parameters_t *Params, unsigned Level, const pcad_schemat
 //		Params->OriginX = 0;
 
 	OutputLibrary( Params, Level + 1, Schematic, &Schematic->library );
+
+	Start	= TraceStart( Params->Cookie );
 	OutputSchematic( Params, Level + 1, Schematic, Sheet );
+	TraceSpan( Params->Cookie, Start, "emit", "schematic" );
 
 	OutputToFile( Params, Level, ")\n" );
 
 	return 0;
 	}
 /*=============================================================================*/
+/* Must be changed whenever the conversion changes, so the outputs of older versions are not kept. */
+#define	FINGERPRINT_VERSION	"KiCAD 20231120 1"
+/*=============================================================================*/
+/*
+Every sheet gets the whole library in its "lib_symbols" and may use the title
+sheet of the design, this is what all the sheets have in common.
+*/
+static uint64_t CommonFingerprint( const pcad_schematicfile_t *Schematic )
+	{
+	const pcad_attr_t	*Attr;
+	uint64_t			Hash;
+	int					i;
+
+	Hash	= HashString( HASH_INITIAL, FINGERPRINT_VERSION );
+	Hash	= HashPCADLibrary( Hash, &Schematic->library );
+	Hash	= HashPCADTitleSheet( Hash, &Schematic->schematicdesign.titlesheet );
+
+	/* The descriptions of the components come from the net list. */
+	for( i = 0; i < Schematic->library.numcompdefs; i++ )
+		{
+		Attr	= FindAttrInNetList( &Schematic->netlist, Schematic->library.viocompdefs[i]->originalname, "Description" );
+		Hash	= HashString( Hash, Attr != NULL ? Attr->value : NULL );
+		}
+
+	return Hash;
+	}
+/*=============================================================================*/
+/* The contents of the sheet and the component instances its symbols refer to. */
+static uint64_t SheetFingerprint( uint64_t Hash, const pcad_schematicfile_t *Schematic, const pcad_sheet_t *Sheet )
+	{
+	const pcad_compinst_t	*CompInst;
+	int						i;
+
+	Hash	= HashPCADSheet( Hash, Sheet );
+
+	for( i = 0; i < Sheet->numsymbols; i++ )
+		if(( CompInst = FindCompInst( &Schematic->netlist, Sheet->viosymbols[i]->refdesref )) != NULL )
+			Hash	= HashPCADCompInst( Hash, CompInst );
+
+	return Hash;
+	}
+/*=============================================================================*/
 void SplitPath( const char *pFullPath, char *pPath, char *pName, char *pExt );
 /*=============================================================================*/
-int OutputKiCAD( cookie_t *Cookie, const pcad_schematicfile_t *PCADSchematic, const char *pName )
+/* If "Output" is not NULL, the sheets whose output is up to date are skipped. */
+static int EmitSheets( cookie_t *Cookie, const pcad_schematicfile_t *PCADSchematic, const pcadsch_writer_t *Writer, outputfile_t *Output )
 	{
 	parameters_t	Params;
-	char			Path[256], Name[256], Ext[256], OutPath[256], BkpPath[256], TmpPath[256];
 	char			SheetName[256], *p;
+	uint64_t		Common	= 0;
+	double			Start;
 	int				i;
 
 	Params.Cookie				= Cookie;
+	Params.Writer				= Writer;
 	Params.DefaultLineWidth		= 254000;
 	Params.PolygonBorderWidth	=    100;
 	Params.PolygonExtraVertex	=      1;
 	Params.StraightBusEntries	=	   0;
 
-	SplitPath( pName, Path, Name, Ext );
-	if( stricmp( Ext, "" ) == 0 )
-		strcpy( Ext, ".kicad_sch" );
-
-	strcat( Path, Name );
+	if( Output != NULL && Output->Manifest != NULL )
+		Common	= CommonFingerprint( PCADSchematic );
 
 	for( i = 0; i < PCADSchematic->schematicdesign.numsheets; i++ )
 		{
-		strcpy( OutPath, Path );
-		strcat( OutPath, "-" );
 		strcpy( SheetName, PCADSchematic->schematicdesign.viosheets[i]->name );
 		for( p = SheetName; ( p = strchr( p, '/' )) != NULL; p = SheetName )
 			*p	= '_';
@@ -1459,33 +1711,77 @@ int OutputKiCAD( cookie_t *Cookie, const pcad_schematicfile_t *PCADSchematic, co
 
 		Params.SheetName	= SheetName;
 
-		strcat( OutPath, SheetName );
+		if( Output != NULL && IsOutputUpToDate( Output, SheetName, SheetFingerprint( Common, PCADSchematic, PCADSchematic->schematicdesign.viosheets[i] )))
+			continue;
 
-		strcpy( TmpPath, OutPath );
-		strcat( TmpPath, ".cvt_tmp" );
+		Start	= TraceStart( Cookie );
 
-		remove( TmpPath );
-
-		if(( Params.File = fopen( TmpPath, "wb" )) == NULL )
-			{
-			fclose( Params.Cookie->File );
-			ErrorOutput( Cookie, -1, "Error creating file" );
-			}
+		if( Writer->Begin != NULL && Writer->Begin( Writer->UserData, SheetName ) != 0 )
+			ErrorOutput( Cookie, -1, "Error creating the output for sheet \"%s\"", SheetName );
 
 		OutputSheet( &Params, 0, PCADSchematic, PCADSchematic->schematicdesign.viosheets[i] );
 
-		fclose( Params.File );
+		if( Writer->End != NULL && Writer->End( Writer->UserData ) != 0 )
+			ErrorOutput( Cookie, -1, "Error writing the output for sheet \"%s\"", SheetName );
 
-		strcat( OutPath, Ext );
+		TraceSpan( Cookie, Start, "emit", "sheet \"%s\"", PCADSchematic->schematicdesign.viosheets[i]->name );
+		}
 
-		strcpy( BkpPath, OutPath );
-		strcat( BkpPath, ".cvt_bak" );
+	return 0;
+	}
+/*=============================================================================*/
+int EmitKiCAD( cookie_t *Cookie, const pcad_schematicfile_t *PCADSchematic, const pcadsch_writer_t *Writer )
+	{
+	return EmitSheets( Cookie, PCADSchematic, Writer, NULL );
+	}
+/*=============================================================================*/
+int OutputKiCAD( cookie_t *Cookie, const pcad_schematicfile_t *PCADSchematic, const char *pName )
+	{
+	outputfile_t		Output;
+	pcadsch_writer_t	Writer	= { BeginOutputFile, WriteOutputFile, EndOutputFile, &Output };
+	manifest_t			Manifest;
+	char				Name[256], ManifestPath[256];
+	jmp_buf				Caller;
+	int					Result;
+
+	SplitPath( pName, Output.Base, Name, Output.Ext );
+	if( stricmp( Output.Ext, "" ) == 0 )
+		strcpy( Output.Ext, ".kicad_sch" );
+
+	Output.File		= NULL;
+	Output.Manifest	= NULL;
+
+	/* The fingerprints of the sheets are kept in "<Path><Name><Ext>.cvt_manifest". */
+	if( snprintf( ManifestPath, sizeof ManifestPath, "%s%s%s.cvt_manifest", Output.Base, Name, Output.Ext ) < sizeof ManifestPath )
+		{
+		LoadManifest( &Manifest, ManifestPath );
+		Output.Manifest	= &Manifest;
+		}
 
-		remove( BkpPath );
-		rename( OutPath, BkpPath );
-		rename( TmpPath, OutPath );
+	strcat( Output.Base, Name );
+	strcat( Output.Base, "-" );
+
+	/* The file being written is discarded if anything goes wrong. */
+	memcpy( Caller, Cookie->JumpBuffer, sizeof Caller );
+
+	if( setjmp( Cookie->JumpBuffer ) == 0 )
+		Result	= EmitSheets( Cookie, PCADSchematic, &Writer, &Output );
+	else
+		{
+		AbortOutputFile( &Output );
+		Result	= Cookie->LastError.Code;
 		}
 
-	return 0;
+	memcpy( Cookie->JumpBuffer, Caller, sizeof Caller );
+
+	/* After a failure only the sheets already done are recorded, the others are written again next time. */
+	if( Output.Manifest != NULL )
+		{
+		if( SaveManifest( &Manifest ) != 0 )
+			WarningOutput( Cookie, "Could not write \"%s\"", ManifestPath );
+		ReleaseManifest( &Manifest );
+		}
+
+	return Result;
 	}
 /*=============================================================================*/
@@ -28,7 +28,9 @@
 /*=============================================================================*/
 #include "PCADStructs.h"
 #include "PCADParser.h"
+#include "PCADSch.h"
 /*=============================================================================*/
+int EmitKiCAD   ( cookie_t *Cookie, const pcad_schematicfile_t *PCADSchematic, const pcadsch_writer_t *Writer );
 int OutputKiCAD ( cookie_t *Cookie, const pcad_schematicfile_t *PCADSchematic, const char *Name );
 /*=============================================================================*/
 #endif	/*	!defined __OUTPUTKICAD_H__ */
@@ -23,32 +23,66 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 /*============================================================================*/
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include "Lexic.h"
+#include "Parser.h"
+#include "Trace.h"
+#if			defined __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#endif	/*	defined __linux__ */
 /*============================================================================*/
 static int GetChar( cookie_t *Cookie )
 	{
-	return fgetc( Cookie->File );
+	int	c;
+
+	if( Cookie->Input != NULL )
+		return Cookie->Position < Cookie->InputLength ? (unsigned char)Cookie->Input[Cookie->Position++] : EOF;
+
+	c	= fgetc( Cookie->File );
+
+	if( c != EOF )
+		Cookie->Position++;
+
+	return c;
 	}
 /*============================================================================*/
 static int UngetChar( cookie_t *Cookie, int c )
 	{
+	if( c != EOF )
+		Cookie->Position--;
+
+	if( Cookie->Input != NULL )
+		return c;
+
 	return ungetc( c, Cookie->File );
 	}
 /*============================================================================*/
-token_t GetToken( cookie_t *Cookie, char *Buffer, size_t BufferSize )
+/*
+Counts the line break "c" just read. A "\r\n" or a "\n\r" is a single line break,
+returns its second character if it is one, or EOF.
+*/
+static int FoldNewLine( cookie_t *Cookie, int c )
 	{
-	int	c;
+	int	Next	= GetChar( Cookie );
 
-	if( Cookie->UngettedToken != TOKEN_NONE )
-		{
-		token_t Temp	= Cookie->UngettedToken;
-		if( Buffer != NULL )
-			strncpy( Buffer, Cookie->UngetBuffer, BufferSize );
-		Cookie->UngettedToken	= TOKEN_NONE;
-		return Temp;
-		}
+	Cookie->LineNumber++;
+	Cookie->Column	= 1;
+
+	if( Next == ( c == '\r' ? '\n' : '\r' ))
+		return Next;
+
+	UngetChar( Cookie, Next );
+
+	return EOF;
+	}
+/*============================================================================*/
+static token_t ReadToken( cookie_t *Cookie, char *Buffer, size_t BufferSize )
+	{
+	int	c;
 
 	do
 		{
@@ -59,24 +93,8 @@ token_t GetToken( cookie_t *Cookie, char *Buffer, size_t BufferSize )
 				Cookie->Column++;
 				break;
 			case '\r':
-				c	= GetChar( Cookie );
-				if( c != '\n' )
-					{
-					UngetChar(	Cookie, c );
-					c	= '\r';
-					}
-				Cookie->LineNumber++;
-				Cookie->Column	= 1;
-				break;
 			case '\n':
-				c	= GetChar( Cookie );
-				if( c != '\r' )
-					{
-					UngetChar( Cookie, c );
-					c	= '\n';
-					}
-				Cookie->LineNumber++;
-				Cookie->Column	= 1;
+				FoldNewLine( Cookie, c );
 				break;
 			case '\t':
 				Cookie->Column	= ((( Cookie->Column - 1 ) / Cookie->TabSize ) + 1 ) * Cookie->TabSize + 1;
@@ -92,6 +110,8 @@ token_t GetToken( cookie_t *Cookie, char *Buffer, size_t BufferSize )
 		}
 	while( isspace( c ));
 
+	Cookie->TokenOffset	= c != EOF ? Cookie->Position - 1 : Cookie->Position;
+
 	switch( c )
 		{
 		case '(':
@@ -168,7 +188,10 @@ token_t GetToken( cookie_t *Cookie, char *Buffer, size_t BufferSize )
 			if( c == '.' || c == ',' )
 				{
 				if( Float != 0 )
-					longjmp( Cookie->JumpBuffer, -1 );
+					{
+					Buffer != NULL && ( *Buffer = '\0' );
+					return TOKEN_INVALID;
+					}
 				Float = 1;
 				}
 
@@ -190,8 +213,393 @@ token_t GetToken( cookie_t *Cookie, char *Buffer, size_t BufferSize )
 	return TOKEN_INVALID;
 	}
 /*============================================================================*/
+#if			defined __linux__
+/*============================================================================*/
+/*
+In pipeline mode the whole file is loaded into memory and a separate thread does
+the lexical analysis, filling a ring buffer with compact token records that the
+parser consumes. There is only one producer and one consumer, so the ring needs
+no locks, just the two indexes. A side that finds the ring full or empty spins
+for a while and then sleeps until the other side wakes it up.
+*/
+/*----------------------------------------------------------------------------*/
+#define	RING_SIZE	4096
+/* How many times a side yields before going to sleep. */
+#define	SPIN_LIMIT	64
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	token_t					Token;
+	unsigned				LineNumber;
+	unsigned				Column;
+	uint32_t				Length;
+	size_t					Offset;
+	int64_t					Value;
+	} tokenrecord_t;
+/*----------------------------------------------------------------------------*/
+typedef struct pipeline_tag
+	{
+	pthread_t				Thread;
+	const char				*Image;
+	size_t					ImageSize;
+	/* The image is not freed when it is the caller's buffer. */
+	int						OwnsImage;
+	unsigned				TabSize;
+	struct trace_tag		*Trace;
+	/* Index of the next record the parser will read, only the parser touches it. */
+	size_t					Read;
+	/* Number of records written by the lexer. */
+	_Alignas( 64 ) atomic_size_t	Head;
+	/* Number of records the lexer may overwrite. */
+	_Alignas( 64 ) atomic_size_t	Tail;
+	atomic_int				Done;
+	atomic_int				Stop;
+	/* Set by a side before it sleeps, so the other one knows it must signal. */
+	atomic_int				ParserWaiting;
+	atomic_int				LexerWaiting;
+	pthread_mutex_t			Mutex;
+	pthread_cond_t			ParserWake;
+	pthread_cond_t			LexerWake;
+	tokenrecord_t			Ring[RING_SIZE];
+	} pipeline_t;
+/*============================================================================*/
+static int64_t ConvertInteger( const char *p, size_t Length )
+	{
+	uint64_t	Value	= 0;
+	int			Sign	= 0;
+
+	if( Length > 0 && ( *p == '+' || *p == '-' ))
+		{
+		Sign	= *p++ == '-';
+		Length--;
+		}
+
+	for( ; Length > 0 && isdigit( *p ); Length-- )
+		Value	= Value * 10 + *p++ - '0';
+
+	return Sign != 0 ? -(int64_t)Value : (int64_t)Value;
+	}
+/*============================================================================*/
+/* The numbers with a decimal point are converted to millionths, the precision of the reals and the finest of the units. */
+static int64_t ConvertFixed( const char *p, size_t Length )
+	{
+	uint64_t	Value	= 0;
+	int			Sign	= 0, Exp = 6;
+
+	if( Length > 0 && ( *p == '+' || *p == '-' ))
+		{
+		Sign	= *p++ == '-';
+		Length--;
+		}
+
+	for( ; Length > 0 && isdigit( *p ); Length-- )
+		Value	= Value * 10 + *p++ - '0';
+
+	if( Length > 0 && ( *p == '.' || *p == ',' ))
+		for( p++, Length--; Length > 0 && isdigit( *p ) && Exp > 0; Length--, Exp-- )
+			Value	= Value * 10 + *p++ - '0';
+
+	for( ; Exp > 0; Exp-- )
+		Value	= Value * 10;
+
+	return Sign != 0 ? -(int64_t)Value : (int64_t)Value;
+	}
+/*============================================================================*/
+/* Wakes the other side if it is sleeping. The store the caller made before must be seen before "Waiting" is read. */
+static void WakeUp( pipeline_t *Pipeline, atomic_int *Waiting, pthread_cond_t *Wake )
+	{
+	atomic_thread_fence( memory_order_seq_cst );
+
+	if( atomic_load_explicit( Waiting, memory_order_relaxed ) == 0 )
+		return;
+
+	pthread_mutex_lock( &Pipeline->Mutex );
+	pthread_cond_signal( Wake );
+	pthread_mutex_unlock( &Pipeline->Mutex );
+	}
+/*============================================================================*/
+/* Waits until "Ready" returns non-zero, spinning first and then sleeping on "Wake". */
+static void WaitFor( pipeline_t *Pipeline, int (*Ready)( pipeline_t *Pipeline ), atomic_int *Waiting, pthread_cond_t *Wake )
+	{
+	int	i;
+
+	for( i = 0; i < SPIN_LIMIT; i++ )
+		{
+		if( Ready( Pipeline ))
+			return;
+		sched_yield();
+		}
+
+	pthread_mutex_lock( &Pipeline->Mutex );
+	atomic_store_explicit( Waiting, 1, memory_order_relaxed );
+	atomic_thread_fence( memory_order_seq_cst );
+	while( !Ready( Pipeline ))
+		pthread_cond_wait( Wake, &Pipeline->Mutex );
+	atomic_store_explicit( Waiting, 0, memory_order_relaxed );
+	pthread_mutex_unlock( &Pipeline->Mutex );
+	}
+/*============================================================================*/
+/* The lexer may write a record if the parser has released a slot or has already given up. */
+static int LexerReady( pipeline_t *Pipeline )
+	{
+	return atomic_load_explicit( &Pipeline->Head, memory_order_relaxed ) - atomic_load_explicit( &Pipeline->Tail, memory_order_acquire ) < RING_SIZE || atomic_load_explicit( &Pipeline->Stop, memory_order_acquire ) != 0;
+	}
+/*============================================================================*/
+/* The parser may read if there is a record or the lexer has finished. */
+static int ParserReady( pipeline_t *Pipeline )
+	{
+	return Pipeline->Read != atomic_load_explicit( &Pipeline->Head, memory_order_acquire ) || atomic_load_explicit( &Pipeline->Done, memory_order_acquire ) != 0;
+	}
+/*============================================================================*/
+static void *LexerThread( void *Argument )
+	{
+	pipeline_t		*Pipeline	= Argument;
+	tokenrecord_t	*Record;
+	cookie_t		Cookie;
+	token_t			Token;
+	size_t			Head		= 0;
+	double			Start;
+
+	Cookie.File				= NULL;
+	Cookie.Input			= Pipeline->Image;
+	Cookie.InputLength		= Pipeline->ImageSize;
+	Cookie.LineNumber		= 1;
+	Cookie.Column			= 1;
+	Cookie.TabSize			= Pipeline->TabSize;
+	Cookie.UngettedToken	= TOKEN_NONE;
+	Cookie.Pipeline			= NULL;
+	Cookie.Position			= 0;
+	Cookie.TokenOffset		= 0;
+	Cookie.Trace			= Pipeline->Trace;
+	/* The lexer reports its errors in the tokens. */
+	Cookie.Diagnostics		= NULL;
+
+	TraceThread( &Cookie, "lexer" );
+	Start					= TraceStart( &Cookie );
+
+	do
+		{
+		Token	= ReadToken( &Cookie, NULL, 0 );
+
+		/* Wait until the parser releases a slot, unless it has already given up. */
+		if( !LexerReady( Pipeline ))
+			WaitFor( Pipeline, LexerReady, &Pipeline->LexerWaiting, &Pipeline->LexerWake );
+		if( atomic_load_explicit( &Pipeline->Stop, memory_order_acquire ) != 0 )
+			break;
+
+		Record				= &Pipeline->Ring[Head % RING_SIZE];
+		Record->Token		= Token;
+		Record->LineNumber	= Cookie.LineNumber;
+		Record->Column		= Cookie.Column;
+		Record->Offset		= Cookie.TokenOffset;
+		Record->Length		= Cookie.Position - Cookie.TokenOffset;
+		Record->Value		= Token == TOKEN_UNSIGNED || Token == TOKEN_INTEGER ? ConvertInteger( &Pipeline->Image[Record->Offset], Record->Length ) : Token == TOKEN_FLOAT ? ConvertFixed( &Pipeline->Image[Record->Offset], Record->Length ) : 0;
+
+		atomic_store_explicit( &Pipeline->Head, ++Head, memory_order_release );
+		WakeUp( Pipeline, &Pipeline->ParserWaiting, &Pipeline->ParserWake );
+		}
+	while( Token != TOKEN_EOF && Token != TOKEN_INVALID );
+
+	TraceSpan( &Cookie, Start, "lex", "lex" );
+
+	atomic_store_explicit( &Pipeline->Done, 1, memory_order_release );
+	WakeUp( Pipeline, &Pipeline->ParserWaiting, &Pipeline->ParserWake );
+
+	return NULL;
+	}
+/*============================================================================*/
+static token_t GetPipelinedToken( cookie_t *Cookie, char *Buffer, size_t BufferSize )
+	{
+	pipeline_t			*Pipeline	= Cookie->Pipeline;
+	const tokenrecord_t	*Record;
+	const char			*p;
+	size_t				Length;
+
+	if( Pipeline->Read == atomic_load_explicit( &Pipeline->Head, memory_order_acquire ))
+		{
+		if( !ParserReady( Pipeline ))
+			WaitFor( Pipeline, ParserReady, &Pipeline->ParserWaiting, &Pipeline->ParserWake );
+		/* "Done" is set after the last record, so "Head" must be read again. */
+		if( Pipeline->Read == atomic_load_explicit( &Pipeline->Head, memory_order_acquire ))
+			return TOKEN_EOF;
+		}
+
+	Record	= &Pipeline->Ring[Pipeline->Read++ % RING_SIZE];
+
+	/* The record just read is kept in the ring so it can be ungotten. */
+	atomic_store_explicit( &Pipeline->Tail, Pipeline->Read - 1, memory_order_release );
+	WakeUp( Pipeline, &Pipeline->LexerWaiting, &Pipeline->LexerWake );
+
+	Cookie->LineNumber	= Record->LineNumber;
+	Cookie->Column		= Record->Column;
+	Cookie->TokenValue	= Record->Value;
+	Cookie->TokenOffset	= Record->Offset;
+
+	p		= &Pipeline->Image[Record->Offset];
+	Length	= Record->Length;
+
+	if( Buffer == NULL || Record->Token == TOKEN_OPEN_PAR || Record->Token == TOKEN_CLOSE_PAR || Record->Token == TOKEN_EOF )
+		return Record->Token;
+
+	if( *p == '"' )
+		{
+		p++;
+		Length--;
+		if( Length > 0 && ( p[Length-1] == '"' || p[Length-1] == '\r' || p[Length-1] == '\n' ))
+			Length--;
+		}
+	else if( Record->Token == TOKEN_INVALID )
+		return Record->Token;
+
+	if( Length > BufferSize - 1 )
+		Length	= BufferSize - 1;
+	memcpy( Buffer, p, Length );
+	Buffer[Length]	= '\0';
+
+	return Record->Token;
+	}
+/*============================================================================*/
+int StartPipeline( cookie_t *Cookie )
+	{
+	pipeline_t	*Pipeline;
+	size_t		Allocated	= 0, Length = 0;
+	char		*Image		= NULL, *p;
+	double		Start		= TraceStart( Cookie );
+
+	/* Load everything that is left in the file, an input in memory is used directly. */
+	if( Cookie->Input != NULL )
+		{
+		Image	= (char*)&Cookie->Input[Cookie->Position];
+		Length	= Cookie->InputLength - Cookie->Position;
+		}
+	else
+		{
+		do
+			{
+			if( Length >= Allocated )
+				{
+				Allocated	= Allocated == 0 ? 65536 : 2 * Allocated;
+				if(( p = realloc( Image, Allocated )) == NULL )
+					{
+					free( Image );
+					return -1;
+					}
+				Image	= p;
+				}
+			Length	+= fread( &Image[Length], 1, Allocated - Length, Cookie->File );
+			}
+		while( Length >= Allocated );
+
+		TraceSpan( Cookie, Start, "read", "read" );
+		}
+
+	if(( Pipeline = aligned_alloc( _Alignof( pipeline_t ), sizeof( pipeline_t ))) == NULL )
+		{
+		if( Cookie->Input == NULL )
+			free( Image );
+		return -1;
+		}
+
+	Pipeline->Image		= Image;
+	Pipeline->ImageSize	= Length;
+	Pipeline->OwnsImage	= Cookie->Input == NULL;
+	Pipeline->TabSize	= Cookie->TabSize;
+	Pipeline->Trace		= Cookie->Trace;
+	Pipeline->Read		= 0;
+	atomic_init( &Pipeline->Head, 0 );
+	atomic_init( &Pipeline->Tail, 0 );
+	atomic_init( &Pipeline->Done, 0 );
+	atomic_init( &Pipeline->Stop, 0 );
+	atomic_init( &Pipeline->ParserWaiting, 0 );
+	atomic_init( &Pipeline->LexerWaiting, 0 );
+	pthread_mutex_init( &Pipeline->Mutex, NULL );
+	pthread_cond_init( &Pipeline->ParserWake, NULL );
+	pthread_cond_init( &Pipeline->LexerWake, NULL );
+
+	if( pthread_create( &Pipeline->Thread, NULL, LexerThread, Pipeline ) != 0 )
+		{
+		pthread_cond_destroy( &Pipeline->LexerWake );
+		pthread_cond_destroy( &Pipeline->ParserWake );
+		pthread_mutex_destroy( &Pipeline->Mutex );
+		if( Pipeline->OwnsImage )
+			free( Image );
+		free( Pipeline );
+		return -1;
+		}
+
+	Cookie->Pipeline	= Pipeline;
+	/* All of the input is read at once. */
+	Cookie->Position	+= Length;
+
+	return 0;
+	}
+/*============================================================================*/
+void StopPipeline( cookie_t *Cookie )
+	{
+	pipeline_t	*Pipeline	= Cookie->Pipeline;
+
+	if( Pipeline == NULL )
+		return;
+
+	atomic_store_explicit( &Pipeline->Stop, 1, memory_order_release );
+	WakeUp( Pipeline, &Pipeline->LexerWaiting, &Pipeline->LexerWake );
+	pthread_join( Pipeline->Thread, NULL );
+
+	pthread_cond_destroy( &Pipeline->LexerWake );
+	pthread_cond_destroy( &Pipeline->ParserWake );
+	pthread_mutex_destroy( &Pipeline->Mutex );
+
+	if( Pipeline->OwnsImage )
+		free( (char*)Pipeline->Image );
+	free( Pipeline );
+
+	Cookie->Pipeline	= NULL;
+	}
+/*============================================================================*/
+#endif	/*	defined __linux__ */
+/*============================================================================*/
+/* Counts the tokens by kind, "UngetToken" takes back the ones returned. */
+static inline token_t CountToken( cookie_t *Cookie, token_t Token, int Increment )
+	{
+	if( Token >= TOKEN_CLOSE_PAR )
+		Cookie->Stats.Tokens[Token-TOKEN_CLOSE_PAR]	+= Increment;
+
+	return Token;
+	}
+/*============================================================================*/
+token_t GetToken( cookie_t *Cookie, char *Buffer, size_t BufferSize )
+	{
+#if			defined __linux__
+	if( Cookie->Pipeline != NULL )
+		return CountToken( Cookie, GetPipelinedToken( Cookie, Buffer, BufferSize ), 1 );
+#endif	/*	defined __linux__ */
+
+	if( Cookie->UngettedToken != TOKEN_NONE )
+		{
+		token_t Temp	= Cookie->UngettedToken;
+		if( Buffer != NULL )
+			strncpy( Buffer, Cookie->UngetBuffer, BufferSize );
+		Cookie->UngettedToken	= TOKEN_NONE;
+		return CountToken( Cookie, Temp, 1 );
+		}
+
+	return CountToken( Cookie, ReadToken( Cookie, Buffer, BufferSize ), 1 );
+	}
+/*============================================================================*/
 void UngetToken( cookie_t *Cookie, token_t Token, const char *TokenString )
 	{
+	CountToken( Cookie, Token, -1 );
+	COUNT( UngetTokens, 1 );
+
+#if			defined __linux__
+	/* The last token read is still in the ring, just step back. */
+	if( Cookie->Pipeline != NULL )
+		{
+		Cookie->Pipeline->Read--;
+		return;
+		}
+#endif	/*	defined __linux__ */
+
 	if( TokenString != NULL )
 		strncpy( Cookie->UngetBuffer, TokenString, sizeof Cookie->UngetBuffer );
 	else
@@ -200,3 +608,89 @@ void UngetToken( cookie_t *Cookie, token_t Token, const char *TokenString )
 	Cookie->UngettedToken	= Token;
 	}
 /*============================================================================*/
+/* Appends "c" to the text collected by "SkipBlock", returns non-zero if there is not enough memory. */
+static int AppendChar( char **Buffer, size_t *Used, size_t *Allocated, int c )
+	{
+	char	*p;
+
+	if( *Used + 1 >= *Allocated )
+		{
+		*Allocated	= *Allocated == 0 ? 4096 : 2 * *Allocated;
+		if(( p = realloc( *Buffer, *Allocated )) == NULL )
+			return -1;
+		*Buffer	= p;
+		}
+
+	(*Buffer)[(*Used)++]	= c;
+
+	return 0;
+	}
+/*============================================================================*/
+/*
+Reads the raw characters of the current block up to (not including) its closing
+parenthesis, without tokenizing them. The lines and columns are counted as the
+lexer counts them. If "Text" is not NULL, the characters are collected into a
+NUL-terminated buffer allocated with "malloc", which the caller must free, even
+if the block is empty. "Length" does not count the terminator.
+Returns zero or the code of the error recorded.
+*/
+int SkipBlock( cookie_t *Cookie, char **Text, size_t *Length )
+	{
+	char		*Buffer		= NULL;
+	size_t		Used		= 0, Allocated = 0, Skipped = 0;
+	unsigned	Depth		= 1;
+	int			InString	= 0, c, Second;
+
+	while( 1 )
+		{
+		if(( c = GetChar( Cookie )) == EOF )
+			{
+			free( Buffer );
+			return RecordError( Cookie, -1, "Expecting \")\"" );
+			}
+
+		Second	= EOF;
+
+		if( c == '"' )
+			InString	= !InString;
+		else if( c == '\r' || c == '\n' )
+			{
+			/* Strings cannot span lines, the lexer would return an invalid token. */
+			InString	= 0;
+			Second		= FoldNewLine( Cookie, c );
+			}
+		else if( c == '(' && !InString )
+			Depth++;
+		else if( c == ')' && !InString && --Depth == 0 )
+			break;
+
+		if( c == '\t' )
+			Cookie->Column	= ((( Cookie->Column - 1 ) / Cookie->TabSize ) + 1 ) * Cookie->TabSize + 1;
+		else if( c != '\r' && c != '\n' )
+			Cookie->Column++;
+
+		if( Text != NULL && ( AppendChar( &Buffer, &Used, &Allocated, c ) != 0 || ( Second != EOF && AppendChar( &Buffer, &Used, &Allocated, Second ) != 0 )))
+			{
+			free( Buffer );
+			return RecordError( Cookie, -1, "Not enough memory" );
+			}
+		Skipped	+= Second != EOF ? 2 : 1;
+		}
+
+	/* The closing parenthesis belongs to the caller. */
+	UngetChar( Cookie, c );
+
+	if( Text != NULL )
+		{
+		/* An empty block still gets its terminator. */
+		if( Buffer == NULL && ( Buffer = malloc( 1 )) == NULL )
+			return RecordError( Cookie, -1, "Not enough memory" );
+		Buffer[Used]	= '\0';
+		*Text			= Buffer;
+		}
+	if( Length != NULL )
+		*Length	= Skipped;
+
+	return 0;
+	}
+/*============================================================================*/
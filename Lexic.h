@@ -31,6 +31,13 @@
 /*============================================================================*/
 token_t	GetToken	( cookie_t *Cookie, char *Buffer, size_t BufferSize );
 void	UngetToken	( cookie_t *Cookie, token_t Token, const char *TokenString );
+/* Returns zero or the code of the error recorded in "Cookie->LastError". */
+int		SkipBlock	( cookie_t *Cookie, char **Text, size_t *Length );
+
+#if			defined __linux__
+int		StartPipeline	( cookie_t *Cookie );
+void	StopPipeline	( cookie_t *Cookie );
+#endif	/*	defined __linux__ */
 /*============================================================================*/
 #endif	/*	!defined __LEXIC_H__ */
 /*============================================================================*/
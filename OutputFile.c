@@ -0,0 +1,422 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include "OutputFile.h"
+#include "Parser.h"
+/*============================================================================*/
+/* The first line of a manifest, a different one means the fingerprints cannot be compared. */
+#define	MANIFEST_HEADER		"PCADSch2KiCAD manifest 3\n"
+/*============================================================================*/
+/* Reads the size, the time and the inode of the file into "Entry", non-zero if it does not exist. */
+static int StatOutput( const char *Path, manifestentry_t *Entry )
+	{
+	struct stat	Status;
+
+	if( stat( Path, &Status ) != 0 )
+		return -1;
+
+	Entry->Size		= Status.st_size;
+#if			defined __linux__
+	Entry->Time		= (int64_t)Status.st_mtim.tv_sec * 1000000000 + Status.st_mtim.tv_nsec;
+#else	/*	defined __linux__ */
+	Entry->Time		= (int64_t)Status.st_mtime * 1000000000;
+#endif	/*	defined __linux__ */
+	Entry->Inode	= Status.st_ino;
+
+	return 0;
+	}
+/*============================================================================*/
+/* Tells whether the file is still as it was when "Entry" was recorded. */
+static int IsUntouched( const manifestentry_t *Entry, const manifestentry_t *OnDisk )
+	{
+	return OnDisk->Size == Entry->Size && OnDisk->Time == Entry->Time && OnDisk->Inode == Entry->Inode;
+	}
+/*============================================================================*/
+static int AddManifestEntry( manifest_t *Manifest, const char *Name, uint64_t Fingerprint, uint64_t Hash, const manifestentry_t *OnDisk )
+	{
+	manifestentry_t	*p;
+	size_t			Allocated;
+
+	if( Manifest->NumCurrent >= Manifest->AllocatedCurrent )
+		{
+		Allocated	= Manifest->AllocatedCurrent > 0 ? 2 * Manifest->AllocatedCurrent : 64;
+		if(( p = realloc( Manifest->Current, Allocated * sizeof( manifestentry_t ))) == NULL )
+			return -1;
+		Manifest->Current			= p;
+		Manifest->AllocatedCurrent	= Allocated;
+		}
+
+	p				= &Manifest->Current[Manifest->NumCurrent++];
+	strncpy( p->Name, Name, sizeof p->Name );
+	p->Name[sizeof p->Name - 1]	= '\0';
+	p->Fingerprint	= Fingerprint;
+	p->Size			= OnDisk->Size;
+	p->Hash			= Hash;
+	p->Time			= OnDisk->Time;
+	p->Inode		= OnDisk->Inode;
+
+	return 0;
+	}
+/*============================================================================*/
+static const manifestentry_t *FindPrevious( const manifest_t *Manifest, const char *Name )
+	{
+	int	i;
+
+	COUNT( Finds[PCADSCH_FIND_PREVIOUS].Calls, 1 );
+	for( i = 0; i < Manifest->NumPrevious; i++ )
+		{
+		COUNT( Finds[PCADSCH_FIND_PREVIOUS].Probes, 1 );
+		if( strcmp( Name, Manifest->Previous[i].Name ) == 0 )
+			return &Manifest->Previous[i];
+		}
+
+	return NULL;
+	}
+/*============================================================================*/
+void LoadManifest( manifest_t *Manifest, const char *Path )
+	{
+	char			Line[512], *p, *End;
+	FILE			*File;
+	size_t			Length;
+	uint64_t		Fingerprint, Hash;
+	manifestentry_t	OnDisk;
+
+	memset( Manifest, 0, sizeof *Manifest );
+	strncpy( Manifest->Path, Path, sizeof Manifest->Path );
+	Manifest->Path[sizeof Manifest->Path - 1]	= '\0';
+
+	if(( File = fopen( Path, "rb" )) == NULL )
+		return;
+
+	if( fgets( Line, sizeof Line, File ) == NULL || strcmp( Line, MANIFEST_HEADER ) != 0 )
+		{
+		fclose( File );
+		return;
+		}
+
+	/* Each line is the fingerprint, the size, the hash, the time and the inode of the output, and then its name. */
+	while( fgets( Line, sizeof Line, File ) != NULL )
+		{
+		if(( Length = strlen( Line )) == 0 || Line[Length-1] != '\n' )
+			break;
+		Line[Length-1]	= '\0';
+
+		Fingerprint	= strtoull( p = Line, &End, 16 );
+		if( End != p + 16 || *End != ' ' )
+			continue;
+		OnDisk.Size	= strtoull( p = End + 1, &End, 10 );
+		if( End == p || *End != ' ' )
+			continue;
+		Hash		= strtoull( p = End + 1, &End, 16 );
+		if( End != p + 16 || *End != ' ' )
+			continue;
+		OnDisk.Time	= strtoll( p = End + 1, &End, 10 );
+		if( End == p || *End != ' ' )
+			continue;
+		OnDisk.Inode	= strtoull( p = End + 1, &End, 10 );
+		if( End == p || *End != ' ' )
+			continue;
+
+		if( AddManifestEntry( Manifest, End + 1, Fingerprint, Hash, &OnDisk ) != 0 )
+			break;
+		}
+
+	fclose( File );
+
+	/* What was read is the previous state, this conversion starts from nothing. */
+	Manifest->NumPrevious		= Manifest->NumCurrent;
+	Manifest->Previous			= Manifest->Current;
+	Manifest->NumCurrent		= 0;
+	Manifest->AllocatedCurrent	= 0;
+	Manifest->Current			= NULL;
+	}
+/*============================================================================*/
+int IsOutputUpToDate( outputfile_t *Output, const char *Name, uint64_t Fingerprint )
+	{
+	manifest_t				*Manifest	= Output->Manifest;
+	const manifestentry_t	*Entry;
+	manifestentry_t			OnDisk;
+	char					Path[sizeof Output->Path];
+
+	if( Manifest == NULL )
+		return 0;
+
+	/* Recorded by "EndOutputFile" if the output has to be written. */
+	Manifest->Fingerprint	= Fingerprint;
+
+	if(( Entry = FindPrevious( Manifest, Name )) == NULL || Entry->Fingerprint != Fingerprint )
+		return 0;
+
+	/* The output may have been removed or changed since. */
+	if( snprintf( Path, sizeof Path, "%s%s%s", Output->Base, Name, Output->Ext ) >= sizeof Path || StatOutput( Path, &OnDisk ) != 0 || !IsUntouched( Entry, &OnDisk ))
+		return 0;
+
+	/* If it cannot be recorded it will be just written again next time. */
+	AddManifestEntry( Manifest, Name, Fingerprint, Entry->Hash, Entry );
+
+	return 1;
+	}
+/*============================================================================*/
+int SaveManifest( manifest_t *Manifest )
+	{
+	char	TmpPath[sizeof Manifest->Path + sizeof ".cvt_tmp"];
+	FILE	*File;
+	int		i, Result;
+
+	if( Manifest->NumCurrent == Manifest->NumPrevious )
+		{
+		for( i = 0; i < Manifest->NumCurrent; i++ )
+			{
+			const manifestentry_t	*Current	= &Manifest->Current[i];
+			const manifestentry_t	*Previous	= &Manifest->Previous[i];
+
+			if( Current->Fingerprint != Previous->Fingerprint || Current->Hash != Previous->Hash || !IsUntouched( Current, Previous ) || strcmp( Current->Name, Previous->Name ) != 0 )
+				break;
+			}
+		/* Nothing changed, let's not touch the file. */
+		if( i >= Manifest->NumCurrent )
+			return 0;
+		}
+
+	strcpy( TmpPath, Manifest->Path );
+	strcat( TmpPath, ".cvt_tmp" );
+
+	if(( File = fopen( TmpPath, "wb" )) == NULL )
+		return -1;
+
+	Result	= fputs( MANIFEST_HEADER, File ) < 0;
+	for( i = 0; i < Manifest->NumCurrent; i++ )
+		Result	|= fprintf( File, "%016" PRIx64 " %" PRIu64 " %016" PRIx64 " %" PRId64 " %" PRIu64 " %s\n", Manifest->Current[i].Fingerprint, Manifest->Current[i].Size, Manifest->Current[i].Hash, Manifest->Current[i].Time, Manifest->Current[i].Inode, Manifest->Current[i].Name ) < 0;
+
+	Result	|= fclose( File ) != 0;
+
+	if( Result != 0 )
+		{
+		remove( TmpPath );
+		return -1;
+		}
+
+	remove( Manifest->Path );
+	rename( TmpPath, Manifest->Path );
+
+	return 0;
+	}
+/*============================================================================*/
+void ReleaseManifest( manifest_t *Manifest )
+	{
+	free( Manifest->Previous );
+	free( Manifest->Current );
+
+	Manifest->Previous		= NULL;
+	Manifest->NumPrevious	= 0;
+	Manifest->Current		= NULL;
+	Manifest->NumCurrent	= 0;
+	}
+/*============================================================================*/
+int BeginOutputFile( void *UserData, const char *Name )
+	{
+	outputfile_t	*Output	= UserData;
+
+	if( Name == NULL )
+		Name	= "";
+
+	/* A name that does not fit would be truncated into some other file, so the output fails. */
+	if( snprintf( Output->Name, sizeof Output->Name, "%s", Name ) >= sizeof Output->Name ||
+		snprintf( Output->TmpPath, sizeof Output->TmpPath, "%s%s.cvt_tmp", Output->Base, Name ) >= sizeof Output->TmpPath ||
+		snprintf( Output->Path, sizeof Output->Path, "%s%s%s", Output->Base, Name, Output->Ext ) >= sizeof Output->Path )
+		return -1;
+
+	remove( Output->TmpPath );
+
+	if(( Output->File = fopen( Output->TmpPath, "wb" )) == NULL )
+		return -1;
+
+	Output->Size	= 0;
+	Output->Hash	= HASH_INITIAL;
+
+	return 0;
+	}
+/*============================================================================*/
+int WriteOutputFile( void *UserData, const void *Data, size_t Length )
+	{
+	outputfile_t	*Output	= UserData;
+
+	Output->Size	+= Length;
+	Output->Hash	 = HashBytes( Output->Hash, Data, Length );
+
+	return fwrite( Data, 1, Length, Output->File ) != Length ? -1 : 0;
+	}
+/*============================================================================*/
+static int HashFile( const char *Path, uint64_t *Hash )
+	{
+	char	Buffer[65536];
+	FILE	*File;
+	size_t	Length;
+	int		Result;
+
+	if(( File = fopen( Path, "rb" )) == NULL )
+		return -1;
+
+	*Hash	= HASH_INITIAL;
+	while(( Length = fread( Buffer, 1, sizeof Buffer, File )) > 0 )
+		*Hash	= HashBytes( *Hash, Buffer, Length );
+
+	Result	= ferror( File ) ? -1 : 0;
+	fclose( File );
+
+	return Result;
+	}
+/*============================================================================*/
+/*
+Tells whether the existing output has the same bytes just written. The sizes
+are compared first, then the hashes. The one of the existing file is taken from
+the manifest if the file is as the manifest left it, otherwise the file must be
+read.
+*/
+static int IsSameAsExisting( const outputfile_t *Output )
+	{
+	const manifestentry_t	*Entry;
+	manifestentry_t			OnDisk;
+	uint64_t				Hash;
+
+	if( StatOutput( Output->Path, &OnDisk ) != 0 || OnDisk.Size != Output->Size )
+		return 0;
+
+	if( Output->Manifest != NULL && ( Entry = FindPrevious( Output->Manifest, Output->Name )) != NULL && IsUntouched( Entry, &OnDisk ))
+		return Entry->Hash == Output->Hash;
+
+	return HashFile( Output->Path, &Hash ) == 0 && Hash == Output->Hash;
+	}
+/*============================================================================*/
+int EndOutputFile( void *UserData )
+	{
+	outputfile_t	*Output	= UserData;
+	char			BkpPath[256+sizeof ".cvt_bak"];
+	manifestentry_t	OnDisk	= { "" };
+	int				Result;
+
+	Result			= fclose( Output->File );
+	Output->File	= NULL;
+
+	if( Result != 0 )
+		{
+		remove( Output->TmpPath );
+		return -1;
+		}
+
+	/* Nothing changed, the file and its time stamps are left as they are. */
+	if( IsSameAsExisting( Output ))
+		remove( Output->TmpPath );
+	else
+		{
+		strcpy( BkpPath, Output->Path );
+		strcat( BkpPath, ".cvt_bak" );
+
+		remove( BkpPath );
+		rename( Output->Path, BkpPath );
+		rename( Output->TmpPath, Output->Path );
+		}
+
+	/* An output that cannot be looked at is recorded as changed, next time it is read to be compared. */
+	if( Output->Manifest != NULL )
+		{
+		StatOutput( Output->Path, &OnDisk );
+		AddManifestEntry( Output->Manifest, Output->Name, Output->Manifest->Fingerprint, Output->Hash, &OnDisk );
+		}
+
+	return 0;
+	}
+/*============================================================================*/
+void AbortOutputFile( outputfile_t *Output )
+	{
+	if( Output->File == NULL )
+		return;
+
+	fclose( Output->File );
+	Output->File	= NULL;
+
+	remove( Output->TmpPath );
+	}
+/*============================================================================*/
+int VOutputFormatted( cookie_t *Cookie, const pcadsch_writer_t *Writer, unsigned Level, const char *Format, va_list ap )
+	{
+	static const char	Tabs[]	= "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+	char				Local[1024], *Buffer = Local;
+	va_list				Copy;
+	int					Length, Result;
+
+	va_copy( Copy, ap );
+
+	/* Most lines fit the local buffer, only the longer ones need to be formatted again. */
+	if(( Length = vsnprintf( Local, sizeof Local, Format, ap )) >= (int)sizeof Local )
+		{
+		if(( Buffer = malloc( Length + 1 )) == NULL )
+			{
+			va_end( Copy );
+			ErrorOutput( Cookie, -1, "Not enough memory" );
+			}
+		vsnprintf( Buffer, Length + 1, Format, Copy );
+		}
+
+	va_end( Copy );
+
+	if( Length < 0 )
+		ErrorOutput( Cookie, -1, "Invalid output format" );
+
+	if( Level > sizeof Tabs - 1 )
+		Level	= sizeof Tabs - 1;
+
+	Result	= ( Level > 0 && Writer->Write( Writer->UserData, Tabs, Level ) != 0 ) || Writer->Write( Writer->UserData, Buffer, Length ) != 0;
+
+	if( Buffer != Local )
+		free( Buffer );
+
+	if( Result != 0 )
+		ErrorOutput( Cookie, -1, "Error writing the output" );
+
+	Cookie->Stats.BytesWritten	+= Level + Length;
+
+	return Length;
+	}
+/*============================================================================*/
+void WriteJSONString( FILE *File, const char *s )
+	{
+	fputc( '"', File );
+	for( ; *s != '\0'; s++ )
+		if( *s == '"' || *s == '\\' )
+			fprintf( File, "\\%c", *s );
+		else if( (unsigned char)*s < 0x20 )
+			fprintf( File, "\\u%04x", *s );
+		else
+			fputc( *s, File );
+	fputc( '"', File );
+	}
+/*============================================================================*/
@@ -0,0 +1,106 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#if			!defined __OUTPUTFILE_H__
+#define __OUTPUTFILE_H__
+/*============================================================================*/
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include "PCADSch.h"
+#include "PCADParser.h"
+/*============================================================================*/
+typedef struct
+	{
+	char				Name[256];
+	uint64_t			Fingerprint;
+	/* The length and the hash of the bytes of the output. */
+	uint64_t			Size;
+	uint64_t			Hash;
+	/* The file as it was left, in nanoseconds, a file changed since cannot be trusted to hold those bytes. */
+	int64_t				Time;
+	uint64_t			Inode;
+	} manifestentry_t;
+/*----------------------------------------------------------------------------*/
+/*
+The sidecar manifest remembers the fingerprint of the inputs of each output
+written by the last conversion, an output whose fingerprint did not change
+need not be produced again. It also remembers the hash of the bytes of each
+output, so an output produced again can be compared without reading the file.
+Both hold only while the file keeps the size, time and inode it was left with.
+*/
+typedef struct
+	{
+	char				Path[256];
+	size_t				NumPrevious;
+	manifestentry_t		*Previous;
+	size_t				NumCurrent;
+	size_t				AllocatedCurrent;
+	manifestentry_t		*Current;
+	/* The fingerprint of the output being written. */
+	uint64_t			Fingerprint;
+	} manifest_t;
+/*============================================================================*/
+/*
+A writer that creates files: each output goes first to "<Base><Name>.cvt_tmp"
+and only when it is complete it replaces "<Base><Name><Ext>", whose previous
+contents are kept in "<Base><Name><Ext>.cvt_bak". If the bytes are the same as
+the existing file's, the existing file is left untouched.
+*/
+typedef struct
+	{
+	FILE				*File;
+	char				Base[256];
+	char				Ext[256];
+	char				Name[256];
+	char				Path[256];
+	char				TmpPath[256];
+	/* The length and the hash of what was written so far. */
+	uint64_t			Size;
+	uint64_t			Hash;
+	/* Optional, the outputs written are recorded in it. */
+	manifest_t			*Manifest;
+	} outputfile_t;
+/*============================================================================*/
+int		BeginOutputFile		( void *UserData, const char *Name );
+int		WriteOutputFile		( void *UserData, const void *Data, size_t Length );
+int		EndOutputFile		( void *UserData );
+void	AbortOutputFile		( outputfile_t *Output );
+
+/* A missing or invalid manifest is just empty, everything gets written. */
+void	LoadManifest		( manifest_t *Manifest, const char *Path );
+/* Returns non-zero if the output "Name" exists and was written from inputs with the same fingerprint. */
+int		IsOutputUpToDate	( outputfile_t *Output, const char *Name, uint64_t Fingerprint );
+/* Writes the outputs of this conversion, if they are not the same as before. */
+int		SaveManifest		( manifest_t *Manifest );
+void	ReleaseManifest		( manifest_t *Manifest );
+
+/* Writes "Level" tabs and then the formatted text, returns the length of the text. */
+int		VOutputFormatted	( cookie_t *Cookie, const pcadsch_writer_t *Writer, unsigned Level, const char *Format, va_list ap );
+/* Writes "s" as a JSON string, quoted and escaped. */
+void	WriteJSONString		( FILE *File, const char *s );
+/*============================================================================*/
+#endif	/*	!defined __OUTPUTFILE_H__ */
+/*============================================================================*/
@@ -0,0 +1,875 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "PCADDiffSchematic.h"
+#include "PCADEnums.h"
+#include "Parser.h"
+/*=============================================================================*/
+/*
+The elements compared are the items of the lists of each section of the file
+and, for the sheets and the nets, the items of their own lists. Everything else
+is part of the contents of the element holding it.
+
+Each element gets a key, from its container, its kind and a name made of the
+same fields the "Compare*" functions of PCADProcessSchematic.c sort it by, and
+a fingerprint of its contents. The elements of the two schematics are joined
+by their keys through a hash table, so the order they are in the files does
+not matter and the whole comparison takes linear time. The three-way merge
+uses the same elements, joining the three schematics two by two.
+*/
+/*=============================================================================*/
+#define	NO_ELEMENT		UINT32_MAX
+/*=============================================================================*/
+typedef struct
+	{
+	char				Text[512];
+	size_t				Length;
+	} description_t;
+/*-----------------------------------------------------------------------------*/
+typedef void (*describe_t)( description_t *Description, const void *Object );
+/*-----------------------------------------------------------------------------*/
+typedef struct
+	{
+	const char			*Tag;
+	describe_t			Describe;
+	/* The items of its lists are compared one by one, not as part of its contents. */
+	int					IsContainer;
+	} elementkind_t;
+/*-----------------------------------------------------------------------------*/
+typedef struct
+	{
+	const parsefield_t	*Field;
+	const void			*Object;
+	uint32_t			Parent;
+	uint64_t			Key;
+	/* The contents, without the elements of a container. */
+	uint64_t			Hash;
+	/* The contents, with the elements of a container. */
+	uint64_t			Deep;
+	} element_t;
+/*-----------------------------------------------------------------------------*/
+typedef struct
+	{
+	cookie_t			*Cookie;
+	element_t			*Elements;
+	uint32_t			NumElements;
+	uint32_t			Allocated;
+	/* The container of the elements being visited. */
+	uint32_t			Parent;
+	/* Each entry is the index of an element plus one, zero when empty. */
+	uint32_t			*Table;
+	uint32_t			TableMask;
+	} elementset_t;
+/*=============================================================================*/
+static void Append( description_t *Description, const char *Format, ... )
+	{
+	va_list	ap;
+	int		Length;
+
+	if( Description->Length >= sizeof Description->Text - 1 )
+		return;
+
+	va_start( ap, Format );
+	Length	= vsnprintf( &Description->Text[Description->Length], sizeof Description->Text - Description->Length, Format, ap );
+	va_end( ap );
+
+	if( Length > 0 )
+		Description->Length	+= Length;
+	if( Description->Length > sizeof Description->Text - 1 )
+		Description->Length	= sizeof Description->Text - 1;
+	}
+/*=============================================================================*/
+/* Dimmensions are in nanometers and reals in millionths, both go out with the trailing zeros removed. */
+static char *FormatMillionths( char *Buffer, int32_t Value )
+	{
+	uint32_t	Magnitude	= Value < 0 ? -(uint32_t)Value : (uint32_t)Value;
+	char		*p;
+
+	p	= Buffer + sprintf( Buffer, "%s%u.%06u", Value < 0 ? "-" : "", (unsigned)( Magnitude / 1000000 ), (unsigned)( Magnitude % 1000000 ));
+	while( p[-1] == '0' )
+		*--p	= '\0';
+	if( p[-1] == '.' )
+		p[-1]	= '\0';
+
+	return Buffer;
+	}
+/*=============================================================================*/
+static void AppendString( description_t *Description, const char *Prefix, const char *String )
+	{
+	Append( Description, "%s\"%s\"", Prefix, String != NULL ? String : "" );
+	}
+/*=============================================================================*/
+static void AppendReal( description_t *Description, const char *Prefix, pcad_real_t Value )
+	{
+	char	Buffer[16];
+
+	Append( Description, "%s%s", Prefix, FormatMillionths( Buffer, Value ));
+	}
+/*=============================================================================*/
+static void AppendPoint( description_t *Description, const char *Prefix, const pcad_point_t *Point )
+	{
+	char	x[16], y[16];
+
+	Append( Description, "%s(%s %s)", Prefix, FormatMillionths( x, Point->x ), FormatMillionths( y, Point->y ));
+	}
+/*=============================================================================*/
+/* The ends of wires, buses and lines may come in any order, the segment is the same. */
+static void AppendSegment( description_t *Description, const char *Prefix, const pcad_point_t *Point1, const pcad_point_t *Point2 )
+	{
+	const pcad_point_t	*Temp;
+
+	if( Point1->x > Point2->x || ( Point1->x == Point2->x && Point1->y > Point2->y ))
+		{
+		Temp	= Point1;
+		Point1	= Point2;
+		Point2	= Temp;
+		}
+
+	AppendPoint( Description, Prefix, Point1 );
+	AppendPoint( Description, "-", Point2 );
+	}
+/*=============================================================================*/
+static void AppendEnum( description_t *Description, const char *Prefix, const parseenum_t *Enum, unsigned Value )
+	{
+	if( Value < Enum->numitems && Enum->items[Value] != NULL )
+		Append( Description, "%s%s", Prefix, Enum->items[Value] );
+	else
+		Append( Description, "%s%u", Prefix, Value );
+	}
+/*=============================================================================*/
+/*=============================================================================*/
+static void DescribeName( description_t *Description, const void *Object )
+	{
+	/* All the elements named only by their name have it as their first field. */
+	AppendString( Description, "", *(char * const *)Object );
+	}
+/*=============================================================================*/
+static void DescribeNode( description_t *Description, const void *Object )
+	{
+	const pcad_node_t	*Node	= Object;
+
+	AppendString( Description, "", Node->component );
+	AppendString( Description, " pin ", Node->pin );
+	}
+/*=============================================================================*/
+static void DescribeWire( description_t *Description, const void *Object )
+	{
+	const pcad_wire_t	*Wire	= Object;
+
+	AppendString( Description, "net ", Wire->netnameref );
+	AppendSegment( Description, " ", &Wire->pt1, &Wire->pt2 );
+	}
+/*=============================================================================*/
+static void DescribeBus( description_t *Description, const void *Object )
+	{
+	const pcad_bus_t	*Bus	= Object;
+
+	AppendString( Description, "", Bus->name );
+	AppendSegment( Description, " ", &Bus->pt1, &Bus->pt2 );
+	}
+/*=============================================================================*/
+static void DescribeSymbol( description_t *Description, const void *Object )
+	{
+	const pcad_symbol_t	*Symbol	= Object;
+
+	AppendString( Description, "", Symbol->refdesref );
+	Append( Description, " part %u", (unsigned)Symbol->partnum );
+	AppendString( Description, " ", Symbol->symbolref );
+	}
+/*=============================================================================*/
+static void DescribeJunction( description_t *Description, const void *Object )
+	{
+	const pcad_junction_t	*Junction	= Object;
+
+	AppendString( Description, "net ", Junction->netnameref );
+	AppendPoint( Description, " ", &Junction->point );
+	}
+/*=============================================================================*/
+static void DescribeBusEntry( description_t *Description, const void *Object )
+	{
+	const pcad_busentry_t	*BusEntry	= Object;
+
+	AppendString( Description, "bus ", BusEntry->busnameref );
+	AppendPoint( Description, " ", &BusEntry->point );
+	AppendEnum( Description, " ", &Orients, BusEntry->orient );
+	}
+/*=============================================================================*/
+static void DescribePort( description_t *Description, const void *Object )
+	{
+	const pcad_port_t	*Port	= Object;
+
+	AppendString( Description, "net ", Port->netnameref );
+	AppendPoint( Description, " ", &Port->point );
+	AppendReal( Description, " rotation ", Port->rotation );
+	}
+/*=============================================================================*/
+static void DescribeText( description_t *Description, const void *Object )
+	{
+	const pcad_text_t	*Text	= Object;
+
+	AppendString( Description, "", Text->value );
+	AppendPoint( Description, " ", &Text->point );
+	AppendEnum( Description, " ", &Justify, Text->justify );
+	AppendReal( Description, " rotation ", Text->rotation );
+	}
+/*=============================================================================*/
+static void DescribeArc( description_t *Description, const void *Object )
+	{
+	const pcad_triplepointarc_t	*Arc	= Object;
+
+	AppendPoint( Description, "", &Arc->point1 );
+	AppendPoint( Description, " ", &Arc->point2 );
+	AppendPoint( Description, " ", &Arc->point3 );
+	}
+/*=============================================================================*/
+static void DescribeLine( description_t *Description, const void *Object )
+	{
+	const pcad_line_t	*Line	= Object;
+
+	AppendSegment( Description, "", &Line->pt1, &Line->pt2 );
+	}
+/*=============================================================================*/
+static void DescribePin( description_t *Description, const void *Object )
+	{
+	const pcad_pin_t	*Pin	= Object;
+
+	Append( Description, "%u", (unsigned)Pin->pinnum );
+	if( Pin->defaultpindes != NULL )
+		AppendString( Description, " ", Pin->defaultpindes );
+	AppendPoint( Description, " ", &Pin->point );
+	}
+/*=============================================================================*/
+static void DescribeRefPoint( description_t *Description, const void *Object )
+	{
+	const pcad_refpoint_t	*RefPoint	= Object;
+
+	AppendPoint( Description, "", &RefPoint->point );
+	}
+/*=============================================================================*/
+static void DescribeIEEESymbol( description_t *Description, const void *Object )
+	{
+	const pcad_ieeesymbol_t	*IEEESymbol	= Object;
+
+	AppendPoint( Description, "", &IEEESymbol->point );
+	}
+/*=============================================================================*/
+/* The points are not sorted yet, this is their bounding rectangle. */
+static void DescribePoly( description_t *Description, const void *Object )
+	{
+	const pcad_poly_t		*Poly	= Object;
+	const pcad_polypoint_t	*Point;
+	pcad_point_t			Min, Max;
+	unsigned				Count;
+
+	if(( Point = Poly->firstpoint ) == NULL )
+		{
+		Append( Description, "0 points" );
+		return;
+		}
+
+	Min	= Max = Point->point;
+	for( Count = 0; Point != NULL; Count++, Point = Point->next )
+		{
+		if( Point->point.x < Min.x )
+			Min.x	= Point->point.x;
+		if( Point->point.y < Min.y )
+			Min.y	= Point->point.y;
+		if( Point->point.x > Max.x )
+			Max.x	= Point->point.x;
+		if( Point->point.y > Max.y )
+			Max.y	= Point->point.y;
+		}
+
+	AppendPoint( Description, "", &Min );
+	AppendPoint( Description, "-", &Max );
+	Append( Description, " %u points", Count );
+	}
+/*=============================================================================*/
+static const elementkind_t	ElementKinds[]	=
+	{
+	/*	Tag					Describe			IsContainer */
+		{ "textStyleDef",	DescribeName,		0 },
+		{ "symbolDef",		DescribeName,		0 },
+		{ "compDef",		DescribeName,		0 },
+		{ "compInst",		DescribeName,		0 },
+		{ "net",			DescribeName,		1 },
+		{ "node",			DescribeNode,		0 },
+		{ "sheet",			DescribeName,		1 },
+		{ "junction",		DescribeJunction,	0 },
+		{ "refPoint",		DescribeRefPoint,	0 },
+		{ "wire",			DescribeWire,		0 },
+		{ "busEntry",		DescribeBusEntry,	0 },
+		{ "bus",			DescribeBus,		0 },
+		{ "port",			DescribePort,		0 },
+		{ "pin",			DescribePin,		0 },
+		{ "text",			DescribeText,		0 },
+		{ "triplePointArc",	DescribeArc,		0 },
+		{ "attr",			DescribeName,		0 },
+		{ "symbol",			DescribeSymbol,		0 },
+		{ "poly",			DescribePoly,		0 },
+		{ "line",			DescribeLine,		0 },
+		{ "ieeeSymbol",		DescribeIEEESymbol,	0 },
+		{ "field",			DescribeName,		0 }
+	};
+/*=============================================================================*/
+/* The sections of the file have no name, the kinds not in the table are known only by their contents. */
+static const elementkind_t *FindKind( const parsefield_t *Field )
+	{
+	static const elementkind_t	Unknown	= { NULL, NULL, 0 };
+	size_t						i;
+
+	for( i = 0; i < LENGTH( ElementKinds ); i++ )
+		if( strcmp( ElementKinds[i].Tag, Field->TagString ) == 0 )
+			return &ElementKinds[i];
+
+	return &Unknown;
+	}
+/*=============================================================================*/
+static void Describe( description_t *Description, const element_t *Element )
+	{
+	const elementkind_t	*Kind	= FindKind( Element->Field );
+
+	Description->Text[0]	= '\0';
+	Description->Length		= 0;
+
+	if( Kind->Describe != NULL )
+		Kind->Describe( Description, Element->Object );
+	}
+/*=============================================================================*/
+static uint32_t AddElement( elementset_t *Set, const parsefield_t *Field, const void *Object )
+	{
+	element_t	*p;
+	uint32_t	Allocated;
+
+	if( Set->NumElements >= Set->Allocated )
+		{
+		Allocated	= Set->Allocated > 0 ? 2 * Set->Allocated : 1024;
+		if(( p = realloc( Set->Elements, Allocated * sizeof( element_t ))) == NULL )
+			ErrorOutput( Set->Cookie, -1, "Not enough memory" );
+		Set->Elements	= p;
+		Set->Allocated	= Allocated;
+		}
+
+	p			= &Set->Elements[Set->NumElements];
+	p->Field	= Field;
+	p->Object	= Object;
+	p->Parent	= Set->Parent;
+
+	return Set->NumElements++;
+	}
+/*=============================================================================*/
+static int VisitElement( void *UserData, const parsefield_t *Field, const void *Item )
+	{
+	elementset_t		*Set	= UserData;
+	const elementkind_t	*Kind	= FindKind( Field );
+	description_t		Description;
+	element_t			*Element;
+	uint32_t			Index, Parent;
+	uint64_t			Key;
+
+	Index	= AddElement( Set, Field, Item );
+	Element	= &Set->Elements[Index];
+	Parent	= Element->Parent;
+
+	/* The key of the container makes the keys of the elements of different sheets different. */
+	Key		= HashBytes( HASH_INITIAL, &Set->Elements[Parent].Key, sizeof Set->Elements[Parent].Key );
+	Key		= HashString( Key, Field->TagString );
+
+	if( Kind->Describe != NULL )
+		{
+		Describe( &Description, Element );
+		Element->Key	= HashString( Key, Description.Text );
+		}
+	/* Without a name, equal contents are the same element and different contents are different elements. */
+	else
+		Element->Key	= HashPCAD( Key, Field->ParseStruct, Item, 1 );
+
+	Element->Hash	= HashPCAD( HASH_INITIAL, Field->ParseStruct, Item, !Kind->IsContainer );
+	Element->Deep	= Kind->IsContainer ? HashPCAD( HASH_INITIAL, Field->ParseStruct, Item, 1 ) : Element->Hash;
+
+	if( Kind->IsContainer )
+		{
+		Set->Parent	= Index;
+		VisitLists( Field->ParseStruct, Item, VisitElement, Set );
+		Set->Parent	= Parent;
+		}
+
+	return 0;
+	}
+/*=============================================================================*/
+/* The sections are the only elements without a container, each one is always there, empty if it was not parsed. */
+static void CollectElements( elementset_t *Set, const pcad_schematicfile_t *Schematic )
+	{
+	const parsestruct_t	*ParseStruct	= GetPCADParseStruct();
+	const parsefield_t	*Field;
+	element_t			*Element;
+	uint32_t			Index;
+	int					i;
+
+	for( i = 0; i < ParseStruct->NumFixedFields; i++ )
+		{
+		Field	= &ParseStruct->FixedFields[i];
+		if( Field->Offset < 0 || Field->Length != 0 || Field->ParseStruct == NULL || Field->ParseStruct->NumLists == 0 )
+			continue;
+
+		Set->Parent		= NO_ELEMENT;
+		Index			= AddElement( Set, Field, (const char*)Schematic + Field->Offset );
+		Element			= &Set->Elements[Index];
+		Element->Key	= HashString( HASH_INITIAL, Field->TagString );
+		Element->Hash	= HashPCAD( HASH_INITIAL, Field->ParseStruct, Element->Object, 0 );
+		Element->Deep	= HashPCAD( HASH_INITIAL, Field->ParseStruct, Element->Object, 1 );
+
+		Set->Parent		= Index;
+		VisitLists( Field->ParseStruct, Element->Object, VisitElement, Set );
+		}
+	}
+/*=============================================================================*/
+static void BuildTable( elementset_t *Set )
+	{
+	uint32_t	Size, i, j;
+
+	for( Size = 16; Size < 2 * Set->NumElements; Size *= 2 )
+		{}
+
+	if(( Set->Table = calloc( Size, sizeof( uint32_t ))) == NULL )
+		ErrorOutput( Set->Cookie, -1, "Not enough memory" );
+	Set->TableMask	= Size - 1;
+
+	for( i = 0; i < Set->NumElements; i++ )
+		{
+		for( j = Set->Elements[i].Key & Set->TableMask; Set->Table[j] != 0; j = ( j + 1 ) & Set->TableMask )
+			{}
+		Set->Table[j]	= i + 1;
+		}
+	}
+/*=============================================================================*/
+/* Finds an element of "Set" not matched yet with the same key as "Element" and, if "SameContents" is not zero, the same contents. */
+static uint32_t FindMatch( const elementset_t *Set, const uint32_t *Matches, const element_t *Element, int SameContents )
+	{
+	const element_t	*Candidate;
+	uint32_t		i, j;
+
+	for( j = Element->Key & Set->TableMask; Set->Table[j] != 0; j = ( j + 1 ) & Set->TableMask )
+		{
+		i			= Set->Table[j] - 1;
+		Candidate	= &Set->Elements[i];
+		if( Candidate->Key == Element->Key && Matches[i] == NO_ELEMENT && ( !SameContents || Candidate->Deep == Element->Deep ))
+			return i;
+		}
+
+	return NO_ELEMENT;
+	}
+/*=============================================================================*/
+static uint32_t *AllocateMatches( const elementset_t *Set )
+	{
+	uint32_t	*Matches, i;
+
+	if(( Matches = malloc(( Set->NumElements + 1 ) * sizeof( uint32_t ))) == NULL )
+		ErrorOutput( Set->Cookie, -1, "Not enough memory" );
+
+	for( i = 0; i < Set->NumElements; i++ )
+		Matches[i]	= NO_ELEMENT;
+
+	return Matches;
+	}
+/*=============================================================================*/
+/* "From" gets, for each element of "Set", the one of "To" it corresponds to, and "Back" the other way round. "To" must have its table built. */
+static void MatchElements( const elementset_t *Set, const elementset_t *To, uint32_t *From, uint32_t *Back )
+	{
+	uint32_t	Pass, i, j;
+
+	/* The unchanged elements are matched first, so that elements with the same key pair up by their contents when they can. */
+	for( Pass = 0; Pass < 2; Pass++ )
+		for( i = 0; i < Set->NumElements; i++ )
+			if( From[i] == NO_ELEMENT && ( j = FindMatch( To, Back, &Set->Elements[i], Pass == 0 )) != NO_ELEMENT )
+				{
+				From[i]	= j;
+				Back[j]	= i;
+				}
+	}
+/*=============================================================================*/
+static void DescribeContainer( description_t *Container, const elementset_t *Set, uint32_t Index )
+	{
+	const element_t	*Element	= &Set->Elements[Index];
+	description_t	Description;
+
+	Container->Text[0]	= '\0';
+	Container->Length	= 0;
+
+	if( Element->Parent != NO_ELEMENT )
+		{
+		Describe( &Description, &Set->Elements[Element->Parent] );
+		Append( Container, "%s%s%s", Set->Elements[Element->Parent].Field->TagString, Description.Length > 0 ? " " : "", Description.Text );
+		}
+	}
+/*=============================================================================*/
+static int Report( const elementset_t *Set, uint32_t Index, pcadsch_change_t Change, pcadsch_diff_t Callback, void *UserData )
+	{
+	const element_t	*Element	= &Set->Elements[Index];
+	description_t	Description, Container;
+
+	DescribeContainer( &Container, Set, Index );
+	Describe( &Description, Element );
+
+	return Callback( UserData, Change, Element->Parent != NO_ELEMENT ? Container.Text : NULL, Element->Field->TagString, Description.Text );
+	}
+/*=============================================================================*/
+/* An element whose container is not in the other schematic goes with the container. */
+static int IsReported( const elementset_t *Set, const uint32_t *Matches, uint32_t Index )
+	{
+	uint32_t	Parent	= Set->Elements[Index].Parent;
+
+	return Parent == NO_ELEMENT || Matches[Parent] != NO_ELEMENT;
+	}
+/*=============================================================================*/
+/* The removed and changed elements go in the order of the old schematic, then the added ones in the order of the new one. */
+static int ReportChanges( const elementset_t *Old, const elementset_t *New, const uint32_t *OldMatches, const uint32_t *NewMatches, pcadsch_diff_t Callback, void *UserData )
+	{
+	uint32_t	i;
+	int			Result, Count = 0;
+
+	for( i = 0; i < Old->NumElements; i++ )
+		{
+		if( !IsReported( Old, OldMatches, i ))
+			continue;
+		if( OldMatches[i] == NO_ELEMENT )
+			Result	= Report( Old, i, PCADSCH_REMOVED, Callback, UserData );
+		else if( Old->Elements[i].Hash != New->Elements[OldMatches[i]].Hash )
+			Result	= Report( New, OldMatches[i], PCADSCH_CHANGED, Callback, UserData );
+		else
+			continue;
+		if( Result != 0 )
+			return Result;
+		Count++;
+		}
+
+	for( i = 0; i < New->NumElements; i++ )
+		{
+		if( NewMatches[i] != NO_ELEMENT || !IsReported( New, NewMatches, i ))
+			continue;
+		if(( Result = Report( New, i, PCADSCH_ADDED, Callback, UserData )) != 0 )
+			return Result;
+		Count++;
+		}
+
+	return Count;
+	}
+/*=============================================================================*/
+/* Everything allocated by a comparison, so that it can be released even after an error. */
+typedef struct
+	{
+	elementset_t		Sets[3];
+	uint32_t			*Matches[6];
+	} comparison_t;
+/*-----------------------------------------------------------------------------*/
+static void InitComparison( comparison_t *Comparison, cookie_t *Cookie )
+	{
+	int	i;
+
+	memset( Comparison, 0, sizeof *Comparison );
+	for( i = 0; i < LENGTH( Comparison->Sets ); i++ )
+		Comparison->Sets[i].Cookie	= Cookie;
+	}
+/*-----------------------------------------------------------------------------*/
+static void ReleaseComparison( comparison_t *Comparison )
+	{
+	int	i;
+
+	for( i = 0; i < LENGTH( Comparison->Sets ); i++ )
+		{
+		free( Comparison->Sets[i].Elements );
+		free( Comparison->Sets[i].Table );
+		}
+	for( i = 0; i < LENGTH( Comparison->Matches ); i++ )
+		free( Comparison->Matches[i] );
+	}
+/*=============================================================================*/
+int DiffPCAD( cookie_t *Cookie, const pcad_schematicfile_t *Old, const pcad_schematicfile_t *New, pcadsch_diff_t Callback, void *UserData )
+	{
+	comparison_t	Comparison;
+	elementset_t	*Sets	= Comparison.Sets;
+	uint32_t		**Matches	= Comparison.Matches;
+	jmp_buf			Caller;
+	int				Result;
+
+	InitComparison( &Comparison, Cookie );
+
+	memcpy( Caller, Cookie->JumpBuffer, sizeof Caller );
+
+	if( setjmp( Cookie->JumpBuffer ) == 0 )
+		{
+		CollectElements( &Sets[0], Old );
+		CollectElements( &Sets[1], New );
+
+		BuildTable( &Sets[1] );
+		Matches[0]	= AllocateMatches( &Sets[0] );
+		Matches[1]	= AllocateMatches( &Sets[1] );
+		MatchElements( &Sets[0], &Sets[1], Matches[0], Matches[1] );
+
+		Result	= ReportChanges( &Sets[0], &Sets[1], Matches[0], Matches[1], Callback, UserData );
+		}
+	else
+		Result	= Cookie->LastError.Code;
+
+	memcpy( Cookie->JumpBuffer, Caller, sizeof Caller );
+
+	ReleaseComparison( &Comparison );
+
+	return Result;
+	}
+/*=============================================================================*/
+/*
+Three-way merge: "Ours" takes every change "Theirs" made to "Base" that does not
+clash with a change of its own. An element is in conflict only when both sides
+changed it in different ways, then it is left as in "Ours" and reported.
+*/
+/*-----------------------------------------------------------------------------*/
+enum { BASE, OURS, THEIRS };
+enum { OURS_TO_BASE, BASE_TO_OURS, THEIRS_TO_BASE, BASE_TO_THEIRS, THEIRS_TO_OURS, OURS_TO_THEIRS };
+/*-----------------------------------------------------------------------------*/
+typedef struct
+	{
+	comparison_t		Comparison;
+	/* The elements of "Ours" to be unlinked, each entry is NULL when empty. */
+	const void			**Removed;
+	uint32_t			RemovedMask;
+	pcadsch_conflict_t	Callback;
+	void				*UserData;
+	int					Conflicts;
+	} merge_t;
+/*-----------------------------------------------------------------------------*/
+/* The sections are inside the file, not in lists, their sizes are not in the tables. */
+static const struct
+	{
+	const char			*Tag;
+	size_t				Size;
+	} SectionSizes[]	=
+	{
+		{ "library",			sizeof( pcad_library_t ) },
+		{ "netlist",			sizeof( pcad_netlist_t ) },
+		{ "schematicDesign",	sizeof( pcad_schematicdesign_t ) }
+	};
+/*=============================================================================*/
+static size_t ElementSize( const element_t *Element )
+	{
+	int	i;
+
+	if( Element->Field->Length > 0 )
+		return Element->Field->Length;
+
+	for( i = 0; i < LENGTH( SectionSizes ); i++ )
+		if( strcmp( SectionSizes[i].Tag, Element->Field->TagString ) == 0 )
+			return SectionSizes[i].Size;
+
+	return 0;
+	}
+/*=============================================================================*/
+static uint32_t HashPointer( const void *Pointer )
+	{
+	return (uint32_t)((( (uintptr_t)Pointer >> 3 ) * UINT64_C( 0x9e3779b97f4a7c15 )) >> 32 );
+	}
+/*=============================================================================*/
+static void RemoveElement( merge_t *Merge, const element_t *Element )
+	{
+	uint32_t	j;
+
+	for( j = HashPointer( Element->Object ) & Merge->RemovedMask; Merge->Removed[j] != NULL && Merge->Removed[j] != Element->Object; j = ( j + 1 ) & Merge->RemovedMask )
+		{}
+	Merge->Removed[j]	= Element->Object;
+	}
+/*=============================================================================*/
+static int IsRemoved( void *UserData, const void *Item )
+	{
+	const merge_t	*Merge	= UserData;
+	uint32_t		j;
+
+	for( j = HashPointer( Item ) & Merge->RemovedMask; Merge->Removed[j] != NULL; j = ( j + 1 ) & Merge->RemovedMask )
+		if( Merge->Removed[j] == Item )
+			return 1;
+
+	return 0;
+	}
+/*=============================================================================*/
+/* The contents of a container are replaced without its elements, they are merged one by one. */
+static void ReplaceElement( merge_t *Merge, const element_t *Ours, const element_t *Theirs )
+	{
+	const elementkind_t	*Kind	= FindKind( Ours->Field );
+	int					IsContainer	= Kind->IsContainer || Ours->Parent == NO_ELEMENT;
+
+	if( CopyStruct( Ours->Field->ParseStruct, (void*)Ours->Object, Theirs->Object, ElementSize( Ours ), !IsContainer ) != 0 )
+		ErrorOutput( Merge->Comparison.Sets[OURS].Cookie, -1, "Internal error, \"%s\" has more than %d lists", Kind->Tag, MAX_LISTS );
+	}
+/*=============================================================================*/
+static void Conflict( merge_t *Merge, const elementset_t *Set, uint32_t Index, pcadsch_change_t Ours, pcadsch_change_t Theirs )
+	{
+	const element_t	*Element	= &Set->Elements[Index];
+	description_t	Description, Container;
+
+	Merge->Conflicts++;
+
+	if( Merge->Callback == NULL )
+		return;
+
+	DescribeContainer( &Container, Set, Index );
+	Describe( &Description, Element );
+
+	if( Merge->Callback( Merge->UserData, Ours, Theirs, Element->Parent != NO_ELEMENT ? Container.Text : NULL, Element->Field->TagString, Description.Text ) != 0 )
+		Merge->Callback	= NULL;
+	}
+/*=============================================================================*/
+static void MergeElements( merge_t *Merge )
+	{
+	const elementset_t	*Sets		= Merge->Comparison.Sets;
+	uint32_t			**Matches	= Merge->Comparison.Matches;
+	const element_t		*Base, *Ours, *Theirs;
+	uint32_t			i, Parent;
+
+	/* The elements in "Base": changed or removed by either side. */
+	for( i = 0; i < Sets[BASE].NumElements; i++ )
+		{
+		/* An element of a container removed by either side goes with its container. */
+		Parent	= Sets[BASE].Elements[i].Parent;
+		if( Parent != NO_ELEMENT && ( Matches[BASE_TO_OURS][Parent] == NO_ELEMENT || Matches[BASE_TO_THEIRS][Parent] == NO_ELEMENT ))
+			continue;
+
+		Base	= &Sets[BASE].Elements[i];
+		Ours	= Matches[BASE_TO_OURS][i] != NO_ELEMENT ? &Sets[OURS].Elements[Matches[BASE_TO_OURS][i]] : NULL;
+		Theirs	= Matches[BASE_TO_THEIRS][i] != NO_ELEMENT ? &Sets[THEIRS].Elements[Matches[BASE_TO_THEIRS][i]] : NULL;
+
+		if( Ours == NULL && Theirs == NULL )
+			continue;
+		else if( Ours == NULL )
+			{
+			if( Theirs->Deep != Base->Deep )
+				Conflict( Merge, &Sets[THEIRS], Matches[BASE_TO_THEIRS][i], PCADSCH_REMOVED, PCADSCH_CHANGED );
+			}
+		else if( Theirs == NULL )
+			{
+			if( Ours->Deep != Base->Deep )
+				Conflict( Merge, &Sets[OURS], Matches[BASE_TO_OURS][i], PCADSCH_CHANGED, PCADSCH_REMOVED );
+			else
+				RemoveElement( Merge, Ours );
+			}
+		else if( Theirs->Hash == Base->Hash || Theirs->Hash == Ours->Hash )
+			continue;
+		else if( Ours->Hash == Base->Hash )
+			ReplaceElement( Merge, Ours, Theirs );
+		else
+			Conflict( Merge, &Sets[OURS], Matches[BASE_TO_OURS][i], PCADSCH_CHANGED, PCADSCH_CHANGED );
+		}
+
+	/* The elements added by "Theirs". */
+	for( i = 0; i < Sets[THEIRS].NumElements; i++ )
+		{
+		if( Matches[THEIRS_TO_BASE][i] != NO_ELEMENT )
+			continue;
+
+		/* Those of a container added by "Theirs" come with it. */
+		Parent	= Sets[THEIRS].Elements[i].Parent;
+		if( Parent == NO_ELEMENT || Matches[THEIRS_TO_OURS][Parent] == NO_ELEMENT )
+			continue;
+
+		Theirs	= &Sets[THEIRS].Elements[i];
+		if( Matches[THEIRS_TO_OURS][i] == NO_ELEMENT || Matches[OURS_TO_BASE][Matches[THEIRS_TO_OURS][i]] != NO_ELEMENT )
+			{
+			Ours	= &Sets[OURS].Elements[Matches[THEIRS_TO_OURS][Parent]];
+			PrependToList( Ours->Field->ParseStruct, Theirs->Field, (void*)Ours->Object, (void*)Theirs->Object );
+			}
+		/* Added by both sides. */
+		else if( Sets[OURS].Elements[Matches[THEIRS_TO_OURS][i]].Deep != Theirs->Deep )
+			Conflict( Merge, &Sets[OURS], Matches[THEIRS_TO_OURS][i], PCADSCH_ADDED, PCADSCH_ADDED );
+		}
+
+	/* Only the containers have lists. */
+	for( i = 0; i < Sets[OURS].NumElements; i++ )
+		{
+		Ours	= &Sets[OURS].Elements[i];
+		if( Ours->Parent == NO_ELEMENT || FindKind( Ours->Field )->IsContainer )
+			FilterLists( Ours->Field->ParseStruct, (void*)Ours->Object, IsRemoved, Merge );
+		}
+	}
+/*=============================================================================*/
+int MergePCAD( cookie_t *Cookie, const pcad_schematicfile_t *Base, pcad_schematicfile_t *Ours, const pcad_schematicfile_t *Theirs, pcadsch_conflict_t Callback, void *UserData )
+	{
+	merge_t			Merge;
+	elementset_t	*Sets		= Merge.Comparison.Sets;
+	uint32_t		**Matches	= Merge.Comparison.Matches;
+	jmp_buf			Caller;
+	uint32_t		Size;
+	int				Result;
+
+	InitComparison( &Merge.Comparison, Cookie );
+	Merge.Removed	= NULL;
+	Merge.Callback	= Callback;
+	Merge.UserData	= UserData;
+	Merge.Conflicts	= 0;
+
+	memcpy( Caller, Cookie->JumpBuffer, sizeof Caller );
+
+	if( setjmp( Cookie->JumpBuffer ) == 0 )
+		{
+		CollectElements( &Sets[BASE], Base );
+		CollectElements( &Sets[OURS], Ours );
+		CollectElements( &Sets[THEIRS], Theirs );
+
+		BuildTable( &Sets[BASE] );
+		BuildTable( &Sets[OURS] );
+
+		Matches[OURS_TO_BASE]	= AllocateMatches( &Sets[OURS] );
+		Matches[BASE_TO_OURS]	= AllocateMatches( &Sets[BASE] );
+		Matches[THEIRS_TO_BASE]	= AllocateMatches( &Sets[THEIRS] );
+		Matches[BASE_TO_THEIRS]	= AllocateMatches( &Sets[BASE] );
+		Matches[THEIRS_TO_OURS]	= AllocateMatches( &Sets[THEIRS] );
+		Matches[OURS_TO_THEIRS]	= AllocateMatches( &Sets[OURS] );
+
+		MatchElements( &Sets[OURS], &Sets[BASE], Matches[OURS_TO_BASE], Matches[BASE_TO_OURS] );
+		MatchElements( &Sets[THEIRS], &Sets[BASE], Matches[THEIRS_TO_BASE], Matches[BASE_TO_THEIRS] );
+		MatchElements( &Sets[THEIRS], &Sets[OURS], Matches[THEIRS_TO_OURS], Matches[OURS_TO_THEIRS] );
+
+		for( Size = 16; Size < 2 * Sets[OURS].NumElements; Size *= 2 )
+			{}
+		if(( Merge.Removed = calloc( Size, sizeof( const void* ))) == NULL )
+			ErrorOutput( Cookie, -1, "Not enough memory" );
+		Merge.RemovedMask	= Size - 1;
+
+		MergeElements( &Merge );
+
+		Result	= Merge.Conflicts;
+		}
+	else
+		Result	= Cookie->LastError.Code;
+
+	memcpy( Cookie->JumpBuffer, Caller, sizeof Caller );
+
+	ReleaseComparison( &Merge.Comparison );
+	free( Merge.Removed );
+
+	return Result;
+	}
+/*=============================================================================*/
@@ -0,0 +1,37 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#if		!defined __DIFFPCAD_H__
+#define __DIFFPCAD_H__
+/*=============================================================================*/
+#include "PCADStructs.h"
+#include "PCADParser.h"
+#include "PCADSch.h"
+/*=============================================================================*/
+int	DiffPCAD	( cookie_t *Cookie, const pcad_schematicfile_t *Old, const pcad_schematicfile_t *New, pcadsch_diff_t Report, void *UserData );
+int	MergePCAD	( cookie_t *Cookie, const pcad_schematicfile_t *Base, pcad_schematicfile_t *Ours, const pcad_schematicfile_t *Theirs, pcadsch_conflict_t Report, void *UserData );
+/*=============================================================================*/
+#endif	/*	!defined __DIFFPCAD_H__ */
+/*=============================================================================*/
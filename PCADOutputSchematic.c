@@ -31,11 +31,13 @@
 #include "PCADOutputSchematic.h"
 #include "PCADStructs.h"
 #include "Parser.h"
+#include "OutputFile.h"
+#include "Trace.h"
 /*=============================================================================*/
 typedef struct
 	{
 	cookie_t			*Cookie;
-	FILE				*File;
+	const pcadsch_writer_t	*Writer;
 	} parameters_t;
 /*=============================================================================*/
 static int FormatReal( const parameters_t *Params, unsigned FracDigs, pcad_dimmension_t Origin, pcad_real_t Scale, pcad_real_t v, char *Buffer, size_t BufferSize )
@@ -72,8 +74,7 @@ static int __attribute__((format(printf, 3, 4))) OutputToFile( const parameters_
 
 	va_start( ap, s );
 
-	fprintf( Params->File, "%.*s", Level, "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t" );
-	CharsWritten	= vfprintf( Params->File, s, ap );
+	CharsWritten	= VOutputFormatted( Params->Cookie, Params->Writer, Level, s, ap );
 
 	va_end( ap );
 
@@ -105,8 +106,10 @@ static int OutputFont( const parameters_t *Params, int Level, const pcad_font_t
 	OutputToFile( Params, Level,	"(font\r\n" );
 
 	OutputToFile( Params, Level + 1, "(fontType %s)\r\n", FontType.items[Font->fonttype%FontType.numitems] );
-	OutputToFile( Params, Level + 1, "(fontFamily %s)\r\n", Font->fontfamily );
-	OutputToFile( Params, Level + 1, "(fontFace \"%s\")\r\n", Font->fontface );
+	if( Font->fontfamily != NULL )
+		OutputToFile( Params, Level + 1, "(fontFamily %s)\r\n", Font->fontfamily );
+	if( Font->fontface != NULL )
+		OutputToFile( Params, Level + 1, "(fontFace \"%s\")\r\n", Font->fontface );
 
 	FormatReal( Params, 0, 0, 1, Font->fontheight, Buffer, sizeof Buffer );
 	OutputToFile( Params, Level + 1, "(fontHeight %s)\r\n", Buffer );
@@ -154,7 +157,10 @@ static int OutputText( const parameters_t *Params, int Level, const pcad_text_t
 	FormatReal( Params, 0, 0, 1, Text->point.x, x, sizeof x );
 	FormatReal( Params, 0, 0, 1, Text->point.y, y, sizeof y );
 
-	OutputToFile( Params, Level, "(text (pt %s %s) \"%s\" (textStyleRef \"%s\")", x, y, Text->value, Text->textstyleref );
+	OutputToFile( Params, Level, "(text (pt %s %s) \"%s\"", x, y, Text->value );
+
+	if( Text->textstyleref != NULL )
+		OutputToFile( Params, 0, " (textStyleRef \"%s\")", Text->textstyleref );
 
 	if( Text->rotation != 0 )
 		{
@@ -203,7 +209,8 @@ static int OutputAttr( int OutputPoint, const parameters_t *Params, int Level, c
 	if( Attr->justify != PCAD_JUSTIFY_LOWERLEFT )
 		OutputToFile( Params, 0, " (justify %s)", Justify.items[Attr->justify] );
 
-	OutputToFile( Params, 0, " (textStyleRef \"%s\")", Attr->textstyleref );
+	if( Attr->textstyleref != NULL )
+		OutputToFile( Params, 0, " (textStyleRef \"%s\")", Attr->textstyleref );
 
 	if( Attr->constraintunits != PCAD_UNITS_NONE )
 		OutputToFile( Params, 0, " (constraintUnits %s)", ConstraintUnits.items[Attr->constraintunits] );
@@ -346,8 +353,8 @@ static int OutputPoly( const parameters_t *Params, unsigned Level, const pcad_po
 
 	for( i = 0; i < Poly->numpoints; i++ )
 		{
-		FormatReal( Params, 0, 0, 1, Poly->viopoints[i]->x, x, sizeof x );
-		FormatReal( Params, 0, 0, 1, Poly->viopoints[i]->y, y, sizeof y );
+		FormatReal( Params, 0, 0, 1, Poly->points[i].x, x, sizeof x );
+		FormatReal( Params, 0, 0, 1, Poly->points[i].y, y, sizeof y );
 		OutputToFile( Params, 0, " (pt %s %s)", x, y );
 		}
 
@@ -414,8 +421,12 @@ static int OutputCompPin( const parameters_t *Params, int Level, const pcad_comp
 /*=============================================================================*/
 static int OutputAttachedSymbol( const parameters_t *Params, int Level, const pcad_attachedsymbol_t *AttachedSymbol )
 	{
-	OutputToFile( Params, Level, "(attachedSymbol (partNum %u) (altType %s) (symbolName \"%s\"))\r\n",
-		AttachedSymbol->partnum, AltTypes.items[AttachedSymbol->alttype], AttachedSymbol->symbolname );
+	OutputToFile( Params, Level, "(attachedSymbol (partNum %u) (altType %s)", AttachedSymbol->partnum, AltTypes.items[AttachedSymbol->alttype] );
+
+	if( AttachedSymbol->symbolname != NULL )
+		OutputToFile( Params, 0, " (symbolName \"%s\")", AttachedSymbol->symbolname );
+
+	OutputToFile( Params, 0, ")\r\n" );
 
 	return 0;
 	}
@@ -431,7 +442,10 @@ static int OutputAttachedPattern( const parameters_t *Params, int Level, const p
 	{
 	int i;
 
-	OutputToFile( Params, Level,	"(attachedPattern (patternNum %u) (patternName \"%s\")\r\n", AttachedPattern->patternnum, AttachedPattern->patternname );
+	OutputToFile( Params, Level,	"(attachedPattern (patternNum %u)", AttachedPattern->patternnum );
+	if( AttachedPattern->patternname != NULL )
+		OutputToFile( Params, 0, " (patternName \"%s\")", AttachedPattern->patternname );
+	OutputToFile( Params, 0,	"\r\n" );
 	OutputToFile( Params, Level + 1,	"(numPads %u)\r\n", AttachedPattern->numpads );
 
 	OutputToFile( Params, Level + 1,	"(padPinMap\r\n" );
@@ -449,10 +463,12 @@ static int OutputCompDef( parameters_t *Params, int Level, const pcad_compdef_t
 	int		i;
 
 	OutputToFile( Params, Level,	"(compDef \"%s\"\r\n", CompDef->name );
-	OutputToFile( Params, Level + 1,	"(originalName \"%s\")\r\n", CompDef->originalname );
+	if( CompDef->originalname != NULL )
+		OutputToFile( Params, Level + 1,	"(originalName \"%s\")\r\n", CompDef->originalname );
 
 	OutputToFile( Params, Level + 1,	"(compHeader\r\n" );
-	OutputToFile( Params, Level + 2,		"(sourceLibrary \"%s\")\r\n", CompDef->compheader.sourcelibrary );
+	if( CompDef->compheader.sourcelibrary != NULL )
+		OutputToFile( Params, Level + 2,		"(sourceLibrary \"%s\")\r\n", CompDef->compheader.sourcelibrary );
 
 	if( CompDef->compheader.comptype != PCAD_COMPTYPE_NORMAL )
 		OutputToFile( Params, Level + 2,		"(compType %s)\r\n", CompType.items[CompDef->compheader.comptype] );
@@ -464,7 +480,8 @@ static int OutputCompDef( parameters_t *Params, int Level, const pcad_compdef_t
 		OutputToFile( Params, Level + 2,	"(composition Heterogeneous)\r\n" );
 
 	OutputToFile( Params, Level + 2,		"(alts (ieeeAlt %s) (deMorganAlt %s))\r\n", CompDef->compheader.alts.ieeealt == PCAD_BOOLEAN_TRUE ? "True" : "False", CompDef->compheader.alts.demorganalt == PCAD_BOOLEAN_TRUE ? "True" : "False" );
-	OutputToFile( Params, Level + 2,		"(refDesPrefix \"%s\")\r\n", CompDef->compheader.refdesprefix );
+	if( CompDef->compheader.refdesprefix != NULL )
+		OutputToFile( Params, Level + 2,		"(refDesPrefix \"%s\")\r\n", CompDef->compheader.refdesprefix );
 	OutputToFile( Params, Level + 1,	")\r\n" );
 
 	for( i = 0; i < CompDef->numcomppins; i++ )
@@ -509,11 +526,15 @@ static int OutputASCIIHeader( const parameters_t *Params, int Level, const pcad_
 	OutputToFile( Params, Level + 1, "(asciiVersion %u %u)\r\n", ASCIIHeader->asciiversion.high, ASCIIHeader->asciiversion.low );
 	OutputToFile( Params, Level + 1, "(timeStamp %u %u %u %u %u %u)\r\n", ASCIIHeader->timestamp.year, ASCIIHeader->timestamp.month, ASCIIHeader->timestamp.day, ASCIIHeader->timestamp.hour, ASCIIHeader->timestamp.minute, ASCIIHeader->timestamp.second );
 	OutputToFile( Params, Level + 1, "(program \"%s\" \"%s\")\r\n", ASCIIHeader->program.name, ASCIIHeader->program.version );
-	OutputToFile( Params, Level + 1, "(copyright \"%s\")\r\n", ASCIIHeader->copyright );
-	OutputToFile( Params, Level + 1, "(fileAuthor \"%s\")\r\n", ASCIIHeader->fileauthor );
-	OutputToFile( Params, Level + 1, "(headerString \"%s\")\r\n", ASCIIHeader->headerstring );
+	if( ASCIIHeader->copyright != NULL )
+		OutputToFile( Params, Level + 1, "(copyright \"%s\")\r\n", ASCIIHeader->copyright );
+	if( ASCIIHeader->fileauthor != NULL )
+		OutputToFile( Params, Level + 1, "(fileAuthor \"%s\")\r\n", ASCIIHeader->fileauthor );
+	if( ASCIIHeader->headerstring != NULL )
+		OutputToFile( Params, Level + 1, "(headerString \"%s\")\r\n", ASCIIHeader->headerstring );
 	OutputToFile( Params, Level + 1, "(fileUnits mm)\r\n" );
-	OutputToFile( Params, Level + 1, "(guidString \"%s\")\r\n", ASCIIHeader->guidstring );
+	if( ASCIIHeader->guidstring != NULL )
+		OutputToFile( Params, Level + 1, "(guidString \"%s\")\r\n", ASCIIHeader->guidstring );
 	OutputToFile( Params, Level,	")\r\n" );
 
 	return 0;
@@ -525,8 +546,10 @@ static int OutputCompInst( const parameters_t *Params, int Level, const pcad_com
 
 	OutputToFile( Params, Level,	"(compInst \"%s\"\r\n", CompInst->name );
 
-	OutputToFile( Params, Level + 1, "(compRef \"%s\")\r\n", CompInst->compref );
-	OutputToFile( Params, Level + 1, "(originalName \"%s\")\r\n", CompInst->originalname );
+	if( CompInst->compref != NULL )
+		OutputToFile( Params, Level + 1, "(compRef \"%s\")\r\n", CompInst->compref );
+	if( CompInst->originalname != NULL )
+		OutputToFile( Params, Level + 1, "(originalName \"%s\")\r\n", CompInst->originalname );
 
 	if( CompInst->compvalue != NULL )
 		OutputToFile( Params, Level + 1, "(compValue \"%s\")\r\n", CompInst->compvalue );
@@ -702,7 +725,8 @@ static int OutputTitleSheet( const parameters_t *Params, int Level, const pcad_t
 
 	OutputToFile( Params, Level + 1,	"(zones\r\n" );
 	OutputToFile( Params, Level + 2,		"(isVisible %s)\r\n", TitleSheet->zones.isvisible == PCAD_BOOLEAN_TRUE ? "True" : "False" );
-	OutputToFile( Params, Level + 2,		"(textStyleRef \"%s\")\r\n", TitleSheet->zones.textstyleref );
+	if( TitleSheet->zones.textstyleref != NULL )
+		OutputToFile( Params, Level + 2,		"(textStyleRef \"%s\")\r\n", TitleSheet->zones.textstyleref );
 	OutputToFile( Params, Level + 2,		"(horizontalZones %u\r\n", TitleSheet->zones.horizontalzones.count );
 	OutputToFile( Params, Level + 3,			"(numDirection %s)\r\n", NumDirection.items[TitleSheet->zones.horizontalzones.numdirection] );
 	OutputToFile( Params, Level + 3,			"(numType %s)\r\n", NumType.items[TitleSheet->zones.horizontalzones.numtype] );
@@ -841,8 +865,10 @@ static int OutputPort( const parameters_t *Params, int Level, const pcad_port_t
 	FormatReal( Params, 0, 0, 1, Port->point.x, x, sizeof x );
 	FormatReal( Params, 0, 0, 1, Port->point.y, y, sizeof y );
 
-	OutputToFile( Params, Level, "(port (pt %s %s) (portType %s) (portPinLength %s) (netNameRef \"%s\")",
-		x, y, PortTypes.items[Port->porttype], PortPinLengths.items[Port->portpinlength], Port->netnameref );
+	OutputToFile( Params, Level, "(port (pt %s %s) (portType %s) (portPinLength %s)",
+		x, y, PortTypes.items[Port->porttype], PortPinLengths.items[Port->portpinlength] );
+	if( Port->netnameref != NULL )
+		OutputToFile( Params, 0, " (netNameRef \"%s\")", Port->netnameref );
 
 	if( Port->rotation != 0 )
 		{
@@ -899,7 +925,8 @@ static int OutputSheet( const parameters_t *Params, int Level, const pcad_sheet_
 	if( Sheet->titlesheet.zones.textstyleref != NULL )
 		OutputTitleSheet( Params, Level + 1, &Sheet->titlesheet );
 
-	OutputToFile( Params, Level + 1, "(fieldSetRef \"%s\")\r\n", Sheet->fieldsetref );
+	if( Sheet->fieldsetref != NULL )
+		OutputToFile( Params, Level + 1, "(fieldSetRef \"%s\")\r\n", Sheet->fieldsetref );
 
 	for( i = 0; i < Sheet->numsymbols; i++ )
 		OutputSymbol( Params, Level + 1, Sheet->viosymbols[i] );
@@ -998,7 +1025,8 @@ static int OutputProgramState( parameters_t *Params, int Level, const pcad_progr
 	OutputToFile( Params, Level + 2,	"(isPromptForRel %s)\r\n", ProgramState->gridstate.ispromptforrel == PCAD_BOOLEAN_TRUE ? "True" : "False" );
 	OutputToFile( Params, Level + 1,	")\r\n" );
 	OutputToFile( Params, Level + 1,	"(ecoState (ecoRecording %s))\r\n", ProgramState->ecostate.ecorecording == PCAD_BOOLEAN_TRUE ? "True" : "False" );
-	OutputToFile( Params, Level + 1,	"(currentTextStyle \"%s\")\r\n", ProgramState->currenttextstyle );
+	if( ProgramState->currenttextstyle != NULL )
+		OutputToFile( Params, Level + 1,	"(currentTextStyle \"%s\")\r\n", ProgramState->currenttextstyle );
 	OutputToFile( Params, Level,		")\r\n" );
 
 	return 0;
@@ -1063,8 +1091,10 @@ static int OutputReportDefinition( parameters_t *Params, int Level, const pcad_r
 	{
 
 	OutputToFile( Params, Level,	"(reportDefinition\r\n" );
-	OutputToFile( Params, Level + 1,	"(reportName \"%s\")\r\n", ReportDefinition->reportname );
-	OutputToFile( Params, Level + 1,	"(reportExtension \"%s\")\r\n", ReportDefinition->reportextension );
+	if( ReportDefinition->reportname != NULL )
+		OutputToFile( Params, Level + 1,	"(reportName \"%s\")\r\n", ReportDefinition->reportname );
+	if( ReportDefinition->reportextension != NULL )
+		OutputToFile( Params, Level + 1,	"(reportExtension \"%s\")\r\n", ReportDefinition->reportextension );
 
 	if( ReportDefinition->reportshowflag == PCAD_BOOLEAN_TRUE )
 		OutputToFile( Params, Level + 1,"(reportShowFlag True)\r\n" );
@@ -1080,12 +1110,14 @@ static int OutputReportDefinition( parameters_t *Params, int Level, const pcad_r
 	if( ReportDefinition->reportuseheader == PCAD_BOOLEAN_TRUE )
 		OutputToFile( Params, Level + 1,"(reportUseHeader True)\r\n" );
 
-	OutputToFile( Params, Level + 1,	"(reportHeader \"%s\")\r\n", ReportDefinition->reportheader );
+	if( ReportDefinition->reportheader != NULL )
+		OutputToFile( Params, Level + 1,	"(reportHeader \"%s\")\r\n", ReportDefinition->reportheader );
 
 	if( ReportDefinition->reportusefooter == PCAD_BOOLEAN_TRUE )
 		OutputToFile( Params, Level + 1,"(reportUseFooter True)\r\n" );
 
-	OutputToFile( Params, Level + 1,	"(reportFooter \"%s\")\r\n", ReportDefinition->reportfooter );
+	if( ReportDefinition->reportfooter != NULL )
+		OutputToFile( Params, Level + 1,	"(reportFooter \"%s\")\r\n", ReportDefinition->reportfooter );
 
 	if( ReportDefinition->reportusedesigninfo == PCAD_BOOLEAN_TRUE )
 		OutputToFile( Params, Level + 1,"(reportUseDesignInfo True)\r\n" );
@@ -1138,7 +1170,8 @@ static int OutputReportSettings( parameters_t *Params, int Level, const pcad_rep
 /*=============================================================================*/
 static int OutputSchematicDesign( parameters_t *Params, int Level, const pcad_schematicdesign_t *SchematicDesign )
 	{
-	int	i;
+	double	Start;
+	int		i;
 
 	OutputToFile( Params, 0,		"\r\n" );
 	OutputToFile( Params, Level,	"(schematicDesign \"%s\"\r\n", SchematicDesign->name );
@@ -1148,7 +1181,11 @@ static int OutputSchematicDesign( parameters_t *Params, int Level, const pcad_sc
 		OutputTitleSheet( Params, Level + 1, &SchematicDesign->titlesheet );
 
 	for( i = 0; i < SchematicDesign->numsheets; i++ )
+		{
+		Start	= TraceStart( Params->Cookie );
 		OutputSheet( Params, Level + 1, SchematicDesign->viosheets[i] );
+		TraceSpan( Params->Cookie, Start, "emit", "sheet \"%s\"", SchematicDesign->viosheets[i]->name );
+		}
 
 	OutputSchematicPrintSettings( Params, Level + 1, &SchematicDesign->schematicPrintSettings );
 	OutputProgramState( Params, Level + 1, &SchematicDesign->programstate );
@@ -1161,45 +1198,71 @@ static int OutputSchematicDesign( parameters_t *Params, int Level, const pcad_sc
 /*=============================================================================*/
 void SplitPath( const char *pFullPath, char *pPath, char *pName, char *pExt );
 /*=============================================================================*/
-int OutputPCAD( cookie_t *Cookie, pcad_schematicfile_t *PCADSchematic, const char *pName )
+int EmitPCAD( cookie_t *Cookie, pcad_schematicfile_t *PCADSchematic, const pcadsch_writer_t *Writer )
 	{
 	parameters_t	Params;
-	char			Path[256], Name[256], Ext[256], BkpPath[256], TmpPath[256];
+	double			Start;
 
 	Params.Cookie	= Cookie;
+	Params.Writer	= Writer;
 
-	SplitPath( pName, Path, Name, Ext );
-	if( stricmp( Ext, "" ) == 0 )
-		strcpy( Ext, ".sch" );
-
-	strcat( Path, Name );
-	strcat( Path, ".sort" );
-
-	strcpy( TmpPath, Path );
-	strcat( TmpPath, ".cvt_tmp" );
-
-	if(( Params.File = fopen( TmpPath, "wb" )) == NULL )
-		ErrorOutput( Cookie, -1, "Error creating file %s", TmpPath );
+	if( Writer->Begin != NULL && Writer->Begin( Writer->UserData, NULL ) != 0 )
+		ErrorOutput( Cookie, -1, "Error creating the output" );
 
 	OutputToFile( &Params, 0, "ACCEL_ASCII \"%s\"\r\n", PCADSchematic->name );
 
 	OutputASCIIHeader( &Params, 0, &PCADSchematic->asciiheader );
+
+	Start	= TraceStart( Cookie );
 	OutputLibrary( &Params, 0, &PCADSchematic->library );
+	TraceSpan( Cookie, Start, "emit", "library" );
+
+	Start	= TraceStart( Cookie );
 	if( PCADSchematic->netlist.vionets != NULL || PCADSchematic->netlist.viocompinsts != NULL )
 		OutputNetList( &Params, 0, &PCADSchematic->netlist );
+	TraceSpan( Cookie, Start, "emit", "netlist" );
+
+	Start	= TraceStart( Cookie );
 	OutputSchematicDesign( &Params, 0, &PCADSchematic->schematicdesign );
+	TraceSpan( Cookie, Start, "emit", "schematicDesign" );
 
-	fclose( Params.File );
+	if( Writer->End != NULL && Writer->End( Writer->UserData ) != 0 )
+		ErrorOutput( Cookie, -1, "Error writing the output" );
 
-	strcat( Path, Ext );
+	return 0;
+	}
+/*=============================================================================*/
+int OutputPCAD( cookie_t *Cookie, pcad_schematicfile_t *PCADSchematic, const char *pName )
+	{
+	outputfile_t		Output;
+	pcadsch_writer_t	Writer	= { BeginOutputFile, WriteOutputFile, EndOutputFile, &Output };
+	char				Name[256];
+	jmp_buf				Caller;
+	int					Result;
 
-	strcpy( BkpPath, Path );
-	strcat( BkpPath, ".cvt_bak" );
+	SplitPath( pName, Output.Base, Name, Output.Ext );
+	if( stricmp( Output.Ext, "" ) == 0 )
+		strcpy( Output.Ext, ".sch" );
 
-	remove( BkpPath );
-	rename( Path, BkpPath );
-	rename( TmpPath, Path );
+	strcat( Output.Base, Name );
+	strcat( Output.Base, ".sort" );
 
-	return 0;
+	Output.File		= NULL;
+	Output.Manifest	= NULL;
+
+	/* The file being written is discarded if anything goes wrong. */
+	memcpy( Caller, Cookie->JumpBuffer, sizeof Caller );
+
+	if( setjmp( Cookie->JumpBuffer ) == 0 )
+		Result	= EmitPCAD( Cookie, PCADSchematic, &Writer );
+	else
+		{
+		AbortOutputFile( &Output );
+		Result	= Cookie->LastError.Code;
+		}
+
+	memcpy( Cookie->JumpBuffer, Caller, sizeof Caller );
+
+	return Result;
 	}
 /*=============================================================================*/
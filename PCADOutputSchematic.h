@@ -28,7 +28,9 @@
 /*=============================================================================*/
 #include "PCADStructs.h"
 #include "PCADParser.h"
+#include "PCADSch.h"
 /*=============================================================================*/
+int	EmitPCAD	( cookie_t *Cookie, pcad_schematicfile_t *PCADSchematic, const pcadsch_writer_t *Writer );
 int	OutputPCAD	( cookie_t *Cookie, pcad_schematicfile_t *PCADSchematic, const char *Name );
 /*=============================================================================*/
 #endif	/*	!defined __OUTPUTPCAD_H__ */
@@ -23,6 +23,7 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 /*============================================================================*/
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <fcntl.h>
@@ -31,7 +32,10 @@
 #include "Parser.h"
 #include "PCADParser.h"
 #include "Lexic.h"
-#include "PCADProcessSchematic.h"
+#include "Trace.h"
+#if			defined __linux__
+#include <pthread.h>
+#endif	/*	defined __linux__ */
 /*============================================================================*/
 /*============================================================================*/
 /*============================================================================*/
@@ -39,6 +43,10 @@
 /*
 The three functions below deal with special cases where the automated table-driven
 parsing is not enough.
+
+Unlike the generic parsers, these still report most of their errors through
+"Error", "ExpectToken" and friends, which jump out to the "setjmp" in
+"ParsePCAD", "ScanPCAD" or "ParseSheetJob".
 */
 /*============================================================================*/
 /*
@@ -48,7 +56,10 @@ all functions can access it.
 /*----------------------------------------------------------------------------*/
 static int Parse_FileUnits( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
 	{
-	ParseEnum( Cookie, ParseField, ParseStruct, Argument );
+	int	Result;
+
+	if(( Result = ParseEnum( Cookie, ParseField, ParseStruct, Argument )) < 0 )
+		return Result;
 
 	Cookie->FileUnits	= *(pcad_enum_units_t*)Argument;
 
@@ -59,10 +70,12 @@ static int Parse_LineInWire( cookie_t *Cookie, const parsefield_t *ParseField, c
 	{
 	char		Buffer[BUFFER_SIZE];
 	pcad_wire_t	*Wire	= Argument;
+	int			Result;
 
 	ExpectToken( Cookie, TOKEN_OPEN_PAR );
 	ExpectName( Cookie, "pt" );
-	ParseGeneric( Cookie, &ParseStruct->FixedFields[0], ParseStruct->FixedFields[0].ParseStruct, &Wire->pt1 );
+	if(( Result = ParseGeneric( Cookie, &ParseStruct->FixedFields[0], ParseStruct->FixedFields[0].ParseStruct, &Wire->pt1 )) < 0 )
+		return Result;
 	ExpectToken( Cookie, TOKEN_CLOSE_PAR );
 
 	ExpectToken( Cookie, TOKEN_OPEN_PAR );
@@ -70,7 +83,8 @@ static int Parse_LineInWire( cookie_t *Cookie, const parsefield_t *ParseField, c
 
 	if( stricmp( Buffer, "endStyle" ) == 0 )
 		{
-		ParseEnum( Cookie, &ParseStruct->FixedFields[1], ParseStruct->FixedFields[1].ParseStruct, &Wire->endstyle1 );
+		if(( Result = ParseEnum( Cookie, &ParseStruct->FixedFields[1], ParseStruct->FixedFields[1].ParseStruct, &Wire->endstyle1 )) < 0 )
+			return Result;
 		ExpectToken( Cookie, TOKEN_CLOSE_PAR );
 
 		ExpectToken( Cookie, TOKEN_OPEN_PAR );
@@ -80,7 +94,8 @@ static int Parse_LineInWire( cookie_t *Cookie, const parsefield_t *ParseField, c
 	if( strcmp( Buffer, "pt" ) != 0 )
 		Error( Cookie, -1, "Expecting \"pt\"" );
 
-	ParseGeneric( Cookie, &ParseStruct->FixedFields[2], ParseStruct->FixedFields[2].ParseStruct, &Wire->pt2 );
+	if(( Result = ParseGeneric( Cookie, &ParseStruct->FixedFields[2], ParseStruct->FixedFields[2].ParseStruct, &Wire->pt2 )) < 0 )
+		return Result;
 	ExpectToken( Cookie, TOKEN_CLOSE_PAR );
 
 	ExpectToken( Cookie, TOKEN_OPEN_PAR );
@@ -88,7 +103,8 @@ static int Parse_LineInWire( cookie_t *Cookie, const parsefield_t *ParseField, c
 
 	if( stricmp( Buffer, "endStyle" ) == 0 )
 		{
-		ParseEnum( Cookie, &ParseStruct->FixedFields[3], ParseStruct->FixedFields[3].ParseStruct, &Wire->endstyle2 );
+		if(( Result = ParseEnum( Cookie, &ParseStruct->FixedFields[3], ParseStruct->FixedFields[3].ParseStruct, &Wire->endstyle2 )) < 0 )
+			return Result;
 		ExpectToken( Cookie, TOKEN_CLOSE_PAR );
 
 		ExpectToken( Cookie, TOKEN_OPEN_PAR );
@@ -98,12 +114,14 @@ static int Parse_LineInWire( cookie_t *Cookie, const parsefield_t *ParseField, c
 	if( strcmp( Buffer, "width" ) != 0 )
 		Error( Cookie, -1, "Expecting \"width\"" );
 
-	ParseDimmension( Cookie, &ParseStruct->FixedFields[4], ParseStruct->FixedFields[4].ParseStruct, &Wire->width );
+	if(( Result = ParseDimmension( Cookie, &ParseStruct->FixedFields[4], ParseStruct->FixedFields[4].ParseStruct, &Wire->width )) < 0 )
+		return Result;
 	ExpectToken( Cookie, TOKEN_CLOSE_PAR );
 
 	ExpectToken( Cookie, TOKEN_OPEN_PAR );
 	ExpectName( Cookie, "netNameRef" );
-	ParseString( Cookie, &ParseStruct->FixedFields[5], ParseStruct->FixedFields[5].ParseStruct, &Wire->netnameref );
+	if(( Result = ParseString( Cookie, &ParseStruct->FixedFields[5], ParseStruct->FixedFields[5].ParseStruct, &Wire->netnameref )) < 0 )
+		return Result;
 	ExpectToken( Cookie, TOKEN_CLOSE_PAR );
 
 	return 0;
@@ -130,7 +148,7 @@ static int Parse_PadPinMap( cookie_t *Cookie, const parsefield_t *ParseField, co
 
 	do
 		{
-		Object		= Allocate( Cookie, sizeof( pcad_padpinmap_t ));
+		Object		= Allocate( Cookie, sizeof( pcad_padpinmap_t ), "pcad_padpinmap_t" );
 		**Parent	= Object;
 		if( ParseStruct != NULL && ParseStruct->OffsetNext >= 0 )
 			*Parent = (void*)( (char*)Object + ParseStruct->OffsetNext );
@@ -195,6 +213,305 @@ static int Parse_Grid( cookie_t *Cookie, const parsefield_t *ParseField, const p
 
 	return 0;
 	}
+/*============================================================================*/
+/* The sections of the file are timed apart in the timeline, see "Trace.h". */
+static int Parse_Section( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
+	{
+	double	Start	= TraceStart( Cookie );
+	int		Result;
+
+	Result	= ParseGeneric( Cookie, ParseField, ParseStruct, Argument );
+
+	TraceSpan( Cookie, Start, "parse", "%s", ParseField->TagString );
+
+	return Result;
+	}
+/*===========================================================================*/
+#if			defined __linux__
+/*============================================================================*/
+/*
+The sheets don't depend on each other, so when there is more than one processor
+available we just collect the text of each sheet while parsing the schematic
+design and parse all of them later in parallel, each one with its own cookie and
+its own slice of the heap.
+*/
+/*----------------------------------------------------------------------------*/
+typedef struct sheetjob_tag
+	{
+	const parsestruct_t		*ParseStruct;
+	pcad_sheet_t			*Sheet;
+	char					*Text;
+	size_t					Length;
+	unsigned				LineNumber;
+	unsigned				Column;
+	uint8_t					*Heap;
+	size_t					HeapSize;
+	struct heapblock_tag	*HeapBlocks;
+	parseerror_t			Error;
+	pcadsch_stats_t			Stats;
+	heapprofile_t			*Profile;
+	struct sheetjob_tag		*next;
+	} sheetjob_t;
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	pthread_mutex_t			Mutex;
+	const cookie_t			*Cookie;
+	sheetjob_t				*NextJob;
+	pthread_t				Caller;
+	} sheetqueue_t;
+/*============================================================================*/
+static int Parse_Sheet( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
+	{
+	sheetjob_t	*Job;
+	void		***Parent	= Argument;
+	void		**Slot		= *Parent;
+	char		*Text		= NULL;
+	size_t		Length		= 0;
+	double		Start		= TraceStart( Cookie );
+	int			Result;
+
+	if( Cookie->Threads <= 1 )
+		{
+		Result	= ParseGeneric( Cookie, ParseField, ParseStruct, Argument );
+		if( Result == 0 )
+			TraceSpan( Cookie, Start, "parse", "sheet \"%s\"", ((pcad_sheet_t*)*Slot)->name );
+		return Result;
+		}
+
+	Job					= Allocate( Cookie, sizeof( sheetjob_t ), "sheetjob_t" );
+	Job->ParseStruct	= ParseStruct;
+	/* Accounted as if it had been parsed here. */
+	Job->Sheet			= AllocateTagged( Cookie, ParseField->Length, ParseField->TagString, "parse" );
+	Job->LineNumber		= Cookie->LineNumber;
+	Job->Column			= Cookie->Column;
+
+	**Parent			= Job->Sheet;
+	*Parent				= (void*)( (char*)Job->Sheet + ParseStruct->OffsetNext );
+
+	/* Collect everything up to the closing parenthesis of the sheet, ignoring the parentheses inside strings. */
+	if(( Result = SkipBlock( Cookie, &Text, &Length )) < 0 )
+		return Result;
+
+	/* Only the parentheses are looked at, but this is all the lexing the sheet gets before being parsed. */
+	TraceSpan( Cookie, Start, "lex", "sheet text" );
+
+	Job->Text			= Text;
+	Job->Length			= Length;
+	/* The sheet gets its own heap when it is parsed, see "ReleasePCAD". */
+	Job->HeapSize		= sizeof( void* ) * Length;
+
+	*Cookie->LastSheetJob	= Job;
+	Cookie->LastSheetJob	= &Job->next;
+
+	return 0;
+	}
+/*============================================================================*/
+static void ParseSheetJob( const cookie_t *Cookie, sheetjob_t *Job )
+	{
+	cookie_t	SheetCookie;
+	double		Start;
+#if			defined PCADSCH_COUNTERS
+	/* The current thread may be the one parsing the file. */
+	pcadsch_counters_t	*Counters	= CurrentCounters;
+#endif	/*	defined PCADSCH_COUNTERS */
+
+	SheetCookie.LineNumber		= Job->LineNumber;
+	SheetCookie.Column			= Job->Column;
+	SheetCookie.TabSize			= Cookie->TabSize;
+	SheetCookie.HeapSize		= Job->HeapSize;
+	SheetCookie.HeapTop			= 0;
+	SheetCookie.HeapBlocks		= NULL;
+	SheetCookie.FileUnits		= Cookie->FileUnits;
+	SheetCookie.UngettedToken	= TOKEN_NONE;
+	SheetCookie.UngetBuffer[0]	= '\0';
+	SheetCookie.Sort			= Cookie->Sort;
+	SheetCookie.Threads			= 1;
+	SheetCookie.Pipeline		= NULL;
+	SheetCookie.File			= NULL;
+	SheetCookie.Input			= Job->Text;
+	SheetCookie.InputLength		= Job->Length;
+	SheetCookie.Position		= 0;
+	SheetCookie.Sections		= Cookie->Sections;
+	SheetCookie.LastError.Code	= 0;
+	SheetCookie.Trace			= Cookie->Trace;
+	SheetCookie.Profile			= NULL;
+	SheetCookie.Diagnostics		= Cookie->Diagnostics;
+	memset( &SheetCookie.Stats, 0, sizeof SheetCookie.Stats );
+	COUNT_INTO( &SheetCookie );
+
+	Start	= TraceStart( &SheetCookie );
+
+	if(( SheetCookie.Heap = Job->Heap = calloc( 1, Job->HeapSize )) == NULL )
+		RecordError( &SheetCookie, -1, "Not enough memory" );
+	/* Each sheet counts its own allocations, they are added up after all of them are parsed. */
+	else if( Cookie->Profile != NULL && ( SheetCookie.Profile = Job->Profile = calloc( 1, sizeof( heapprofile_t ))) == NULL )
+		RecordError( &SheetCookie, -1, "Not enough memory" );
+	/* Only the special cases may still jump out. */
+	else if( setjmp( SheetCookie.JumpBuffer ) == 0 )
+		{
+		SheetCookie.Stats.HeapSize	= Job->HeapSize;
+		if( ParseGeneric( &SheetCookie, NULL, Job->ParseStruct, Job->Sheet ) == 0 && GetToken( &SheetCookie, NULL, 0 ) != TOKEN_EOF )
+			RecordError( &SheetCookie, -1, "Expecting \")\"" );
+		}
+
+	SheetCookie.Stats.HeapUsed	+= SheetCookie.HeapTop;
+
+	if( SheetCookie.LastError.Code == 0 )
+		TraceSpan( &SheetCookie, Start, "parse", "sheet \"%s\"", Job->Sheet->name );
+
+	Job->HeapBlocks	= SheetCookie.HeapBlocks;
+	Job->Error		= SheetCookie.LastError;
+	Job->Stats		= SheetCookie.Stats;
+
+#if			defined PCADSCH_COUNTERS
+	CurrentCounters	= Counters;
+#endif	/*	defined PCADSCH_COUNTERS */
+	}
+/*============================================================================*/
+static void *SheetWorker( void *Argument )
+	{
+	sheetqueue_t	*Queue	= Argument;
+	sheetjob_t		*Job;
+
+	/* The current thread works too, it has its name already. */
+	if( pthread_equal( pthread_self(), Queue->Caller ) == 0 )
+		TraceThread( Queue->Cookie, "sheet worker" );
+
+	while( 1 )
+		{
+		pthread_mutex_lock( &Queue->Mutex );
+		if(( Job = Queue->NextJob ) != NULL )
+			Queue->NextJob	= Job->next;
+		pthread_mutex_unlock( &Queue->Mutex );
+
+		if( Job == NULL )
+			return NULL;
+
+		ParseSheetJob( Queue->Cookie, Job );
+		}
+	}
+/*============================================================================*/
+/* Frees the texts of the sheets, already parsed or not. */
+static void ReleaseSheetJobs( cookie_t *Cookie )
+	{
+	sheetjob_t	*Job;
+
+	for( Job = Cookie->FirstSheetJob; Job != NULL; Job = Job->next )
+		{
+		free( Job->Text );
+		Job->Text	= NULL;
+		}
+	}
+/*============================================================================*/
+#define	MAX_THREADS	64
+/*----------------------------------------------------------------------------*/
+static int ParseSheetJobs( cookie_t *Cookie )
+	{
+	pthread_t		Threads[MAX_THREADS];
+	sheetqueue_t	Queue;
+	sheetjob_t		*Job;
+	unsigned		NumJobs, NumThreads, i;
+	int				Result	= 0;
+
+	for( NumJobs = 0, Job = Cookie->FirstSheetJob; Job != NULL; Job = Job->next )
+		NumJobs++;
+
+	NumThreads	= Cookie->Threads < NumJobs ? Cookie->Threads : NumJobs;
+	if( NumThreads > MAX_THREADS )
+		NumThreads	= MAX_THREADS;
+
+	pthread_mutex_init( &Queue.Mutex, NULL );
+	Queue.Cookie	= Cookie;
+	Queue.NextJob	= Cookie->FirstSheetJob;
+	Queue.Caller	= pthread_self();
+
+	/* The current thread also does its share of the work. */
+	for( i = 1; i < NumThreads; i++ )
+		if( pthread_create( &Threads[i], NULL, SheetWorker, &Queue ) != 0 )
+			break;
+	NumThreads	= i;
+
+	SheetWorker( &Queue );
+
+	for( i = 1; i < NumThreads; i++ )
+		pthread_join( Threads[i], NULL );
+
+	pthread_mutex_destroy( &Queue.Mutex );
+
+	for( Job = Cookie->FirstSheetJob; Job != NULL; Job = Job->next )
+		{
+		MergeStats( &Cookie->Stats, &Job->Stats );
+		if( Job->Profile != NULL )
+			{
+			MergeHeapProfile( Cookie->Profile, Job->Profile );
+			free( Job->Profile );
+			Job->Profile	= NULL;
+			}
+		}
+
+	/* Report the first sheet that failed. */
+	for( Job = Cookie->FirstSheetJob; Job != NULL; Job = Job->next )
+		if( Job->Error.Code != 0 )
+			{
+			Cookie->LastError	= Job->Error;
+			Result				= Job->Error.Code;
+			break;
+			}
+
+	ReleaseSheetJobs( Cookie );
+
+	return Result;
+	}
+/*============================================================================*/
+static int Parse_SchematicDesign( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
+	{
+	double	Start	= TraceStart( Cookie );
+	int		Result;
+
+	Cookie->FirstSheetJob	= NULL;
+	Cookie->LastSheetJob	= &Cookie->FirstSheetJob;
+
+	if(( Result = ParseGeneric( Cookie, ParseField, ParseStruct, Argument )) < 0 )
+		{
+		ReleaseSheetJobs( Cookie );
+		return Result;
+		}
+
+	Result	= ParseSheetJobs( Cookie );
+
+	TraceSpan( Cookie, Start, "parse", "%s", ParseField->TagString );
+
+	return Result;
+	}
+/*============================================================================*/
+/* Frees the heaps of the sheets, the schematic cannot be used anymore. */
+void ReleasePCAD( cookie_t *Cookie )
+	{
+	sheetjob_t	*Job;
+
+	ReleaseSheetJobs( Cookie );
+
+	for( Job = Cookie->FirstSheetJob; Job != NULL; Job = Job->next )
+		{
+		ReleaseHeap( &Job->HeapBlocks );
+		free( Job->Heap );
+		Job->Heap	= NULL;
+		}
+
+	Cookie->FirstSheetJob	= NULL;
+	}
+/*============================================================================*/
+#else	/*	defined __linux__ */
+/*============================================================================*/
+void ReleasePCAD( cookie_t *Cookie )
+	{
+	}
+/*============================================================================*/
+#define	Parse_Sheet				ParseGeneric
+#define	Parse_SchematicDesign	Parse_Section
+/*============================================================================*/
+#endif	/*	defined __linux__ */
 /*===========================================================================*/
 /*============================================================================*/
 /*============================================================================*/
@@ -215,7 +532,26 @@ static const parsestruct_t	Point_ParseStruct	=
 	.Fields			= NULL,
 	.NumLists		=  0,
 	.Lists			= NULL,
-	.OffsetNext		= offsetof( pcad_point_t, next )
+	.OffsetNext		= -1
+	};
+/*============================================================================*/
+static const parsefield_t	PolyPoint_FixedFields[]	=
+	{
+	/*	Flags			TagString	ParseFunction		Size	Offset										ParseStruct */
+		{ FLAG_NAKED,	NULL,		ParseDimmension,	0,		offsetof( pcad_polypoint_t, point.x ),		NULL },
+		{ FLAG_NAKED,	NULL,		ParseDimmension,	0,		offsetof( pcad_polypoint_t, point.y ),		NULL }
+	};
+/*----------------------------------------------------------------------------*/
+static const parsestruct_t	PolyPoint_ParseStruct	=
+	{
+	.Flags			=  0,
+	.NumFixedFields = LENGTH( PolyPoint_FixedFields ),
+	.FixedFields	= PolyPoint_FixedFields,
+	.NumFields		=  0,
+	.Fields			= NULL,
+	.NumLists		=  0,
+	.Lists			= NULL,
+	.OffsetNext		= offsetof( pcad_polypoint_t, next )
 	};
 /*============================================================================*/
 static const parsefield_t	Attr_FixedFields[]	=
@@ -487,13 +823,13 @@ static const parsestruct_t	Font_ParseStruct	=
 /*============================================================================*/
 static const listhead_t	Poly_Lists[]		=
 	{
-		{ .OffsetHead = offsetof( pcad_poly_t, firstpoint ),	.OffsetLink = offsetof( pcad_poly_t, viopoints ) },
+		{ .OffsetHead = offsetof( pcad_poly_t, firstpoint ),	.OffsetLink = offsetof( pcad_poly_t, points ) },
 	};
 /*----------------------------------------------------------------------------*/
 static const parsefield_t	Poly_Fields[]	=
 	{
 	/*	Flags						TagString	ParseFunction	Size					Offset								ParseStruct */
-		{ FLAG_WRAPPED | FLAG_LIST,	"pt",		ParseGeneric,	sizeof( pcad_point_t ), offsetof( pcad_poly_t, viopoints ), &Point_ParseStruct }
+		{ FLAG_WRAPPED | FLAG_LIST | FLAG_ORDERED,	"pt",		ParseGeneric,	sizeof( pcad_polypoint_t ), offsetof( pcad_poly_t, points ), &PolyPoint_ParseStruct }
 	};
 /*----------------------------------------------------------------------------*/
 static const parsestruct_t	Poly_ParseStruct	=
@@ -636,7 +972,7 @@ static const parsefield_t	TextStyleDef_FixedFields[]	=
 static const parsefield_t	TextStyleDef_Fields[]	=
 	{
 	/*	Flags						TagString					ParseFunction		Size					Offset											ParseStruct */
-		{ FLAG_WRAPPED | FLAG_LIST, "font",						ParseGeneric,		sizeof( pcad_font_t ),	offsetof( pcad_textstyledef_t, viofonts ),		&Font_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_LIST | FLAG_ORDERED, "font",						ParseGeneric,		sizeof( pcad_font_t ),	offsetof( pcad_textstyledef_t, viofonts ),		&Font_ParseStruct },
 		{ FLAG_WRAPPED | FLAG_LIST, "textStyleAllowTType",		ParseBoolean,		0,						offsetof( pcad_textstyledef_t, allowttype ),	NULL },
 		{ FLAG_WRAPPED | FLAG_LIST, "textStyleDisplayTType",	ParseBoolean,		0,						offsetof( pcad_textstyledef_t, displayttype ),	NULL }
 	};
@@ -1616,7 +1952,7 @@ static const listhead_t	ReportFieldConditions_Lists[]	=
 static const parsefield_t	ReportFieldConditions_Fields[]	=
 	{
 	/*	Flags						TagString					ParseFunction	Size									Offset																ParseStruct */
-		{ FLAG_WRAPPED | FLAG_LIST,	"reportFieldCondition",		ParseGeneric,	sizeof( pcad_reportfieldcondition_t ),	offsetof( pcad_reportfieldconditions_t, vioreportfieldconditions ),	&ReportFieldCondition_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_LIST | FLAG_ORDERED,	"reportFieldCondition",		ParseGeneric,	sizeof( pcad_reportfieldcondition_t ),	offsetof( pcad_reportfieldconditions_t, vioreportfieldconditions ),	&ReportFieldCondition_ParseStruct },
 	};
 /*----------------------------------------------------------------------------*/
 static const parsestruct_t	ReportFieldConditions_ParseStruct	=
@@ -1668,7 +2004,7 @@ static const listhead_t	ReportFields_Lists[]	=
 static const parsefield_t	ReportFields_Fields[]	=
 	{
 	/*	Flags						TagString					ParseFunction	Size							Offset												ParseStruct */
-		{ FLAG_WRAPPED | FLAG_LIST,	"reportField",				ParseGeneric,	sizeof( pcad_reportfield_t ),	offsetof( pcad_reportfields_t, vioreportfields ),	&ReportField_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_LIST | FLAG_ORDERED,	"reportField",				ParseGeneric,	sizeof( pcad_reportfield_t ),	offsetof( pcad_reportfields_t, vioreportfields ),	&ReportField_ParseStruct },
 	};
 /*----------------------------------------------------------------------------*/
 static const parsestruct_t	ReportFields_ParseStruct	=
@@ -1692,7 +2028,7 @@ static const listhead_t	ReportFieldsSections_Lists[]	=
 static const parsefield_t	ReportFieldsSections_Fields[]	=
 	{
 	/*	Flags						TagString					ParseFunction	Size							Offset													ParseStruct */
-		{ FLAG_WRAPPED | FLAG_LIST,	"reportFields",				ParseGeneric,	sizeof( pcad_reportfields_t ),	offsetof( pcad_reportfieldssection_t, vioreportfieldss ),	&ReportFields_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_LIST | FLAG_ORDERED,	"reportFields",				ParseGeneric,	sizeof( pcad_reportfields_t ),	offsetof( pcad_reportfieldssection_t, vioreportfieldss ),	&ReportFields_ParseStruct },
 	};
 /*----------------------------------------------------------------------------*/
 static const parsestruct_t	ReportFieldsSections_ParseStruct	=
@@ -1749,7 +2085,7 @@ static const listhead_t	ReportDefinitions_Lists[]		=
 static const parsefield_t	ReportDefinitions_Fields[]	=
 	{
 	/*	Flags						TagString				ParseFunction	Size								Offset														ParseStruct */
-		{ FLAG_WRAPPED | FLAG_LIST,	"reportDefinition",		ParseGeneric,	sizeof( pcad_reportdefinition_t ),	offsetof( pcad_reportdefinitions_t, vioreportdefinitions ),	&ReportDefinition_ParseStruct }
+		{ FLAG_WRAPPED | FLAG_LIST | FLAG_ORDERED,	"reportDefinition",		ParseGeneric,	sizeof( pcad_reportdefinition_t ),	offsetof( pcad_reportdefinitions_t, vioreportdefinitions ),	&ReportDefinition_ParseStruct }
 	};
 /*----------------------------------------------------------------------------*/
 static const parsestruct_t	ReportDefinitions_ParseStruct	=
@@ -1954,16 +2290,16 @@ static const parsestruct_t	DesignInfo_ParseStruct	=
 /*===========================================================================*/
 static const parsefield_t	SchDesignHeader_FixedFields[]	=
 	{
-	/*	Flags			TagString				ParseFunction		Size	Offset													ParseStruct */
-		{ FLAG_WRAPPED, "workspaceSize",		ParseGeneric,		0,		offsetof( pcad_schdesignheader_t, workspacesize ),		&Extent_ParseStruct },
-		{ FLAG_WRAPPED, "gridDfns",				ParseGeneric,		0,		offsetof( pcad_schdesignheader_t, griddfns ),			&GridDfns_ParseStruct },
-		{ FLAG_WRAPPED, "designInfo",			ParseGeneric,		0,		offsetof( pcad_schdesignheader_t, designinfo ),			&DesignInfo_ParseStruct },
-		{ FLAG_WRAPPED, "refPointSize",			ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, refpointsize ),		NULL },
-		{ FLAG_WRAPPED, "infoPointSize",		ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, infopointsize ),		NULL },
-		{ FLAG_WRAPPED, "junctionSize",			ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, junctionsize ),		NULL },
-		{ FLAG_WRAPPED, "refPointSizePrint",	ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, refpointsizeprint ),	NULL },
-		{ FLAG_WRAPPED, "infoPointSizePrint",	ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, infopointsizeprint ),	NULL },
-		{ FLAG_WRAPPED, "junctionSizePrint",	ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, junctionsizeprint ),	NULL }
+	/*	Flags							TagString				ParseFunction		Size	Offset													ParseStruct */
+		{ FLAG_WRAPPED,					"workspaceSize",		ParseGeneric,		0,		offsetof( pcad_schdesignheader_t, workspacesize ),		&Extent_ParseStruct },
+		{ FLAG_WRAPPED,					"gridDfns",				ParseGeneric,		0,		offsetof( pcad_schdesignheader_t, griddfns ),			&GridDfns_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_SETTINGS,	"designInfo",			ParseGeneric,		0,		offsetof( pcad_schdesignheader_t, designinfo ),			&DesignInfo_ParseStruct },
+		{ FLAG_WRAPPED,					"refPointSize",			ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, refpointsize ),		NULL },
+		{ FLAG_WRAPPED,					"infoPointSize",		ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, infopointsize ),		NULL },
+		{ FLAG_WRAPPED,					"junctionSize",			ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, junctionsize ),		NULL },
+		{ FLAG_WRAPPED,					"refPointSizePrint",	ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, refpointsizeprint ),	NULL },
+		{ FLAG_WRAPPED,					"infoPointSizePrint",	ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, infopointsizeprint ),	NULL },
+		{ FLAG_WRAPPED,					"junctionSizePrint",	ParseDimmension,	0,		offsetof( pcad_schdesignheader_t, junctionsizeprint ),	NULL }
 	};
 /*----------------------------------------------------------------------------*/
 static const parsestruct_t	SchDesignHeader_ParseStruct	=
@@ -1992,12 +2328,12 @@ static const parsefield_t	SchematicDesign_FixedFields[]	=
 /*----------------------------------------------------------------------------*/
 static const parsefield_t	SchematicDesign_Fields[]	=
 	{
-	/*	Flags						TagString					ParseFunction			Size					Offset														ParseStruct */
-		{ FLAG_WRAPPED,				"titleSheet",				ParseGeneric,			0,						offsetof( pcad_schematicdesign_t, titlesheet ),				&TitleSheet_ParseStruct },
-		{ FLAG_WRAPPED | FLAG_LIST,	"sheet",					ParseGeneric,			sizeof( pcad_sheet_t ), offsetof( pcad_schematicdesign_t, viosheets ),				&Sheet_ParseStruct },
-		{ FLAG_WRAPPED,				"schematicPrintSettings",	ParseGeneric,			0,						offsetof( pcad_schematicdesign_t, schematicPrintSettings ),	&PrintSettings_ParseStruct },
-		{ FLAG_WRAPPED,				"programState",				ParseGeneric,			0,						offsetof( pcad_schematicdesign_t, programstate ),			&ProgramState_ParseStruct },
-		{ FLAG_WRAPPED,				"reportSettings",			ParseGeneric,			0,						offsetof( pcad_schematicdesign_t, reportsettings ),			&ReportSettings_ParseStruct }
+	/*	Flags										TagString					ParseFunction			Size					Offset														ParseStruct */
+		{ FLAG_WRAPPED | FLAG_SETTINGS,				"titleSheet",				ParseGeneric,			0,						offsetof( pcad_schematicdesign_t, titlesheet ),				&TitleSheet_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_LIST | FLAG_SHEETS,	"sheet",					Parse_Sheet,			sizeof( pcad_sheet_t ), offsetof( pcad_schematicdesign_t, viosheets ),				&Sheet_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_SETTINGS,				"schematicPrintSettings",	ParseGeneric,			0,						offsetof( pcad_schematicdesign_t, schematicPrintSettings ),	&PrintSettings_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_SETTINGS,				"programState",				ParseGeneric,			0,						offsetof( pcad_schematicdesign_t, programstate ),			&ProgramState_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_SETTINGS,				"reportSettings",			ParseGeneric,			0,						offsetof( pcad_schematicdesign_t, reportsettings ),			&ReportSettings_ParseStruct }
 	};
 /*----------------------------------------------------------------------------*/
 static const parsestruct_t	SchematicDesign_ParseStruct	=
@@ -2014,13 +2350,13 @@ static const parsestruct_t	SchematicDesign_ParseStruct	=
 /*===========================================================================*/
 static const parsefield_t	SchematicFile_FixedFields[]	=
 	{
-	/*	Flags			TagString			ParseFunction	Size	Offset												ParseStruct */
-		{ FLAG_NAKED,	"ACCEL_ASCII",		ParseName,		0,		-1,													NULL },
-		{ FLAG_NAKED,	NULL,				ParseString,	0,		offsetof( pcad_schematicfile_t, name ),				NULL },
-		{ FLAG_WRAPPED, "asciiHeader",		ParseGeneric,	0,		offsetof( pcad_schematicfile_t, asciiheader ),		&ASCIIHeader_ParseStruct },
-		{ FLAG_WRAPPED, "library",			ParseGeneric,	0,		offsetof( pcad_schematicfile_t, library ),			&Library_ParseStruct },
-		{ FLAG_WRAPPED, "netlist",			ParseGeneric,	0,		offsetof( pcad_schematicfile_t, netlist ),			&NetList_ParseStruct },
-		{ FLAG_WRAPPED, "schematicDesign",	ParseGeneric,	0,		offsetof( pcad_schematicfile_t, schematicdesign ),	&SchematicDesign_ParseStruct }
+	/*	Flags											TagString			ParseFunction			Size	Offset												ParseStruct */
+		{ FLAG_NAKED,									"ACCEL_ASCII",		ParseName,				0,		-1,													NULL },
+		{ FLAG_NAKED,									NULL,				ParseString,			0,		offsetof( pcad_schematicfile_t, name ),				NULL },
+		{ FLAG_WRAPPED,									"asciiHeader",		Parse_Section,			0,		offsetof( pcad_schematicfile_t, asciiheader ),		&ASCIIHeader_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_LIBRARY,					"library",			Parse_Section,			0,		offsetof( pcad_schematicfile_t, library ),			&Library_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_NETLIST,					"netlist",			Parse_Section,			0,		offsetof( pcad_schematicfile_t, netlist ),			&NetList_ParseStruct },
+		{ FLAG_WRAPPED | FLAG_SHEETS | FLAG_SETTINGS,	"schematicDesign",	Parse_SchematicDesign,	0,		offsetof( pcad_schematicfile_t, schematicdesign ),	&SchematicDesign_ParseStruct }
 	};
 /*----------------------------------------------------------------------------*/
 static const parsestruct_t	SchematicFile_ParseStruct	=
@@ -2042,18 +2378,46 @@ static pcad_schematicfile_t *PCADParseSchematicFile( cookie_t *Cookie )
 	{
 	pcad_schematicfile_t	*s;
 
-	s	= Allocate( Cookie, sizeof( pcad_schematicfile_t ));
+	s	= Allocate( Cookie, sizeof( pcad_schematicfile_t ), "pcad_schematicfile_t" );
 
-	ParseGeneric( Cookie, NULL, &SchematicFile_ParseStruct, s );
+	if( ParseGeneric( Cookie, NULL, &SchematicFile_ParseStruct, s ) < 0 )
+		return NULL;
 
 	return s;
 	}
 /*============================================================================*/
+/*
+Only parses the file, the result must still be processed by "PCADProcesSchematic".
+Returns NULL on error, with the details in "Cookie->LastError". The caller's
+"Cookie->JumpBuffer" is preserved, nothing raised inside the parser escapes.
+*/
 pcad_schematicfile_t *ParsePCAD( cookie_t *Cookie, const char *pNameIn, const char *pNameOut )
 	{
 	pcad_schematicfile_t	*s;
+	jmp_buf					Caller;
+
+	memcpy( Caller, Cookie->JumpBuffer, sizeof Caller );
 
-	s	= PCADParseSchematicFile( Cookie );
+	Cookie->LastError.Code	= 0;
+	Cookie->FirstSheetJob	= NULL;
+
+	if( setjmp( Cookie->JumpBuffer ) != 0 )
+		{
+		ReleasePCAD( Cookie );
+		ReportSkipped( Cookie );
+		memcpy( Cookie->JumpBuffer, Caller, sizeof Caller );
+		return NULL;
+		}
+
+	if(( s = PCADParseSchematicFile( Cookie )) == NULL )
+		{
+		ReleasePCAD( Cookie );
+		ReportSkipped( Cookie );
+		memcpy( Cookie->JumpBuffer, Caller, sizeof Caller );
+		return NULL;
+		}
+
+	ReportSkipped( Cookie );
 
 #if 0
 	char	fn[256];
@@ -2067,8 +2431,83 @@ pcad_schematicfile_t *ParsePCAD( cookie_t *Cookie, const char *pNameIn, const ch
 	close( g );
 #endif
 
-	PCADProcesSchematic( Cookie, s );
+	memcpy( Cookie->JumpBuffer, Caller, sizeof Caller );
 
 	return s;
 	}
 /*============================================================================*/
+/* Tells the scanner what the special cases above produce. */
+static scankind_t ClassifySpecial( parsefunc_t ParseFunc )
+	{
+	if( ParseFunc == Parse_FileUnits )
+		return SCAN_ENUM;
+	if( ParseFunc == Parse_Grid )
+		return SCAN_STRING;
+	if( ParseFunc == Parse_LineInWire || ParseFunc == Parse_PadPinMap || ParseFunc == Parse_Sheet || ParseFunc == Parse_Section || ParseFunc == Parse_SchematicDesign )
+		return SCAN_STRUCT;
+
+	return SCAN_SKIP;
+	}
+/*============================================================================*/
+int ScanPCAD( cookie_t *Cookie, const scanner_t *Scanner )
+	{
+	jmp_buf	Caller;
+	int		Result;
+
+	memcpy( Caller, Cookie->JumpBuffer, sizeof Caller );
+
+	Cookie->LastError.Code		= 0;
+	Cookie->Stats.NumSkipped	= 0;
+	Cookie->Stats.OtherSkipped	= 0;
+
+	if( setjmp( Cookie->JumpBuffer ) == 0 )
+		Result	= ScanGeneric( Cookie, &SchematicFile_ParseStruct, Scanner, ClassifySpecial );
+	else
+		Result	= Cookie->LastError.Code;
+
+	ReportSkipped( Cookie );
+
+	memcpy( Cookie->JumpBuffer, Caller, sizeof Caller );
+
+	return Result;
+	}
+/*============================================================================*/
+/* Tells the fingerprints how the special cases store what they parse, grids are read as strings but kept as dimensions. */
+static scankind_t ClassifyStored( parsefunc_t ParseFunc )
+	{
+	if( ParseFunc == Parse_Grid )
+		return SCAN_DIMMENSION;
+
+	return ClassifySpecial( ParseFunc );
+	}
+/*============================================================================*/
+uint64_t HashPCADLibrary( uint64_t Hash, const pcad_library_t *Library )
+	{
+	return HashGeneric( Hash, &Library_ParseStruct, Library, ClassifyStored );
+	}
+/*============================================================================*/
+uint64_t HashPCADCompInst( uint64_t Hash, const pcad_compinst_t *CompInst )
+	{
+	return HashGeneric( Hash, &CompInst_ParseStruct, CompInst, ClassifyStored );
+	}
+/*============================================================================*/
+uint64_t HashPCADTitleSheet( uint64_t Hash, const pcad_titlesheet_t *TitleSheet )
+	{
+	return HashGeneric( Hash, &TitleSheet_ParseStruct, TitleSheet, ClassifyStored );
+	}
+/*============================================================================*/
+uint64_t HashPCADSheet( uint64_t Hash, const pcad_sheet_t *Sheet )
+	{
+	return HashGeneric( Hash, &Sheet_ParseStruct, Sheet, ClassifyStored );
+	}
+/*============================================================================*/
+uint64_t HashPCAD( uint64_t Hash, const parsestruct_t *ParseStruct, const void *Object, int Lists )
+	{
+	return Lists ? HashGeneric( Hash, ParseStruct, Object, ClassifyStored ) : HashHeader( Hash, ParseStruct, Object, ClassifyStored );
+	}
+/*============================================================================*/
+const parsestruct_t *GetPCADParseStruct( void )
+	{
+	return &SchematicFile_ParseStruct;
+	}
+/*============================================================================*/
@@ -29,11 +29,19 @@
 #include <stdio.h>
 #include <setjmp.h>
 #include "PCADStructs.h"
+#include "PCADSch.h"
 /*===========================================================================*/
 #define BUFFER_SIZE					128
 /*============================================================================*/
 #define PARSE_FLAGS_OMMIT_CLOSE_PAR	  1
 #define	PARSE_FLAGS_REQUIRE_EOF		  2
+/*============================================================================*/
+/* The sections of the file to be parsed, the others are skipped without being tokenized. */
+#define SECTION_LIBRARY				 16
+#define SECTION_NETLIST				 32
+#define SECTION_SHEETS				 64
+#define SECTION_SETTINGS			128
+#define SECTION_ALL					( SECTION_LIBRARY | SECTION_NETLIST | SECTION_SHEETS | SECTION_SETTINGS )
 /*===========================================================================*/
 typedef enum
 	{
@@ -50,6 +58,15 @@ typedef enum
 	TOKEN_FLOAT
 	} token_t;
 /*============================================================================*/
+/* The last error found, "LineNumber" and "Column" are zero if it is not related to the input file. */
+typedef struct
+	{
+	int					Code;
+	unsigned			LineNumber;
+	unsigned			Column;
+	char				Message[256];
+	} parseerror_t;
+/*============================================================================*/
 typedef struct
 	{
 	jmp_buf				JumpBuffer;
@@ -60,13 +77,64 @@ typedef struct
 	size_t				HeapSize;
 	size_t				HeapTop;
 	uint8_t				*Heap;
+	struct heapblock_tag	*HeapBlocks;
 	pcad_enum_units_t	FileUnits;
 	token_t				UngettedToken;
 	char				UngetBuffer[BUFFER_SIZE];
 	int					Sort;
+	unsigned			Threads;
+	struct sheetjob_tag	*FirstSheetJob;
+	struct sheetjob_tag	**LastSheetJob;
+	struct pipeline_tag	*Pipeline;
+	/* When not NULL the input is read from memory instead of from "File". */
+	const char			*Input;
+	size_t				InputLength;
+	size_t				Position;
+	size_t				TokenOffset;
+	int64_t				TokenValue;
+	unsigned			Sections;
+	parseerror_t		LastError;
+	/* "Stats.HeapUsed" leaves out the current block, whose use is "HeapTop". */
+	pcadsch_stats_t		Stats;
+	/* NULL unless a timeline is being recorded, see "Trace.h". */
+	struct trace_tag	*Trace;
+	/* NULL unless the allocations are being counted, see "Parser.h". */
+	struct heapprofile_tag	*Profile;
+	/* NULL writes the warnings and errors as they come, see "Diagnostics.h". */
+	struct diagnostics_tag	*Diagnostics;
 	} cookie_t;
 /*===========================================================================*/
+/*
+The hot-path counters, compiled in only with PCADSCH_COUNTERS. Many of the
+counted functions have no cookie, so they count into the statistics the current
+thread points at, if any. Each phase points it at the statistics of its cookie.
+*/
+#if			defined PCADSCH_COUNTERS
+extern _Thread_local pcadsch_counters_t	*CurrentCounters;
+#define	COUNT( Counter, Increment )		do { if( CurrentCounters != NULL ) CurrentCounters->Counter += ( Increment ); } while( 0 )
+#define	COUNT_INTO( Cookie )			( CurrentCounters = &( Cookie )->Stats.Counters, CurrentCounters->Enabled = 1 )
+#else	/*	defined PCADSCH_COUNTERS */
+#define	COUNT( Counter, Increment )		do { (void)( Increment ); } while( 0 )
+#define	COUNT_INTO( Cookie )			do {} while( 0 )
+#endif	/*	defined PCADSCH_COUNTERS */
+/*===========================================================================*/
+struct scanner_tag;
+struct parsestruct_tag;
+/*===========================================================================*/
 pcad_schematicfile_t	*ParsePCAD	( cookie_t *Cookie, const char *pNameIn, const char *pNameOut );
+void					ReleasePCAD	( cookie_t *Cookie );
+int						ScanPCAD	( cookie_t *Cookie, const struct scanner_tag *Scanner );
+
+/* Fingerprints of the parsed structures, to be combined starting from "HASH_INITIAL". */
+uint64_t				HashPCADLibrary		( uint64_t Hash, const pcad_library_t *Library );
+uint64_t				HashPCADCompInst	( uint64_t Hash, const pcad_compinst_t *CompInst );
+uint64_t				HashPCADTitleSheet	( uint64_t Hash, const pcad_titlesheet_t *TitleSheet );
+uint64_t				HashPCADSheet		( uint64_t Hash, const pcad_sheet_t *Sheet );
+/* Any of the parsed structures, "Lists" zero leaves out the lists of the structure itself. */
+uint64_t				HashPCAD			( uint64_t Hash, const struct parsestruct_tag *ParseStruct, const void *Object, int Lists );
+
+/* The table of the whole file, for the code walking the parsed structures. */
+const struct parsestruct_tag	*GetPCADParseStruct	( void );
 /*===========================================================================*/
 #endif	/*	!defined __PCADPARSER_H__ */
 /*===========================================================================*/
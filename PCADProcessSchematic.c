@@ -29,6 +29,12 @@
 #include "Parser.h"
 #include "PCADStructs.h"
 #include "PCADProcessSchematic.h"
+#include "Trace.h"
+/*===========================================================================*/
+#if			defined PCADSCH_COUNTERS
+/* Counts the comparisons of each collection, named after the expression of its array. */
+#define	qsort( Base, Num, Size, Compare )	SortCounted( #Base, Base, Num, Size, Compare )
+#endif	/*	defined PCADSCH_COUNTERS */
 /*===========================================================================*/
 static inline pcad_dimmension_t __attribute__((always_inline)) min( pcad_dimmension_t a, pcad_dimmension_t b )
 	{
@@ -89,6 +95,8 @@ static int CompareNames( const char *a, const char *b )
 	char	Num1[256], Num2[256];
 	int		Len1, Len2, Zeros1, Zeros2, i;
 
+	COUNT( CompareNames, 1 );
+
 	if( a == NULL || b == NULL )
 		return a == b ? 0 : a == NULL ? -1 : 1;
 
@@ -294,13 +302,13 @@ static int ComparePolys( const void *a, const void *b )
 	boundingrect_t		RectA, RectB;
 	int					i;
 
-	CalculateBoundingRectangle( &RectA, pa->viopoints[0], pa->viopoints[0] );
+	CalculateBoundingRectangle( &RectA, &pa->points[0], &pa->points[0] );
 	for( i = 1; i < pa->numpoints; i++ )
-		BoundingRectangleAdd( &RectA, pa->viopoints[i] );
+		BoundingRectangleAdd( &RectA, &pa->points[i] );
 
-	CalculateBoundingRectangle( &RectB, pb->viopoints[0], pb->viopoints[0] );
+	CalculateBoundingRectangle( &RectB, &pb->points[0], &pb->points[0] );
 	for( i = 1; i < pb->numpoints; i++ )
-		BoundingRectangleAdd( &RectB, pb->viopoints[i] );
+		BoundingRectangleAdd( &RectB, &pb->points[i] );
 
 	i	= CompareBoundingRectangleTLtoBR( &RectA, &RectB );
 	if( i != 0 )
@@ -362,16 +370,16 @@ static int ProcessPoly( cookie_t *Cookie, pcad_poly_t *Poly )
 
 	/*------------------------------------------------------------------------*/
 
-	pcad_point_t *pPoint;
+	pcad_polypoint_t *pPoint;
 
 	for( i = 0, pPoint = Poly->firstpoint; pPoint != NULL; i++, pPoint = pPoint->next )
 		{}
 	Poly->numpoints	= i;
 	if( i > 0 )
 		{
-		Poly->viopoints = Allocate( Cookie, i * sizeof( pcad_point_t* ));
+		Poly->points	= Allocate( Cookie, i * sizeof( pcad_point_t ), "pcad_point_t[]" );
 		for( i = 0, pPoint = Poly->firstpoint; i < Poly->numpoints && pPoint != NULL; i++, pPoint = pPoint->next )
-			Poly->viopoints[i]	= pPoint;
+			Poly->points[i]	= pPoint->point;
 		}
 
 	return 0;
@@ -388,7 +396,7 @@ static int ProcessTitleSheet( cookie_t *Cookie, pcad_titlesheet_t *TitleSheet )
 	TitleSheet->numlines	= i;
 	if( i > 0 )
 		{
-		TitleSheet->violines	= Allocate( Cookie, i * sizeof( pcad_line_t* ));
+		TitleSheet->violines	= Allocate( Cookie, i * sizeof( pcad_line_t* ), "pcad_line_t*[]" );
 		for( i = 0, pLine = TitleSheet->firstline; i < TitleSheet->numlines && pLine != NULL; i++, pLine = pLine->next )
 			TitleSheet->violines[i]	= pLine;
 		if( Cookie->Sort )
@@ -407,7 +415,7 @@ static int ProcessTitleSheet( cookie_t *Cookie, pcad_titlesheet_t *TitleSheet )
 	TitleSheet->numtexts	= i;
 	if( i > 0 )
 		{
-		TitleSheet->viotexts	= Allocate( Cookie, i * sizeof( pcad_text_t* ));
+		TitleSheet->viotexts	= Allocate( Cookie, i * sizeof( pcad_text_t* ), "pcad_text_t*[]" );
 		for( i = 0, pText = TitleSheet->firsttext; i < TitleSheet->numtexts && pText != NULL; i++, pText = pText->next )
 			TitleSheet->viotexts[i]	= pText;
 		if( Cookie->Sort )
@@ -434,7 +442,7 @@ static int ProcessSymbol( cookie_t *Cookie, pcad_symbol_t *Symbol )
 	Symbol->numattrs	= i;
 	if( i > 0 )
 		{
-		Symbol->vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ));
+		Symbol->vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ), "pcad_attr_t*[]" );
 		for( i = 0, pAttr = Symbol->firstattr; i < Symbol->numattrs && pAttr != NULL; i++, pAttr = pAttr->next )
 			Symbol->vioattrs[i]	= pAttr;
 		if( Cookie->Sort )
@@ -447,6 +455,65 @@ static int ProcessSymbol( cookie_t *Cookie, pcad_symbol_t *Symbol )
 	return 0;
 	}
 /*===========================================================================*/
+/* Copies the coordinates of the sorted wires, junctions and bus entries to contiguous arrays for the emitters. */
+static int ProcessSheetGeometry( cookie_t *Cookie, pcad_sheet_t *Sheet )
+	{
+	pcad_sheetgeometry_t	*Geometry;
+	size_t					i;
+
+	Geometry	= Allocate( Cookie, sizeof( pcad_sheetgeometry_t ), "pcad_sheetgeometry_t" );
+
+	Geometry->numwires	= Sheet->numwires;
+	if( Sheet->numwires > 0 )
+		{
+		Geometry->wirex1		= Allocate( Cookie, Sheet->numwires * sizeof( pcad_dimmension_t ), "pcad_dimmension_t[]" );
+		Geometry->wirey1		= Allocate( Cookie, Sheet->numwires * sizeof( pcad_dimmension_t ), "pcad_dimmension_t[]" );
+		Geometry->wirex2		= Allocate( Cookie, Sheet->numwires * sizeof( pcad_dimmension_t ), "pcad_dimmension_t[]" );
+		Geometry->wirey2		= Allocate( Cookie, Sheet->numwires * sizeof( pcad_dimmension_t ), "pcad_dimmension_t[]" );
+		Geometry->wireendstyle1	= Allocate( Cookie, Sheet->numwires * sizeof( pcad_enum_endstyle_t ), "pcad_enum_endstyle_t[]" );
+		Geometry->wireendstyle2	= Allocate( Cookie, Sheet->numwires * sizeof( pcad_enum_endstyle_t ), "pcad_enum_endstyle_t[]" );
+		for( i = 0; i < Sheet->numwires; i++ )
+			{
+			Geometry->wirex1[i]			= Sheet->viowires[i]->pt1.x;
+			Geometry->wirey1[i]			= Sheet->viowires[i]->pt1.y;
+			Geometry->wirex2[i]			= Sheet->viowires[i]->pt2.x;
+			Geometry->wirey2[i]			= Sheet->viowires[i]->pt2.y;
+			Geometry->wireendstyle1[i]	= Sheet->viowires[i]->endstyle1;
+			Geometry->wireendstyle2[i]	= Sheet->viowires[i]->endstyle2;
+			}
+		}
+
+	Geometry->numjunctions	= Sheet->numjunctions;
+	if( Sheet->numjunctions > 0 )
+		{
+		Geometry->junctionx	= Allocate( Cookie, Sheet->numjunctions * sizeof( pcad_dimmension_t ), "pcad_dimmension_t[]" );
+		Geometry->junctiony	= Allocate( Cookie, Sheet->numjunctions * sizeof( pcad_dimmension_t ), "pcad_dimmension_t[]" );
+		for( i = 0; i < Sheet->numjunctions; i++ )
+			{
+			Geometry->junctionx[i]	= Sheet->viojunctions[i]->point.x;
+			Geometry->junctiony[i]	= Sheet->viojunctions[i]->point.y;
+			}
+		}
+
+	Geometry->numbusentries	= Sheet->numbusentries;
+	if( Sheet->numbusentries > 0 )
+		{
+		Geometry->busentryx			= Allocate( Cookie, Sheet->numbusentries * sizeof( pcad_dimmension_t ), "pcad_dimmension_t[]" );
+		Geometry->busentryy			= Allocate( Cookie, Sheet->numbusentries * sizeof( pcad_dimmension_t ), "pcad_dimmension_t[]" );
+		Geometry->busentryorient	= Allocate( Cookie, Sheet->numbusentries * sizeof( pcad_enum_orient_t ), "pcad_enum_orient_t[]" );
+		for( i = 0; i < Sheet->numbusentries; i++ )
+			{
+			Geometry->busentryx[i]		= Sheet->viobusentries[i]->point.x;
+			Geometry->busentryy[i]		= Sheet->viobusentries[i]->point.y;
+			Geometry->busentryorient[i]	= Sheet->viobusentries[i]->orient;
+			}
+		}
+
+	Sheet->geometry	= Geometry;
+
+	return 0;
+	}
+/*===========================================================================*/
 static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	{
 	int				i;
@@ -462,7 +529,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numwires	= i;
 	if( i > 0 )
 		{
-		Sheet->viowires	= Allocate( Cookie, i * sizeof( pcad_wire_t* ));
+		Sheet->viowires	= Allocate( Cookie, i * sizeof( pcad_wire_t* ), "pcad_wire_t*[]" );
 		for( i = 0, pWire = Sheet->firstwire; i < Sheet->numwires && pWire != NULL; i++, pWire = pWire->next )
 			Sheet->viowires[i]	= pWire;
 		if( Cookie->Sort )
@@ -481,7 +548,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numbuses = i;
 	if( i > 0 )
 		{
-		Sheet->viobuses	= Allocate( Cookie, i * sizeof( pcad_bus_t* ));
+		Sheet->viobuses	= Allocate( Cookie, i * sizeof( pcad_bus_t* ), "pcad_bus_t*[]" );
 		for( i = 0, pBus = Sheet->firstbus; i < Sheet->numbuses && pBus != NULL; i++, pBus = pBus->next )
 			Sheet->viobuses[i]	= pBus;
 		if( Cookie->Sort )
@@ -500,7 +567,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numbusentries = i;
 	if( i > 0 )
 		{
-		Sheet->viobusentries	= Allocate( Cookie, i * sizeof( pcad_busentry_t* ));
+		Sheet->viobusentries	= Allocate( Cookie, i * sizeof( pcad_busentry_t* ), "pcad_busentry_t*[]" );
 		for( i = 0, pBusEntry = Sheet->firstbusentry; i < Sheet->numbusentries && pBusEntry != NULL; i++, pBusEntry = pBusEntry->next )
 			Sheet->viobusentries[i]	= pBusEntry;
 		if( Cookie->Sort )
@@ -519,7 +586,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numsymbols	= i;
 	if( i > 0 )
 		{
-		Sheet->viosymbols	= Allocate( Cookie, i * sizeof( pcad_symbol_t* ));
+		Sheet->viosymbols	= Allocate( Cookie, i * sizeof( pcad_symbol_t* ), "pcad_symbol_t*[]" );
 		for( i = 0, pSymbol = Sheet->firstsymbol; i < Sheet->numsymbols && pSymbol != NULL; i++, pSymbol = pSymbol->next )
 			Sheet->viosymbols[i]	= pSymbol;
 		if( Cookie->Sort )
@@ -542,7 +609,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numjunctions	= i;
 	if( i > 0 )
 		{
-		Sheet->viojunctions	= Allocate( Cookie, i * sizeof( pcad_junction_t* ));
+		Sheet->viojunctions	= Allocate( Cookie, i * sizeof( pcad_junction_t* ), "pcad_junction_t*[]" );
 		for( i = 0, pJunction = Sheet->firstjunction; i < Sheet->numjunctions && pJunction != NULL; i++, pJunction = pJunction->next )
 			Sheet->viojunctions[i]	= pJunction;
 		if( Cookie->Sort )
@@ -561,7 +628,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numports	= i;
 	if( i > 0 )
 		{
-		Sheet->vioports	= Allocate( Cookie, i * sizeof( pcad_port_t* ));
+		Sheet->vioports	= Allocate( Cookie, i * sizeof( pcad_port_t* ), "pcad_port_t*[]" );
 		for( i = 0, pPort = Sheet->firstport; i < Sheet->numports && pPort != NULL; i++, pPort = pPort->next )
 			Sheet->vioports[i]	= pPort;
 		if( Cookie->Sort )
@@ -580,7 +647,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numtexts	= i;
 	if( i > 0 )
 		{
-		Sheet->viotexts	= Allocate( Cookie, i * sizeof( pcad_text_t* ));
+		Sheet->viotexts	= Allocate( Cookie, i * sizeof( pcad_text_t* ), "pcad_text_t*[]" );
 		for( i = 0, pText = Sheet->firsttext; i < Sheet->numtexts && pText != NULL; i++, pText = pText->next )
 			Sheet->viotexts[i]	= pText;
 		if( Cookie->Sort )
@@ -599,7 +666,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numtriplepointarcs	= i;
 	if( i > 0 )
 		{
-		Sheet->viotriplepointarcs	= Allocate( Cookie, i * sizeof( pcad_triplepointarc_t* ));
+		Sheet->viotriplepointarcs	= Allocate( Cookie, i * sizeof( pcad_triplepointarc_t* ), "pcad_triplepointarc_t*[]" );
 		for( i = 0, pArc = Sheet->firsttriplepointarc; i < Sheet->numtriplepointarcs && pArc != NULL; i++, pArc = pArc->next )
 			Sheet->viotriplepointarcs[i]	= pArc;
 		if( Cookie->Sort )
@@ -618,7 +685,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numattrs	= i;
 	if( i > 0 )
 		{
-		Sheet->vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ));
+		Sheet->vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ), "pcad_attr_t*[]" );
 		for( i = 0, pAttr = Sheet->firstattr; i < Sheet->numattrs && pAttr != NULL; i++, pAttr = pAttr->next )
 			Sheet->vioattrs[i]	= pAttr;
 		if( Cookie->Sort )
@@ -637,7 +704,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numpolys	= i;
 	if( i > 0 )
 		{
-		Sheet->viopolys	= Allocate( Cookie, i * sizeof( pcad_poly_t* ));
+		Sheet->viopolys	= Allocate( Cookie, i * sizeof( pcad_poly_t* ), "pcad_poly_t*[]" );
 		for( i = 0, pPoly = Sheet->firstpoly; i < Sheet->numpolys && pPoly != NULL; i++, pPoly = pPoly->next )
 			{
 //				fprintf( stderr, "\tProcessing polygon %u\n", i );
@@ -657,7 +724,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numlines	= i;
 	if( i > 0 )
 		{
-		Sheet->violines	= Allocate( Cookie, i * sizeof( pcad_line_t* ));
+		Sheet->violines	= Allocate( Cookie, i * sizeof( pcad_line_t* ), "pcad_line_t*[]" );
 		for( i = 0, pLine = Sheet->firstline; i < Sheet->numlines && pLine != NULL; i++, pLine = pLine->next )
 			Sheet->violines[i]	= pLine;
 		if( Cookie->Sort )
@@ -676,7 +743,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numpins	= i;
 	if( i > 0 )
 		{
-		Sheet->viopins	= Allocate( Cookie, i * sizeof( pcad_pin_t* ));
+		Sheet->viopins	= Allocate( Cookie, i * sizeof( pcad_pin_t* ), "pcad_pin_t*[]" );
 		for( i = 0, pPin = Sheet->firstpin; i < Sheet->numpins && pPin != NULL; i++, pPin = pPin->next )
 			Sheet->viopins[i]	= pPin;
 		if( Cookie->Sort )
@@ -695,7 +762,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numieeesymbols	= i;
 	if( i > 0 )
 		{
-		Sheet->vioieeesymbols	= Allocate( Cookie, i * sizeof( pcad_ieeesymbol_t* ));
+		Sheet->vioieeesymbols	= Allocate( Cookie, i * sizeof( pcad_ieeesymbol_t* ), "pcad_ieeesymbol_t*[]" );
 		for( i = 0, pIEEESymbol = Sheet->firstieeesymbol; i < Sheet->numieeesymbols && pIEEESymbol != NULL; i++, pIEEESymbol = pIEEESymbol->next )
 			Sheet->vioieeesymbols[i]	= pIEEESymbol;
 		if( Cookie->Sort )
@@ -714,7 +781,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numfields	= i;
 	if( i > 0 )
 		{
-		Sheet->viofields	= Allocate( Cookie, i * sizeof( pcad_field_t* ));
+		Sheet->viofields	= Allocate( Cookie, i * sizeof( pcad_field_t* ), "pcad_field_t*[]" );
 		for( i = 0, pField = Sheet->firstfield; i < Sheet->numfields && pField != NULL; i++, pField = pField->next )
 			Sheet->viofields[i]	= pField;
 		if( Cookie->Sort )
@@ -733,7 +800,7 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 	Sheet->numrefpoints	= i;
 	if( i > 0 )
 		{
-		Sheet->viorefpoints	= Allocate( Cookie, i * sizeof( pcad_refpoint_t* ));
+		Sheet->viorefpoints	= Allocate( Cookie, i * sizeof( pcad_refpoint_t* ), "pcad_refpoint_t*[]" );
 		for( i = 0, pRefPoint = Sheet->firstrefpoint; i < Sheet->numrefpoints && pRefPoint != NULL; i++, pRefPoint = pRefPoint->next )
 			Sheet->viorefpoints[i]	= pRefPoint;
 		if( Cookie->Sort )
@@ -745,6 +812,10 @@ static int ProcessSheet( cookie_t *Cookie, pcad_sheet_t *Sheet )
 
 	/*------------------------------------------------------------------------*/
 
+	ProcessSheetGeometry( Cookie, Sheet );
+
+	/*------------------------------------------------------------------------*/
+
 	return 0;
 	}
 /*===========================================================================*/
@@ -787,7 +858,7 @@ static int ProcessFieldSet( cookie_t *Cookie, pcad_fieldset_t *FieldSet )
 	FieldSet->numfielddefs	= i;
 	if( i > 0 )
 		{
-		FieldSet->viofielddefs	= Allocate( Cookie, i * sizeof( pcad_fielddef_t* ));
+		FieldSet->viofielddefs	= Allocate( Cookie, i * sizeof( pcad_fielddef_t* ), "pcad_fielddef_t*[]" );
 		for( i = 0, pFieldDef = FieldSet->firstfielddef; i < FieldSet->numfielddefs && pFieldDef != NULL; i++, pFieldDef = pFieldDef->next )
 			FieldSet->viofielddefs[i]	= pFieldDef;
 		if( Cookie->Sort )
@@ -806,7 +877,7 @@ static int ProcessFieldSet( cookie_t *Cookie, pcad_fieldset_t *FieldSet )
 	FieldSet->numnotes	= i;
 	if( i > 0 )
 		{
-		FieldSet->vionotes	= Allocate( Cookie, i * sizeof( pcad_note_t* ));
+		FieldSet->vionotes	= Allocate( Cookie, i * sizeof( pcad_note_t* ), "pcad_note_t*[]" );
 		for( i = 0, pNote = FieldSet->firstnote; i < FieldSet->numnotes && pNote != NULL; i++, pNote = pNote->next )
 			FieldSet->vionotes[i]	= pNote;
 		if( Cookie->Sort )
@@ -825,7 +896,7 @@ static int ProcessFieldSet( cookie_t *Cookie, pcad_fieldset_t *FieldSet )
 	FieldSet->numrevisionnotes	= i;
 	if( i > 0 )
 		{
-		FieldSet->viorevisionnotes	= Allocate( Cookie, i * sizeof( pcad_revisionnote_t* ));
+		FieldSet->viorevisionnotes	= Allocate( Cookie, i * sizeof( pcad_revisionnote_t* ), "pcad_revisionnote_t*[]" );
 		for( i = 0, pRevisionNote = FieldSet->firstrevisionnote; i < FieldSet->numrevisionnotes && pRevisionNote != NULL; i++, pRevisionNote = pRevisionNote->next )
 			FieldSet->viorevisionnotes[i]	= pRevisionNote;
 		if( Cookie->Sort )
@@ -874,7 +945,7 @@ static int ProcessReportField( cookie_t *Cookie, pcad_reportfield_t *ReportField
 	ReportField->reportfieldconditions.numreportfieldconditions	= i;
 	if( i > 0 )
 		{
-		ReportField->reportfieldconditions.vioreportfieldconditions	= Allocate( Cookie, i * sizeof( pcad_reportfieldcondition_t* ));
+		ReportField->reportfieldconditions.vioreportfieldconditions	= Allocate( Cookie, i * sizeof( pcad_reportfieldcondition_t* ), "pcad_reportfieldcondition_t*[]" );
 		for( i = 0, pReportFieldCondition = ReportField->reportfieldconditions.firstreportfieldcondition; i < ReportField->reportfieldconditions.numreportfieldconditions && pReportFieldCondition != NULL; i++, pReportFieldCondition = pReportFieldCondition->next )
 			ReportField->reportfieldconditions.vioreportfieldconditions[i]	= pReportFieldCondition;
 //		if( Cookie->Sort )
@@ -899,7 +970,7 @@ static int ProcessReportFields( cookie_t *Cookie, pcad_reportfields_t *ReportFie
 	ReportFields->numreportfields	= i;
 	if( i > 0 )
 		{
-		ReportFields->vioreportfields	= Allocate( Cookie, i * sizeof( pcad_reportfield_t* ));
+		ReportFields->vioreportfields	= Allocate( Cookie, i * sizeof( pcad_reportfield_t* ), "pcad_reportfield_t*[]" );
 		for( i = 0, pReportField = ReportFields->firstreportfield; i < ReportFields->numreportfields && pReportField != NULL; i++, pReportField = pReportField->next )
 			ReportFields->vioreportfields[i]	= pReportField;
 		//if( Cookie->Sort )
@@ -924,7 +995,7 @@ static int ProcessReportDefinition( cookie_t *Cookie, pcad_reportdefinition_t *R
 	ReportDefinition->reportfieldssections.numreportfieldss	= i;
 	if( i > 0 )
 		{
-		ReportDefinition->reportfieldssections.vioreportfieldss	= Allocate( Cookie, i * sizeof( pcad_reportfields_t* ));
+		ReportDefinition->reportfieldssections.vioreportfieldss	= Allocate( Cookie, i * sizeof( pcad_reportfields_t* ), "pcad_reportfields_t*[]" );
 		for( i = 0, pReportFields = ReportDefinition->reportfieldssections.firstreportfields; i < ReportDefinition->reportfieldssections.numreportfieldss && pReportFields != NULL; i++, pReportFields = pReportFields->next )
 			{
 			ReportDefinition->reportfieldssections.vioreportfieldss[i]	= pReportFields;
@@ -986,18 +1057,20 @@ static int CompareReportDefinitions( const void *a, const void *b )
 /*===========================================================================*/
 static int ProcessPCADSchematicDesign( cookie_t *Cookie, pcad_schematicdesign_t *SchematicDesign )
 	{
+	double			Start;
 	int				i;
 
 	/*------------------------------------------------------------------------*/
 
 	pcad_grid_t	*pGrids;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pGrids = SchematicDesign->schdesignheader.griddfns.firstgrid; pGrids != NULL; i++, pGrids = pGrids->next )
 		{}
 	SchematicDesign->schdesignheader.griddfns.numgrids	= i;
 	if( i > 0 )
 		{
-		SchematicDesign->schdesignheader.griddfns.viogrids	= Allocate( Cookie, i * sizeof( pcad_grid_t* ));
+		SchematicDesign->schdesignheader.griddfns.viogrids	= Allocate( Cookie, i * sizeof( pcad_grid_t* ), "pcad_grid_t*[]" );
 		for( i = 0, pGrids = SchematicDesign->schdesignheader.griddfns.firstgrid; i < SchematicDesign->schdesignheader.griddfns.numgrids && pGrids != NULL; i++, pGrids = pGrids->next )
 			SchematicDesign->schdesignheader.griddfns.viogrids[i]	= pGrids;
 		if( Cookie->Sort )
@@ -1007,16 +1080,19 @@ static int ProcessPCADSchematicDesign( cookie_t *Cookie, pcad_schematicdesign_t
 //	for( i = 0; i < SchematicDesign->schdesignheader.griddfns.numgrids; i++ )
 //		ProcessGrid( Cookie, SchematicDesign->schdesignheader.griddfns.viogrids[i] );
 
+	TraceSpan( Cookie, Start, "process", "grids" );
+
 	/*------------------------------------------------------------------------*/
 
 	pcad_fieldset_t *pFieldSet;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pFieldSet = SchematicDesign->schdesignheader.designinfo.firstfieldset; pFieldSet != NULL; i++, pFieldSet = pFieldSet->next )
 		{}
 	SchematicDesign->schdesignheader.designinfo.numfieldsets	= i;
 	if( i > 0 )
 		{
-		SchematicDesign->schdesignheader.designinfo.viofieldsets	= Allocate( Cookie, i * sizeof( pcad_fieldset_t* ));
+		SchematicDesign->schdesignheader.designinfo.viofieldsets	= Allocate( Cookie, i * sizeof( pcad_fieldset_t* ), "pcad_fieldset_t*[]" );
 		for( i = 0, pFieldSet = SchematicDesign->schdesignheader.designinfo.firstfieldset; i < SchematicDesign->schdesignheader.designinfo.numfieldsets && pFieldSet != NULL; i++, pFieldSet = pFieldSet->next )
 			SchematicDesign->schdesignheader.designinfo.viofieldsets[i]	= pFieldSet;
 		if( Cookie->Sort )
@@ -1026,9 +1102,13 @@ static int ProcessPCADSchematicDesign( cookie_t *Cookie, pcad_schematicdesign_t
 	for( i = 0; i < SchematicDesign->schdesignheader.designinfo.numfieldsets; i++ )
 		ProcessFieldSet( Cookie, SchematicDesign->schdesignheader.designinfo.viofieldsets[i] );
 
+	TraceSpan( Cookie, Start, "process", "fieldSets" );
+
 	/*------------------------------------------------------------------------*/
 
+	Start	= TraceStart( Cookie );
 	ProcessTitleSheet( Cookie, &SchematicDesign->titlesheet );
+	TraceSpan( Cookie, Start, "process", "titleSheet" );
 
 #if 0
 	pcad_line_t	*pLine;
@@ -1071,12 +1151,13 @@ static int ProcessPCADSchematicDesign( cookie_t *Cookie, pcad_schematicdesign_t
 
 	pcad_sheet_t *pSheet;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pSheet = SchematicDesign->firstsheet; pSheet != NULL; i++, pSheet = pSheet->next )
 		{}
 	SchematicDesign->numsheets	= i;
 	if( i > 0 )
 		{
-		SchematicDesign->viosheets	= Allocate( Cookie, i * sizeof( pcad_sheet_t* ));
+		SchematicDesign->viosheets	= Allocate( Cookie, i * sizeof( pcad_sheet_t* ), "pcad_sheet_t*[]" );
 		for( i = 0, pSheet = SchematicDesign->firstsheet; i < SchematicDesign->numsheets && pSheet != NULL; i++, pSheet = pSheet->next )
 			SchematicDesign->viosheets[i]	= pSheet;
 		if( Cookie->Sort )
@@ -1085,21 +1166,27 @@ static int ProcessPCADSchematicDesign( cookie_t *Cookie, pcad_schematicdesign_t
 
 	for( i = 0; i < SchematicDesign->numsheets; i++ )
 		{
+		double	SheetStart	= TraceStart( Cookie );
+
 //		fprintf( stderr, "Processing sheet %u: ", i );
 //		fprintf( stderr, "%s\n", SchematicDesign->viosheets[i]->name );
 		ProcessSheet( Cookie, SchematicDesign->viosheets[i] );
+		TraceSpan( Cookie, SheetStart, "process", "sheet \"%s\"", SchematicDesign->viosheets[i]->name );
 		}
 
+	TraceSpan( Cookie, Start, "process", "sheets" );
+
 	/*------------------------------------------------------------------------*/
 
 	pcad_sheetref_t *pSheetRef;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pSheetRef = SchematicDesign->schematicPrintSettings.sheetlist.firstsheetref; pSheetRef != NULL; i++, pSheetRef = pSheetRef->next )
 		{}
 	SchematicDesign->schematicPrintSettings.sheetlist.numsheetrefs	= i;
 	if( i > 0 )
 		{
-		SchematicDesign->schematicPrintSettings.sheetlist.viosheetrefs	= Allocate( Cookie, i * sizeof( pcad_sheetref_t* ));
+		SchematicDesign->schematicPrintSettings.sheetlist.viosheetrefs	= Allocate( Cookie, i * sizeof( pcad_sheetref_t* ), "pcad_sheetref_t*[]" );
 		for( i = 0, pSheetRef = SchematicDesign->schematicPrintSettings.sheetlist.firstsheetref; i < SchematicDesign->schematicPrintSettings.sheetlist.numsheetrefs && pSheetRef != NULL; i++, pSheetRef = pSheetRef->next )
 			SchematicDesign->schematicPrintSettings.sheetlist.viosheetrefs[i]	= pSheetRef;
 		if( Cookie->Sort )
@@ -1109,16 +1196,19 @@ static int ProcessPCADSchematicDesign( cookie_t *Cookie, pcad_schematicdesign_t
 //	for( i = 0; i < SchematicDesign->schematicPrintSettings.sheetlist.numsheetrefs; i++ )
 //		ProcessSheetRef( Cookie, SchematicDesign->schematicPrintSettings.sheetlist.viosheetrefs[i] );
 
+	TraceSpan( Cookie, Start, "process", "sheetRefs" );
+
 	/*------------------------------------------------------------------------*/
 
 	pcad_reportdefinition_t *pReportDefinition;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pReportDefinition = SchematicDesign->reportsettings.reportdefinitions.firstreportdefinition; pReportDefinition != NULL; i++, pReportDefinition = pReportDefinition->next )
 		{}
 	SchematicDesign->reportsettings.reportdefinitions.numreportdefinitions	= i;
 	if( i > 0 )
 		{
-		SchematicDesign->reportsettings.reportdefinitions.vioreportdefinitions	= Allocate( Cookie, i * sizeof( pcad_reportdefinition_t* ));
+		SchematicDesign->reportsettings.reportdefinitions.vioreportdefinitions	= Allocate( Cookie, i * sizeof( pcad_reportdefinition_t* ), "pcad_reportdefinition_t*[]" );
 		for( i = 0, pReportDefinition = SchematicDesign->reportsettings.reportdefinitions.firstreportdefinition;
 				i < SchematicDesign->reportsettings.reportdefinitions.numreportdefinitions && pReportDefinition != NULL; i++, pReportDefinition = pReportDefinition->next )
 			SchematicDesign->reportsettings.reportdefinitions.vioreportdefinitions[i]	= pReportDefinition;
@@ -1133,6 +1223,8 @@ static int ProcessPCADSchematicDesign( cookie_t *Cookie, pcad_schematicdesign_t
 		ProcessReportDefinition( Cookie, SchematicDesign->reportsettings.reportdefinitions.vioreportdefinitions[i] );
 		}
 
+	TraceSpan( Cookie, Start, "process", "reportDefinitions" );
+
 	/*------------------------------------------------------------------------*/
 
 	return 0;
@@ -1182,7 +1274,7 @@ static int ProcessCompInst( cookie_t *Cookie, pcad_compinst_t *CompInst )
 	CompInst->numattrs	= i;
 	if( i > 0 )
 		{
-		CompInst->vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ));
+		CompInst->vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ), "pcad_attr_t*[]" );
 		for( i = 0, pAttr = CompInst->firstattr; i < CompInst->numattrs && pAttr != NULL; i++, pAttr = pAttr->next )
 			CompInst->vioattrs[i]	= pAttr;
 		if( Cookie->Sort )
@@ -1210,7 +1302,7 @@ static int ProcessNet( cookie_t *Cookie, pcad_net_t *Net )
 	Net->numnodes	= i;
 	if( i > 0 )
 		{
-		Net->vionodes	= Allocate( Cookie, i * sizeof( pcad_node_t* ));
+		Net->vionodes	= Allocate( Cookie, i * sizeof( pcad_node_t* ), "pcad_node_t*[]" );
 		for( i = 0, pNode = Net->firstnode; i < Net->numnodes && pNode != NULL; i++, pNode = pNode->next )
 			Net->vionodes[i]	= pNode;
 		if( Cookie->Sort )
@@ -1227,18 +1319,20 @@ static int ProcessNet( cookie_t *Cookie, pcad_net_t *Net )
 /*===========================================================================*/
 static int ProcessPCADNetList( cookie_t *Cookie, pcad_netlist_t *NetList )
 	{
+	double			Start;
 	int				i;
 
 	/*------------------------------------------------------------------------*/
 
 	pcad_attr_t	*pAttr;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pAttr = NetList->globalattrs.firstattr; pAttr != NULL; i++, pAttr = pAttr->next )
 		{}
 	NetList->globalattrs.numattr	= i;
 	if( i > 0 )
 		{
-		NetList->globalattrs.vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ));
+		NetList->globalattrs.vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ), "pcad_attr_t*[]" );
 		for( i = 0, pAttr = NetList->globalattrs.firstattr; i < NetList->globalattrs.numattr && pAttr != NULL; i++, pAttr = pAttr->next )
 			NetList->globalattrs.vioattrs[i]	= pAttr;
 		if( Cookie->Sort )
@@ -1248,16 +1342,19 @@ static int ProcessPCADNetList( cookie_t *Cookie, pcad_netlist_t *NetList )
 //	for( i = 0; i < NetList->globalattrs.numattr; i++ )
 //		ProcessAttr( Cookie, NetList->globalattrs.vioattrs[i] );
 
+	TraceSpan( Cookie, Start, "process", "globalAttrs" );
+
 	/*------------------------------------------------------------------------*/
 
 	pcad_compinst_t *pCompInst;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pCompInst = NetList->firstcompinst; pCompInst != NULL; i++, pCompInst = pCompInst->next )
 		{}
 	NetList->numcompinsts	= i;
 	if( i > 0 )
 		{
-		NetList->viocompinsts	= Allocate( Cookie, i * sizeof( pcad_compinst_t* ));
+		NetList->viocompinsts	= Allocate( Cookie, i * sizeof( pcad_compinst_t* ), "pcad_compinst_t*[]" );
 		for( i = 0, pCompInst = NetList->firstcompinst; i < NetList->numcompinsts && pCompInst != NULL; i++, pCompInst = pCompInst->next )
 			NetList->viocompinsts[i]	= pCompInst;
 		if( Cookie->Sort )
@@ -1267,16 +1364,19 @@ static int ProcessPCADNetList( cookie_t *Cookie, pcad_netlist_t *NetList )
 	for( i = 0; i < NetList->numcompinsts; i++ )
 		ProcessCompInst( Cookie, NetList->viocompinsts[i] );
 
+	TraceSpan( Cookie, Start, "process", "compInsts" );
+
 	/*------------------------------------------------------------------------*/
 
 	pcad_net_t	*pNet;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pNet = NetList->firstnet; pNet != NULL; i++, pNet = pNet->next )
 		{}
 	NetList->numnets	= i;
 	if( i > 0 )
 		{
-		NetList->vionets	= Allocate( Cookie, i * sizeof( pcad_net_t* ));
+		NetList->vionets	= Allocate( Cookie, i * sizeof( pcad_net_t* ), "pcad_net_t*[]" );
 		for( i = 0, pNet = NetList->firstnet; i < NetList->numnets && pNet != NULL; i++, pNet = pNet->next )
 			NetList->vionets[i]	= pNet;
 		if( Cookie->Sort )
@@ -1286,6 +1386,8 @@ static int ProcessPCADNetList( cookie_t *Cookie, pcad_netlist_t *NetList )
 	for( i = 0; i < NetList->numnets; i++ )
 		ProcessNet( Cookie, NetList->vionets[i] );
 
+	TraceSpan( Cookie, Start, "process", "nets" );
+
 	/*------------------------------------------------------------------------*/
 
 	return 0;
@@ -1315,7 +1417,7 @@ static int ProcessSymbolDef( cookie_t *Cookie, pcad_symboldef_t *SymbolDef )
 	SymbolDef->numpins	= i;
 	if( i > 0 )
 		{
-		SymbolDef->viopins	= Allocate( Cookie, i * sizeof( pcad_pin_t* ));
+		SymbolDef->viopins	= Allocate( Cookie, i * sizeof( pcad_pin_t* ), "pcad_pin_t*[]" );
 		for( i = 0, pPin = SymbolDef->firstpin; i < SymbolDef->numpins && pPin != NULL; i++, pPin = pPin->next )
 			SymbolDef->viopins[i]	= pPin;
 		if( Cookie->Sort )
@@ -1334,7 +1436,7 @@ static int ProcessSymbolDef( cookie_t *Cookie, pcad_symboldef_t *SymbolDef )
 	SymbolDef->numlines	= i;
 	if( i > 0 )
 		{
-		SymbolDef->violines	= Allocate( Cookie, i * sizeof( pcad_line_t* ));
+		SymbolDef->violines	= Allocate( Cookie, i * sizeof( pcad_line_t* ), "pcad_line_t*[]" );
 		for( i = 0, pLine = SymbolDef->firstline; i < SymbolDef->numlines && pLine != NULL; i++, pLine = pLine->next )
 			SymbolDef->violines[i]	= pLine;
 		if( Cookie->Sort )
@@ -1353,7 +1455,7 @@ static int ProcessSymbolDef( cookie_t *Cookie, pcad_symboldef_t *SymbolDef )
 	SymbolDef->numpolys	= i;
 	if( i > 0 )
 		{
-		SymbolDef->viopolys	= Allocate( Cookie, i * sizeof( pcad_poly_t* ));
+		SymbolDef->viopolys	= Allocate( Cookie, i * sizeof( pcad_poly_t* ), "pcad_poly_t*[]" );
 		for( i = 0, pPoly = SymbolDef->firstpoly; i < SymbolDef->numpolys && pPoly != NULL; i++, pPoly = pPoly->next )
 			{
 //			fprintf( stderr, "\tProcessing polygon %u\n", i );
@@ -1373,7 +1475,7 @@ static int ProcessSymbolDef( cookie_t *Cookie, pcad_symboldef_t *SymbolDef )
 	SymbolDef->numattrs	= i;
 	if( i > 0 )
 		{
-		SymbolDef->vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ));
+		SymbolDef->vioattrs	= Allocate( Cookie, i * sizeof( pcad_attr_t* ), "pcad_attr_t*[]" );
 		for( i = 0, pAttr = SymbolDef->firstattr; i < SymbolDef->numattrs && pAttr != NULL; i++, pAttr = pAttr->next )
 			SymbolDef->vioattrs[i]	= pAttr;
 		if( Cookie->Sort )
@@ -1392,7 +1494,7 @@ static int ProcessSymbolDef( cookie_t *Cookie, pcad_symboldef_t *SymbolDef )
 	SymbolDef->numtriplepointarcs	= i;
 	if( i > 0 )
 		{
-		SymbolDef->viotriplepointarcs	= Allocate( Cookie, i * sizeof( pcad_triplepointarc_t* ));
+		SymbolDef->viotriplepointarcs	= Allocate( Cookie, i * sizeof( pcad_triplepointarc_t* ), "pcad_triplepointarc_t*[]" );
 		for( i = 0, pArc = SymbolDef->firsttriplepointarc; i < SymbolDef->numtriplepointarcs && pArc != NULL; i++, pArc = pArc->next )
 			SymbolDef->viotriplepointarcs[i]	= pArc;
 		if( Cookie->Sort )
@@ -1411,7 +1513,7 @@ static int ProcessSymbolDef( cookie_t *Cookie, pcad_symboldef_t *SymbolDef )
 	SymbolDef->numtexts	= i;
 	if( i > 0 )
 		{
-		SymbolDef->viotexts	= Allocate( Cookie, i * sizeof( pcad_text_t* ));
+		SymbolDef->viotexts	= Allocate( Cookie, i * sizeof( pcad_text_t* ), "pcad_text_t*[]" );
 		for( i = 0, pText = SymbolDef->firsttext; i < SymbolDef->numtexts && pText != NULL; i++, pText = pText->next )
 			SymbolDef->viotexts[i]	= pText;
 		if( Cookie->Sort )
@@ -1430,7 +1532,7 @@ static int ProcessSymbolDef( cookie_t *Cookie, pcad_symboldef_t *SymbolDef )
 	SymbolDef->numieeesymbols	= i;
 	if( i > 0 )
 		{
-		SymbolDef->vioieeesymbols	= Allocate( Cookie, i * sizeof( pcad_ieeesymbol_t* ));
+		SymbolDef->vioieeesymbols	= Allocate( Cookie, i * sizeof( pcad_ieeesymbol_t* ), "pcad_ieeesymbol_t*[]" );
 		for( i = 0, pIEEESymbol = SymbolDef->firstieeesymbol; i < SymbolDef->numieeesymbols && pIEEESymbol != NULL; i++, pIEEESymbol = pIEEESymbol->next )
 			SymbolDef->vioieeesymbols[i]	= pIEEESymbol;
 		if( Cookie->Sort )
@@ -1477,7 +1579,7 @@ static int ProcessCompDef( cookie_t *Cookie, pcad_compdef_t *CompDef )
 	CompDef->numcomppins	= i;
 	if( i > 0 )
 		{
-		CompDef->viocomppins	= Allocate( Cookie, i * sizeof( pcad_comppin_t* ));
+		CompDef->viocomppins	= Allocate( Cookie, i * sizeof( pcad_comppin_t* ), "pcad_comppin_t*[]" );
 		for( i = 0, pCompPin = CompDef->firstcomppin; i < CompDef->numcomppins && pCompPin != NULL; i++, pCompPin = pCompPin->next )
 			CompDef->viocomppins[i]	= pCompPin;
 		if( Cookie->Sort )
@@ -1496,7 +1598,7 @@ static int ProcessCompDef( cookie_t *Cookie, pcad_compdef_t *CompDef )
 	CompDef->numattachedsymbols	= i;
 	if( i > 0 )
 		{
-		CompDef->vioattachedsymbols	= Allocate( Cookie, i * sizeof( pcad_attachedsymbol_t* ));
+		CompDef->vioattachedsymbols	= Allocate( Cookie, i * sizeof( pcad_attachedsymbol_t* ), "pcad_attachedsymbol_t*[]" );
 		for( i = 0, pAttachedSymbol = CompDef->firstattachedsymbol; i < CompDef->numattachedsymbols && pAttachedSymbol != NULL; i++, pAttachedSymbol = pAttachedSymbol->next )
 			CompDef->vioattachedsymbols[i]	= pAttachedSymbol;
 		if( Cookie->Sort )
@@ -1515,7 +1617,7 @@ static int ProcessCompDef( cookie_t *Cookie, pcad_compdef_t *CompDef )
 	CompDef->attachedpattern.numpadpinmaps	= i;
 	if( i > 0 )
 		{
-		CompDef->attachedpattern.viopadpinmaps	= Allocate( Cookie, i * sizeof( pcad_padpinmap_t* ));
+		CompDef->attachedpattern.viopadpinmaps	= Allocate( Cookie, i * sizeof( pcad_padpinmap_t* ), "pcad_padpinmap_t*[]" );
 		for( i = 0, pPadPinMap = CompDef->attachedpattern.firstpadpinmap; i < CompDef->attachedpattern.numpadpinmaps && pPadPinMap != NULL; i++, pPadPinMap = pPadPinMap->next )
 			CompDef->attachedpattern.viopadpinmaps[i]	= pPadPinMap;
 		if( Cookie->Sort )
@@ -1568,7 +1670,7 @@ static int ProcessTextStyleDef( cookie_t *Cookie, pcad_textstyledef_t *TextStyle
 	TextStyleDef->numfonts	= i;
 	if( i > 0 )
 		{
-		TextStyleDef->viofonts	= Allocate( Cookie, i * sizeof( pcad_textstyledef_t* ));
+		TextStyleDef->viofonts	= Allocate( Cookie, i * sizeof( pcad_textstyledef_t* ), "pcad_textstyledef_t*[]" );
 		for( i = 0, pFont = TextStyleDef->firstfont; i < TextStyleDef->numfonts && pFont != NULL; i++, pFont = pFont->next )
 			TextStyleDef->viofonts[i]	= pFont;
 //		if( Cookie->Sort )
@@ -1584,18 +1686,20 @@ static int ProcessTextStyleDef( cookie_t *Cookie, pcad_textstyledef_t *TextStyle
 /*===========================================================================*/
 static int ProcessPCADLibrary( cookie_t *Cookie, pcad_library_t *PCADLibrary )
 	{
+	double			Start;
 	int				i;
 
 	/*------------------------------------------------------------------------*/
 
 	pcad_textstyledef_t *pTextStyleDef;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pTextStyleDef = PCADLibrary->firsttextstyledef; pTextStyleDef != NULL; i++, pTextStyleDef = pTextStyleDef->next )
 		{}
 	PCADLibrary->numtextstyledefs	= i;
 	if( i > 0 )
 		{
-		PCADLibrary->viotextstyledefs	= Allocate( Cookie, i * sizeof( pcad_textstyledef_t* ));
+		PCADLibrary->viotextstyledefs	= Allocate( Cookie, i * sizeof( pcad_textstyledef_t* ), "pcad_textstyledef_t*[]" );
 		for( i = 0, pTextStyleDef = PCADLibrary->firsttextstyledef; i < PCADLibrary->numtextstyledefs && pTextStyleDef != NULL; i++, pTextStyleDef = pTextStyleDef->next )
 			PCADLibrary->viotextstyledefs[i]	= pTextStyleDef;
 		if( Cookie->Sort )
@@ -1605,16 +1709,19 @@ static int ProcessPCADLibrary( cookie_t *Cookie, pcad_library_t *PCADLibrary )
 	for( i = 0; i < PCADLibrary->numtextstyledefs; i++ )
 		ProcessTextStyleDef( Cookie, PCADLibrary->viotextstyledefs[i] );
 
+	TraceSpan( Cookie, Start, "process", "textStyleDefs" );
+
 	/*------------------------------------------------------------------------*/
 
 	pcad_symboldef_t *pSymbolDef;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pSymbolDef = PCADLibrary->firstsymboldef; pSymbolDef != NULL; i++, pSymbolDef = pSymbolDef->next )
 		{}
 	PCADLibrary->numsymboldefs	= i;
 	if( i > 0 )
 		{
-		PCADLibrary->viosymboldefs	= Allocate( Cookie, i * sizeof( pcad_textstyledef_t* ));
+		PCADLibrary->viosymboldefs	= Allocate( Cookie, i * sizeof( pcad_textstyledef_t* ), "pcad_textstyledef_t*[]" );
 		for( i = 0, pSymbolDef = PCADLibrary->firstsymboldef; i < PCADLibrary->numsymboldefs && pSymbolDef != NULL; i++, pSymbolDef = pSymbolDef->next )
 			PCADLibrary->viosymboldefs[i]	= pSymbolDef;
 		if( Cookie->Sort )
@@ -1628,16 +1735,19 @@ static int ProcessPCADLibrary( cookie_t *Cookie, pcad_library_t *PCADLibrary )
 		ProcessSymbolDef( Cookie, PCADLibrary->viosymboldefs[i] );
 		}
 
+	TraceSpan( Cookie, Start, "process", "symbolDefs" );
+
 	/*------------------------------------------------------------------------*/
 
 	pcad_compdef_t *pCompDef;
 
+	Start	= TraceStart( Cookie );
 	for( i = 0, pCompDef = PCADLibrary->firstcompdef; pCompDef != NULL; i++, pCompDef = pCompDef->next )
 		{}
 	PCADLibrary->numcompdefs	= i;
 	if( i > 0 )
 		{
-		PCADLibrary->viocompdefs	= Allocate( Cookie, i * sizeof( pcad_compdef_t* ));
+		PCADLibrary->viocompdefs	= Allocate( Cookie, i * sizeof( pcad_compdef_t* ), "pcad_compdef_t*[]" );
 		for( i = 0, pCompDef = PCADLibrary->firstcompdef; i < PCADLibrary->numcompdefs && pCompDef != NULL; i++, pCompDef = pCompDef->next )
 			PCADLibrary->viocompdefs[i]	= pCompDef;
 		if( Cookie->Sort )
@@ -1647,6 +1757,8 @@ static int ProcessPCADLibrary( cookie_t *Cookie, pcad_library_t *PCADLibrary )
 	for( i = 0; i < PCADLibrary->numcompdefs; i++ )
 		ProcessCompDef( Cookie, PCADLibrary->viocompdefs[i] );
 
+	TraceSpan( Cookie, Start, "process", "compDefs" );
+
 	/*------------------------------------------------------------------------*/
 
 	return 0;
@@ -1654,9 +1766,20 @@ static int ProcessPCADLibrary( cookie_t *Cookie, pcad_library_t *PCADLibrary )
 /*===========================================================================*/
 int PCADProcesSchematic( cookie_t *Cookie, pcad_schematicfile_t *PCADSchematic )
 	{
+	double	Start;
+
+	Start	= TraceStart( Cookie );
 	ProcessPCADLibrary( Cookie, &PCADSchematic->library );
+	TraceSpan( Cookie, Start, "process", "library" );
+
+	Start	= TraceStart( Cookie );
 	ProcessPCADNetList( Cookie, &PCADSchematic->netlist );
+	TraceSpan( Cookie, Start, "process", "netlist" );
+
+	Start	= TraceStart( Cookie );
 	ProcessPCADSchematicDesign( Cookie, &PCADSchematic->schematicdesign );
+	TraceSpan( Cookie, Start, "process", "schematicDesign" );
+
 	return 0;
 	}
 /*===========================================================================*/
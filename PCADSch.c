@@ -0,0 +1,679 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if			defined __linux__
+#include <unistd.h>
+#endif	/*	defined __linux__ */
+#include "PCADSch.h"
+#include "Parser.h"
+#include "Lexic.h"
+#include "PCADParser.h"
+#include "PCADProcessSchematic.h"
+#include "PCADOutputSchematic.h"
+#include "KiCADOutputSchematic.h"
+#include "PCADDiffSchematic.h"
+#include "Trace.h"
+#include "Diagnostics.h"
+/*============================================================================*/
+#if			PCADSCH_SECTION_LIBRARY != SECTION_LIBRARY || PCADSCH_SECTION_NETLIST != SECTION_NETLIST || PCADSCH_SECTION_SHEETS != SECTION_SHEETS || PCADSCH_SECTION_SETTINGS != SECTION_SETTINGS
+#error "The PCADSCH_SECTION_* values must be the same as the SECTION_* ones"
+#endif	/*	PCADSCH_SECTION_LIBRARY != SECTION_LIBRARY || ... */
+/*============================================================================*/
+/* The first block of the heap when the size of the input is not known. */
+#define	PCADSCH_INITIAL_HEAP	( 4 * 1024 * 1024 )
+/*============================================================================*/
+_Static_assert( TOKEN_FLOAT - TOKEN_CLOSE_PAR + 1 == PCADSCH_NUM_TOKENS, "The PCADSCH_TOKEN_* values must follow the TOKEN_* ones" );
+/*============================================================================*/
+struct pcadsch_tag
+	{
+	cookie_t				Cookie;
+	uint8_t					*Heap;
+	size_t					HeapAllocated;
+	pcad_schematicfile_t	*Schematic;
+	unsigned				Threads;
+	int						Pipeline;
+	int						Processed;
+	/* One of the PCADSCH_DIAGNOSTICS_* values. */
+	int						Diagnostics;
+	};
+/*============================================================================*/
+void SplitPath( const char *pFullPath, char *pPath, char *pName, char *pExt )
+	{
+	char	FullPath[256], *p, *q;
+
+	strncpy( FullPath, pFullPath, sizeof FullPath );
+	FullPath[sizeof FullPath - 1]	= '\0';
+
+	if(( p = strrchr( FullPath, '\\' )) != NULL )
+		{
+		*p++	= '\0';
+		if( pPath != NULL )
+			{
+			strcpy( pPath, FullPath );
+			strcat( pPath, "\\" );
+			}
+		}
+	else if(( p = strrchr( FullPath, ':' )) != NULL )
+		{
+		*p++	= '\0';
+		if( pPath != NULL )
+			{
+			strcpy( pPath, FullPath );
+			strcat( pPath, ":" );
+			}
+		}
+	else
+		{
+		p		= FullPath;
+		if( pPath != NULL )
+			strcpy( pPath, "" );
+		}
+
+	if(( q = strrchr( p, '.' )) != NULL )
+		{
+		if( pExt != NULL )
+			strcpy( pExt, q );
+		*q		= '\0';
+		}
+	else
+		strcpy( pExt, "" );
+
+	if( pName != NULL )
+		strcpy( pName, p );
+	}
+/*============================================================================*/
+static double Now( void )
+	{
+	struct timespec	Time;
+
+#if			defined __linux__
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+#else	/*	defined __linux__ */
+	timespec_get( &Time, TIME_UTC );
+#endif	/*	defined __linux__ */
+
+	return Time.tv_sec + Time.tv_nsec / 1.0e9;
+	}
+/*============================================================================*/
+pcadsch_t *PCADSchCreate( void )
+	{
+	pcadsch_t	*Context;
+
+	if(( Context = calloc( 1, sizeof( pcadsch_t ))) == NULL )
+		return NULL;
+
+	Context->Cookie.TabSize		= 4;
+	Context->Cookie.Sort		= 1;
+	Context->Cookie.Sections	= SECTION_ALL;
+#if			defined __linux__
+	Context->Threads			= sysconf( _SC_NPROCESSORS_ONLN );
+#else	/*	defined __linux__ */
+	Context->Threads			= 1;
+#endif	/*	defined __linux__ */
+
+	if(( Context->Cookie.Diagnostics = CreateDiagnostics()) == NULL )
+		{
+		free( Context );
+		return NULL;
+		}
+
+	return Context;
+	}
+/*============================================================================*/
+static void ReleaseSchematic( pcadsch_t *Context )
+	{
+	ReleasePCAD( &Context->Cookie );
+	ReleaseHeap( &Context->Cookie.HeapBlocks );
+
+	Context->Schematic	= NULL;
+	Context->Processed	= 0;
+	}
+/*============================================================================*/
+void PCADSchDestroy( pcadsch_t *Context )
+	{
+	if( Context == NULL )
+		return;
+
+	ReleaseSchematic( Context );
+	ReleaseTrace( Context->Cookie.Trace );
+	ReleaseDiagnostics( Context->Cookie.Diagnostics );
+	free( Context->Cookie.Profile );
+#if			defined PCADSCH_COUNTERS
+	if( CurrentCounters == &Context->Cookie.Stats.Counters )
+		CurrentCounters	= NULL;
+#endif	/*	defined PCADSCH_COUNTERS */
+	free( Context->Heap );
+	free( Context );
+	}
+/*============================================================================*/
+int PCADSchSetOption( pcadsch_t *Context, pcadsch_option_t Option, int Value )
+	{
+	switch( Option )
+		{
+		case PCADSCH_OPTION_THREADS:
+			Context->Threads			= Value > 0 ? Value : 1;
+			return 0;
+		case PCADSCH_OPTION_PIPELINE:
+#if			defined __linux__
+			Context->Pipeline			= Value != 0;
+			return 0;
+#else	/*	defined __linux__ */
+			return Value != 0 ? -1 : 0;
+#endif	/*	defined __linux__ */
+		case PCADSCH_OPTION_SECTIONS:
+			Context->Cookie.Sections	= Value & SECTION_ALL;
+			return 0;
+		case PCADSCH_OPTION_TABSIZE:
+			if( Value <= 0 )
+				return -1;
+			Context->Cookie.TabSize		= Value;
+			return 0;
+		case PCADSCH_OPTION_TRACE:
+			if( Value == 0 )
+				{
+				ReleaseTrace( Context->Cookie.Trace );
+				Context->Cookie.Trace	= NULL;
+				}
+			else if( Context->Cookie.Trace == NULL && ( Context->Cookie.Trace = CreateTrace()) == NULL )
+				return -1;
+			return 0;
+		case PCADSCH_OPTION_HEAPPROFILE:
+			if( Value == 0 )
+				{
+				free( Context->Cookie.Profile );
+				Context->Cookie.Profile	= NULL;
+				}
+			else if( Context->Cookie.Profile == NULL && ( Context->Cookie.Profile = calloc( 1, sizeof( heapprofile_t ))) == NULL )
+				return -1;
+			return 0;
+		case PCADSCH_OPTION_DIAGNOSTICS:
+			if( Value != PCADSCH_DIAGNOSTICS_TEXT && Value != PCADSCH_DIAGNOSTICS_JSON && Value != PCADSCH_DIAGNOSTICS_KEEP )
+				return -1;
+			Context->Diagnostics		= Value;
+			return 0;
+		default:
+			return -1;
+		}
+	}
+/*============================================================================*/
+/* The warnings and errors are written when the call that found them returns, unless they are kept. */
+static int ReportDiagnostics( pcadsch_t *Context, int Result )
+	{
+	if( Context->Diagnostics != PCADSCH_DIAGNOSTICS_KEEP )
+		FlushDiagnostics( Context->Cookie.Diagnostics, stderr, Context->Diagnostics == PCADSCH_DIAGNOSTICS_JSON );
+
+	return Result;
+	}
+/*============================================================================*/
+/* Parses from "File" or, if "Buffer" is not NULL, from memory. "Length" is the size of the input, zero if it is not known. */
+static int ParseInput( pcadsch_t *Context, FILE *File, const void *Buffer, size_t Length )
+	{
+	cookie_t	*Cookie	= &Context->Cookie;
+	size_t		Size;
+	double		Start	= Now();
+
+	ReleaseSchematic( Context );
+
+	Cookie->LastError.Code	= 0;
+	memset( &Cookie->Stats, 0, sizeof Cookie->Stats );
+	COUNT_INTO( Cookie );
+	ResetDiagnostics( Cookie->Diagnostics );
+
+	if( Cookie->Trace != NULL )
+		{
+		ResetTrace( Cookie->Trace );
+		TraceThread( Cookie, "main" );
+		}
+
+	if( Cookie->Profile != NULL )
+		memset( Cookie->Profile, 0, sizeof( heapprofile_t ));
+
+	if( setjmp( Cookie->JumpBuffer ) != 0 )
+		{
+#if			defined __linux__
+		StopPipeline( Cookie );
+#endif	/*	defined __linux__ */
+		ReleaseSchematic( Context );
+		return Cookie->LastError.Code;
+		}
+
+	/* The parsed structures never take more than this, the heap grows if the length is not known. */
+	Size					= Length > 0 ? sizeof( void* ) * Length : PCADSCH_INITIAL_HEAP;
+
+	/*
+	The heap is kept from one parse to the next, so a long-lived context does not
+	get new pages each time. There is no need to clear it, "Allocate" does it.
+	*/
+	if( Size > Context->HeapAllocated || Size < Context->HeapAllocated / 4 )
+		{
+		free( Context->Heap );
+		Context->HeapAllocated	= 0;
+		if(( Context->Heap = malloc( Size )) == NULL )
+			ErrorOutput( Cookie, -1, "Not enough memory" );
+		Context->HeapAllocated	= Size;
+		}
+
+	Cookie->File			= File;
+	Cookie->Input			= Buffer;
+	Cookie->InputLength		= Length;
+	Cookie->LineNumber		= 1;
+	Cookie->Column			= 1;
+	Cookie->HeapSize		= Context->HeapAllocated;
+	Cookie->HeapTop			= 0;
+	Cookie->Heap			= Context->Heap;
+	Cookie->HeapBlocks		= NULL;
+	Cookie->FileUnits		= PCAD_UNITS_MIL;
+	Cookie->UngettedToken	= TOKEN_NONE;
+	Cookie->UngetBuffer[0]	= '\0';
+	Cookie->Threads			= Context->Threads;
+	Cookie->Pipeline		= NULL;
+	Cookie->Position		= 0;
+	Cookie->Stats.HeapSize	= Context->HeapAllocated;
+
+#if			defined __linux__
+	/* The sheets are then parsed in sequence, the lexer thread already takes a processor. */
+	if( Context->Pipeline )
+		{
+		Cookie->Threads	= 1;
+		if( StartPipeline( Cookie ) != 0 )
+			ErrorOutput( Cookie, -1, "Could not start the lexer thread" );
+		}
+#endif	/*	defined __linux__ */
+
+	Context->Schematic		= ParsePCAD( Cookie, NULL, NULL );
+
+#if			defined __linux__
+	StopPipeline( Cookie );
+#endif	/*	defined __linux__ */
+
+	Cookie->Input				= NULL;
+	Cookie->Stats.BytesRead		= Cookie->Position;
+	Cookie->Stats.ParseSeconds	= Now() - Start;
+	TraceSpan( Cookie, Start, "parse", "parse" );
+
+	if( Context->Schematic == NULL )
+		{
+		ReleaseSchematic( Context );
+		return Cookie->LastError.Code;
+		}
+
+	return 0;
+	}
+/*============================================================================*/
+/* Pipes and terminals cannot be sized, they are read as they come. */
+int PCADSchParseFile( pcadsch_t *Context, FILE *File )
+	{
+	long	Start, End;
+
+	if(( Start = ftell( File )) < 0 || fseek( File, 0, SEEK_END ) != 0 || ( End = ftell( File )) < 0 || fseek( File, Start, SEEK_SET ) != 0 )
+		return ReportDiagnostics( Context, ParseInput( Context, File, NULL, 0 ));
+
+	return ReportDiagnostics( Context, ParseInput( Context, File, NULL, End - Start ));
+	}
+/*============================================================================*/
+int PCADSchParseBuffer( pcadsch_t *Context, const void *Buffer, size_t Length )
+	{
+	return ReportDiagnostics( Context, ParseInput( Context, NULL, Buffer, Length ));
+	}
+/*============================================================================*/
+int PCADSchParse( pcadsch_t *Context, const char *Path )
+	{
+	FILE	*File;
+	int		Result;
+
+	Context->Cookie.LastError.Code	= 0;
+
+	if( setjmp( Context->Cookie.JumpBuffer ) != 0 )
+		return ReportDiagnostics( Context, Context->Cookie.LastError.Code );
+
+	if(( File = fopen( Path, "rb" )) == NULL )
+		ErrorOutput( &Context->Cookie, -1, "Error opening file \"%s\"", Path );
+
+	Result	= PCADSchParseFile( Context, File );
+
+	fclose( File );
+
+	return Result;
+	}
+/*============================================================================*/
+static const char *ScanTag( const parsefield_t *Field, const char *Tag )
+	{
+	return Tag != NULL ? Tag : Field->TagString;
+	}
+/*============================================================================*/
+static int ScanBegin( void *UserData, const parsefield_t *Field, const char *Tag )
+	{
+	const pcadsch_scanner_t	*Scanner	= UserData;
+
+	return Scanner->Begin != NULL ? Scanner->Begin( Scanner->UserData, ScanTag( Field, Tag )) : 0;
+	}
+/*============================================================================*/
+static int ScanValue( void *UserData, const parsefield_t *Field, const char *Tag, const scanvalue_t *Value )
+	{
+	static const pcadsch_valuekind_t	Kinds[]	=
+		{
+		[SCAN_STRING]		= PCADSCH_VALUE_STRING,
+		[SCAN_NAME]			= PCADSCH_VALUE_NAME,
+		[SCAN_UNSIGNED]		= PCADSCH_VALUE_UNSIGNED,
+		[SCAN_SIGNED]		= PCADSCH_VALUE_SIGNED,
+		[SCAN_REAL]			= PCADSCH_VALUE_REAL,
+		[SCAN_DIMMENSION]	= PCADSCH_VALUE_DIMMENSION,
+		[SCAN_BOOLEAN]		= PCADSCH_VALUE_BOOLEAN,
+		[SCAN_ENUM]			= PCADSCH_VALUE_ENUM
+		};
+	const pcadsch_scanner_t	*Scanner	= UserData;
+	pcadsch_value_t			Public;
+
+	if( Scanner->Value == NULL )
+		return 0;
+
+	Public.Kind		= Kinds[Value->Kind];
+	Public.String	= Value->String;
+	Public.Number	= Value->Number;
+
+	return Scanner->Value( Scanner->UserData, ScanTag( Field, Tag ), &Public );
+	}
+/*============================================================================*/
+static int ScanEnd( void *UserData, const parsefield_t *Field, const char *Tag )
+	{
+	const pcadsch_scanner_t	*Scanner	= UserData;
+
+	return Scanner->End != NULL ? Scanner->End( Scanner->UserData, ScanTag( Field, Tag )) : 0;
+	}
+/*============================================================================*/
+/* Like "ParseInput", but the lexer is not run in its own thread and nothing is allocated. */
+static int ScanInput( pcadsch_t *Context, FILE *File, const void *Buffer, size_t Length, const pcadsch_scanner_t *Scanner )
+	{
+	cookie_t	*Cookie		= &Context->Cookie;
+	scanner_t	Adapter		= { ScanBegin, ScanValue, ScanEnd, (void*)Scanner };
+	double		Start		= Now();
+	int			Result;
+
+	ReleaseSchematic( Context );
+
+	Cookie->LastError.Code	= 0;
+	memset( &Cookie->Stats, 0, sizeof Cookie->Stats );
+	COUNT_INTO( Cookie );
+	ResetDiagnostics( Cookie->Diagnostics );
+
+	Cookie->File			= File;
+	Cookie->Input			= Buffer;
+	Cookie->InputLength		= Length;
+	Cookie->LineNumber		= 1;
+	Cookie->Column			= 1;
+	Cookie->FileUnits		= PCAD_UNITS_MIL;
+	Cookie->UngettedToken	= TOKEN_NONE;
+	Cookie->UngetBuffer[0]	= '\0';
+	Cookie->Pipeline		= NULL;
+	Cookie->Position		= 0;
+
+	Result	= ScanPCAD( Cookie, &Adapter );
+
+	Cookie->Input				= NULL;
+	Cookie->Stats.BytesRead		= Cookie->Position;
+	Cookie->Stats.ParseSeconds	= Now() - Start;
+
+	return Result;
+	}
+/*============================================================================*/
+int PCADSchScanFile( pcadsch_t *Context, FILE *File, const pcadsch_scanner_t *Scanner )
+	{
+	return ReportDiagnostics( Context, ScanInput( Context, File, NULL, 0, Scanner ));
+	}
+/*============================================================================*/
+int PCADSchScanBuffer( pcadsch_t *Context, const void *Buffer, size_t Length, const pcadsch_scanner_t *Scanner )
+	{
+	return ReportDiagnostics( Context, ScanInput( Context, NULL, Buffer, Length, Scanner ));
+	}
+/*============================================================================*/
+int PCADSchScan( pcadsch_t *Context, const char *Path, const pcadsch_scanner_t *Scanner )
+	{
+	FILE	*File;
+	int		Result;
+
+	Context->Cookie.LastError.Code	= 0;
+
+	if( setjmp( Context->Cookie.JumpBuffer ) != 0 )
+		return ReportDiagnostics( Context, Context->Cookie.LastError.Code );
+
+	if(( File = fopen( Path, "rb" )) == NULL )
+		ErrorOutput( &Context->Cookie, -1, "Error opening file \"%s\"", Path );
+
+	Result	= PCADSchScanFile( Context, File, Scanner );
+
+	fclose( File );
+
+	return Result;
+	}
+/*============================================================================*/
+int PCADSchProcess( pcadsch_t *Context )
+	{
+	cookie_t	*Cookie	= &Context->Cookie;
+
+	Cookie->LastError.Code	= 0;
+
+	if( setjmp( Cookie->JumpBuffer ) != 0 )
+		return ReportDiagnostics( Context, Cookie->LastError.Code );
+
+	if( Context->Schematic == NULL )
+		ErrorOutput( Cookie, -1, "There is no schematic to process" );
+
+	/* The outputs all come through here, so they count there too. */
+	COUNT_INTO( Cookie );
+
+	if( !Context->Processed )
+		{
+		double	Start	= Now();
+
+		PCADProcesSchematic( Cookie, Context->Schematic );
+		Context->Processed				= 1;
+		Cookie->Stats.ProcessSeconds	= Now() - Start;
+		TraceSpan( Cookie, Start, "process", "process" );
+		}
+
+	return ReportDiagnostics( Context, 0 );
+	}
+/*============================================================================*/
+int PCADSchWriteKiCAD( pcadsch_t *Context, const char *Name )
+	{
+	double	Start;
+	int		Result;
+
+	/* The output depends on the references resolved while processing. */
+	if(( Result = PCADSchProcess( Context )) != 0 )
+		return Result;
+
+	Start	= Now();
+	Result	= OutputKiCAD( &Context->Cookie, Context->Schematic, Name );
+	Context->Cookie.Stats.OutputSeconds	+= Now() - Start;
+	TraceSpan( &Context->Cookie, Start, "emit", "KiCAD" );
+
+	return ReportDiagnostics( Context, Result );
+	}
+/*============================================================================*/
+int PCADSchWritePCAD( pcadsch_t *Context, const char *Name )
+	{
+	double	Start;
+	int		Result;
+
+	if(( Result = PCADSchProcess( Context )) != 0 )
+		return Result;
+
+	Start	= Now();
+	Result	= OutputPCAD( &Context->Cookie, Context->Schematic, Name );
+	Context->Cookie.Stats.OutputSeconds	+= Now() - Start;
+	TraceSpan( &Context->Cookie, Start, "emit", "P-CAD" );
+
+	return ReportDiagnostics( Context, Result );
+	}
+/*============================================================================*/
+int PCADSchEmitKiCAD( pcadsch_t *Context, const pcadsch_writer_t *Writer )
+	{
+	double	Start;
+	int		Result;
+
+	if(( Result = PCADSchProcess( Context )) != 0 )
+		return Result;
+
+	if( setjmp( Context->Cookie.JumpBuffer ) != 0 )
+		return ReportDiagnostics( Context, Context->Cookie.LastError.Code );
+
+	Start	= Now();
+	Result	= EmitKiCAD( &Context->Cookie, Context->Schematic, Writer );
+	Context->Cookie.Stats.OutputSeconds	+= Now() - Start;
+	TraceSpan( &Context->Cookie, Start, "emit", "KiCAD" );
+
+	return ReportDiagnostics( Context, Result );
+	}
+/*============================================================================*/
+int PCADSchEmitPCAD( pcadsch_t *Context, const pcadsch_writer_t *Writer )
+	{
+	double	Start;
+	int		Result;
+
+	if(( Result = PCADSchProcess( Context )) != 0 )
+		return Result;
+
+	if( setjmp( Context->Cookie.JumpBuffer ) != 0 )
+		return ReportDiagnostics( Context, Context->Cookie.LastError.Code );
+
+	Start	= Now();
+	Result	= EmitPCAD( &Context->Cookie, Context->Schematic, Writer );
+	Context->Cookie.Stats.OutputSeconds	+= Now() - Start;
+	TraceSpan( &Context->Cookie, Start, "emit", "P-CAD" );
+
+	return ReportDiagnostics( Context, Result );
+	}
+/*============================================================================*/
+int PCADSchBufferWrite( void *UserData, const void *Data, size_t Length )
+	{
+	pcadsch_buffer_t	*Buffer	= UserData;
+	size_t				Allocated;
+	char				*p;
+
+	if( Buffer->Length + Length > Buffer->Allocated )
+		{
+		for( Allocated = Buffer->Allocated > 0 ? Buffer->Allocated : 65536; Allocated < Buffer->Length + Length; Allocated *= 2 )
+			;
+		if(( p = realloc( Buffer->Data, Allocated )) == NULL )
+			return -1;
+		Buffer->Data		= p;
+		Buffer->Allocated	= Allocated;
+		}
+
+	memcpy( &Buffer->Data[Buffer->Length], Data, Length );
+	Buffer->Length	+= Length;
+
+	return 0;
+	}
+/*============================================================================*/
+/* The elements are taken from the lists as parsed, so it does not matter whether the schematics were processed. */
+int PCADSchDiff( pcadsch_t *Old, pcadsch_t *New, pcadsch_diff_t Report, void *UserData )
+	{
+	cookie_t	*Cookie	= &Old->Cookie;
+
+	Cookie->LastError.Code	= 0;
+
+	if( setjmp( Cookie->JumpBuffer ) != 0 )
+		return ReportDiagnostics( Old, Cookie->LastError.Code );
+
+	if( Old->Schematic == NULL || New->Schematic == NULL )
+		ErrorOutput( Cookie, -1, "There is no schematic to compare" );
+
+	return ReportDiagnostics( Old, DiffPCAD( Cookie, Old->Schematic, New->Schematic, Report, UserData ));
+	}
+/*============================================================================*/
+/* Processing builds the arrays the output uses from the lists, so it must come after the merge changes them. */
+int PCADSchMerge( pcadsch_t *Base, pcadsch_t *Ours, pcadsch_t *Theirs, pcadsch_conflict_t Report, void *UserData )
+	{
+	cookie_t	*Cookie	= &Ours->Cookie;
+
+	Cookie->LastError.Code	= 0;
+
+	if( setjmp( Cookie->JumpBuffer ) != 0 )
+		return ReportDiagnostics( Ours, Cookie->LastError.Code );
+
+	if( Base->Schematic == NULL || Ours->Schematic == NULL || Theirs->Schematic == NULL )
+		ErrorOutput( Cookie, -1, "There is no schematic to merge" );
+	if( Ours->Processed )
+		ErrorOutput( Cookie, -1, "The schematic was already processed" );
+
+	return ReportDiagnostics( Ours, MergePCAD( Cookie, Base->Schematic, Ours->Schematic, Theirs->Schematic, Report, UserData ));
+	}
+/*============================================================================*/
+const pcad_schematicfile_t *PCADSchGetSchematic( const pcadsch_t *Context )
+	{
+	return Context->Schematic;
+	}
+/*============================================================================*/
+/* The heap in use is counted as it is now, the processing and the outputs also take from it. */
+int PCADSchGetStats( const pcadsch_t *Context, pcadsch_stats_t *Stats )
+	{
+	*Stats			 = Context->Cookie.Stats;
+	Stats->HeapUsed	+= Context->Cookie.HeapTop;
+
+	return 0;
+	}
+/*============================================================================*/
+int PCADSchWriteTrace( const pcadsch_t *Context, FILE *File )
+	{
+	if( Context->Cookie.Trace == NULL )
+		return -1;
+
+	return WriteTrace( Context->Cookie.Trace, File );
+	}
+/*============================================================================*/
+int PCADSchGetHeapProfile( const pcadsch_t *Context, pcadsch_heapsite_t *Sites, int Max )
+	{
+	if( Context->Cookie.Profile == NULL )
+		return -1;
+
+	return ListHeapProfile( Context->Cookie.Profile, Sites, Max );
+	}
+/*============================================================================*/
+int PCADSchGetDiagnostics( const pcadsch_t *Context, pcadsch_diagnostic_t *Diagnostics, int Max )
+	{
+	return ListDiagnostics( Context->Cookie.Diagnostics, Diagnostics, Max );
+	}
+/*============================================================================*/
+int PCADSchGetError( const pcadsch_t *Context, unsigned *LineNumber, unsigned *Column, const char **Message )
+	{
+	const parseerror_t	*Error	= &Context->Cookie.LastError;
+
+	if( LineNumber != NULL )
+		*LineNumber	= Error->LineNumber;
+	if( Column != NULL )
+		*Column		= Error->Column;
+	if( Message != NULL )
+		*Message	= Error->Message;
+
+	return Error->Code;
+	}
+/*============================================================================*/
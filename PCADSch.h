@@ -0,0 +1,370 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+/*============================================================================*/
+#if			!defined __PCADSCH_H__
+#define __PCADSCH_H__
+/*============================================================================*/
+/*
+libpcadsch: converts P-CAD 2006 ASCII schematics to KiCAD or to sorted P-CAD.
+
+All the state of a conversion is kept in its context, so any number of
+conversions may run at the same time, each one in its own thread.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include "PCADStructs.h"
+/*============================================================================*/
+typedef struct pcadsch_tag	pcadsch_t;
+/*============================================================================*/
+typedef enum
+	{
+	/* Number of threads used to parse the sheets, the default is the number of processors. */
+	PCADSCH_OPTION_THREADS,
+	/* Non-zero runs the lexical analysis in a separate thread (Linux only). */
+	PCADSCH_OPTION_PIPELINE,
+	/* The sections to parse, an OR of the PCADSCH_SECTION_* values. */
+	PCADSCH_OPTION_SECTIONS,
+	/* Used to compute the columns reported in the messages, the default is 4. */
+	PCADSCH_OPTION_TABSIZE,
+	/* Non-zero records a timeline of each conversion, see PCADSchWriteTrace. */
+	PCADSCH_OPTION_TRACE,
+	/* Non-zero counts the allocations in the heap by kind and site, see PCADSchGetHeapProfile. */
+	PCADSCH_OPTION_HEAPPROFILE,
+	/* How the warnings and errors are reported, one of the PCADSCH_DIAGNOSTICS_* values, the default is text. */
+	PCADSCH_OPTION_DIAGNOSTICS
+	} pcadsch_option_t;
+/*----------------------------------------------------------------------------*/
+/*
+The warnings and errors found by each call are written to the standard error
+when it returns, as text or as one JSON object per line, or they are kept until
+the next parse for PCADSchGetDiagnostics.
+*/
+#define	PCADSCH_DIAGNOSTICS_TEXT	0
+#define	PCADSCH_DIAGNOSTICS_JSON	1
+#define	PCADSCH_DIAGNOSTICS_KEEP	2
+/*----------------------------------------------------------------------------*/
+#define PCADSCH_SECTION_LIBRARY		 16
+#define PCADSCH_SECTION_NETLIST		 32
+#define PCADSCH_SECTION_SHEETS		 64
+#define PCADSCH_SECTION_SETTINGS	128
+#define PCADSCH_SECTION_ALL			( PCADSCH_SECTION_LIBRARY | PCADSCH_SECTION_NETLIST | PCADSCH_SECTION_SHEETS | PCADSCH_SECTION_SETTINGS )
+/*============================================================================*/
+/*
+Receives the output of PCADSchEmitKiCAD and PCADSchEmitPCAD. "Begin" and "End"
+are optional and delimit each of the outputs: KiCAD produces one per sheet and
+"Begin" gets the name of the sheet, P-CAD produces just one and "Begin" gets
+NULL. A callback returning non-zero aborts the conversion.
+*/
+typedef struct
+	{
+	int							(*Begin)	( void *UserData, const char *Name );
+	int							(*Write)	( void *UserData, const void *Data, size_t Length );
+	int							(*End)		( void *UserData );
+	void						*UserData;
+	} pcadsch_writer_t;
+/*----------------------------------------------------------------------------*/
+typedef enum
+	{
+	PCADSCH_ADDED,
+	PCADSCH_REMOVED,
+	PCADSCH_CHANGED
+	} pcadsch_change_t;
+/*----------------------------------------------------------------------------*/
+/*
+Receives each difference found by PCADSchDiff. "Kind" is the P-CAD keyword of
+the element, like "symbol" or "wire", and "Name" tells which one it is, empty
+for the sections of the file. "Container" is the element holding it, like
+"sheet \"Sheet1\"", or NULL for the sections. A callback returning non-zero
+stops the comparison and PCADSchDiff returns that value.
+*/
+typedef int (*pcadsch_diff_t)( void *UserData, pcadsch_change_t Change, const char *Container, const char *Kind, const char *Name );
+/*----------------------------------------------------------------------------*/
+/*
+Receives each element PCADSchMerge could not merge because both sides changed
+it in different ways, "Ours" and "Theirs" tell what each side did to it. The
+element is left as it is in "Ours". A callback returning non-zero stops the
+reports, not the merge.
+*/
+typedef int (*pcadsch_conflict_t)( void *UserData, pcadsch_change_t Ours, pcadsch_change_t Theirs, const char *Container, const char *Kind, const char *Name );
+/*----------------------------------------------------------------------------*/
+/* A growable buffer for PCADSchBufferWrite, start it zeroed and release "Data" with "free". */
+typedef struct
+	{
+	char						*Data;
+	size_t						Length;
+	size_t						Allocated;
+	} pcadsch_buffer_t;
+/*----------------------------------------------------------------------------*/
+/* The kinds of tokens counted by PCADSchGetStats. */
+typedef enum
+	{
+	PCADSCH_TOKEN_CLOSE_PAR,
+	PCADSCH_TOKEN_OPEN_PAR,
+	PCADSCH_TOKEN_NAME,
+	PCADSCH_TOKEN_STRING,
+	PCADSCH_TOKEN_UNSIGNED,
+	PCADSCH_TOKEN_INTEGER,
+	PCADSCH_TOKEN_FLOAT,
+	PCADSCH_NUM_TOKENS
+	} pcadsch_token_t;
+/*----------------------------------------------------------------------------*/
+#define	PCADSCH_MAX_SKIPPED			32
+/*----------------------------------------------------------------------------*/
+/* An element unknown to the parser, skipped "Count" times, the first one at "LineNumber" and "Column". */
+typedef struct
+	{
+	char						Tag[32];
+	unsigned long				Count;
+	unsigned					LineNumber;
+	unsigned					Column;
+	} pcadsch_skipped_t;
+/*----------------------------------------------------------------------------*/
+/* The lookups counted when the library is built with PCADSCH_COUNTERS. */
+typedef enum
+	{
+	PCADSCH_FIND_BUSENTRY,
+	PCADSCH_FIND_PIN,
+	PCADSCH_FIND_COMPDEF,
+	PCADSCH_FIND_SYMBOLDEF,
+	PCADSCH_FIND_SYMBOLDEF_BY_ORIGINAL_NAME,
+	PCADSCH_FIND_ATTR_IN_NETLIST,
+	PCADSCH_FIND_ATTR,
+	PCADSCH_FIND_COMPINST,
+	PCADSCH_FIND_PREVIOUS,
+	PCADSCH_NUM_FINDS
+	} pcadsch_find_t;
+/*----------------------------------------------------------------------------*/
+/* "Probes" is the number of elements looked at, "Probes / Calls" growing with the file is a quadratic. */
+typedef struct
+	{
+	uint64_t					Calls;
+	uint64_t					Probes;
+	} pcadsch_lookup_t;
+/*----------------------------------------------------------------------------*/
+#define	PCADSCH_MAX_SORTED			64
+/*----------------------------------------------------------------------------*/
+/* A collection sorted "Sorts" times, with "Elements" elements in all, named as in the source. */
+typedef struct
+	{
+	char						Collection[64];
+	uint64_t					Sorts;
+	uint64_t					Elements;
+	uint64_t					Comparisons;
+	} pcadsch_sorted_t;
+/*----------------------------------------------------------------------------*/
+/*
+The calls on the hot paths. They are counted only if the library is built with
+PCADSCH_COUNTERS, which sets "Enabled", otherwise they are all zero. The bytes
+skipped are those of the elements skipped, which the lexer did not tokenize
+when it could avoid it.
+*/
+typedef struct
+	{
+	int							Enabled;
+	pcadsch_lookup_t			Finds[PCADSCH_NUM_FINDS];
+	uint64_t					CompareNames;
+	uint64_t					UngetTokens;
+	uint64_t					SkipAlls;
+	uint64_t					BytesSkipped;
+	/* The collections that do not fit in "Sorted" are only counted in "OtherComparisons". */
+	unsigned					NumSorted;
+	uint64_t					OtherComparisons;
+	pcadsch_sorted_t			Sorted[PCADSCH_MAX_SORTED];
+	} pcadsch_counters_t;
+/*----------------------------------------------------------------------------*/
+/*
+What the last parse and what followed it went through, see PCADSchGetStats.
+The parsed structures live in a heap of "HeapSize" bytes, set aside from the
+size of the input, and "HeapBlocks" tells how many more blocks it took when
+that was not enough. The times of the outputs add up.
+*/
+typedef struct
+	{
+	double						ParseSeconds;
+	double						ProcessSeconds;
+	double						OutputSeconds;
+	uint64_t					BytesRead;
+	uint64_t					BytesWritten;
+	uint64_t					Tokens[PCADSCH_NUM_TOKENS];
+	uint64_t					HeapSize;
+	uint64_t					HeapUsed;
+	unsigned					HeapBlocks;
+	uint64_t					StringBytes;
+	/* The tags that do not fit in "Skipped" are only counted in "OtherSkipped". */
+	unsigned					NumSkipped;
+	unsigned long				OtherSkipped;
+	pcadsch_skipped_t			Skipped[PCADSCH_MAX_SKIPPED];
+	pcadsch_counters_t			Counters;
+	} pcadsch_stats_t;
+/*----------------------------------------------------------------------------*/
+/*
+One kind of allocation in the heap of the schematic, see PCADSchGetHeapProfile.
+The elements parsed are of the kind of their P-CAD keyword, like "pin" or "pt",
+and their site is "parse". The strings are of the kind "string" and their site
+is the keyword of their field, if it has one. The rest were allocated while
+processing: their kind is the type allocated, with "[]" for the arrays, and
+their site is the function that allocated them. The padding that keeps the
+elements aligned is of the kind "alignment".
+*/
+typedef struct
+	{
+	char						Kind[48];
+	char						Site[48];
+	uint64_t					Count;
+	uint64_t					Bytes;
+	} pcadsch_heapsite_t;
+/*----------------------------------------------------------------------------*/
+typedef enum
+	{
+	PCADSCH_SEVERITY_WARNING,
+	PCADSCH_SEVERITY_ERROR
+	} pcadsch_severity_t;
+/*----------------------------------------------------------------------------*/
+/*
+A warning or an error, see PCADSchGetDiagnostics. The same message found again
+is counted in "Count", at the position of the first one. After a few different
+messages made in the same place the rest are only counted, in "More" of the
+last one kept. "LineNumber" and "Column" are zero if it is not related to the
+input.
+*/
+typedef struct
+	{
+	pcadsch_severity_t			Severity;
+	unsigned					LineNumber;
+	unsigned					Column;
+	unsigned long				Count;
+	unsigned long				More;
+	char						Message[256];
+	} pcadsch_diagnostic_t;
+/*----------------------------------------------------------------------------*/
+/* The kinds of the values reported by PCADSchScan. */
+typedef enum
+	{
+	PCADSCH_VALUE_STRING,
+	PCADSCH_VALUE_NAME,
+	PCADSCH_VALUE_UNSIGNED,
+	PCADSCH_VALUE_SIGNED,
+	PCADSCH_VALUE_REAL,
+	PCADSCH_VALUE_DIMMENSION,
+	PCADSCH_VALUE_BOOLEAN,
+	PCADSCH_VALUE_ENUM
+	} pcadsch_valuekind_t;
+/*----------------------------------------------------------------------------*/
+/*
+A value found by PCADSchScan. "String" holds the strings and the names and is
+valid only during the callback, "Number" holds the rest: the dimensions and the
+reals as in "pcad_dimmension_t" and "pcad_real_t", the enumerations as in
+"PCADEnums.h".
+*/
+typedef struct
+	{
+	pcadsch_valuekind_t			Kind;
+	const char					*String;
+	int64_t						Number;
+	} pcadsch_value_t;
+/*----------------------------------------------------------------------------*/
+/*
+Receives what PCADSchScan finds, in the order of the file. "Begin" and "End"
+delimit each element and get its keyword, like "compInst" or "wire", "Value"
+gets each value with the keyword of its field. The keyword is NULL for the
+fields that have none of their own. Any of the callbacks may be NULL, one
+returning non-zero stops the scan and PCADSchScan returns that value.
+*/
+typedef struct
+	{
+	int							(*Begin)	( void *UserData, const char *Tag );
+	int							(*Value)	( void *UserData, const char *Tag, const pcadsch_value_t *Value );
+	int							(*End)		( void *UserData, const char *Tag );
+	void						*UserData;
+	} pcadsch_scanner_t;
+/*============================================================================*/
+/* All the functions returning "int" return zero on success and a negative value on error. */
+/*----------------------------------------------------------------------------*/
+pcadsch_t					*PCADSchCreate			( void );
+void						PCADSchDestroy			( pcadsch_t *Context );
+int							PCADSchSetOption		( pcadsch_t *Context, pcadsch_option_t Option, int Value );
+
+/* The file is read from its current position, it is not closed. */
+int							PCADSchParseFile		( pcadsch_t *Context, FILE *File );
+int							PCADSchParse			( pcadsch_t *Context, const char *Path );
+/* The buffer is needed only during the call. */
+int							PCADSchParseBuffer		( pcadsch_t *Context, const void *Buffer, size_t Length );
+int							PCADSchProcess			( pcadsch_t *Context );
+
+/*
+Reads a file as the parse does, but only reports its elements and values to
+"Scanner", nothing is kept and the schematic parsed before is released. The
+sections read are those of PCADSCH_OPTION_SECTIONS.
+*/
+int							PCADSchScanFile			( pcadsch_t *Context, FILE *File, const pcadsch_scanner_t *Scanner );
+int							PCADSchScan				( pcadsch_t *Context, const char *Path, const pcadsch_scanner_t *Scanner );
+int							PCADSchScanBuffer		( pcadsch_t *Context, const void *Buffer, size_t Length, const pcadsch_scanner_t *Scanner );
+
+/* KiCAD creates one file per sheet, named after "Name" and the sheet. */
+int							PCADSchWriteKiCAD		( pcadsch_t *Context, const char *Name );
+int							PCADSchWritePCAD		( pcadsch_t *Context, const char *Name );
+
+/* The same, without touching the file system. */
+int							PCADSchEmitKiCAD		( pcadsch_t *Context, const pcadsch_writer_t *Writer );
+int							PCADSchEmitPCAD			( pcadsch_t *Context, const pcadsch_writer_t *Writer );
+/* A "Write" callback appending to the "pcadsch_buffer_t" given as "UserData". */
+int							PCADSchBufferWrite		( void *UserData, const void *Data, size_t Length );
+
+/* Compares the schematics parsed in two contexts, returns the number of differences or a negative value on error. */
+int							PCADSchDiff				( pcadsch_t *Old, pcadsch_t *New, pcadsch_diff_t Report, void *UserData );
+/*
+Merges into "Ours" the changes from "Base" to "Theirs", returns the number of
+conflicts or a negative value on error. "Ours" must not have been processed yet
+and "Theirs" must be kept until "Ours" is written, part of it may be moved there.
+*/
+int							PCADSchMerge			( pcadsch_t *Base, pcadsch_t *Ours, pcadsch_t *Theirs, pcadsch_conflict_t Report, void *UserData );
+
+const pcad_schematicfile_t	*PCADSchGetSchematic	( const pcadsch_t *Context );
+/* Returns the code of the last error, "LineNumber" and "Column" are zero if it is not related to the input. */
+int							PCADSchGetError			( const pcadsch_t *Context, unsigned *LineNumber, unsigned *Column, const char **Message );
+int							PCADSchGetStats			( const pcadsch_t *Context, pcadsch_stats_t *Stats );
+/*
+Writes the timeline recorded since the last parse as Chrome trace events, for
+Perfetto or "chrome://tracing". Fails if PCADSCH_OPTION_TRACE was not set.
+*/
+int							PCADSchWriteTrace		( const pcadsch_t *Context, FILE *File );
+/*
+Copies up to "Max" of the kinds of allocation made since the last parse, the
+largest first, and returns how many there are. Fails if
+PCADSCH_OPTION_HEAPPROFILE was not set.
+*/
+int							PCADSchGetHeapProfile	( const pcadsch_t *Context, pcadsch_heapsite_t *Sites, int Max );
+/*
+Copies up to "Max" of the warnings and errors, in the order they were found, and
+returns how many there are. They are kept from one parse to the next only with
+PCADSCH_DIAGNOSTICS_KEEP, otherwise each call writes them and forgets them.
+*/
+int							PCADSchGetDiagnostics	( const pcadsch_t *Context, pcadsch_diagnostic_t *Diagnostics, int Max );
+
+void						SplitPath				( const char *pFullPath, char *pPath, char *pName, char *pExt );
+/*============================================================================*/
+#endif	/*	!defined __PCADSCH_H__ */
+/*============================================================================*/
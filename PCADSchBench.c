@@ -0,0 +1,416 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+/*
+Runs the phases of the conversion over each schematic given, from the smallest
+to the largest, and writes their timings as JSON: wall time, throughput and the
+peak resident set size of each phase. The peak of the process is reset before
+each phase, so it is the peak of that phase alone, and "rss_growth_kb" is how
+much of it the phase added to what was already resident. Both are zero where
+the peak cannot be reset. The "scaling" section is the exponent
+of the time of each phase on the size of the input, fitted over all the runs,
+so 1.0 is linear growth and 2.0 quadratic.
+
+"parse" includes its own lexical analysis, "lex" alone tells how much of it that
+is. The outputs are produced in memory, the file system is not timed.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "PCADSch.h"
+#include "Lexic.h"
+#include "OutputFile.h"
+/*============================================================================*/
+enum
+	{
+	PHASE_LEX,
+	PHASE_PARSE,
+	PHASE_PROCESS,
+	PHASE_KICAD,
+	PHASE_PCAD,
+	NUM_PHASES
+	};
+/*----------------------------------------------------------------------------*/
+static const char	*PhaseNames[NUM_PHASES]	=
+	{
+	[PHASE_LEX]		= "lex",
+	[PHASE_PARSE]	= "parse",
+	[PHASE_PROCESS]	= "process",
+	[PHASE_KICAD]	= "output_kicad",
+	[PHASE_PCAD]	= "output_pcad"
+	};
+/*============================================================================*/
+typedef struct
+	{
+	const char		*Path;
+	size_t			Bytes;
+	unsigned long	Elements;
+	double			Seconds[NUM_PHASES];
+	long			PeakRSS[NUM_PHASES];
+	long			RSSGrowth[NUM_PHASES];
+	} run_t;
+/*============================================================================*/
+static double Now( void )
+	{
+	struct timespec	Time;
+
+#if			defined __linux__
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+#else	/*	defined __linux__ */
+	timespec_get( &Time, TIME_UTC );
+#endif	/*	defined __linux__ */
+
+	return Time.tv_sec + Time.tv_nsec / 1.0e9;
+	}
+/*============================================================================*/
+/* Non-zero while the peak of the process can be reset, see "Begin". */
+static int	CanResetPeak	= 1;
+/* What was resident when the current phase began. */
+static long	StartRSS;
+/*============================================================================*/
+/*
+Writing "5" to "clear_refs" resets the peak resident set size of the process
+(VmHWM) to its current size, from Linux 4.0 on. Returns non-zero if it could not.
+*/
+static int ResetPeakRSS( void )
+	{
+#if			defined __linux__
+	FILE	*f;
+	int		Result;
+
+	if(( f = fopen( "/proc/self/clear_refs", "w" )) != NULL )
+		{
+		Result	= fputs( "5", f ) < 0;
+		return ( fclose( f ) != 0 ) | Result;
+		}
+#endif	/*	defined __linux__ */
+
+	return -1;
+	}
+/*============================================================================*/
+/* A size from "/proc/self/status", e.g. "VmHWM:", in kilobytes, zero where it is not available. */
+static long StatusSize( const char *Field )
+	{
+	long	Size	= 0;
+#if			defined __linux__
+	char	Line[256];
+	size_t	Length	= strlen( Field );
+	FILE	*f;
+
+	if(( f = fopen( "/proc/self/status", "r" )) != NULL )
+		{
+		while( fgets( Line, sizeof Line, f ) != NULL && !( strncmp( Line, Field, Length ) == 0 && sscanf( Line + Length, "%ld", &Size ) == 1 ))
+			{}
+		fclose( f );
+		}
+#endif	/*	defined __linux__ */
+
+	return Size;
+	}
+/*============================================================================*/
+/* Starts timing a phase, with the peak of the process brought down to what is resident now. */
+static double Begin( void )
+	{
+	if( CanResetPeak && ResetPeakRSS() != 0 )
+		CanResetPeak	= 0;
+	StartRSS	= StatusSize( "VmRSS:" );
+
+	return Now();
+	}
+/*============================================================================*/
+static int CountWrite( void *UserData, const void *Data, size_t Length )
+	{
+	*(size_t*)UserData += Length;
+
+	return 0;
+	}
+/*============================================================================*/
+/* Every element of a P-CAD file is a parenthesized list, so they are counted by their opening parentheses. */
+static int Lex( const char *Data, size_t Length, unsigned long *Elements )
+	{
+	static char	Buffer[65536];
+	cookie_t	Cookie;
+	token_t		Token;
+
+	memset( &Cookie, 0, sizeof Cookie );
+	Cookie.Input			= Data;
+	Cookie.InputLength		= Length;
+	Cookie.LineNumber		= 1;
+	Cookie.Column			= 1;
+	Cookie.TabSize			= 4;
+	Cookie.UngettedToken	= TOKEN_NONE;
+
+	if( setjmp( Cookie.JumpBuffer ) != 0 )
+		return -1;
+
+	for( *Elements = 0; ( Token = GetToken( &Cookie, Buffer, sizeof Buffer )) != TOKEN_EOF; )
+		if( Token == TOKEN_INVALID )
+			return -1;
+		else if( Token == TOKEN_OPEN_PAR )
+			++*Elements;
+
+	return 0;
+	}
+/*============================================================================*/
+static void Keep( run_t *Run, int Phase, double Start, int Repetition )
+	{
+	double	Seconds	= Now() - Start;
+	long	Peak	= CanResetPeak ? StatusSize( "VmHWM:" ) : 0;
+	long	Growth	= CanResetPeak ? Peak - StartRSS : 0;
+
+	if( Repetition == 0 || Seconds < Run->Seconds[Phase] )
+		Run->Seconds[Phase]	= Seconds;
+	if( Repetition == 0 || Peak > Run->PeakRSS[Phase] )
+		Run->PeakRSS[Phase]	= Peak;
+	if( Repetition == 0 || Growth > Run->RSSGrowth[Phase] )
+		Run->RSSGrowth[Phase]	= Growth;
+	}
+/*============================================================================*/
+/* The best time of "Repeat" conversions, each one from the start, because the outputs change the processed schematic. */
+static int Measure( run_t *Run, const char *Data, int Repeat, int Threads )
+	{
+	pcadsch_writer_t	Writer	= { .Write = CountWrite };
+	pcadsch_t			*Context;
+	size_t				Output;
+	double				Start;
+	int					i, Result = 0;
+
+	Writer.UserData	= &Output;
+
+	for( i = 0; i < Repeat && Result == 0; i++ )
+		{
+		Start	= Begin();
+		if(( Result = Lex( Data, Run->Bytes, &Run->Elements )) != 0 )
+			break;
+		Keep( Run, PHASE_LEX, Start, i );
+
+		if(( Context = PCADSchCreate()) == NULL )
+			return -1;
+		PCADSchSetOption( Context, PCADSCH_OPTION_THREADS, Threads );
+
+		Start	= Begin();
+		if(( Result = PCADSchParseBuffer( Context, Data, Run->Bytes )) == 0 )
+			{
+			Keep( Run, PHASE_PARSE, Start, i );
+
+			Start	= Begin();
+			if(( Result = PCADSchProcess( Context )) == 0 )
+				{
+				Keep( Run, PHASE_PROCESS, Start, i );
+
+				Start	= Begin();
+				if(( Result = PCADSchEmitKiCAD( Context, &Writer )) == 0 )
+					{
+					Keep( Run, PHASE_KICAD, Start, i );
+
+					Start	= Begin();
+					if(( Result = PCADSchEmitPCAD( Context, &Writer )) == 0 )
+						Keep( Run, PHASE_PCAD, Start, i );
+					}
+				}
+			}
+
+		PCADSchDestroy( Context );
+		}
+
+	return Result;
+	}
+/*============================================================================*/
+/* Returns -1 if the file cannot be read. */
+static long FileSize( const char *Path )
+	{
+	FILE	*f;
+	long	Size	= -1;
+
+	if(( f = fopen( Path, "rb" )) == NULL )
+		return -1;
+
+	if( fseek( f, 0, SEEK_END ) == 0 )
+		Size	= ftell( f );
+
+	fclose( f );
+
+	return Size;
+	}
+/*============================================================================*/
+static char *ReadFile( const char *Path, size_t Length )
+	{
+	FILE	*f;
+	char	*Data	= NULL;
+
+	if(( f = fopen( Path, "rb" )) == NULL )
+		return NULL;
+
+	if(( Data = malloc( Length + 1 )) != NULL && fread( Data, 1, Length, f ) != Length )
+		{
+		free( Data );
+		Data	= NULL;
+		}
+
+	fclose( f );
+
+	return Data;
+	}
+/*============================================================================*/
+/* Least squares on the logarithms, zero if the sizes do not vary. */
+static double Exponent( const run_t *Runs, int NumRuns, int Phase )
+	{
+	double	x, y, SumX = 0, SumY = 0, SumXX = 0, SumXY = 0, Divisor;
+	int		i;
+
+	for( i = 0; i < NumRuns; i++ )
+		{
+		x		 = log( (double)Runs[i].Bytes );
+		y		 = log( Runs[i].Seconds[Phase] > 0 ? Runs[i].Seconds[Phase] : 1.0e-9 );
+		SumX	+= x;
+		SumY	+= y;
+		SumXX	+= x * x;
+		SumXY	+= x * y;
+		}
+
+	Divisor	= NumRuns * SumXX - SumX * SumX;
+
+	return Divisor > 1.0e-9 ? ( NumRuns * SumXY - SumX * SumY ) / Divisor : 0;
+	}
+/*============================================================================*/
+/* Just the characters a path may have that JSON does not take as they are. */
+static void OutputJSON( FILE *f, const run_t *Runs, int NumRuns, int Repeat, int Threads )
+	{
+	int	i, j;
+
+	fprintf( f, "{\n  \"repeat\": %d,\n  \"threads\": %d,\n  \"runs\": [\n", Repeat, Threads );
+	for( i = 0; i < NumRuns; i++ )
+		{
+		fprintf( f, "    {\n      \"file\": " );
+		WriteJSONString( f, Runs[i].Path );
+		fprintf( f, ",\n      \"bytes\": %zu,\n      \"elements\": %lu,\n      \"phases\": {\n", Runs[i].Bytes, Runs[i].Elements );
+		for( j = 0; j < NUM_PHASES; j++ )
+			{
+			double	Seconds	= Runs[i].Seconds[j] > 0 ? Runs[i].Seconds[j] : 1.0e-9;
+
+			fprintf( f, "        \"%s\": { \"seconds\": %.6f, \"mb_per_s\": %.3f, \"elements_per_s\": %.0f, \"peak_rss_kb\": %ld, \"rss_growth_kb\": %ld }%s\n",
+				PhaseNames[j], Runs[i].Seconds[j], Runs[i].Bytes / 1.0e6 / Seconds, Runs[i].Elements / Seconds, Runs[i].PeakRSS[j], Runs[i].RSSGrowth[j], j < NUM_PHASES - 1 ? "," : "" );
+			}
+		fprintf( f, "      }\n    }%s\n", i < NumRuns - 1 ? "," : "" );
+		}
+	fprintf( f, "  ],\n  \"scaling\": {\n" );
+	for( j = 0; j < NUM_PHASES; j++ )
+		fprintf( f, "    \"%s\": %.3f%s\n", PhaseNames[j], Exponent( Runs, NumRuns, j ), j < NUM_PHASES - 1 ? "," : "" );
+	fprintf( f, "  }\n}\n" );
+	}
+/*============================================================================*/
+static int CompareRuns( const void *a, const void *b )
+	{
+	const run_t	*pa	= a;
+	const run_t	*pb	= b;
+
+	return pa->Bytes < pb->Bytes ? -1 : pa->Bytes > pb->Bytes;
+	}
+/*============================================================================*/
+int main( int ArgC, char *ArgV[] )
+	{
+	const char	*PathOut	= NULL;
+	run_t		*Runs;
+	char		*Data;
+	FILE		*f			= stdout;
+	int			i, NumRuns, Repeat = 3, Threads = 1, Result = 0;
+
+	for( i = 1; i + 1 < ArgC && strncmp( ArgV[i], "--", 2 ) == 0; i += 2 )
+		{
+		if( strcmp( ArgV[i], "--repeat" ) == 0 )
+			Repeat	= atoi( ArgV[i+1] );
+		else if( strcmp( ArgV[i], "--threads" ) == 0 )
+			Threads	= atoi( ArgV[i+1] );
+		else if( strcmp( ArgV[i], "--json" ) == 0 )
+			PathOut	= ArgV[i+1];
+		else
+			break;
+		}
+
+	if( i >= ArgC || strncmp( ArgV[i], "--", 2 ) == 0 || Repeat < 1 || Threads < 1 )
+		{
+		fprintf( stderr, "\nUsage: %s [--repeat <n>] [--threads <n>] [--json <fileout>] <schematic>...\n\n", ArgV[0] );
+		return -1;
+		}
+
+	if(( Runs = calloc( ArgC - i, sizeof( run_t ))) == NULL )
+		{
+		fprintf( stderr, "\nNot enough memory.\n\n" );
+		return -1;
+		}
+
+	for( NumRuns = 0; i < ArgC && Result == 0; i++, NumRuns++ )
+		{
+		long	Size;
+
+		Runs[NumRuns].Path	= ArgV[i];
+		if(( Size = FileSize( ArgV[i] )) < 0 )
+			{
+			fprintf( stderr, "\nError reading file \"%s\".\n\n", ArgV[i] );
+			Result	= -1;
+			}
+		Runs[NumRuns].Bytes	= Size;
+		}
+
+	qsort( Runs, NumRuns, sizeof( run_t ), CompareRuns );
+
+	for( i = 0; i < NumRuns && Result == 0; i++ )
+		{
+		if(( Data = ReadFile( Runs[i].Path, Runs[i].Bytes )) == NULL )
+			{
+			fprintf( stderr, "\nError reading file \"%s\".\n\n", Runs[i].Path );
+			Result	= -1;
+			}
+		else if( Measure( &Runs[i], Data, Repeat, Threads ) != 0 )
+			{
+			fprintf( stderr, "\nError converting file \"%s\".\n\n", Runs[i].Path );
+			Result	= -1;
+			}
+		free( Data );
+		}
+
+	if( Result == 0 )
+		{
+		if( PathOut != NULL && ( f = fopen( PathOut, "w" )) == NULL )
+			{
+			fprintf( stderr, "\nError creating file \"%s\".\n\n", PathOut );
+			Result	= -1;
+			}
+		else
+			{
+			OutputJSON( f, Runs, NumRuns, Repeat, Threads );
+			if( f != stdout )
+				fclose( f );
+			}
+		}
+
+	free( Runs );
+
+	return Result;
+	}
+/*============================================================================*/
@@ -0,0 +1,462 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+/*
+Generates synthetic P-CAD 2006 ASCII schematics of any size, following the same
+grammar the tables in PCADParser.c accept, for the scaling benchmarks and for
+reproducing the cases that only show up on big designs.
+
+The output depends only on the parameters and the seed.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+/*============================================================================*/
+typedef struct
+	{
+	const char		*Name;
+	unsigned long	Value;
+	const char		*Description;
+	} parameter_t;
+/*============================================================================*/
+enum
+	{
+	PARAM_SHEETS,
+	PARAM_SYMBOLS,
+	PARAM_LIBRARY,
+	PARAM_PINS,
+	PARAM_WIRES,
+	PARAM_BUSES,
+	PARAM_BUSENTRIES,
+	PARAM_STRINGS,
+	PARAM_SEED
+	};
+/*----------------------------------------------------------------------------*/
+static parameter_t	Parameters[]	=
+	{
+	[PARAM_SHEETS]		= { "--sheets",		 4,	"sheets" },
+	[PARAM_SYMBOLS]		= { "--symbols",	50,	"symbols per sheet" },
+	[PARAM_LIBRARY]		= { "--library",	10,	"symbol definitions in the library" },
+	[PARAM_PINS]		= { "--pins",		 8,	"pins per part" },
+	[PARAM_WIRES]		= { "--wires",		 1,	"wire segments from each pin to its net" },
+	[PARAM_BUSES]		= { "--buses",		 1,	"buses per sheet" },
+	[PARAM_BUSENTRIES]	= { "--busentries",	16,	"bus entries per bus, each with its wire" },
+	[PARAM_STRINGS]		= { "--strings",	 8,	"minimum length of the names" },
+	[PARAM_SEED]		= { "--seed",		 1,	"seed of the pseudo-random choices" }
+	};
+/*============================================================================*/
+#define	PARAM( p )		( Parameters[PARAM_##p].Value )
+/*============================================================================*/
+/* The symbols are placed in a grid, the coordinates are in mils. */
+#define	PIN_PITCH		100
+#define	PIN_LENGTH		100
+#define	BODY_WIDTH		600
+#define	CELL_WIDTH		( BODY_WIDTH + 2 * PIN_LENGTH + 1000 )
+#define	GRID_COLUMNS	16
+/*============================================================================*/
+#define	NAME_SIZE		256
+/*============================================================================*/
+static uint64_t	Random;
+/*============================================================================*/
+static unsigned NextRandom( unsigned long Range )
+	{
+	Random ^= Random << 13;
+	Random ^= Random >> 7;
+	Random ^= Random << 17;
+
+	return Range != 0 ? Random % Range : 0;
+	}
+/*============================================================================*/
+/* Names padded with zeros up to the minimum length. */
+static const char *Name( char *Buffer, const char *Prefix, unsigned long Number )
+	{
+	int	Width	= (int)PARAM( STRINGS ) - (int)strlen( Prefix );
+
+	if( Width < 1 )
+		Width	= 1;
+	else if( Width > NAME_SIZE / 2 )
+		Width	= NAME_SIZE / 2;
+
+	snprintf( Buffer, NAME_SIZE, "%s%0*lu", Prefix, Width, Number );
+
+	return Buffer;
+	}
+/*============================================================================*/
+static unsigned long CellHeight( void )
+	{
+	return ( PARAM( PINS ) + 1 ) / 2 * PIN_PITCH + 1000;
+	}
+/*============================================================================*/
+/* Half the pins are on the left side pointing left, the others on the right side pointing right. */
+static void PinEnd( unsigned long Pin, long *x, long *y )
+	{
+	unsigned long	Half	= ( PARAM( PINS ) + 1 ) / 2;
+
+	*x	= Pin < Half ? -PIN_LENGTH : BODY_WIDTH + PIN_LENGTH;
+	*y	= -(long)( Pin % Half ) * PIN_PITCH;
+	}
+/*============================================================================*/
+static void OutputHeader( FILE *f )
+	{
+	fprintf( f,
+		"ACCEL_ASCII \"synthetic.sch\"\n"
+		"\n"
+		"(asciiHeader\n"
+		"  (asciiVersion 3 0)\n"
+		"  (timeStamp 2024 1 1 0 0 0)\n"
+		"  (program \"P-CAD 2006 Schematic\" \"19.02.9589\")\n"
+		"  (copyright \"Copyright 1991-2006 Altium Limited\")\n"
+		"  (fileAuthor \"PCADSchGen\")\n"
+		"  (headerString \"\")\n"
+		"  (fileUnits Mil)\n"
+		"  (guidString \"\")\n"
+		")\n"
+		"\n" );
+	}
+/*============================================================================*/
+static void OutputLibrary( FILE *f )
+	{
+	char			Symbol[NAME_SIZE];
+	unsigned long	i, j;
+	long			x, y, Bottom;
+
+	fprintf( f,
+		"(library \"Library_1\"\n"
+		"  (textStyleDef \"(Default)\"\n"
+		"    (font\n"
+		"      (fontType Stroke)\n"
+		"      (fontHeight 80.0)\n"
+		"      (strokeWidth 10.0)\n"
+		"    )\n"
+		"    (textStyleAllowTType False)\n"
+		"    (textStyleDisplayTType False)\n"
+		"  )\n" );
+
+	Bottom	= -(long)(( PARAM( PINS ) + 1 ) / 2 ) * PIN_PITCH;
+
+	for( i = 0; i < PARAM( LIBRARY ); i++ )
+		{
+		Name( Symbol, "SYM", i );
+		fprintf( f, "  (symbolDef \"%s\"\n    (originalName \"%s\")\n", Symbol, Symbol );
+		for( j = 0; j < PARAM( PINS ); j++ )
+			{
+			PinEnd( j, &x, &y );
+			fprintf( f,
+				"    (pin\n"
+				"      (pinNum %lu)\n"
+				"      (pt %ld.0 %ld.0)\n"
+				"%s"
+				"      (pinLength %d.0)\n"
+				"      (pinDes\n"
+				"        (text (pt %ld.0 %ld.0) \"%lu\" (justify LowerLeft) (textStyleRef \"(Default)\"))\n"
+				"      )\n"
+				"      (pinName\n"
+				"        (text (pt %ld.0 %ld.0) \"P%lu\" (justify Left) (textStyleRef \"(Default)\"))\n"
+				"      )\n"
+				"    )\n",
+				j + 1, x, y, x < 0 ? "      (rotation 180.0)\n" : "", PIN_LENGTH,
+				x < 0 ? x + 20 : x - 80, y + 10, j + 1,
+				x < 0 ? 20L : BODY_WIDTH - 120L, y - 10, j + 1 );
+			}
+		fprintf( f,
+			"    (line (pt 0.0 %d.0) (pt %d.0 %d.0) (width 10.0))\n"
+			"    (line (pt %d.0 %d.0) (pt %d.0 %ld.0) (width 10.0))\n"
+			"    (line (pt %d.0 %ld.0) (pt 0.0 %ld.0) (width 10.0))\n"
+			"    (line (pt 0.0 %ld.0) (pt 0.0 %d.0) (width 10.0))\n"
+			"    (attr \"RefDes\" \"\" (pt %d.0 %d.0) (isVisible True) (justify Center) (textStyleRef \"(Default)\"))\n"
+			"    (attr \"Value\" \"\" (pt %d.0 %ld.0) (isVisible True) (justify Center) (textStyleRef \"(Default)\"))\n"
+			"  )\n",
+			PIN_PITCH, BODY_WIDTH, PIN_PITCH,
+			BODY_WIDTH, PIN_PITCH, BODY_WIDTH, Bottom,
+			BODY_WIDTH, Bottom, Bottom,
+			Bottom, PIN_PITCH,
+			BODY_WIDTH / 2, 2 * PIN_PITCH,
+			BODY_WIDTH / 2, Bottom - PIN_PITCH );
+		}
+
+	for( i = 0; i < PARAM( LIBRARY ); i++ )
+		{
+		Name( Symbol, "SYM", i );
+		fprintf( f,
+			"  (compDef \"%s_1\"\n"
+			"    (originalName \"%s\")\n"
+			"    (compHeader\n"
+			"      (sourceLibrary \"synthetic.lib\")\n"
+			"      (numPins %lu)\n"
+			"      (numParts 1)\n"
+			"      (alts (ieeeAlt False) (deMorganAlt False))\n"
+			"      (refDesPrefix \"U\")\n"
+			"    )\n",
+			Symbol, Symbol, PARAM( PINS ));
+		for( j = 0; j < PARAM( PINS ); j++ )
+			fprintf( f, "    (compPin \"%lu\" (partNum 1) (symPinNum %lu) (gateEq 0) (pinEq 0) (pinType Passive))\n", j + 1, j + 1 );
+		fprintf( f, "    (attachedSymbol (partNum 1) (altType Normal) (symbolName \"%s\"))\n  )\n", Symbol );
+		}
+
+	fprintf( f, ")\n\n" );
+	}
+/*============================================================================*/
+/* The symbol each instance uses, chosen once so the net list and the sheets agree. */
+static unsigned long *ChooseSymbols( unsigned long Count )
+	{
+	unsigned long	*Symbols, i;
+
+	if(( Symbols = malloc(( Count + 1 ) * sizeof( unsigned long ))) == NULL )
+		return NULL;
+
+	for( i = 0; i < Count; i++ )
+		Symbols[i]	= NextRandom( PARAM( LIBRARY ));
+
+	return Symbols;
+	}
+/*============================================================================*/
+/* Every pin is on one of the nets of its sheet, about four pins per net. */
+static unsigned long NetsPerSheet( void )
+	{
+	unsigned long	Nets	= PARAM( SYMBOLS ) * PARAM( PINS ) / 4;
+
+	return Nets > 0 ? Nets : 1;
+	}
+/*----------------------------------------------------------------------------*/
+static unsigned long *ChooseNets( unsigned long Count )
+	{
+	unsigned long	*Nets, i;
+
+	if(( Nets = malloc(( Count * PARAM( PINS ) + 1 ) * sizeof( unsigned long ))) == NULL )
+		return NULL;
+
+	for( i = 0; i < Count * PARAM( PINS ); i++ )
+		Nets[i]	= ( i / ( PARAM( SYMBOLS ) * PARAM( PINS ))) * NetsPerSheet() + NextRandom( NetsPerSheet() );
+
+	return Nets;
+	}
+/*============================================================================*/
+static void OutputNetList( FILE *f, const unsigned long *Symbols, const unsigned long *Nets, unsigned long Count )
+	{
+	char			Buffer[NAME_SIZE], Buffer2[NAME_SIZE];
+	unsigned long	i, j, Net;
+
+	fprintf( f, "(netlist \"Netlist_1\"\n  (globalAttrs\n  )\n" );
+
+	for( i = 0; i < Count; i++ )
+		fprintf( f, "  (compInst \"%s\"\n    (compRef \"%s_1\")\n    (originalName \"%s\")\n    (compValue \"%s\")\n  )\n",
+			Name( Buffer, "U", i + 1 ), Name( Buffer2, "SYM", Symbols[i] ), Buffer2, Name( Buffer2, "V", NextRandom( 1000 )));
+
+	/* The nodes of each net, the pins are scanned once per sheet. */
+	for( Net = 0; Net < NetsPerSheet() * PARAM( SHEETS ); Net++ )
+		{
+		unsigned long	First	= Net / NetsPerSheet() * PARAM( SYMBOLS );
+
+		fprintf( f, "  (net \"%s\"\n", Name( Buffer, "NET", Net ));
+		for( i = First; i < First + PARAM( SYMBOLS ) && i < Count; i++ )
+			for( j = 0; j < PARAM( PINS ); j++ )
+				if( Nets[i*PARAM( PINS )+j] == Net )
+					fprintf( f, "    (node \"%s\" \"%lu\")\n", Name( Buffer2, "U", i + 1 ), j + 1 );
+		fprintf( f, "  )\n" );
+		}
+
+	fprintf( f, ")\n\n" );
+	}
+/*============================================================================*/
+static void OutputSheet( FILE *f, unsigned long Sheet, const unsigned long *Symbols, const unsigned long *Nets )
+	{
+	char			Buffer[NAME_SIZE], Buffer2[NAME_SIZE];
+	unsigned long	i, j, k, Symbol, Bus;
+	long			x, y, ox, oy, Right;
+
+	fprintf( f, "  (sheet \"%s\"\n    (sheetNum %lu)\n", Name( Buffer, "Sheet", Sheet + 1 ), Sheet + 1 );
+
+	for( i = 0; i < PARAM( SYMBOLS ); i++ )
+		{
+		Symbol	= Sheet * PARAM( SYMBOLS ) + i;
+		ox		= ( i % GRID_COLUMNS ) * CELL_WIDTH + 1000;
+		oy		= ( i / GRID_COLUMNS ) * CellHeight() + 1000;
+
+		fprintf( f, "    (symbol (symbolRef \"%s\") (refDesRef \"%s\") (partNum 1) (pt %ld.0 %ld.0)\n",
+			Name( Buffer, "SYM", Symbols[Symbol] ), Name( Buffer2, "U", Symbol + 1 ), ox, oy );
+		fprintf( f, "      (attr \"RefDes\" \"%s\" (pt %ld.0 %ld.0) (isVisible True) (justify Center) (textStyleRef \"(Default)\"))\n    )\n",
+			Buffer2, ox + BODY_WIDTH / 2, oy + 2 * PIN_PITCH );
+
+		/* The wires go straight out of the pins, one segment after the other. */
+		for( j = 0; j < PARAM( PINS ); j++ )
+			{
+			PinEnd( j, &x, &y );
+			x	+= ox;
+			y	+= oy;
+			for( k = 0; k < PARAM( WIRES ); k++ )
+				{
+				long	Step	= x < ox ? -100 : 100;
+
+				fprintf( f, "    (wire (line (pt %ld.0 %ld.0) (pt %ld.0 %ld.0) (width 10.0) (netNameRef \"%s\")))\n",
+					x, y, x + Step, y, Name( Buffer, "NET", Nets[Symbol*PARAM( PINS )+j] ));
+				x	+= Step;
+				}
+			if( PARAM( WIRES ) > 0 )
+				fprintf( f, "    (junction (pt %ld.0 %ld.0) (netNameRef \"%s\"))\n", x, y, Buffer );
+			}
+		}
+
+	/* The buses are vertical, right of the symbols, the entries face right with a wire each. */
+	Right	= GRID_COLUMNS * CELL_WIDTH + 1000;
+	for( Bus = 0; Bus < PARAM( BUSES ); Bus++ )
+		{
+		x	= Right + Bus * 1000;
+		Name( Buffer, "BUS", Sheet * PARAM( BUSES ) + Bus );
+		fprintf( f, "    (bus \"%s\" (pt %ld.0 1000.0) (pt %ld.0 %ld.0))\n", Buffer, x, x, 1000 + (long)PARAM( BUSENTRIES ) * 100 + 100 );
+		for( i = 0; i < PARAM( BUSENTRIES ); i++ )
+			{
+			y	= 1100 + (long)i * 100;
+			fprintf( f, "    (busEntry (busNameRef \"%s\") (pt %ld.0 %ld.0) (orient Right))\n", Buffer, x, y );
+			fprintf( f, "    (wire (line (pt %ld.0 %ld.0) (endStyle RightLead) (pt %ld.0 %ld.0) (width 10.0) (netNameRef \"%s%lu\")))\n",
+				x, y, x + 500, y, Buffer, i );
+			}
+		}
+
+	fprintf( f,
+		"    (drawBorder False)\n"
+		"    (EntireDesign False)\n"
+		"    (isRotated False)\n"
+		"    (pageSize Size_A)\n"
+		"    (scaleFactor 1.0)\n"
+		"    (sheetOrderNum %lu)\n"
+		"  )\n", Sheet + 1 );
+	}
+/*============================================================================*/
+static void OutputDesign( FILE *f, const unsigned long *Symbols, const unsigned long *Nets )
+	{
+	unsigned long	i;
+
+	fprintf( f,
+		"(schematicDesign \"SchematicDesign_1\"\n"
+		"  (schDesignHeader\n"
+		"    (workspaceSize 32000.0 22000.0)\n"
+		"    (gridDfns\n"
+		"      (grid \"100.0\")\n"
+		"    )\n"
+		"    (designInfo\n"
+		"      (fieldSet \"(Default)\"\n"
+		"        (fieldDef \"Title\" \"\")\n"
+		"      )\n"
+		"    )\n"
+		"    (refPointSize 200.0)\n"
+		"    (infoPointSize 200.0)\n"
+		"    (junctionSize 40.0)\n"
+		"    (refPointSizePrint 200.0)\n"
+		"    (infoPointSizePrint 200.0)\n"
+		"    (junctionSizePrint 40.0)\n"
+		"  )\n"
+		"  (titleSheet \"\" 1.0\n"
+		"    (isVisible True)\n"
+		"    (offset 0.0 0.0)\n"
+		"    (border (isVisible True) (height 500.0) (width 500.0) (offset 0.0 0.0))\n"
+		"    (zones (isVisible True) (textStyleRef \"(Default)\")\n"
+		"      (horizontalZones 4 (numDirection Ascending) (numType Numeric))\n"
+		"      (verticalZones 4 (numDirection Descending) (numType Alphabetic)))\n"
+		"  )\n" );
+
+	for( i = 0; i < PARAM( SHEETS ); i++ )
+		OutputSheet( f, i, Symbols, Nets );
+
+	fprintf( f, "  (schematicPrintSettings\n    (sheetList\n" );
+	for( i = 0; i < PARAM( SHEETS ); i++ )
+		fprintf( f, "      (sheetRef %lu)\n", i + 1 );
+	fprintf( f,
+		"    )\n"
+		"  )\n"
+		"  (programState\n"
+		"    (currentTextStyle \"(Default)\")\n"
+		"  )\n"
+		")\n" );
+	}
+/*============================================================================*/
+static void PrintUsage( const char *Program )
+	{
+	int	i;
+
+	fprintf( stderr, "\nUsage: %s [--<parameter> <value>]... [<fileout>]\n\n", Program );
+	for( i = 0; i < sizeof Parameters / sizeof Parameters[0]; i++ )
+		fprintf( stderr, "\"%s\"\t%s, %lu by default.\n", Parameters[i].Name, Parameters[i].Description, Parameters[i].Value );
+	fprintf( stderr, "\nWithout <fileout> the schematic is written to the standard output.\n\n" );
+	}
+/*============================================================================*/
+int main( int ArgC, char *ArgV[] )
+	{
+	unsigned long	*Symbols, *Nets, Count;
+	FILE			*f	= stdout;
+	char			*End;
+	int				i, j;
+
+	for( i = 1; i + 1 < ArgC && strncmp( ArgV[i], "--", 2 ) == 0; i += 2 )
+		{
+		for( j = 0; j < sizeof Parameters / sizeof Parameters[0] && strcmp( ArgV[i], Parameters[j].Name ) != 0; j++ )
+			;
+		if( j == sizeof Parameters / sizeof Parameters[0] )
+			break;
+		Parameters[j].Value	= strtoul( ArgV[i+1], &End, 10 );
+		if( *End != '\0' )
+			break;
+		}
+
+	if( i < ArgC - 1 || ( i == ArgC - 1 && strncmp( ArgV[i], "--", 2 ) == 0 ) || PARAM( LIBRARY ) == 0 || PARAM( STRINGS ) > NAME_SIZE / 2 )
+		{
+		PrintUsage( ArgV[0] );
+		return -1;
+		}
+
+	if( i == ArgC - 1 && ( f = fopen( ArgV[i], "wb" )) == NULL )
+		{
+		fprintf( stderr, "\nError creating file \"%s\".\n\n", ArgV[i] );
+		return -1;
+		}
+
+	/* Zero would stop the generator. */
+	Random	= PARAM( SEED ) * UINT64_C( 0x9E3779B97F4A7C15 ) | 1;
+	Count	= PARAM( SHEETS ) * PARAM( SYMBOLS );
+
+	if(( Symbols = ChooseSymbols( Count )) == NULL || ( Nets = ChooseNets( Count )) == NULL )
+		{
+		fprintf( stderr, "\nNot enough memory.\n\n" );
+		return -1;
+		}
+
+	OutputHeader( f );
+	OutputLibrary( f );
+	OutputNetList( f, Symbols, Nets, Count );
+	OutputDesign( f, Symbols, Nets );
+
+	free( Nets );
+	free( Symbols );
+
+	if( f != stdout ? fclose( f ) != 0 : fflush( f ) != 0 )
+		{
+		fprintf( stderr, "\nError writing the output.\n\n" );
+		return -1;
+		}
+
+	return 0;
+	}
+/*============================================================================*/
@@ -0,0 +1,789 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+/*============================================================================*/
+/*
+Times the innermost functions of the converter one call at a time, in
+nanoseconds per operation. Most of them are static, so this file includes the
+sources that define them instead of linking against the library.
+
+Each benchmark belongs to a group, and the alternatives of a group run over the
+same operands, so they are compared side by side, relative to the first one of
+the group. A candidate implementation is measured by adding it here next to the
+one it is meant to replace, with a new line in "Benchmarks".
+
+The lookups run over the structures of the schematic given, the other groups
+over operands generated here, always the same ones.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "PCADSch.h"
+#include "Lexic.h"
+#include "KiCADOutputSchematic.c"
+#include "PCADProcessSchematic.c"
+/*============================================================================*/
+#define	POPULATION_SIZE		4096
+#define	MAX_QUERIES			65536
+#define	MIX_SIZE			65536
+/*============================================================================*/
+typedef uint64_t (*operation_t)( size_t Count );
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	const char	*Group;
+	const char	*Name;
+	operation_t	Run;
+	/* The benchmark is skipped if it is zero, the schematic has nothing to look for. */
+	size_t		*Operands;
+	} benchmark_t;
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	const pcad_sheetgeometry_t	*Geometry;
+	pcad_point_t				p;
+	pcad_point_t				p2;
+	} busentryquery_t;
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	const pcad_compdef_t		*CompDef;
+	unsigned					PartNumber;
+	unsigned					PinNumber;
+	} pinquery_t;
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	const pcad_compinst_t		*CompInst;
+	const char					*Name;
+	} attrquery_t;
+/*============================================================================*/
+static const pcad_schematicfile_t	*Schematic;
+static cookie_t						Cookie;
+static parameters_t					Params;
+
+static const char					*Mixes[4];
+static size_t						MixLengths[4];
+static size_t						NumMixes	= LENGTH( Mixes );
+
+static char							Dimmensions[POPULATION_SIZE][16];
+static pcad_enum_units_t			DimmensionUnits[POPULATION_SIZE];
+static size_t						NumDimmensions	= POPULATION_SIZE;
+
+static char							RefDes[POPULATION_SIZE][24];
+static size_t						NumRefDes		= POPULATION_SIZE;
+static char							NetNames[POPULATION_SIZE][24];
+static size_t						NumNetNames		= POPULATION_SIZE;
+
+static pcad_dimmension_t			Coordinates[POPULATION_SIZE];
+static size_t						NumCoordinates	= POPULATION_SIZE;
+
+static char							Labels[POPULATION_SIZE][24];
+static size_t						NumLabels		= POPULATION_SIZE;
+
+static const char					*CompDefNames[MAX_QUERIES];
+static size_t						NumCompDefNames;
+static const char					*SymbolDefNames[MAX_QUERIES];
+static size_t						NumSymbolDefNames;
+static const char					*SymbolDefOriginalNames[MAX_QUERIES];
+static size_t						NumSymbolDefOriginalNames;
+static const char					*CompInstNames[MAX_QUERIES];
+static size_t						NumCompInstNames;
+static const char					*CompInstOriginalNames[MAX_QUERIES];
+static size_t						NumCompInstOriginalNames;
+static attrquery_t					AttrQueries[MAX_QUERIES];
+static size_t						NumAttrQueries;
+static pinquery_t					PinQueries[MAX_QUERIES];
+static size_t						NumPinQueries;
+static busentryquery_t				BusEntryQueries[MAX_QUERIES];
+static size_t						NumBusEntryQueries;
+
+/* Everything the operations return ends here, so the compiler cannot drop the calls. */
+static volatile uint64_t			Sink;
+/*============================================================================*/
+static uint32_t	Seed	= 2463534242u;
+/*----------------------------------------------------------------------------*/
+static uint32_t NextRandom( uint32_t Range )
+	{
+	Seed ^= Seed << 13;
+	Seed ^= Seed >> 17;
+	Seed ^= Seed << 5;
+
+	return Seed % Range;
+	}
+/*============================================================================*/
+static double Now( void )
+	{
+	struct timespec	Time;
+
+#if			defined __linux__
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+#else	/*	defined __linux__ */
+	timespec_get( &Time, TIME_UTC );
+#endif	/*	defined __linux__ */
+
+	return Time.tv_sec + Time.tv_nsec / 1.0e9;
+	}
+/*============================================================================*/
+/* The mixes of tokens, each one a pattern repeated to MIX_SIZE bytes. The last one is the schematic itself. */
+static char *Repeat( const char *Pattern, size_t *Length )
+	{
+	size_t	PatternLength	= strlen( Pattern );
+	char	*Mix, *p;
+
+	if(( Mix = malloc( MIX_SIZE + PatternLength + 1 )) == NULL )
+		return NULL;
+
+	for( p = Mix; p < Mix + MIX_SIZE; p += PatternLength )
+		memcpy( p, Pattern, PatternLength );
+	*p		= '\0';
+	*Length	= p - Mix;
+
+	return Mix;
+	}
+/*============================================================================*/
+static void StartLexer( cookie_t *Lexer, const char *Mix, size_t Length )
+	{
+	memset( Lexer, 0, sizeof *Lexer );
+	Lexer->Input			= Mix;
+	Lexer->InputLength		= Length;
+	Lexer->LineNumber		= 1;
+	Lexer->Column			= 1;
+	Lexer->TabSize			= 4;
+	Lexer->UngettedToken	= TOKEN_NONE;
+	}
+/*============================================================================*/
+/* Reads "Count" tokens, starting the mix again each time it ends. */
+static uint64_t Lex( size_t Mix, size_t Count, int Pipelined )
+	{
+	static char	Buffer[65536];
+	cookie_t	Lexer;
+	uint64_t	Sum = 0;
+	token_t		Token;
+	size_t		i;
+
+	StartLexer( &Lexer, Mixes[Mix], MixLengths[Mix] );
+#if			defined __linux__
+	if( Pipelined && StartPipeline( &Lexer ) != 0 )
+		return 0;
+#endif	/*	defined __linux__ */
+
+	for( i = 0; i < Count; i++ )
+		{
+		if(( Token = GetToken( &Lexer, Buffer, sizeof Buffer )) == TOKEN_EOF )
+			{
+#if			defined __linux__
+			StopPipeline( &Lexer );
+#endif	/*	defined __linux__ */
+			StartLexer( &Lexer, Mixes[Mix], MixLengths[Mix] );
+#if			defined __linux__
+			if( Pipelined && StartPipeline( &Lexer ) != 0 )
+				return 0;
+#endif	/*	defined __linux__ */
+			}
+		Sum	+= Token;
+		}
+
+#if			defined __linux__
+	StopPipeline( &Lexer );
+#endif	/*	defined __linux__ */
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t LexCoordinates( size_t Count )			{ return Lex( 0, Count, 0 ); }
+static uint64_t LexKeywords( size_t Count )				{ return Lex( 1, Count, 0 ); }
+static uint64_t LexStrings( size_t Count )				{ return Lex( 2, Count, 0 ); }
+static uint64_t LexSchematic( size_t Count )			{ return Lex( 3, Count, 0 ); }
+#if			defined __linux__
+static uint64_t LexCoordinatesPipelined( size_t Count )	{ return Lex( 0, Count, 1 ); }
+static uint64_t LexKeywordsPipelined( size_t Count )	{ return Lex( 1, Count, 1 ); }
+static uint64_t LexStringsPipelined( size_t Count )		{ return Lex( 2, Count, 1 ); }
+static uint64_t LexSchematicPipelined( size_t Count )	{ return Lex( 3, Count, 1 ); }
+#endif	/*	defined __linux__ */
+/*============================================================================*/
+static uint64_t RunProcessDimmension( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumDimmensions ? j + 1 : 0 )
+		Sum	+= ProcessDimmension( &Cookie, Dimmensions[j], DimmensionUnits[j] );
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+/* The obvious way, through floating point. */
+static pcad_dimmension_t DimmensionStrtod( const char *Buffer, pcad_enum_units_t Unit )
+	{
+	static const double	Factors[]	= { [PCAD_UNITS_NONE]=0, [PCAD_UNITS_MM]=1.0e6, [PCAD_UNITS_MIL]=25400.0, [PCAD_UNITS_IN]=25400000.0 };
+
+	return llround( strtod( Buffer, NULL ) * Factors[Unit] );
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t RunDimmensionStrtod( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumDimmensions ? j + 1 : 0 )
+		Sum	+= DimmensionStrtod( Dimmensions[j], DimmensionUnits[j] );
+
+	return Sum;
+	}
+/*============================================================================*/
+static uint64_t CompareAll( char (*Names)[24], size_t NumNames, size_t Count, int (*Compare)( const char *a, const char *b ))
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 2 < NumNames ? j + 1 : 0 )
+		Sum	+= Compare( Names[j], Names[j+1] ) < 0;
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+static int CompareStrcmp( const char *a, const char *b )
+	{
+	return strcmp( a, b );
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t CompareRefDes( size_t Count )
+	{
+	return CompareAll( RefDes, NumRefDes, Count, CompareNames );
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t CompareRefDesStrcmp( size_t Count )
+	{
+	return CompareAll( RefDes, NumRefDes, Count, CompareStrcmp );
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t CompareNetNames( size_t Count )
+	{
+	return CompareAll( NetNames, NumNetNames, Count, CompareNames );
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t CompareNetNamesStrcmp( size_t Count )
+	{
+	return CompareAll( NetNames, NumNetNames, Count, CompareStrcmp );
+	}
+/*============================================================================*/
+static uint64_t RunFormatReal( size_t Count )
+	{
+	char		Buffer[32];
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumCoordinates ? j + 1 : 0 )
+		Sum	+= FormatReal( &Params, 0, 12700000, -1, Coordinates[j], Buffer, sizeof Buffer );
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+/* How "FormatReal" was written before "FormatMillionths". */
+static int FormatRealSnprintf( const parameters_t *Params, unsigned FracDigs, pcad_dimmension_t Origin, pcad_real_t Scale, pcad_real_t v, char *Buffer, size_t BufferSize )
+	{
+	int			Sign;
+	uint32_t	Int;
+	uint32_t	Frac;
+	int			Res, Dig;
+
+	if( Scale < 0 )
+		v	= Origin - v;
+	else
+		v	= v - Origin;
+
+	Sign	= v < 0;
+
+	Int		= abs( v ) / 1000000ul;
+	Frac	= abs( v ) % 1000000ul;
+
+	for( Dig = 6; Dig > 1 && Dig > FracDigs && Frac % 10 == 0; Dig-- )
+		Frac /= 10;
+
+	Res	= snprintf( Buffer, BufferSize, "%s%u.%0*u", Sign ? "-" : "", Int, Dig, Frac );
+	if( Res <= 0 || Res >= BufferSize )
+		ErrorOutput( Params->Cookie, -1, "Invalid number" );
+
+	return Res;
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t RunFormatRealSnprintf( size_t Count )
+	{
+	char		Buffer[32];
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumCoordinates ? j + 1 : 0 )
+		Sum	+= FormatRealSnprintf( &Params, 0, 12700000, -1, Coordinates[j], Buffer, sizeof Buffer );
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+/* The operations are the values, formatted COORDINATE_BATCH at a time. */
+static uint64_t RunFormatCoordinates( size_t Count )
+	{
+	coordinate_t	Text[COORDINATE_BATCH];
+	uint64_t		Sum = 0;
+	size_t			i, j, Batch;
+
+	for( i = 0, j = 0; i < Count; i += Batch, j = j + Batch < NumCoordinates ? j + Batch : 0 )
+		{
+		Batch	= Count - i < COORDINATE_BATCH ? Count - i : COORDINATE_BATCH;
+		if( Batch > NumCoordinates - j )
+			Batch	= NumCoordinates - j;
+		FormatCoordinates( 12700000, -1, &Coordinates[j], Batch, Text );
+		Sum	+= Text[Batch-1][0];
+		}
+
+	return Sum;
+	}
+/*============================================================================*/
+static uint64_t RunFormatLabel( size_t Count )
+	{
+	char		Buffer[3*sizeof Labels[0]+1];
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumLabels ? j + 1 : 0 )
+		Sum	+= FormatLabel( Labels[j], Buffer, sizeof Buffer )[0];
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t RunFormatName( size_t Count )
+	{
+	char		Buffer[256];
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumLabels ? j + 1 : 0 )
+		Sum	+= FormatName( Labels[j], Buffer, sizeof Buffer )[0];
+
+	return Sum;
+	}
+/*============================================================================*/
+static uint64_t RunFindCompDef( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumCompDefNames ? j + 1 : 0 )
+		Sum	+= FindCompDef( Schematic, CompDefNames[j] ) != NULL;
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t RunFindSymbolDef( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumSymbolDefNames ? j + 1 : 0 )
+		Sum	+= FindSymbolDef( Schematic, SymbolDefNames[j] ) != NULL;
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t RunFindSymbolDefByOriginalName( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumSymbolDefOriginalNames ? j + 1 : 0 )
+		Sum	+= FindSymbolDefByOriginalName( Schematic, SymbolDefOriginalNames[j] ) != NULL;
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t RunFindCompInst( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumCompInstNames ? j + 1 : 0 )
+		Sum	+= FindCompInst( &Schematic->netlist, CompInstNames[j] ) != NULL;
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t RunFindAttr( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumAttrQueries ? j + 1 : 0 )
+		Sum	+= FindAttr( (const pcad_attr_t * const *)AttrQueries[j].CompInst->vioattrs, AttrQueries[j].CompInst->numattrs, AttrQueries[j].Name ) != NULL;
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+/* As it is called for every component definition, most of the times without a match. */
+static uint64_t RunFindAttrInNetList( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumCompInstOriginalNames ? j + 1 : 0 )
+		Sum	+= FindAttrInNetList( &Schematic->netlist, CompInstOriginalNames[j], "Description" ) != NULL;
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+static uint64_t RunFindPin( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumPinQueries ? j + 1 : 0 )
+		Sum	+= FindPin( &Params, PinQueries[j].PartNumber, PinQueries[j].PinNumber, PinQueries[j].CompDef ) != NULL;
+
+	return Sum;
+	}
+/*----------------------------------------------------------------------------*/
+/* Both ends of every wire, as "AdjustWire" looks for them. */
+static uint64_t RunFindBusEntry( size_t Count )
+	{
+	uint64_t	Sum = 0;
+	size_t		i, j;
+
+	for( i = 0, j = 0; i < Count; i++, j = j + 1 < NumBusEntryQueries ? j + 1 : 0 )
+		Sum	+= FindBusEntry( BusEntryQueries[j].Geometry, &BusEntryQueries[j].p, &BusEntryQueries[j].p2 ) >= 0;
+
+	return Sum;
+	}
+/*============================================================================*/
+static const benchmark_t	Benchmarks[]	=
+	{
+	{ "GetToken/coordinates",			"memory",	LexCoordinates,					&NumMixes },
+#if			defined __linux__
+	{ "GetToken/coordinates",			"pipeline",	LexCoordinatesPipelined,		&NumMixes },
+#endif	/*	defined __linux__ */
+	{ "GetToken/keywords",				"memory",	LexKeywords,					&NumMixes },
+#if			defined __linux__
+	{ "GetToken/keywords",				"pipeline",	LexKeywordsPipelined,			&NumMixes },
+#endif	/*	defined __linux__ */
+	{ "GetToken/strings",				"memory",	LexStrings,						&NumMixes },
+#if			defined __linux__
+	{ "GetToken/strings",				"pipeline",	LexStringsPipelined,			&NumMixes },
+#endif	/*	defined __linux__ */
+	{ "GetToken/schematic",				"memory",	LexSchematic,					&NumMixes },
+#if			defined __linux__
+	{ "GetToken/schematic",				"pipeline",	LexSchematicPipelined,			&NumMixes },
+#endif	/*	defined __linux__ */
+	{ "ProcessDimmension",				"current",	RunProcessDimmension,			&NumDimmensions },
+	{ "ProcessDimmension",				"strtod",	RunDimmensionStrtod,			&NumDimmensions },
+	{ "CompareNames/refdes",			"current",	CompareRefDes,					&NumRefDes },
+	{ "CompareNames/refdes",			"strcmp",	CompareRefDesStrcmp,			&NumRefDes },
+	{ "CompareNames/nets",				"current",	CompareNetNames,				&NumNetNames },
+	{ "CompareNames/nets",				"strcmp",	CompareNetNamesStrcmp,			&NumNetNames },
+	{ "FormatReal",						"current",	RunFormatReal,					&NumCoordinates },
+	{ "FormatReal",						"snprintf",	RunFormatRealSnprintf,			&NumCoordinates },
+	{ "FormatReal",						"batch",	RunFormatCoordinates,			&NumCoordinates },
+	{ "FormatLabel",					"current",	RunFormatLabel,					&NumLabels },
+	{ "FormatName",						"current",	RunFormatName,					&NumLabels },
+	{ "FindCompDef",					"linear",	RunFindCompDef,					&NumCompDefNames },
+	{ "FindSymbolDef",					"linear",	RunFindSymbolDef,				&NumSymbolDefNames },
+	{ "FindSymbolDefByOriginalName",	"linear",	RunFindSymbolDefByOriginalName,	&NumSymbolDefOriginalNames },
+	{ "FindCompInst",					"linear",	RunFindCompInst,				&NumCompInstNames },
+	{ "FindAttr",						"linear",	RunFindAttr,					&NumAttrQueries },
+	{ "FindAttrInNetList",				"linear",	RunFindAttrInNetList,			&NumCompInstOriginalNames },
+	{ "FindPin",						"linear",	RunFindPin,						&NumPinQueries },
+	{ "FindBusEntry",					"linear",	RunFindBusEntry,				&NumBusEntryQueries }
+	};
+/*============================================================================*/
+static int SetupMixes( const char *Data, size_t Length )
+	{
+	static const char	*Patterns[]	=
+		{
+		"(pt 1234.5 -678.25) (pt 0.0 2540) (rotation 90.0) ",
+		"(isVisible True) (justify LowerLeft) (textStyleRef \"(Default)\") (pinType Passive) ",
+		"(compRef \"RES_0805\") (net \"NET00012\") (node \"U12\" \"14\") (value \"10k 1% 0.125W\") "
+		};
+	int					i;
+
+	for( i = 0; i < LENGTH( Patterns ); i++ )
+		if(( Mixes[i] = Repeat( Patterns[i], &MixLengths[i] )) == NULL )
+			return -1;
+
+	Mixes[i]		= Data;
+	MixLengths[i]	= Length;
+
+	return 0;
+	}
+/*============================================================================*/
+/* Reference designators and net names as they are in real designs, with and without numbers, and the numbers of different lengths. */
+static void SetupOperands( void )
+	{
+	static const char	*Prefixes[]		= { "R", "C", "U", "Q", "D", "L", "J", "TP", "FB", "SW" };
+	static const char	*Nets[]			= { "NET", "N$", "DATA", "ADDR", "/CLK", "GND", "VCC_3V3", "SPI1_MOSI", "LED" };
+	static const char	*LabelParts[]	= { "~RESET~", "CLK", "D/C", "~CS~", "SDA", "A0", "OE~", "~WR~/RD" };
+	size_t				i;
+
+	for( i = 0; i < NumDimmensions; i++ )
+		{
+		DimmensionUnits[i]	= PCAD_UNITS_MM + NextRandom( 3 );
+		snprintf( Dimmensions[i], sizeof Dimmensions[i], "%s%u.%0*u", NextRandom( 4 ) == 0 ? "-" : "", NextRandom( 1000 ), DimmensionUnits[i] == PCAD_UNITS_MM ? 3 : 2, NextRandom( DimmensionUnits[i] == PCAD_UNITS_MM ? 1000 : 100 ));
+		}
+
+	for( i = 0; i < NumRefDes; i++ )
+		snprintf( RefDes[i], sizeof RefDes[i], "%s%u%s", Prefixes[NextRandom( LENGTH( Prefixes ))], 1 + NextRandom( NextRandom( 2 ) ? 99 : 999 ), NextRandom( 8 ) == 0 ? "A" : "" );
+
+	for( i = 0; i < NumNetNames; i++ )
+		{
+		const char	*Prefix	= Nets[NextRandom( LENGTH( Nets ))];
+
+		if( strcmp( Prefix, "GND" ) == 0 || strcmp( Prefix, "VCC_3V3" ) == 0 )
+			snprintf( NetNames[i], sizeof NetNames[i], "%s", Prefix );
+		else
+			snprintf( NetNames[i], sizeof NetNames[i], "%s%0*u", Prefix, NextRandom( 2 ) ? 5 : 1, NextRandom( 1000 ));
+		}
+
+	for( i = 0; i < NumCoordinates; i++ )
+		Coordinates[i]	= ( NextRandom( 20000 ) - 10000 ) * ( NextRandom( 2 ) ? 254000 : 1000 );
+
+	for( i = 0; i < NumLabels; i++ )
+		snprintf( Labels[i], sizeof Labels[i], "%s%s", LabelParts[NextRandom( LENGTH( LabelParts ))], NextRandom( 2 ) ? LabelParts[NextRandom( LENGTH( LabelParts ))] : "" );
+	}
+/*============================================================================*/
+/* The lookups are made for what is really in the schematic, so they all succeed as most of them do in the conversion. */
+static void SetupQueries( void )
+	{
+	const pcad_library_t	*Library	= &Schematic->library;
+	const pcad_netlist_t	*NetList	= &Schematic->netlist;
+	size_t					i, j;
+
+	for( i = 0; i < Library->numcompdefs && NumCompDefNames < MAX_QUERIES; i++ )
+		CompDefNames[NumCompDefNames++]	= Library->viocompdefs[i]->name;
+
+	for( i = 0; i < Library->numsymboldefs && NumSymbolDefNames < MAX_QUERIES; i++ )
+		{
+		SymbolDefNames[NumSymbolDefNames++]					= Library->viosymboldefs[i]->name;
+		SymbolDefOriginalNames[NumSymbolDefOriginalNames++]	= Library->viosymboldefs[i]->originalname;
+		}
+
+	for( i = 0; i < NetList->numcompinsts && NumCompInstNames < MAX_QUERIES; i++ )
+		{
+		CompInstNames[NumCompInstNames++]					= NetList->viocompinsts[i]->name;
+		CompInstOriginalNames[NumCompInstOriginalNames++]	= NetList->viocompinsts[i]->originalname;
+		for( j = 0; j < NetList->viocompinsts[i]->numattrs && NumAttrQueries < MAX_QUERIES; j++ )
+			{
+			AttrQueries[NumAttrQueries].CompInst	= NetList->viocompinsts[i];
+			AttrQueries[NumAttrQueries++].Name		= NetList->viocompinsts[i]->vioattrs[j]->name;
+			}
+		}
+
+	for( i = 0; i < Library->numcompdefs; i++ )
+		for( j = 0; j < Library->viocompdefs[i]->numcomppins && NumPinQueries < MAX_QUERIES; j++ )
+			{
+			PinQueries[NumPinQueries].CompDef		= Library->viocompdefs[i];
+			PinQueries[NumPinQueries].PartNumber	= Library->viocompdefs[i]->viocomppins[j]->partnum;
+			PinQueries[NumPinQueries++].PinNumber	= Library->viocompdefs[i]->viocomppins[j]->sympinnum;
+			}
+
+	for( i = 0; i < Schematic->schematicdesign.numsheets; i++ )
+		{
+		const pcad_sheetgeometry_t	*Geometry	= Schematic->schematicdesign.viosheets[i]->geometry;
+
+		for( j = 0; Geometry != NULL && j < Geometry->numwires && NumBusEntryQueries + 1 < MAX_QUERIES; j++ )
+			{
+			busentryquery_t	*Query	= &BusEntryQueries[NumBusEntryQueries];
+
+			Query[0].Geometry	= Geometry;
+			Query[0].p.x		= Geometry->wirex1[j];
+			Query[0].p.y		= Geometry->wirey1[j];
+			Query[0].p2.x		= Geometry->wirex2[j];
+			Query[0].p2.y		= Geometry->wirey2[j];
+			Query[1].Geometry	= Geometry;
+			Query[1].p			= Query[0].p2;
+			Query[1].p2			= Query[0].p;
+			NumBusEntryQueries += 2;
+			}
+		}
+	}
+/*============================================================================*/
+/* The best of "Repeat" timings, each one with enough operations to take at least "Seconds". */
+static double Measure( operation_t Run, double Seconds, int Repeat )
+	{
+	double	Start, Elapsed, Best = 0;
+	size_t	Count;
+	int		i;
+
+	for( Count = 1; ; Count = Elapsed > Seconds / 100 ? Count * ( 1.2 * Seconds / Elapsed ) + 1 : Count * 10 )
+		{
+		Start	 = Now();
+		Sink	+= Run( Count );
+		if(( Elapsed = Now() - Start ) >= Seconds )
+			break;
+		}
+
+	for( i = 0; i < Repeat; i++ )
+		{
+		Start	 = Now();
+		Sink	+= Run( Count );
+		Elapsed	 = Now() - Start;
+		if( i == 0 || Elapsed < Best )
+			Best	= Elapsed;
+		}
+
+	return Best * 1.0e9 / Count;
+	}
+/*============================================================================*/
+static char *ReadFile( const char *Path, size_t *Length )
+	{
+	FILE	*f;
+	char	*Data	= NULL;
+	long	Size;
+
+	if(( f = fopen( Path, "rb" )) == NULL )
+		return NULL;
+
+	if( fseek( f, 0, SEEK_END ) == 0 && ( Size = ftell( f )) >= 0 && fseek( f, 0, SEEK_SET ) == 0 && ( Data = malloc( Size + 1 )) != NULL )
+		{
+		if( fread( Data, 1, Size, f ) != Size )
+			{
+			free( Data );
+			Data	= NULL;
+			}
+		*Length	= Size;
+		}
+
+	fclose( f );
+
+	return Data;
+	}
+/*============================================================================*/
+int main( int ArgC, char *ArgV[] )
+	{
+	const char	*Filter		= NULL, *PathOut = NULL, *Group = NULL;
+	pcadsch_t	*Context;
+	char		*Data;
+	size_t		Length;
+	FILE		*f			= NULL;
+	double		Seconds		= 0.1, Reference = 0, NsPerOp;
+	int			i, Repeat = 5, First = 1;
+
+	for( i = 1; i + 1 < ArgC && strncmp( ArgV[i], "--", 2 ) == 0; i += 2 )
+		{
+		if( strcmp( ArgV[i], "--time" ) == 0 )
+			Seconds	= atoi( ArgV[i+1] ) / 1000.0;
+		else if( strcmp( ArgV[i], "--repeat" ) == 0 )
+			Repeat	= atoi( ArgV[i+1] );
+		else if( strcmp( ArgV[i], "--filter" ) == 0 )
+			Filter	= ArgV[i+1];
+		else if( strcmp( ArgV[i], "--json" ) == 0 )
+			PathOut	= ArgV[i+1];
+		else
+			break;
+		}
+
+	if( i + 1 != ArgC || strncmp( ArgV[i], "--", 2 ) == 0 || Seconds <= 0 || Repeat < 1 )
+		{
+		fprintf( stderr, "\nUsage: %s [--time <ms>] [--repeat <n>] [--filter <text>] [--json <fileout>] <schematic>\n\n", ArgV[0] );
+		return -1;
+		}
+
+	if(( Data = ReadFile( ArgV[i], &Length )) == NULL )
+		{
+		fprintf( stderr, "\nError reading file \"%s\".\n\n", ArgV[i] );
+		return -1;
+		}
+
+	if(( Context = PCADSchCreate()) == NULL || PCADSchParseBuffer( Context, Data, Length ) != 0 || PCADSchProcess( Context ) != 0 )
+		{
+		fprintf( stderr, "\nError converting file \"%s\".\n\n", ArgV[i] );
+		return -1;
+		}
+
+	if( PathOut != NULL && ( f = fopen( PathOut, "w" )) == NULL )
+		{
+		fprintf( stderr, "\nError creating file \"%s\".\n\n", PathOut );
+		return -1;
+		}
+
+	Schematic				= PCADSchGetSchematic( Context );
+	Cookie.UngettedToken	= TOKEN_NONE;
+	Params.Cookie			= &Cookie;
+
+	if( SetupMixes( Data, Length ) != 0 )
+		{
+		fprintf( stderr, "\nNot enough memory.\n\n" );
+		return -1;
+		}
+	SetupOperands();
+	SetupQueries();
+
+	/* Something going wrong in a function being measured is a bug, there is no recovery. */
+	if( setjmp( Cookie.JumpBuffer ) != 0 )
+		{
+		fprintf( stderr, "\n%s\n\n", Cookie.LastError.Message );
+		return -1;
+		}
+
+	printf( "%-32s %-10s %12s %9s\n", "group", "variant", "ns/op", "relative" );
+	if( f != NULL )
+		fprintf( f, "{\n  \"benchmarks\": [" );
+
+	for( i = 0; i < LENGTH( Benchmarks ); i++ )
+		{
+		if( Filter != NULL && strstr( Benchmarks[i].Group, Filter ) == NULL )
+			continue;
+
+		if( *Benchmarks[i].Operands == 0 )
+			{
+			printf( "%-32s %-10s %12s\n", Benchmarks[i].Group, Benchmarks[i].Name, "-" );
+			continue;
+			}
+
+		NsPerOp	= Measure( Benchmarks[i].Run, Seconds, Repeat );
+		if( Group == NULL || strcmp( Group, Benchmarks[i].Group ) != 0 )
+			{
+			Group		= Benchmarks[i].Group;
+			Reference	= NsPerOp;
+			}
+
+		printf( "%-32s %-10s %12.2f %9.2f\n", Benchmarks[i].Group, Benchmarks[i].Name, NsPerOp, NsPerOp / Reference );
+		fflush( stdout );
+
+		if( f != NULL )
+			fprintf( f, "%s\n    { \"group\": \"%s\", \"variant\": \"%s\", \"ns_per_op\": %.3f, \"relative\": %.3f }", First ? "" : ",", Benchmarks[i].Group, Benchmarks[i].Name, NsPerOp, NsPerOp / Reference );
+		First	= 0;
+		}
+
+	if( f != NULL )
+		{
+		fprintf( f, "\n  ]\n}\n" );
+		fclose( f );
+		}
+
+	PCADSchDestroy( Context );
+	free( Data );
+
+	return 0;
+	}
+/*============================================================================*/
@@ -0,0 +1,376 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+/*
+Checks of the library that need a whole schematic, run by "ctest" over one
+written by PCADSchGen. Each check is named on the command line and prints why
+it failed.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "PCADSch.h"
+/*============================================================================*/
+typedef struct
+	{
+	unsigned long	CompInsts;
+	unsigned long	Nets;
+	unsigned long	Values;
+	int				Depth;
+	} scancounts_t;
+/*============================================================================*/
+static int CountBegin( void *UserData, const char *Tag )
+	{
+	scancounts_t	*Counts	= UserData;
+
+	Counts->Depth++;
+	if( Tag != NULL && strcmp( Tag, "compInst" ) == 0 )
+		Counts->CompInsts++;
+	else if( Tag != NULL && strcmp( Tag, "net" ) == 0 )
+		Counts->Nets++;
+
+	return 0;
+	}
+/*============================================================================*/
+static int CountValue( void *UserData, const char *Tag, const pcadsch_value_t *Value )
+	{
+	scancounts_t	*Counts	= UserData;
+
+	Counts->Values++;
+
+	return 0;
+	}
+/*============================================================================*/
+static int CountEnd( void *UserData, const char *Tag )
+	{
+	scancounts_t	*Counts	= UserData;
+
+	Counts->Depth--;
+
+	return 0;
+	}
+/*============================================================================*/
+/* The scan must find the same elements the parse keeps, reading as much of the file. */
+static int TestScan( pcadsch_t *Context, const char *Path, const char *Data, size_t Length )
+	{
+	scancounts_t				Counts		= { 0 };
+	pcadsch_scanner_t			Scanner		= { CountBegin, CountValue, CountEnd, &Counts };
+	const pcad_schematicfile_t	*Schematic;
+	const pcad_compinst_t		*CompInst;
+	const pcad_net_t			*Net;
+	pcadsch_stats_t				Parsed, Scanned;
+	unsigned long				CompInsts = 0, Nets = 0;
+
+	if( PCADSchParseBuffer( Context, Data, Length ) != 0 || ( Schematic = PCADSchGetSchematic( Context )) == NULL || PCADSchGetStats( Context, &Parsed ) != 0 )
+		return -1;
+
+	for( CompInst = Schematic->netlist.firstcompinst; CompInst != NULL; CompInst = CompInst->next )
+		CompInsts++;
+	for( Net = Schematic->netlist.firstnet; Net != NULL; Net = Net->next )
+		Nets++;
+
+	if( PCADSchScan( Context, Path, &Scanner ) != 0 || PCADSchGetStats( Context, &Scanned ) != 0 )
+		return -1;
+
+	if( Counts.CompInsts != CompInsts || Counts.Nets != Nets || Counts.Depth != 0 || Counts.Values == 0 )
+		{
+		fprintf( stderr, "The scan found %lu compInsts and %lu nets, the parse %lu and %lu.\n", Counts.CompInsts, Counts.Nets, CompInsts, Nets );
+		return -1;
+		}
+	if( Scanned.BytesRead != Parsed.BytesRead )
+		{
+		fprintf( stderr, "The scan read %lu bytes, the parse %lu.\n", (unsigned long)Scanned.BytesRead, (unsigned long)Parsed.BytesRead );
+		return -1;
+		}
+
+	return 0;
+	}
+/*============================================================================*/
+/* Where the element starting at "Start" ends, past its closing parenthesis, or zero if it does not. */
+static size_t ElementEnd( const char *Data, size_t Length, size_t Start )
+	{
+	size_t	i;
+	int		Depth = 0, InString = 0;
+
+	for( i = Start; i < Length; i++ )
+		{
+		if( InString )
+			InString	= Data[i] != '"';
+		else if( Data[i] == '"' )
+			InString	= 1;
+		else if( Data[i] == '(' )
+			Depth++;
+		else if( Data[i] == ')' && --Depth == 0 )
+			return i + 1;
+		}
+
+	return 0;
+	}
+/*============================================================================*/
+/* The next element "Tag" from "Start" on, at any depth, or "End" if there is none before it. */
+static size_t FindElement( const char *Data, size_t Start, size_t End, const char *Tag )
+	{
+	size_t	Length	= strlen( Tag );
+
+	for( ; Start + Length + 1 < End; Start++ )
+		if( Data[Start] == '(' && strncmp( &Data[Start+1], Tag, Length ) == 0 && strchr( " \t\r\n)", Data[Start+Length+1] ) != NULL )
+			return Start;
+
+	return End;
+	}
+/*============================================================================*/
+/*
+A copy of the file with the first two "Tag" elements of the first "Parent"
+having two of them swapped or, if "Remove" is non-zero, the first one removed.
+The rest of the file is left as it is.
+*/
+static char *EditElements( const char *Data, size_t Length, const char *Parent, const char *Tag, int Remove, size_t *NewLength )
+	{
+	size_t	ParentStart, ParentEnd, First, FirstEnd, Second, SecondEnd;
+	char	*Edited;
+
+	for( ParentStart = 0; ( ParentStart = FindElement( Data, ParentStart, Length, Parent )) < Length; ParentStart = ParentEnd )
+		{
+		if(( ParentEnd = ElementEnd( Data, Length, ParentStart )) == 0 )
+			return NULL;
+		if(( First = FindElement( Data, ParentStart + 1, ParentEnd, Tag )) < ParentEnd && ( FirstEnd = ElementEnd( Data, ParentEnd, First )) != 0 &&
+			( Second = FindElement( Data, FirstEnd, ParentEnd, Tag )) < ParentEnd && ( SecondEnd = ElementEnd( Data, ParentEnd, Second )) != 0 )
+			break;
+		}
+
+	if( ParentStart >= Length || ( Edited = malloc( Length + 1 )) == NULL )
+		return NULL;
+
+	memcpy( Edited, Data, First );
+	if( Remove )
+		{
+		memcpy( &Edited[First], &Data[Second], Length - Second );
+		*NewLength	= Length - ( Second - First );
+		}
+	else
+		{
+		/* The second, what was between them and then the first. */
+		memcpy( &Edited[First], &Data[Second], SecondEnd - Second );
+		memcpy( &Edited[First+SecondEnd-Second], &Data[FirstEnd], Second - FirstEnd );
+		memcpy( &Edited[First+SecondEnd-FirstEnd], &Data[First], FirstEnd - First );
+		memcpy( &Edited[SecondEnd], &Data[SecondEnd], Length - SecondEnd );
+		*NewLength	= Length;
+		}
+
+	return Edited;
+	}
+/*============================================================================*/
+static pcadsch_t *ParseCopy( const char *Data, size_t Length )
+	{
+	pcadsch_t	*Context;
+
+	if(( Context = PCADSchCreate()) != NULL && PCADSchParseBuffer( Context, Data, Length ) != 0 )
+		{
+		PCADSchDestroy( Context );
+		return NULL;
+		}
+
+	return Context;
+	}
+/*============================================================================*/
+static int CountDifference( void *UserData, pcadsch_change_t Change, const char *Container, const char *Kind, const char *Name )
+	{
+	fprintf( stderr, "%c %s%s%s %s\n", "+-~"[Change], Container != NULL ? Container : "", Container != NULL ? ": " : "", Kind, Name );
+
+	return 0;
+	}
+/*============================================================================*/
+/* A file saved again by P-CAD may have the elements in a different order, that is not a change. */
+static int TestDiffOrder( pcadsch_t *Context, const char *Path, const char *Data, size_t Length )
+	{
+	static const char	*Edits[][2]	= { { "symbolDef", "pin" }, { "symbolDef", "line" }, { "compDef", "compPin" } };
+	pcadsch_t			*Edited;
+	char				*Copy;
+	size_t				CopyLength;
+	int					Result = 0, Differences, i;
+
+	if( PCADSchParseBuffer( Context, Data, Length ) != 0 )
+		return -1;
+
+	for( i = 0; i < (int)LENGTH( Edits ) && Result == 0; i++ )
+		{
+		if(( Copy = EditElements( Data, Length, Edits[i][0], Edits[i][1], 0, &CopyLength )) == NULL || ( Edited = ParseCopy( Copy, CopyLength )) == NULL )
+			{
+			fprintf( stderr, "Could not swap two \"%s\" of a \"%s\".\n", Edits[i][1], Edits[i][0] );
+			free( Copy );
+			return -1;
+			}
+
+		Differences	= PCADSchDiff( Context, Edited, CountDifference, NULL );
+		if( Differences != 0 )
+			{
+			fprintf( stderr, "Swapping two \"%s\" of a \"%s\" gave %d differences.\n", Edits[i][1], Edits[i][0], Differences );
+			Result	= -1;
+			}
+
+		PCADSchDestroy( Edited );
+		free( Copy );
+		}
+
+	return Result;
+	}
+/*============================================================================*/
+static int CountConflict( void *UserData, pcadsch_change_t Ours, pcadsch_change_t Theirs, const char *Container, const char *Kind, const char *Name )
+	{
+	fprintf( stderr, "! %s%s%s %s\n", Container != NULL ? Container : "", Container != NULL ? ": " : "", Kind, Name );
+
+	return 0;
+	}
+/*============================================================================*/
+/* One side only reorders the pins of a symbol definition, the other removes one of them: it merges without a conflict, into the other side. */
+static int TestMergeOrder( pcadsch_t *Context, const char *Path, const char *Data, size_t Length )
+	{
+	pcadsch_t			*Ours = NULL, *Theirs = NULL;
+	pcadsch_buffer_t	Merged		= { NULL, 0, 0 }, Expected = { NULL, 0, 0 };
+	pcadsch_writer_t	MergedWriter	= { NULL, PCADSchBufferWrite, NULL, &Merged };
+	pcadsch_writer_t	ExpectedWriter	= { NULL, PCADSchBufferWrite, NULL, &Expected };
+	char				*Swapped, *Removed;
+	size_t				SwappedLength, RemovedLength;
+	int					Result = -1, Conflicts;
+
+	Swapped		= EditElements( Data, Length, "symbolDef", "pin", 0, &SwappedLength );
+	Removed		= EditElements( Data, Length, "symbolDef", "pin", 1, &RemovedLength );
+
+	if( Swapped != NULL && Removed != NULL && PCADSchParseBuffer( Context, Data, Length ) == 0 && ( Ours = ParseCopy( Swapped, SwappedLength )) != NULL && ( Theirs = ParseCopy( Removed, RemovedLength )) != NULL )
+		{
+		if(( Conflicts = PCADSchMerge( Context, Ours, Theirs, CountConflict, NULL )) != 0 )
+			fprintf( stderr, "The merge gave %d conflicts.\n", Conflicts );
+		else if( PCADSchEmitPCAD( Ours, &MergedWriter ) != 0 || PCADSchEmitPCAD( Theirs, &ExpectedWriter ) != 0 )
+			fprintf( stderr, "The merge could not be written.\n" );
+		else if( Merged.Length != Expected.Length || memcmp( Merged.Data, Expected.Data, Merged.Length ) != 0 )
+			fprintf( stderr, "The merge is not the same as the side that removed the pin.\n" );
+		else
+			Result	= 0;
+		}
+
+	PCADSchDestroy( Theirs );
+	PCADSchDestroy( Ours );
+	free( Expected.Data );
+	free( Merged.Data );
+	free( Removed );
+	free( Swapped );
+
+	return Result;
+	}
+/*============================================================================*/
+/* The parsed schematic is only read by the emitters, the same context written twice gives the same output. */
+static int TestEmitTwice( pcadsch_t *Context, const char *Path, const char *Data, size_t Length )
+	{
+	pcadsch_buffer_t	First		= { NULL, 0, 0 }, Second = { NULL, 0, 0 };
+	pcadsch_writer_t	FirstWriter		= { NULL, PCADSchBufferWrite, NULL, &First };
+	pcadsch_writer_t	SecondWriter	= { NULL, PCADSchBufferWrite, NULL, &Second };
+	int					Result = -1;
+
+	if( PCADSchParseBuffer( Context, Data, Length ) != 0 || PCADSchEmitKiCAD( Context, &FirstWriter ) != 0 || PCADSchEmitKiCAD( Context, &SecondWriter ) != 0 )
+		fprintf( stderr, "The schematic could not be written.\n" );
+	else if( First.Length != Second.Length || memcmp( First.Data, Second.Data, First.Length ) != 0 )
+		fprintf( stderr, "The second output has %lu bytes, the first %lu, and they differ.\n", (unsigned long)Second.Length, (unsigned long)First.Length );
+	else
+		Result	= 0;
+
+	free( Second.Data );
+	free( First.Data );
+
+	return Result;
+	}
+/*============================================================================*/
+static const struct
+	{
+	const char	*Name;
+	int			(*Run)( pcadsch_t *Context, const char *Path, const char *Data, size_t Length );
+	} Tests[]	=
+	{
+	{ "scan",			TestScan },
+	{ "diff-order",		TestDiffOrder },
+	{ "merge-order",	TestMergeOrder },
+	{ "emit-twice",		TestEmitTwice }
+	};
+/*============================================================================*/
+static char *ReadFile( const char *Path, size_t *Length )
+	{
+	FILE	*f;
+	char	*Data	= NULL;
+	long	Size;
+
+	if(( f = fopen( Path, "rb" )) == NULL )
+		return NULL;
+
+	if( fseek( f, 0, SEEK_END ) == 0 && ( Size = ftell( f )) >= 0 && fseek( f, 0, SEEK_SET ) == 0 && ( Data = malloc( Size + 1 )) != NULL && fread( Data, 1, Size, f ) != (size_t)Size )
+		{
+		free( Data );
+		Data	= NULL;
+		}
+	else if( Data != NULL )
+		*Length	= Size;
+
+	fclose( f );
+
+	return Data;
+	}
+/*============================================================================*/
+int main( int ArgC, char *ArgV[] )
+	{
+	pcadsch_t	*Context;
+	char		*Data;
+	size_t		Length;
+	int			i, Result;
+
+	for( i = 0; ArgC == 3 && i < (int)LENGTH( Tests ) && strcmp( ArgV[1], Tests[i].Name ) != 0; i++ )
+		{}
+
+	if( ArgC != 3 || i >= (int)LENGTH( Tests ))
+		{
+		fprintf( stderr, "\nUsage: %s <test> <schematic>\n\n", ArgV[0] );
+		return -1;
+		}
+
+	if(( Data = ReadFile( ArgV[2], &Length )) == NULL )
+		{
+		fprintf( stderr, "\nError reading file \"%s\".\n\n", ArgV[2] );
+		return -1;
+		}
+
+	if(( Context = PCADSchCreate()) == NULL )
+		{
+		fprintf( stderr, "\nNot enough memory.\n\n" );
+		free( Data );
+		return -1;
+		}
+
+	if(( Result = Tests[i].Run( Context, ArgV[2], Data, Length )) != 0 )
+		fprintf( stderr, "\nTest \"%s\" failed.\n\n", Tests[i].Name );
+
+	PCADSchDestroy( Context );
+	free( Data );
+
+	return Result != 0 ? 1 : 0;
+	}
+/*============================================================================*/
@@ -40,8 +40,14 @@ typedef struct pcad_point_tag
 	{
 	pcad_dimmension_t						x;
 	pcad_dimmension_t						y;
-	struct pcad_point_tag					*next;
 	} pcad_point_t;
+/*---------------------------------------------------------------------------*/
+/* Only the points of a "poly" form a list, the others are embedded in their structures. */
+typedef struct pcad_polypoint_tag
+	{
+	pcad_point_t							point;
+	struct pcad_polypoint_tag				*next;
+	} pcad_polypoint_t;
 /*=============================================================================*/
 typedef struct
 	{
@@ -201,11 +207,12 @@ typedef struct pcad_triplepointarc_tag
 /*=============================================================================*/
 typedef struct pcad_poly_tag
 	{
-	pcad_point_t							*firstpoint;
+	pcad_polypoint_t						*firstpoint;
 	struct pcad_poly_tag					*next;
 
 	size_t									numpoints;
-	pcad_point_t							**viopoints;
+	/* After processing the points are copied to a contiguous array. */
+	pcad_point_t							*points;
 	} pcad_poly_t;
 /*=============================================================================*/
 typedef struct pcad_symboldef_tag
@@ -593,6 +600,25 @@ typedef struct pcad_refpoint_tag
 	struct pcad_refpoint_tag				*next;
 	} pcad_refpoint_t;
 /*=============================================================================*/
+/* The geometry of a sheet in parallel arrays, in the same order as "viowires", "viojunctions" and "viobusentries". */
+typedef struct pcad_sheetgeometry_tag
+	{
+	size_t									numwires;
+	pcad_dimmension_t						*wirex1;
+	pcad_dimmension_t						*wirey1;
+	pcad_dimmension_t						*wirex2;
+	pcad_dimmension_t						*wirey2;
+	pcad_enum_endstyle_t					*wireendstyle1;
+	pcad_enum_endstyle_t					*wireendstyle2;
+	size_t									numjunctions;
+	pcad_dimmension_t						*junctionx;
+	pcad_dimmension_t						*junctiony;
+	size_t									numbusentries;
+	pcad_dimmension_t						*busentryx;
+	pcad_dimmension_t						*busentryy;
+	pcad_enum_orient_t						*busentryorient;
+	} pcad_sheetgeometry_t;
+/*=============================================================================*/
 typedef struct pcad_sheet_tag
 	{
 	char									*name;
@@ -654,6 +680,7 @@ typedef struct pcad_sheet_tag
 	pcad_field_t							**viofields;
 	size_t									numrefpoints;
 	pcad_refpoint_t							**viorefpoints;
+	pcad_sheetgeometry_t					*geometry;
 	} pcad_sheet_t;
 /*=============================================================================*/
 typedef struct pcad_sheetref_tag
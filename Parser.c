@@ -23,12 +23,18 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 /*============================================================================*/
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdarg.h>
 #include "Parser.h"
 #include "Lexic.h"
 #include "PCADEnums.h"
+#include "Diagnostics.h"
+/*============================================================================*/
+#if			defined PCADSCH_COUNTERS
+_Thread_local pcadsch_counters_t	*CurrentCounters;
+#endif	/*	defined PCADSCH_COUNTERS */
 /*============================================================================*/
 pcad_dimmension_t ProcessDimmension( cookie_t *Cookie, const char *Buffer, pcad_enum_units_t Unit )
 	{
@@ -83,7 +89,36 @@ pcad_dimmension_t ProcessDimmension( cookie_t *Cookie, const char *Buffer, pcad_
 	return Value;
 	}
 /*============================================================================*/
-pcad_enum_units_t TranslateUnits( cookie_t *Cookie, const char *Buffer )
+/*
+The same as "ProcessDimmension" for a number the lexer thread has already
+converted to millionths. The unit must have been checked by the caller.
+*/
+static pcad_dimmension_t ScaleDimmension( int64_t Value, pcad_enum_units_t Unit )
+	{
+	int	Sign	= Value < 0;
+
+	if( Sign != 0 )
+		Value	= -Value;
+
+	/* The digits the unit has no room for are dropped, as "ProcessDimmension" does. */
+	switch( Unit )
+		{
+		case PCAD_UNITS_NONE:
+		case PCAD_UNITS_MM:
+			break;
+		case PCAD_UNITS_MIL:
+			Value	= Value / 10000 * 254;
+			break;
+		case PCAD_UNITS_IN:
+			Value	= Value / 10 * 254;
+			break;
+		}
+
+	return Sign != 0 ? -(pcad_dimmension_t)Value : (pcad_dimmension_t)Value;
+	}
+/*============================================================================*/
+/* Same as "TranslateUnits", but returns the error code instead of jumping out. */
+static int CheckUnits( cookie_t *Cookie, const char *Buffer )
 	{
 	static const char	*UnitsStr[]	= { [PCAD_UNITS_NONE]="", [PCAD_UNITS_MM]="mm", [PCAD_UNITS_MIL]="Mil", [PCAD_UNITS_IN]="in" };
 	int					i;
@@ -95,11 +130,21 @@ pcad_enum_units_t TranslateUnits( cookie_t *Cookie, const char *Buffer )
 		{}
 
 	if( i >= LENGTH( UnitsStr ))
-		Error( Cookie, -1, "Unknown unit" );
+		return RecordError( Cookie, -1, "Unknown unit" );
 
 	return i;
 	}
 /*============================================================================*/
+pcad_enum_units_t TranslateUnits( cookie_t *Cookie, const char *Buffer )
+	{
+	int	Unit;
+
+	if(( Unit = CheckUnits( Cookie, Buffer )) < 0 )
+		longjmp( Cookie->JumpBuffer, Cookie->LastError.Code );
+
+	return Unit;
+	}
+/*============================================================================*/
 int ExpectName( cookie_t *Cookie, const char *Name )
 	{
 	char	Buffer[BUFFER_SIZE];
@@ -118,7 +163,7 @@ int ExpectName( cookie_t *Cookie, const char *Name )
 	return TOKEN_NAME;
 	}
 /*============================================================================*/
-static pcad_real_t GetReal( cookie_t *Cookie )
+static int GetReal( cookie_t *Cookie, pcad_real_t *Real )
 	{
 	char	Buffer[BUFFER_SIZE], *p = Buffer;
 	int32_t	Value	= 0;
@@ -127,7 +172,14 @@ static pcad_real_t GetReal( cookie_t *Cookie )
 	token_t	Token	= GetToken( Cookie, Buffer, sizeof Buffer );
 
 	if( Token != TOKEN_INTEGER && Token != TOKEN_UNSIGNED && Token != TOKEN_FLOAT )
-		Error( Cookie, -1, "Expecting number" );
+		return RecordError( Cookie, -1, "Expecting number" );
+
+	/* The lexer thread has already converted it, the integers without scaling them. */
+	if( Cookie->Pipeline != NULL )
+		{
+		*Real	= Cookie->TokenValue;
+		return 0;
+		}
 
 	if( *p == '+' || *p == '-' )
 		Sign	= *p++ == '-';
@@ -148,85 +200,118 @@ static pcad_real_t GetReal( cookie_t *Cookie )
 	if( Sign != 0 )
 		Value	= -Value;
 
-	return Value;
+	*Real	= Value;
+
+	return 0;
 	}
 /*============================================================================*/
 int ParseReal( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
 	{
 	pcad_real_t	*Real	= (pcad_real_t*)Argument;
 
-	*Real	= GetReal( Cookie );
-
-	return 0;
+	return GetReal( Cookie, Real );
 	}
 /*============================================================================*/
-static pcad_dimmension_t GetDimmension( cookie_t *Cookie )
+static int GetDimmension( cookie_t *Cookie, pcad_dimmension_t *Dimmension )
 	{
 	char				Buffer1[BUFFER_SIZE];
 	char				Buffer2[BUFFER_SIZE];
 	token_t				Token;
-	pcad_dimmension_t	Dimmension;
+	int					Unit;
+
+	int64_t				Value	= 0;
 
 	Token	= GetToken( Cookie, Buffer1, sizeof Buffer1 );
 	if( Token != TOKEN_FLOAT && Token != TOKEN_INTEGER && Token != TOKEN_UNSIGNED )
-		Error( Cookie, -1, "Expecting a number" );
+		return RecordError( Cookie, -1, "Expecting a number" );
+
+	/* Reading the unit replaces the value the lexer thread converted, let's keep it. */
+	if( Cookie->Pipeline != NULL )
+		Value	= Token == TOKEN_FLOAT ? Cookie->TokenValue : Cookie->TokenValue * 1000000;
 
 	Token	= GetToken( Cookie, Buffer2, sizeof Buffer2 );
 	if( Token == TOKEN_NAME )
-		Dimmension	= ProcessDimmension( Cookie, Buffer1, TranslateUnits( Cookie, Buffer2 ));
+		{
+		if(( Unit = CheckUnits( Cookie, Buffer2 )) < 0 )
+			return Unit;
+		}
 	else
 		{
 		UngetToken( Cookie, Token, Buffer2 );
-		Dimmension	= ProcessDimmension( Cookie, Buffer1, Cookie->FileUnits );
+		Unit	= Cookie->FileUnits;
 		}
 
-	return Dimmension;
+	if( Unit == PCAD_UNITS_NONE )
+		return RecordError( Cookie, -1, "Invalid unit \"%s\"", Units.items[Unit] );
+
+	*Dimmension	= Cookie->Pipeline != NULL ? ScaleDimmension( Value, Unit ) : ProcessDimmension( Cookie, Buffer1, Unit );
+
+	return 0;
 	}
 /*============================================================================*/
 int ParseDimmension( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
 	{
 	pcad_dimmension_t	*Dimmension = (pcad_dimmension_t*)Argument;
 
-	*Dimmension = GetDimmension( Cookie );
-
-	return 0;
+	return GetDimmension( Cookie, Dimmension );
 	}
 /*============================================================================*/
-static pcad_enum_boolean_t GetBoolean( cookie_t *Cookie )
+static int GetBoolean( cookie_t *Cookie, pcad_enum_boolean_t *Boolean )
 	{
 	char	Buffer[BUFFER_SIZE];
 
 	if( GetToken( Cookie, Buffer, sizeof Buffer ) != TOKEN_NAME )
-		Error( Cookie, -1, "Expecting boolean value" );
+		return RecordError( Cookie, -1, "Expecting boolean value" );
+
 	if( stricmp( Buffer, "False" ) == 0 )
-		return PCAD_BOOLEAN_FALSE;
-	if( stricmp( Buffer, "True" ) == 0 )
-		return PCAD_BOOLEAN_TRUE;
+		*Boolean	= PCAD_BOOLEAN_FALSE;
+	else if( stricmp( Buffer, "True" ) == 0 )
+		*Boolean	= PCAD_BOOLEAN_TRUE;
+	else
+		return RecordError( Cookie, -1, "Expecting boolean value" );
 
-	Error( Cookie, -1, "Expecting boolean value" );
+	return 0;
 	}
 /*============================================================================*/
 int ParseBoolean( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
 	{
 	pcad_enum_boolean_t	*Boolean	= (pcad_unsigned_t*)Argument;
 
-	*Boolean	= GetBoolean( Cookie );
-
-	return 0;
+	return GetBoolean( Cookie, Boolean );
 	}
 /*============================================================================*/
-uint32_t GetUnsigned( cookie_t *Cookie )
+/* Same as "GetUnsigned", but returns the error code instead of jumping out. */
+static int CheckUnsigned( cookie_t *Cookie, uint32_t *Unsigned )
 	{
 	char		Buffer[BUFFER_SIZE], *p = Buffer;
 	uint32_t	Value	= 0;
 	token_t		Token	= GetToken( Cookie, Buffer, sizeof Buffer );
 
 	if( Token != TOKEN_UNSIGNED )
-		Error( Cookie, -1, "Expecting unsigned integer number" );
+		return RecordError( Cookie, -1, "Expecting unsigned integer number" );
+
+	/* The lexer thread has already converted it. */
+	if( Cookie->Pipeline != NULL )
+		{
+		*Unsigned	= Cookie->TokenValue;
+		return 0;
+		}
 
 	while( isdigit( *p ))
 		Value	= Value * 10 + *p++ - '0';
 
+	*Unsigned	= Value;
+
+	return 0;
+	}
+/*============================================================================*/
+uint32_t GetUnsigned( cookie_t *Cookie )
+	{
+	uint32_t	Value;
+
+	if( CheckUnsigned( Cookie, &Value ) < 0 )
+		longjmp( Cookie->JumpBuffer, Cookie->LastError.Code );
+
 	return Value;
 	}
 /*============================================================================*/
@@ -234,12 +319,10 @@ int ParseUnsigned( cookie_t *Cookie, const parsefield_t *ParseField, const parse
 	{
 	pcad_unsigned_t	*Unsigned	= (pcad_unsigned_t*)Argument;
 
-	*Unsigned	= GetUnsigned( Cookie );
-
-	return 0;
+	return CheckUnsigned( Cookie, Unsigned );
 	}
 /*============================================================================*/
-static int32_t GetSigned( cookie_t *Cookie )
+static int GetSigned( cookie_t *Cookie, int32_t *Signed )
 	{
 	char		Buffer[BUFFER_SIZE], *p = Buffer;
 	int32_t	    Value	= 0;
@@ -247,7 +330,13 @@ static int32_t GetSigned( cookie_t *Cookie )
 	token_t		Token	= GetToken( Cookie, Buffer, sizeof Buffer );
 
 	if( Token != TOKEN_UNSIGNED && Token != TOKEN_INTEGER )
-		Error( Cookie, -1, "Expecting signed integer number" );
+		return RecordError( Cookie, -1, "Expecting signed integer number" );
+
+	if( Cookie->Pipeline != NULL )
+		{
+		*Signed	= Cookie->TokenValue;
+		return 0;
+		}
 
     if (*p == '-') {
         Sign = -1;
@@ -257,22 +346,31 @@ static int32_t GetSigned( cookie_t *Cookie )
 	while( isdigit( *p ))
 		Value	= Value * 10 + *p++ - '0';
 
-	return Value * Sign;
+	*Signed	= Value * Sign;
+
+	return 0;
 	}
 /*============================================================================*/
 int ParseSigned( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
 	{
-	pcad_unsigned_t	*Unsigned	= (pcad_unsigned_t*)Argument;
+	int32_t	*Signed	= (int32_t*)Argument;
 
-	*Unsigned	= GetSigned( Cookie );
+	return GetSigned( Cookie, Signed );
+	}
+/*============================================================================*/
+/* Same as "GetName", but returns the error code instead of jumping out. */
+static int CheckName( cookie_t *Cookie, char *Buffer, size_t BufferLength )
+	{
+	if( GetToken( Cookie, Buffer, BufferLength ) != TOKEN_NAME )
+		return RecordError( Cookie, -1, "Expecting name" );
 
-	return 0;
+	return TOKEN_NAME;
 	}
 /*============================================================================*/
 int GetName( cookie_t *Cookie, char *Buffer, size_t BufferLength )
 	{
-	if( GetToken( Cookie, Buffer, BufferLength ) != TOKEN_NAME )
-		Error( Cookie, -1, "Expecting name" );
+	if( CheckName( Cookie, Buffer, BufferLength ) < 0 )
+		longjmp( Cookie->JumpBuffer, Cookie->LastError.Code );
 
 	return TOKEN_NAME;
 	}
@@ -282,10 +380,11 @@ int ParseEnum( cookie_t *Cookie, const parsefield_t *ParseField, const parsestru
 	char			Buffer[BUFFER_SIZE];
 	pcad_unsigned_t	*Enum		= (pcad_unsigned_t*)Argument;
 	parseenum_t		*EnumStruct = (parseenum_t*)ParseStruct;
-	int				i;
+	int				i, Result;
 
 	*Enum	= 0;
-	GetName( Cookie, Buffer, sizeof Buffer );
+	if(( Result = CheckName( Cookie, Buffer, sizeof Buffer )) < 0 )
+		return Result;
 	for( i = 0; i < EnumStruct->numitems; i++ )
 		if( stricmp( Buffer, EnumStruct->items[i] ) == 0 )
 			{
@@ -298,50 +397,126 @@ int ParseEnum( cookie_t *Cookie, const parsefield_t *ParseField, const parsestru
 	return 0;
 	}
 /*============================================================================*/
-int GetString( cookie_t *Cookie, char *Buffer, size_t BufferLength )
+/* Same as "GetString", but returns the error code instead of jumping out. */
+static int CheckString( cookie_t *Cookie, char *Buffer, size_t BufferLength )
 	{
 	if( GetToken( Cookie, Buffer, BufferLength ) != TOKEN_STRING )
-		Error( Cookie, -1, "Expecting quoted string" );
+		return RecordError( Cookie, -1, "Expecting quoted string" );
 
 	return TOKEN_STRING;
 	}
 /*============================================================================*/
-static char *StoreString( cookie_t *Cookie, const char *Buffer )
+int GetString( cookie_t *Cookie, char *Buffer, size_t BufferLength )
+	{
+	if( CheckString( Cookie, Buffer, BufferLength ) < 0 )
+		longjmp( Cookie->JumpBuffer, Cookie->LastError.Code );
+
+	return TOKEN_STRING;
+	}
+/*============================================================================*/
+/*
+When the heap is exhausted a new block is chained to it. The old blocks are kept
+until "ReleaseHeap" because the structures already parsed point into them.
+*/
+#define	HEAP_BLOCK_SIZE		( 1024 * 1024 )
+/*----------------------------------------------------------------------------*/
+typedef struct heapblock_tag
+	{
+	struct heapblock_tag	*Next;
+	} heapblock_t;
+/*============================================================================*/
+/* Returns non-zero if there is no room for "size" bytes and no memory for a new block. */
+static int ReserveHeap( cookie_t *Cookie, size_t size )
+	{
+	heapblock_t	*Block;
+	size_t		BlockSize;
+
+	if( Cookie->HeapTop < Cookie->HeapSize && size < Cookie->HeapSize - Cookie->HeapTop )
+		return 0;
+
+	BlockSize	= size < HEAP_BLOCK_SIZE ? HEAP_BLOCK_SIZE : size + 1;
+
+	if(( Block = malloc( sizeof( heapblock_t ) + BlockSize )) == NULL )
+		return -1;
+
+	Cookie->Stats.HeapUsed	+= Cookie->HeapTop;
+	Cookie->Stats.HeapSize	+= BlockSize;
+	Cookie->Stats.HeapBlocks++;
+
+	Block->Next			= Cookie->HeapBlocks;
+	Cookie->HeapBlocks	= Block;
+	Cookie->Heap		= (uint8_t*)( Block + 1 );
+	Cookie->HeapSize	= BlockSize;
+	Cookie->HeapTop		= 0;
+
+	return 0;
+	}
+/*============================================================================*/
+/* Frees the blocks chained to a heap, its first block belongs to whoever set "Cookie->Heap". */
+void ReleaseHeap( heapblock_t **Blocks )
+	{
+	heapblock_t	*Block, *Next;
+
+	for( Block = *Blocks; Block != NULL; Block = Next )
+		{
+		Next	= Block->Next;
+		free( Block );
+		}
+
+	*Blocks	= NULL;
+	}
+/*============================================================================*/
+/*
+"Site" is the tag of the field the string is for, NULL if it has none. Returns
+NULL, with the error recorded, if there is no memory for the string.
+*/
+static char *StoreString( cookie_t *Cookie, const char *Buffer, const char *Site )
 	{
 	void	*Address;
 	size_t	size	= strlen( Buffer ) + 1;
 
-	if( Cookie->HeapTop >= Cookie->HeapSize || Cookie->HeapTop + size >= Cookie->HeapSize )
-		Error( Cookie, -1, "Not enough memory" );
+	if( ReserveHeap( Cookie, size ) != 0 )
+		{
+		RecordError( Cookie, -1, "Not enough memory" );
+		return NULL;
+		}
 
 	Address = &Cookie->Heap[Cookie->HeapTop];
 
 	memcpy( Address, Buffer, size );
 
-	Cookie->HeapTop += size;
+	Cookie->HeapTop				+= size;
+	Cookie->Stats.StringBytes	+= size;
+
+	if( Cookie->Profile != NULL )
+		RecordAllocation( Cookie->Profile, "string", Site != NULL ? Site : "parse", size );
 
 	return Address;
 	}
 /*============================================================================*/
 char *GetAndStoreString( cookie_t *Cookie )
 	{
-	char	Buffer[BUFFER_SIZE];
+	char	Buffer[BUFFER_SIZE], *String;
+
+	GetString( Cookie, Buffer, sizeof Buffer );
 
-	if( GetToken( Cookie, Buffer, sizeof Buffer ) != TOKEN_STRING )
-		Error( Cookie, -1, "Expecting quoted string" );
+	if(( String = StoreString( Cookie, Buffer, NULL )) == NULL )
+		longjmp( Cookie->JumpBuffer, Cookie->LastError.Code );
 
-	return StoreString( Cookie, Buffer );
+	return String;
 	}
 /*============================================================================*/
 int ParseName( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
 	{
 	char	Buffer[256];
 	char	**p	= (char**)Argument;
+	int		Result;
 
-	GetName( Cookie, Buffer, sizeof Buffer );
+	if(( Result = CheckName( Cookie, Buffer, sizeof Buffer )) < 0 )
+		return Result;
 
-	if( p != NULL )
-		*p	= StoreString( Cookie, Buffer );
+	if( p != NULL && ( *p = StoreString( Cookie, Buffer, ParseField != NULL ? ParseField->TagString : NULL )) == NULL )
+		return Cookie->LastError.Code;
 
 	return 0;
 	}
@@ -350,23 +525,37 @@ int ParseString( cookie_t *Cookie, const parsefield_t *ParseField, const parsest
 	{
 	char	Buffer[256];
 	char	**p	= (char**)Argument;
+	int		Result;
 
-	GetString( Cookie, Buffer, sizeof Buffer );
+	if(( Result = CheckString( Cookie, Buffer, sizeof Buffer )) < 0 )
+		return Result;
 
-	if( p != NULL )
-		*p	= StoreString( Cookie, Buffer );
+	if( p != NULL && ( *p = StoreString( Cookie, Buffer, ParseField != NULL ? ParseField->TagString : NULL )) == NULL )
+		return Cookie->LastError.Code;
 
 	return 0;
 	}
 /*============================================================================*/
-void *Allocate( cookie_t *Cookie, size_t size )
+/* Returns NULL if the heap is exhausted. */
+static void *TryAllocate( cookie_t *Cookie, size_t size, const char *Kind, const char *Site )
 	{
 	void	*Address;
+	size_t	Aligned;
 
-	if( Cookie->HeapTop >= Cookie->HeapSize || Cookie->HeapTop + size >= Cookie->HeapSize )
-		Error( Cookie, -1, "Not enough memory" );
+	Aligned	= ( Cookie->HeapTop + sizeof( void* ) - 1 ) & -sizeof( void* );
+
+	if( Cookie->Profile != NULL )
+		{
+		if( Aligned > Cookie->HeapTop )
+			RecordAllocation( Cookie->Profile, "alignment", "heap", Aligned - Cookie->HeapTop );
+		RecordAllocation( Cookie->Profile, Kind, Site, size );
+		}
+
+	Cookie->HeapTop	= Aligned;
+
+	if( ReserveHeap( Cookie, size ) != 0 )
+		return NULL;
 
-	Cookie->HeapTop	= ( Cookie->HeapTop + sizeof( void* ) - 1 ) & -sizeof( void* );
 	Address			= &Cookie->Heap[ Cookie->HeapTop ];
 
 	memset( Address, 0x00, size );
@@ -376,55 +565,236 @@ void *Allocate( cookie_t *Cookie, size_t size )
 	return Address;
 	}
 /*============================================================================*/
-token_t ExpectToken( cookie_t *Cookie, token_t tk )
+void *AllocateTagged( cookie_t *Cookie, size_t size, const char *Kind, const char *Site )
+	{
+	void	*Address;
+
+	if(( Address = TryAllocate( Cookie, size, Kind, Site )) == NULL )
+		Error( Cookie, -1, "Not enough memory" );
+
+	return Address;
+	}
+/*============================================================================*/
+static heapsite_t *FindHeapSite( heapprofile_t *Profile, const char *Kind, const char *Site )
+	{
+	heapsite_t	*Entry;
+	unsigned	i, n;
+
+	i	= HashString( HashString( HASH_INITIAL, Kind ), Site ) % MAX_HEAP_SITES;
+
+	for( n = 0; n < MAX_HEAP_SITES; n++, i = ( i + 1 ) % MAX_HEAP_SITES )
+		{
+		Entry	= &Profile->Sites[i];
+		if( Entry->Kind == NULL )
+			{
+			Entry->Kind	= Kind;
+			Entry->Site	= Site;
+			Profile->NumSites++;
+			return Entry;
+			}
+		if(( Entry->Kind == Kind || strcmp( Entry->Kind, Kind ) == 0 ) && ( Entry->Site == Site || strcmp( Entry->Site, Site ) == 0 ))
+			return Entry;
+		}
+
+	return NULL;
+	}
+/*============================================================================*/
+void RecordAllocation( heapprofile_t *Profile, const char *Kind, const char *Site, size_t Size )
+	{
+	heapsite_t	*Entry;
+
+	if(( Entry = FindHeapSite( Profile, Kind != NULL ? Kind : "(untagged)", Site )) == NULL )
+		{
+		Profile->OtherCount++;
+		Profile->OtherBytes	+= Size;
+		return;
+		}
+
+	Entry->Count++;
+	Entry->Bytes	+= Size;
+	}
+/*============================================================================*/
+void MergeHeapProfile( heapprofile_t *Profile, const heapprofile_t *Sheet )
+	{
+	const heapsite_t	*Source;
+	heapsite_t			*Entry;
+
+	for( Source = Sheet->Sites; Source < Sheet->Sites + MAX_HEAP_SITES; Source++ )
+		{
+		if( Source->Kind == NULL )
+			continue;
+		if(( Entry = FindHeapSite( Profile, Source->Kind, Source->Site )) == NULL )
+			{
+			Profile->OtherCount	+= Source->Count;
+			Profile->OtherBytes	+= Source->Bytes;
+			continue;
+			}
+		Entry->Count	+= Source->Count;
+		Entry->Bytes	+= Source->Bytes;
+		}
+
+	Profile->OtherCount	+= Sheet->OtherCount;
+	Profile->OtherBytes	+= Sheet->OtherBytes;
+	}
+/*============================================================================*/
+static int CompareHeapSites( const void *a, const void *b )
+	{
+	const pcadsch_heapsite_t	*pa	= a;
+	const pcadsch_heapsite_t	*pb	= b;
+
+	if( pa->Bytes != pb->Bytes )
+		return pa->Bytes < pb->Bytes ? 1 : -1;
+
+	return pa->Count < pb->Count ? 1 : pa->Count > pb->Count ? -1 : 0;
+	}
+/*============================================================================*/
+int ListHeapProfile( const heapprofile_t *Profile, pcadsch_heapsite_t *Sites, int Max )
+	{
+	const heapsite_t	*Source;
+	pcadsch_heapsite_t	*List;
+	int					NumSites = 0, i;
+
+	if(( List = malloc(( Profile->NumSites + 1 ) * sizeof( pcadsch_heapsite_t ))) == NULL )
+		return -1;
+
+	/* Sites whose names differ only past the width of the list are counted together. */
+	for( Source = Profile->Sites; Source < Profile->Sites + MAX_HEAP_SITES; Source++ )
+		{
+		if( Source->Kind == NULL )
+			continue;
+
+		for( i = 0; i < NumSites && ( strncmp( List[i].Kind, Source->Kind, sizeof List[i].Kind - 1 ) != 0 || strncmp( List[i].Site, Source->Site, sizeof List[i].Site - 1 ) != 0 ); i++ )
+			{}
+		if( i == NumSites )
+			{
+			snprintf( List[i].Kind, sizeof List[i].Kind, "%s", Source->Kind );
+			snprintf( List[i].Site, sizeof List[i].Site, "%s", Source->Site );
+			List[i].Count	= 0;
+			List[i].Bytes	= 0;
+			NumSites++;
+			}
+		List[i].Count	+= Source->Count;
+		List[i].Bytes	+= Source->Bytes;
+		}
+
+	if( Profile->OtherCount > 0 )
+		{
+		strcpy( List[NumSites].Kind, "(other)" );
+		strcpy( List[NumSites].Site, "" );
+		List[NumSites].Count	= Profile->OtherCount;
+		List[NumSites].Bytes	= Profile->OtherBytes;
+		NumSites++;
+		}
+
+	qsort( List, NumSites, sizeof( pcadsch_heapsite_t ), CompareHeapSites );
+
+	if( Max > 0 )
+		memcpy( Sites, List, ( NumSites < Max ? NumSites : Max ) * sizeof( pcadsch_heapsite_t ));
+
+	free( List );
+
+	return NumSites;
+	}
+/*============================================================================*/
+/* Same as "ExpectToken", but returns the error code instead of jumping out. */
+static int CheckToken( cookie_t *Cookie, token_t tk )
 	{
 	if( GetToken( Cookie, NULL, 0 ) != tk )
-		Error( Cookie, -1, "Expecting \"%s\"", Tokens.items[tk%Tokens.numitems] );
+		return RecordError( Cookie, -1, "Expecting \"%s\"", Tokens.items[tk%Tokens.numitems] );
+
+	return tk;
+	}
+/*============================================================================*/
+token_t ExpectToken( cookie_t *Cookie, token_t tk )
+	{
+	if( CheckToken( Cookie, tk ) < 0 )
+		longjmp( Cookie->JumpBuffer, Cookie->LastError.Code );
 
 	return tk;
 	}
 /*============================================================================*/
 static int SkipAll( cookie_t *Cookie )
 	{
-	char	Buffer[BUFFER_SIZE];
-	token_t Token;
+	char		Buffer[BUFFER_SIZE];
+	token_t		Token;
+	unsigned	Depth	= 1;
 
-	Token	= GetToken( Cookie, Buffer, sizeof Buffer );
 	do
 		{
-		if( Token == TOKEN_OPEN_PAR && SkipAll( Cookie ) < RESULT_OK )
-			Error( Cookie, -1, "Unknown error" );
 		Token	= GetToken( Cookie, Buffer, sizeof Buffer );
+		if( Token == TOKEN_OPEN_PAR )
+			Depth++;
+		else if( Token == TOKEN_CLOSE_PAR )
+			Depth--;
+		else if( Token == TOKEN_INVALID || Token == TOKEN_EOF )
+			return RecordError( Cookie, -1, "Expecting \")\"" );
 		}
-	while( Token != TOKEN_CLOSE_PAR && Token != TOKEN_INVALID && Token != TOKEN_EOF );
-
-	if( Token != TOKEN_CLOSE_PAR )
-		Error( Cookie, -1, "Expecting \")\"" );
+	while( Depth > 0 );
 
 	return Token;
 	}
 /*============================================================================*/
+/* Skips the contents of the current field, leaving its closing parenthesis to be read. */
+static int SkipContents( cookie_t *Cookie )
+	{
+	int		Result;
+	/* The bytes skipped are counted from the last token read, the tag of the element, to its closing parenthesis. */
+	size_t	Start	= Cookie->TokenOffset;
+
+	/* The raw skipper bypasses the lexer, so it can be used only if there is no token pending. */
+	if( Cookie->Pipeline == NULL && Cookie->UngettedToken == TOKEN_NONE )
+		{
+		if(( Result = SkipBlock( Cookie, NULL, NULL )) < 0 )
+			return Result;
+		COUNT( BytesSkipped, Cookie->Position - Start );
+		return 0;
+		}
+
+	if(( Result = SkipAll( Cookie )) < 0 )
+		return Result;
+	COUNT( SkipAlls, 1 );
+	COUNT( BytesSkipped, Cookie->TokenOffset - Start );
+	UngetToken( Cookie, TOKEN_CLOSE_PAR, ")" );
+
+	return 0;
+	}
+/*============================================================================*/
+/* Tells whether the field is in one of the sections being parsed. */
+static int IsWanted( const cookie_t *Cookie, const parsefield_t *Field )
+	{
+	return ( Field->Flags & FLAG_SECTIONS ) == 0 || ( Field->Flags & Cookie->Sections & FLAG_SECTIONS ) != 0;
+	}
+/*============================================================================*/
 //#define BREAKPOINT
 
 #if			defined BREAKPOINT
 static const char Bkpt[]	= "schematicPrintSettings";
 #endif	/*	defined BREAKPOINT */
 /*============================================================================*/
-int ParseGeneric( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
+/*
+Allocates (if needed) the object described by "ParseStruct", links it to its
+parent and initializes its lists. Returns NULL on error.
+*/
+static void *OpenObject( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
 	{
-	char	Buffer[256];
 	void	*Object;
 	int		i;
 
-//	fprintf( stderr, "(%u,%u)", Cookie->LineNumber, Cookie->Column );
 	if( ParseStruct == NULL )
-		Error( Cookie, -1, "Internal error, \"ParseStruct\" is NULL" );
+		{
+		RecordError( Cookie, -1, "Internal error, \"ParseStruct\" is NULL" );
+		return NULL;
+		}
 
 	/* This field is a pointer inside its data structure, it does not have an area reserved for it... */
 	if( ParseField != NULL && ParseField->Length > 0 )
 		{
 		/* ...so let's allocate memory for it. */
-		Object		= Allocate( Cookie, ParseField->Length );
+		if(( Object = TryAllocate( Cookie, ParseField->Length, ParseField->TagString, "parse" )) == NULL )
+			{
+			RecordError( Cookie, -1, "Not enough memory" );
+			return NULL;
+			}
 
 		/* This field is a list, possibly with multiple instances... */
 		if( ParseField->Flags & FLAG_LIST )
@@ -459,17 +829,64 @@ int ParseGeneric( cookie_t *Cookie, const parsefield_t *ParseField, const parses
 			}
 		}
 
-	/* Process all the fixed fields of this object. */
-	if( ParseStruct->NumFixedFields > 0 && ParseStruct->FixedFields != NULL )
+	return Object;
+	}
+/*============================================================================*/
+/*
+The nested structures are parsed without recursion, each one being a frame in
+an explicit stack. Only the leaf fields and the special cases (which have their
+own parse function) are called. The leaf parsers above return their errors as
+this function does, but the special cases of the grammar may still jump out
+through "Error" (see "PCADParser.c").
+*/
+/*----------------------------------------------------------------------------*/
+#define	MAX_PARSE_DEPTH		32
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	const parsestruct_t		*ParseStruct;
+	void					*Object;
+	/* The next fixed field to parse, past the last one we are in the tagged fields. */
+	size_t					Index;
+	/* The frame was opened by a wrapped field and must consume its closing parenthesis. */
+	int						Wrapped;
+	} parseframe_t;
+/*----------------------------------------------------------------------------*/
+int ParseGeneric( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument )
+	{
+	parseframe_t	Stack[MAX_PARSE_DEPTH];
+	char			Buffer[256];
+	unsigned		Depth;
+	int				i, Result;
+
+//	fprintf( stderr, "(%u,%u)", Cookie->LineNumber, Cookie->Column );
+	if(( Stack[0].Object = OpenObject( Cookie, ParseField, ParseStruct, Argument )) == NULL )
+		return Cookie->LastError.Code;
+	Stack[0].ParseStruct	= ParseStruct;
+	Stack[0].Index			= 0;
+	Stack[0].Wrapped		= 0;
+	Depth					= 1;
+
+	while( Depth > 0 )
 		{
-		for( i = 0; i < ParseStruct->NumFixedFields; i++ )
+		parseframe_t		*Frame	= &Stack[Depth-1];
+		const parsefield_t	*Field;
+		int					Wrapped;
+
+		ParseStruct	= Frame->ParseStruct;
+
+		/* Process all the fixed fields of this object. */
+		if( ParseStruct->FixedFields != NULL && Frame->Index < ParseStruct->NumFixedFields )
 			{
-			const parsefield_t	*Field	= &ParseStruct->FixedFields[i];
+			Field	= &ParseStruct->FixedFields[Frame->Index++];
+			Wrapped	= Field->Flags & FLAG_WRAPPED;
 
-			if( Field->Flags & FLAG_WRAPPED )
+			if( Wrapped )
 				{
-				ExpectToken( Cookie, TOKEN_OPEN_PAR );
-				GetName( Cookie, Buffer, sizeof Buffer );
+				if(( Result = CheckToken( Cookie, TOKEN_OPEN_PAR )) < 0 )
+					return Result;
+				if( GetToken( Cookie, Buffer, sizeof Buffer ) != TOKEN_NAME )
+					return RecordError( Cookie, -1, "Expecting name" );
 
 #if			defined BREAKPOINT
 				if( stricmp( Bkpt, Buffer ) == 0 )
@@ -477,12 +894,205 @@ int ParseGeneric( cookie_t *Cookie, const parsefield_t *ParseField, const parses
 #endif	/*	defined BREAKPOINT */
 
 				if( Field->TagString != NULL && strcmp( Buffer, Field->TagString ) != 0 )
-					Error( Cookie, -1, "Expecting name" );
-				Field->ParseFunc( Cookie, Field, Field->ParseStruct, Field->Offset < 0 ? NULL : (char*)Object + Field->Offset );
-				ExpectToken( Cookie, TOKEN_CLOSE_PAR );
+					return RecordError( Cookie, -1, "Expecting name" );
 				}
-			else
-				Field->ParseFunc( Cookie, Field, Field->ParseStruct, Field->Offset < 0 ? NULL : (char*)Object + Field->Offset );
+			}
+		/* Then the tagged fields, in any order. */
+		else if( ParseStruct->Fields != NULL && ParseStruct->NumFields > 0 )
+			{
+			token_t Token;
+
+			if(( Token = GetToken( Cookie, Buffer, sizeof Buffer )) != TOKEN_OPEN_PAR )
+				{
+				UngetToken( Cookie, Token, Buffer );
+				Depth--;
+				if( Frame->Wrapped && ( Result = CheckToken( Cookie, TOKEN_CLOSE_PAR )) < 0 )
+					return Result;
+				continue;
+				}
+
+			if(( Token = GetToken( Cookie, Buffer, sizeof Buffer )) != TOKEN_NAME )
+				return RecordError( Cookie, -1, "Expecting tag at" );
+
+#if			defined BREAKPOINT
+			if( stricmp( Bkpt, Buffer ) == 0 )
+				asm volatile( "int3" );
+#endif	/*	defined BREAKPOINT */
+
+			for( i = 0; i < ParseStruct->NumFields && (( ParseStruct->Fields[i].Flags & FLAG_CASESENSITIVE ) ? ( strcmp( Buffer, ParseStruct->Fields[i].TagString ) != 0 ) : ( stricmp( Buffer, ParseStruct->Fields[i].TagString ) != 0 )); i++ )
+				{}
+
+			if( i >= ParseStruct->NumFields )
+				{
+				RecordSkipped( Cookie, Buffer );
+				if(( Result = SkipContents( Cookie )) < 0 || ( Result = CheckToken( Cookie, TOKEN_CLOSE_PAR )) < 0 )
+					return Result;
+				continue;
+				}
+
+			Field	= &ParseStruct->Fields[i];
+			Wrapped	= 1;
+			}
+		/* This object is complete. */
+		else
+			{
+			Depth--;
+			if( Frame->Wrapped && ( Result = CheckToken( Cookie, TOKEN_CLOSE_PAR )) < 0 )
+				return Result;
+			continue;
+			}
+
+		Argument	= Field->Offset < 0 ? NULL : (char*)Frame->Object + Field->Offset;
+
+		if( !IsWanted( Cookie, Field ))
+			{
+			if(( Result = SkipContents( Cookie )) < 0 )
+				return Result;
+			}
+		/* A nested structure, let's open a new frame for it. */
+		else if( Field->ParseFunc == ParseGeneric )
+			{
+			if( Depth >= MAX_PARSE_DEPTH )
+				return RecordError( Cookie, -1, "Too many nesting levels" );
+
+			Frame	= &Stack[Depth];
+			if(( Frame->Object = OpenObject( Cookie, Field, Field->ParseStruct, Argument )) == NULL )
+				return Cookie->LastError.Code;
+			Frame->ParseStruct	= Field->ParseStruct;
+			Frame->Index		= 0;
+			Frame->Wrapped		= Wrapped;
+			Depth++;
+			continue;
+			}
+		else if(( Result = Field->ParseFunc( Cookie, Field, Field->ParseStruct, Argument )) < 0 )
+			return Result;
+
+		if( Wrapped && ( Result = CheckToken( Cookie, TOKEN_CLOSE_PAR )) < 0 )
+			return Result;
+		}
+
+	return 0;
+	}
+/*============================================================================*/
+static scankind_t ClassifyField( const parsefield_t *Field, scanclassify_t Classify )
+	{
+	if( Field->ParseFunc == ParseGeneric )
+		return SCAN_STRUCT;
+	if( Field->ParseFunc == ParseString )
+		return SCAN_STRING;
+	if( Field->ParseFunc == ParseName )
+		return SCAN_NAME;
+	if( Field->ParseFunc == ParseUnsigned )
+		return SCAN_UNSIGNED;
+	if( Field->ParseFunc == ParseSigned )
+		return SCAN_SIGNED;
+	if( Field->ParseFunc == ParseReal )
+		return SCAN_REAL;
+	if( Field->ParseFunc == ParseDimmension )
+		return SCAN_DIMMENSION;
+	if( Field->ParseFunc == ParseBoolean )
+		return SCAN_BOOLEAN;
+	if( Field->ParseFunc == ParseEnum )
+		return SCAN_ENUM;
+
+	/* The special cases are known only to the grammar. */
+	return Classify != NULL ? Classify( Field->ParseFunc ) : SCAN_SKIP;
+	}
+/*============================================================================*/
+static int ScanField( cookie_t *Cookie, const parsefield_t *Field, const char *Tag, const scanner_t *Scanner, scanclassify_t Classify )
+	{
+	char		Buffer[BUFFER_SIZE];
+	scanvalue_t	Value;
+	uint32_t	Scratch	= 0;
+	int			Result;
+
+	Value.Kind		= ClassifyField( Field, Classify );
+	Value.String	= NULL;
+	Value.Number	= 0;
+
+	switch( Value.Kind )
+		{
+		case SCAN_SKIP:
+			if( Tag == NULL )
+				return RecordError( Cookie, -1, "Internal error, cannot skip a naked field" );
+			return SkipContents( Cookie );
+		case SCAN_STRUCT:
+			if( Scanner->BeginStruct != NULL && ( Result = Scanner->BeginStruct( Scanner->UserData, Field, Tag )) != 0 )
+				return Result;
+			if(( Result = ScanGeneric( Cookie, Field->ParseStruct, Scanner, Classify )) != 0 )
+				return Result;
+			if( Scanner->EndStruct != NULL )
+				return Scanner->EndStruct( Scanner->UserData, Field, Tag );
+			return 0;
+		case SCAN_STRING:
+			if(( Result = CheckString( Cookie, Buffer, sizeof Buffer )) < 0 )
+				return Result;
+			Value.String	= Buffer;
+			break;
+		case SCAN_NAME:
+			if(( Result = CheckName( Cookie, Buffer, sizeof Buffer )) < 0 )
+				return Result;
+			Value.String	= Buffer;
+			break;
+		/* These don't allocate anything, so they can do their job on a scratch variable. */
+		case SCAN_SIGNED:
+		case SCAN_REAL:
+		case SCAN_DIMMENSION:
+			if(( Result = Field->ParseFunc( Cookie, Field, Field->ParseStruct, &Scratch )) < 0 )
+				return Result;
+			Value.Number	= (int32_t)Scratch;
+			break;
+		default:
+			if(( Result = Field->ParseFunc( Cookie, Field, Field->ParseStruct, &Scratch )) < 0 )
+				return Result;
+			Value.Number	= Scratch;
+			break;
+		}
+
+	if( Scanner->FieldValue != NULL )
+		return Scanner->FieldValue( Scanner->UserData, Field, Tag, &Value );
+
+	return 0;
+	}
+/*============================================================================*/
+/*
+Recurses once per nesting level, which the grammar bounds. Like "ParseGeneric"
+it returns the errors, only the special cases may jump out.
+*/
+int ScanGeneric( cookie_t *Cookie, const parsestruct_t *ParseStruct, const scanner_t *Scanner, scanclassify_t Classify )
+	{
+	char	Buffer[256];
+	int		i, j, Result;
+
+	if( ParseStruct == NULL )
+		return RecordError( Cookie, -1, "Internal error, \"ParseStruct\" is NULL" );
+
+	if( ParseStruct->NumFixedFields > 0 && ParseStruct->FixedFields != NULL )
+		{
+		for( i = 0; i < ParseStruct->NumFixedFields; i++ )
+			{
+			const parsefield_t	*Field	= &ParseStruct->FixedFields[i];
+
+			if( Field->Flags & FLAG_WRAPPED )
+				{
+				if(( Result = CheckToken( Cookie, TOKEN_OPEN_PAR )) < 0 || ( Result = CheckName( Cookie, Buffer, sizeof Buffer )) < 0 )
+					return Result;
+
+				/* Some fixed fields may be omitted (e.g. the "endStyle" of wires), let's look ahead for the one that matches. */
+				for( j = i; j < ParseStruct->NumFixedFields && !(( ParseStruct->FixedFields[j].Flags & FLAG_WRAPPED ) && ( ParseStruct->FixedFields[j].TagString == NULL || strcmp( Buffer, ParseStruct->FixedFields[j].TagString ) == 0 )); j++ )
+					{}
+				if( j >= ParseStruct->NumFixedFields )
+					return RecordError( Cookie, -1, "Expecting name" );
+
+				i		= j;
+				Field	= &ParseStruct->FixedFields[i];
+				if(( Result = IsWanted( Cookie, Field ) ? ScanField( Cookie, Field, Buffer, Scanner, Classify ) : SkipContents( Cookie )) != 0 )
+					return Result;
+				if(( Result = CheckToken( Cookie, TOKEN_CLOSE_PAR )) < 0 )
+					return Result;
+				}
+			else if(( Result = ScanField( Cookie, Field, NULL, Scanner, Classify )) != 0 )
+				return Result;
 			}
 		}
 
@@ -493,26 +1103,25 @@ int ParseGeneric( cookie_t *Cookie, const parsefield_t *ParseField, const parses
 		while(( Token = GetToken( Cookie, Buffer, sizeof Buffer )) == TOKEN_OPEN_PAR )
 			{
 			if(( Token = GetToken( Cookie, Buffer, sizeof Buffer )) != TOKEN_NAME )
-				Error( Cookie, -1, "Expecting tag at" );
-
-#if			defined BREAKPOINT
-			if( stricmp( Bkpt, Buffer ) == 0 )
-				asm volatile( "int3" );
-#endif	/*	defined BREAKPOINT */
+				return RecordError( Cookie, -1, "Expecting tag at" );
 
 			for( i = 0; i < ParseStruct->NumFields && (( ParseStruct->Fields[i].Flags & FLAG_CASESENSITIVE ) ? ( strcmp( Buffer, ParseStruct->Fields[i].TagString ) != 0 ) : ( stricmp( Buffer, ParseStruct->Fields[i].TagString ) != 0 )); i++ )
 				{}
 
 			if( i < ParseStruct->NumFields )
 				{
-				const parsefield_t	*Field	= &ParseStruct->Fields[i];
-				Field->ParseFunc( Cookie, Field, Field->ParseStruct, Field->Offset < 0 ? NULL : (char*)Object + Field->Offset );
-				ExpectToken( Cookie, TOKEN_CLOSE_PAR );
+				if(( Result = IsWanted( Cookie, &ParseStruct->Fields[i] ) ? ScanField( Cookie, &ParseStruct->Fields[i], Buffer, Scanner, Classify ) : SkipContents( Cookie )) != 0 )
+					return Result;
+				if(( Result = CheckToken( Cookie, TOKEN_CLOSE_PAR )) < 0 )
+					return Result;
 				}
 			else
 				{
-				Warning( Cookie, "Skipping \"%s\"", Buffer );
-				SkipAll( Cookie );
+				RecordSkipped( Cookie, Buffer );
+				if(( Result = SkipContents( Cookie )) != 0 )
+					return Result;
+				if(( Result = CheckToken( Cookie, TOKEN_CLOSE_PAR )) < 0 )
+					return Result;
 				}
 			}
 		UngetToken( Cookie, Token, Buffer );
@@ -521,16 +1130,269 @@ int ParseGeneric( cookie_t *Cookie, const parsefield_t *ParseField, const parses
 	return 0;
 	}
 /*============================================================================*/
-int Error( cookie_t *Cookie, int ErrorCode, const char *Message, ... )
+uint64_t HashBytes( uint64_t Hash, const void *Data, size_t Length )
+	{
+	const uint8_t	*p	= Data;
+
+	while( Length-- > 0 )
+		Hash	= ( Hash ^ *p++ ) * UINT64_C( 1099511628211 );
+
+	return Hash;
+	}
+/*============================================================================*/
+/* The terminator is hashed too, so that consecutive strings cannot be confused, and a missing string is not the same as an empty one. */
+uint64_t HashString( uint64_t Hash, const char *String )
+	{
+	if( String == NULL )
+		return HashBytes( Hash, "\xff", 1 );
+
+	return HashBytes( Hash, String, strlen( String ) + 1 );
+	}
+/*============================================================================*/
+/* The field is the link of a list, returns where the first element of the list is pointed to, or NULL if the list has no head. */
+static void **ListHeadLink( const parsestruct_t *ParseStruct, const parsefield_t *Field, const void *Object )
+	{
+	int	i;
+
+	for( i = 0; i < ParseStruct->NumLists && ParseStruct->Lists[i].OffsetLink != Field->Offset; i++ )
+		{}
+	if( i >= ParseStruct->NumLists )
+		return NULL;
+
+	return (void**)( (char*)Object + ParseStruct->Lists[i].OffsetHead );
+	}
+/*============================================================================*/
+static const void *ListHead( const parsestruct_t *ParseStruct, const parsefield_t *Field, const void *Object )
+	{
+	void	**Link	= ListHeadLink( ParseStruct, Field, Object );
+
+	return Link != NULL ? *Link : NULL;
+	}
+/*============================================================================*/
+static const void *ListNext( const parsefield_t *Field, const void *Item )
+	{
+	return Field->ParseStruct->OffsetNext >= 0 ? *(const void * const *)( (const char*)Item + Field->ParseStruct->OffsetNext ) : NULL;
+	}
+/*============================================================================*/
+static int IsList( const parsefield_t *Field )
+	{
+	return Field->Offset >= 0 && ( Field->Flags & FLAG_LIST ) != 0 && Field->Length > 0 && Field->ParseStruct != NULL;
+	}
+/*============================================================================*/
+static uint64_t HashField( uint64_t Hash, const parsestruct_t *ParseStruct, const parsefield_t *Field, const void *Object, scanclassify_t Classify )
+	{
+	const char	*Argument;
+	const void	*Item;
+	uint64_t	Sum;
+	uint32_t	Count;
+
+	/* Fields that are parsed but not stored. */
+	if( Field->Offset < 0 )
+		return Hash;
+
+	Argument	= (const char*)Object + Field->Offset;
+
+	switch( ClassifyField( Field, Classify ))
+		{
+		case SCAN_SKIP:
+			return Hash;
+		case SCAN_STRUCT:
+			/* The structure is inside its parent. */
+			if( Field->Length == 0 )
+				return HashGeneric( Hash, Field->ParseStruct, Argument, Classify );
+
+			/* A pointer to a single structure. */
+			if(( Field->Flags & FLAG_LIST ) == 0 )
+				{
+				Item	= *(const void * const *)Argument;
+				return Item != NULL ? HashGeneric( Hash, Field->ParseStruct, Item, Classify ) : HashBytes( Hash, "\xff", 1 );
+				}
+
+			if( Field->Flags & FLAG_ORDERED )
+				for( Count = 0, Item = ListHead( ParseStruct, Field, Object ); Item != NULL; Count++, Item = ListNext( Field, Item ))
+					Hash	= HashGeneric( Hash, Field->ParseStruct, Item, Classify );
+			else
+				{
+				/* Adding up the hashes of the elements does not depend on their order and keeps the repeated ones. */
+				for( Count = 0, Sum = 0, Item = ListHead( ParseStruct, Field, Object ); Item != NULL; Count++, Item = ListNext( Field, Item ))
+					Sum	+= HashGeneric( HASH_INITIAL, Field->ParseStruct, Item, Classify );
+				Hash	= HashBytes( Hash, &Sum, sizeof Sum );
+				}
+
+			/* The number of elements separates this list from what comes next. */
+			return HashBytes( Hash, &Count, sizeof Count );
+		case SCAN_STRING:
+		case SCAN_NAME:
+			return HashString( Hash, *(const char * const *)Argument );
+		case SCAN_DIMMENSION:
+			return HashBytes( Hash, Argument, sizeof( pcad_dimmension_t ));
+		case SCAN_REAL:
+			return HashBytes( Hash, Argument, sizeof( pcad_real_t ));
+		/* Everything else is stored as an unsigned. */
+		default:
+			return HashBytes( Hash, Argument, sizeof( pcad_unsigned_t ));
+		}
+	}
+/*============================================================================*/
+uint64_t HashGeneric( uint64_t Hash, const parsestruct_t *ParseStruct, const void *Object, scanclassify_t Classify )
+	{
+	int	i;
+
+	if( ParseStruct->FixedFields != NULL )
+		for( i = 0; i < ParseStruct->NumFixedFields; i++ )
+			Hash	= HashField( Hash, ParseStruct, &ParseStruct->FixedFields[i], Object, Classify );
+
+	if( ParseStruct->Fields != NULL )
+		for( i = 0; i < ParseStruct->NumFields; i++ )
+			Hash	= HashField( Hash, ParseStruct, &ParseStruct->Fields[i], Object, Classify );
+
+	return Hash;
+	}
+/*============================================================================*/
+uint64_t HashHeader( uint64_t Hash, const parsestruct_t *ParseStruct, const void *Object, scanclassify_t Classify )
+	{
+	int	i;
+
+	if( ParseStruct->FixedFields != NULL )
+		for( i = 0; i < ParseStruct->NumFixedFields; i++ )
+			if( !IsList( &ParseStruct->FixedFields[i] ))
+				Hash	= HashField( Hash, ParseStruct, &ParseStruct->FixedFields[i], Object, Classify );
+
+	if( ParseStruct->Fields != NULL )
+		for( i = 0; i < ParseStruct->NumFields; i++ )
+			if( !IsList( &ParseStruct->Fields[i] ))
+				Hash	= HashField( Hash, ParseStruct, &ParseStruct->Fields[i], Object, Classify );
+
+	return Hash;
+	}
+/*============================================================================*/
+static int VisitList( const parsestruct_t *ParseStruct, const parsefield_t *Field, const void *Object, visitor_t Visit, void *UserData )
+	{
+	const void	*Item;
+	int			Result;
+
+	if( !IsList( Field ))
+		return 0;
+
+	for( Item = ListHead( ParseStruct, Field, Object ); Item != NULL; Item = ListNext( Field, Item ))
+		if(( Result = Visit( UserData, Field, Item )) != 0 )
+			return Result;
+
+	return 0;
+	}
+/*============================================================================*/
+int VisitLists( const parsestruct_t *ParseStruct, const void *Object, visitor_t Visit, void *UserData )
+	{
+	int	Result, i;
+
+	if( ParseStruct->FixedFields != NULL )
+		for( i = 0; i < ParseStruct->NumFixedFields; i++ )
+			if(( Result = VisitList( ParseStruct, &ParseStruct->FixedFields[i], Object, Visit, UserData )) != 0 )
+				return Result;
+
+	if( ParseStruct->Fields != NULL )
+		for( i = 0; i < ParseStruct->NumFields; i++ )
+			if(( Result = VisitList( ParseStruct, &ParseStruct->Fields[i], Object, Visit, UserData )) != 0 )
+				return Result;
+
+	return 0;
+	}
+/*============================================================================*/
+void PrependToList( const parsestruct_t *ParseStruct, const parsefield_t *Field, void *Object, void *Item )
+	{
+	void	**Link;
+
+	if( !IsList( Field ) || Field->ParseStruct->OffsetNext < 0 || ( Link = ListHeadLink( ParseStruct, Field, Object )) == NULL )
+		return;
+
+	*(void**)( (char*)Item + Field->ParseStruct->OffsetNext )	= *Link;
+	*Link	= Item;
+	}
+/*============================================================================*/
+static void FilterList( const parsestruct_t *ParseStruct, const parsefield_t *Field, void *Object, int (*Remove)( void *UserData, const void *Item ), void *UserData )
+	{
+	void	**Link;
+
+	if( !IsList( Field ) || Field->ParseStruct->OffsetNext < 0 || ( Link = ListHeadLink( ParseStruct, Field, Object )) == NULL )
+		return;
+
+	while( *Link != NULL )
+		{
+		if( Remove( UserData, *Link ))
+			*Link	= *(void**)( (char*)*Link + Field->ParseStruct->OffsetNext );
+		else
+			Link	= (void**)( (char*)*Link + Field->ParseStruct->OffsetNext );
+		}
+	}
+/*============================================================================*/
+void FilterLists( const parsestruct_t *ParseStruct, void *Object, int (*Remove)( void *UserData, const void *Item ), void *UserData )
+	{
+	int	i;
+
+	if( ParseStruct->FixedFields != NULL )
+		for( i = 0; i < ParseStruct->NumFixedFields; i++ )
+			FilterList( ParseStruct, &ParseStruct->FixedFields[i], Object, Remove, UserData );
+
+	if( ParseStruct->Fields != NULL )
+		for( i = 0; i < ParseStruct->NumFields; i++ )
+			FilterList( ParseStruct, &ParseStruct->Fields[i], Object, Remove, UserData );
+	}
+/*============================================================================*/
+int CopyStruct( const parsestruct_t *ParseStruct, void *Object, const void *Source, size_t Size, int Lists )
+	{
+	void	*Next	= NULL;
+	void	*Heads[MAX_LISTS];
+	int		i;
+
+	if( !Lists && ParseStruct->NumLists > LENGTH( Heads ))
+		return -1;
+
+	if( ParseStruct->OffsetNext >= 0 )
+		Next	= *(void**)( (char*)Object + ParseStruct->OffsetNext );
+	if( !Lists )
+		for( i = 0; i < ParseStruct->NumLists; i++ )
+			Heads[i]	= *(void**)( (char*)Object + ParseStruct->Lists[i].OffsetHead );
+
+	memcpy( Object, Source, Size );
+
+	if( ParseStruct->OffsetNext >= 0 )
+		*(void**)( (char*)Object + ParseStruct->OffsetNext )	= Next;
+	if( !Lists )
+		for( i = 0; i < ParseStruct->NumLists; i++ )
+			*(void**)( (char*)Object + ParseStruct->Lists[i].OffsetHead )	= Heads[i];
+
+	return 0;
+	}
+/*============================================================================*/
+static int VRecordError( cookie_t *Cookie, int ErrorCode, int HasPosition, const char *Message, va_list ap )
+	{
+	Cookie->LastError.Code			= ErrorCode;
+	Cookie->LastError.LineNumber	= HasPosition ? Cookie->LineNumber : 0;
+	Cookie->LastError.Column		= HasPosition ? Cookie->Column : 0;
+	vsnprintf( Cookie->LastError.Message, sizeof Cookie->LastError.Message, Message, ap );
+
+	Diagnose( Cookie, PCADSCH_SEVERITY_ERROR, Cookie->LastError.LineNumber, Cookie->LastError.Column, 1, Message, Cookie->LastError.Message );
+
+	return ErrorCode;
+	}
+/*============================================================================*/
+int RecordError( cookie_t *Cookie, int ErrorCode, const char *Message, ... )
 	{
 	va_list ap;
 
 	va_start( ap, Message );
+	VRecordError( Cookie, ErrorCode, 1, Message, ap );
+	va_end( ap );
 
-	fprintf( stderr, "Error in line %u column %u: ", Cookie->LineNumber, Cookie->Column );
-	vfprintf( stderr, Message, ap );
-	fprintf( stderr, "\n" );
+	return ErrorCode;
+	}
+/*============================================================================*/
+int Error( cookie_t *Cookie, int ErrorCode, const char *Message, ... )
+	{
+	va_list ap;
 
+	va_start( ap, Message );
+	VRecordError( Cookie, ErrorCode, 1, Message, ap );
 	va_end( ap );
 
 	longjmp( Cookie->JumpBuffer, ErrorCode );
@@ -541,11 +1403,7 @@ int ErrorOutput( cookie_t *Cookie, int ErrorCode, const char *Message, ... )
 	va_list ap;
 
 	va_start( ap, Message );
-
-	fprintf( stderr, "Error: " );
-	vfprintf( stderr, Message, ap );
-	fprintf( stderr, "\n" );
-
+	VRecordError( Cookie, ErrorCode, 0, Message, ap );
 	va_end( ap );
 
 	longjmp( Cookie->JumpBuffer, ErrorCode );
@@ -553,31 +1411,218 @@ int ErrorOutput( cookie_t *Cookie, int ErrorCode, const char *Message, ... )
 /*============================================================================*/
 int Warning( const cookie_t *Cookie, const char *Message, ... )
 	{
+	char	Buffer[sizeof Cookie->LastError.Message];
 	va_list ap;
 
 	va_start( ap, Message );
-
-	fprintf( stderr, "Warning in line %u column %u: ", Cookie->LineNumber, Cookie->Column );
-	vfprintf( stderr, Message, ap );
-	fprintf( stderr, "\n" );
-
+	vsnprintf( Buffer, sizeof Buffer, Message, ap );
 	va_end( ap );
 
+	Diagnose( Cookie, PCADSCH_SEVERITY_WARNING, Cookie->LineNumber, Cookie->Column, 1, Message, Buffer );
+
 	return 0;
 	}
 /*============================================================================*/
-int WarningOutput( const char *Message, ... )
+static pcadsch_skipped_t *FindSkipped( pcadsch_stats_t *Stats, const char *Tag )
 	{
-	va_list ap;
+	unsigned	i;
 
-	va_start( ap, Message );
+	for( i = 0; i < Stats->NumSkipped; i++ )
+		if( strcmp( Stats->Skipped[i].Tag, Tag ) == 0 )
+			return &Stats->Skipped[i];
+
+	if( Stats->NumSkipped >= LENGTH( Stats->Skipped ))
+		return NULL;
+
+	return &Stats->Skipped[Stats->NumSkipped++];
+	}
+/*============================================================================*/
+void RecordSkipped( cookie_t *Cookie, const char *Tag )
+	{
+	pcadsch_skipped_t	*Skipped;
+	char				Buffer[sizeof Skipped->Tag];
 
-	fprintf( stderr, "Warning: " );
-	vfprintf( stderr, Message, ap );
-	fprintf( stderr, "\n" );
+	snprintf( Buffer, sizeof Buffer, "%s", Tag );
 
+	if(( Skipped = FindSkipped( &Cookie->Stats, Buffer )) == NULL )
+		{
+		Cookie->Stats.OtherSkipped++;
+		return;
+		}
+
+	if( Skipped->Count++ == 0 )
+		{
+		strcpy( Skipped->Tag, Buffer );
+		Skipped->LineNumber	= Cookie->LineNumber;
+		Skipped->Column		= Cookie->Column;
+		}
+	}
+/*============================================================================*/
+static pcadsch_sorted_t *FindSorted( pcadsch_counters_t *Counters, const char *Collection )
+	{
+	unsigned	i;
+
+	for( i = 0; i < Counters->NumSorted; i++ )
+		if( strcmp( Counters->Sorted[i].Collection, Collection ) == 0 )
+			return &Counters->Sorted[i];
+
+	if( Counters->NumSorted >= LENGTH( Counters->Sorted ))
+		return NULL;
+
+	strcpy( Counters->Sorted[Counters->NumSorted].Collection, Collection );
+	return &Counters->Sorted[Counters->NumSorted++];
+	}
+/*============================================================================*/
+static void MergeCounters( pcadsch_counters_t *Counters, const pcadsch_counters_t *Sheet )
+	{
+	pcadsch_sorted_t	*Sorted;
+	unsigned			i;
+
+	Counters->Enabled			|= Sheet->Enabled;
+	for( i = 0; i < LENGTH( Counters->Finds ); i++ )
+		{
+		Counters->Finds[i].Calls	+= Sheet->Finds[i].Calls;
+		Counters->Finds[i].Probes	+= Sheet->Finds[i].Probes;
+		}
+	Counters->CompareNames		+= Sheet->CompareNames;
+	Counters->UngetTokens		+= Sheet->UngetTokens;
+	Counters->SkipAlls			+= Sheet->SkipAlls;
+	Counters->BytesSkipped		+= Sheet->BytesSkipped;
+	Counters->OtherComparisons	+= Sheet->OtherComparisons;
+
+	for( i = 0; i < Sheet->NumSorted; i++ )
+		{
+		if(( Sorted = FindSorted( Counters, Sheet->Sorted[i].Collection )) == NULL )
+			Counters->OtherComparisons	+= Sheet->Sorted[i].Comparisons;
+		else
+			{
+			Sorted->Sorts		+= Sheet->Sorted[i].Sorts;
+			Sorted->Elements	+= Sheet->Sorted[i].Elements;
+			Sorted->Comparisons	+= Sheet->Sorted[i].Comparisons;
+			}
+		}
+	}
+/*============================================================================*/
+#if			defined PCADSCH_COUNTERS
+/*============================================================================*/
+static _Thread_local int		(*SortCompare)( const void *a, const void *b );
+static _Thread_local uint64_t	SortComparisons;
+/*============================================================================*/
+static int CountComparison( const void *a, const void *b )
+	{
+	SortComparisons++;
+	return SortCompare( a, b );
+	}
+/*============================================================================*/
+void SortCounted( const char *Collection, void *Base, size_t Num, size_t Size, int (*Compare)( const void *a, const void *b ))
+	{
+	pcadsch_sorted_t	*Sorted;
+	char				Name[sizeof Sorted->Collection];
+	const char			*Field, *p;
+
+	SortCompare		= Compare;
+	SortComparisons	= 0;
+	qsort( Base, Num, Size, CountComparison );
+
+	if( CurrentCounters == NULL )
+		return;
+
+	/* "Sheet->viowires" is counted as "Sheet->wires". */
+	for( Field = p = Collection; *p != '\0'; p++ )
+		if( *p == '>' || *p == '.' )
+			Field	= p + 1;
+	if( strncmp( Field, "vio", 3 ) == 0 )
+		snprintf( Name, sizeof Name, "%.*s%s", (int)( Field - Collection ), Collection, Field + 3 );
+	else
+		snprintf( Name, sizeof Name, "%s", Collection );
+
+	if(( Sorted = FindSorted( CurrentCounters, Name )) == NULL )
+		{
+		CurrentCounters->OtherComparisons	+= SortComparisons;
+		return;
+		}
+
+	Sorted->Sorts++;
+	Sorted->Elements	+= Num;
+	Sorted->Comparisons	+= SortComparisons;
+	}
+/*============================================================================*/
+#endif	/*	defined PCADSCH_COUNTERS */
+/*============================================================================*/
+void MergeStats( pcadsch_stats_t *Stats, const pcadsch_stats_t *Sheet )
+	{
+	pcadsch_skipped_t	*Skipped;
+	unsigned long		Count;
+	unsigned			i;
+
+	for( i = 0; i < LENGTH( Stats->Tokens ); i++ )
+		Stats->Tokens[i]	+= Sheet->Tokens[i];
+
+	MergeCounters( &Stats->Counters, &Sheet->Counters );
+
+	Stats->HeapSize		+= Sheet->HeapSize;
+	Stats->HeapUsed		+= Sheet->HeapUsed;
+	Stats->HeapBlocks	+= Sheet->HeapBlocks;
+	Stats->StringBytes	+= Sheet->StringBytes;
+	Stats->OtherSkipped	+= Sheet->OtherSkipped;
+
+	for( i = 0; i < Sheet->NumSkipped; i++ )
+		{
+		if(( Skipped = FindSkipped( Stats, Sheet->Skipped[i].Tag )) == NULL )
+			Stats->OtherSkipped	+= Sheet->Skipped[i].Count;
+		/* The first one found is the one nearest the start of the file. */
+		else if( Skipped->Count == 0 || Sheet->Skipped[i].LineNumber < Skipped->LineNumber )
+			{
+			Count			 = Skipped->Count;
+			*Skipped		 = Sheet->Skipped[i];
+			Skipped->Count	+= Count;
+			}
+		else
+			Skipped->Count	+= Sheet->Skipped[i].Count;
+		}
+	}
+/*============================================================================*/
+static int CompareSkipped( const void *a, const void *b )
+	{
+	const pcadsch_skipped_t	*pa	= a;
+	const pcadsch_skipped_t	*pb	= b;
+
+	if( pa->LineNumber != pb->LineNumber )
+		return pa->LineNumber < pb->LineNumber ? -1 : 1;
+
+	return pa->Column < pb->Column ? -1 : pa->Column > pb->Column;
+	}
+/*============================================================================*/
+/* In the order they first appear in the file, the sheets parsed in parallel find them in any order. */
+void ReportSkipped( cookie_t *Cookie )
+	{
+	static const char		Template[]	= "Skipping \"%.*s\"";
+	const pcadsch_skipped_t	*Skipped;
+	char					Buffer[sizeof Skipped->Tag + sizeof Template];
+
+	qsort( Cookie->Stats.Skipped, Cookie->Stats.NumSkipped, sizeof( pcadsch_skipped_t ), CompareSkipped );
+
+	for( Skipped = Cookie->Stats.Skipped; Skipped < Cookie->Stats.Skipped + Cookie->Stats.NumSkipped; Skipped++ )
+		{
+		snprintf( Buffer, sizeof Buffer, Template, (int)sizeof Skipped->Tag, Skipped->Tag );
+		Diagnose( Cookie, PCADSCH_SEVERITY_WARNING, Skipped->LineNumber, Skipped->Column, Skipped->Count, Template, Buffer );
+		}
+
+	if( Cookie->Stats.OtherSkipped > 0 )
+		WarningOutput( Cookie, "Skipping %lu more elements of other kinds", Cookie->Stats.OtherSkipped );
+	}
+/*============================================================================*/
+int WarningOutput( const cookie_t *Cookie, const char *Message, ... )
+	{
+	char	Buffer[sizeof Cookie->LastError.Message];
+	va_list ap;
+
+	va_start( ap, Message );
+	vsnprintf( Buffer, sizeof Buffer, Message, ap );
 	va_end( ap );
 
+	Diagnose( Cookie, PCADSCH_SEVERITY_WARNING, 0, 0, 1, Message, Buffer );
+
 	return 0;
 	}
 /*============================================================================*/
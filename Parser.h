@@ -39,6 +39,14 @@
 #define FLAG_CASESENSITIVE	2
 #define	FLAG_LIST			4
 #define	FLAG_OPTIONAL		8
+/* A list kept in the order of the file, the other lists are sorted when processed. */
+#define	FLAG_ORDERED		256
+/* The section a field belongs to, see "Cookie->Sections". */
+#define	FLAG_LIBRARY		SECTION_LIBRARY
+#define	FLAG_NETLIST		SECTION_NETLIST
+#define	FLAG_SHEETS			SECTION_SHEETS
+#define	FLAG_SETTINGS		SECTION_SETTINGS
+#define	FLAG_SECTIONS		SECTION_ALL
 /*============================================================================*/
 typedef struct parsefield_tag		parsefield_t;
 typedef struct parsestruct_tag		parsestruct_t;
@@ -50,6 +58,9 @@ typedef struct listhead_tag
 	size_t							OffsetHead;
 	size_t							OffsetLink;
 	} listhead_t;
+/*----------------------------------------------------------------------------*/
+/* The most lists a structure may have for "CopyStruct" to keep them. */
+#define	MAX_LISTS		32
 /*===========================================================================*/
 typedef struct parsefield_tag
 	{
@@ -73,7 +84,91 @@ typedef struct parsestruct_tag
 	const ssize_t					OffsetNext;
 	} parsestruct_t;
 /*============================================================================*/
-void				*Allocate			( cookie_t *Cookie, size_t Size );
+/*
+Event-driven scanning: the same tables drive the parser, but instead of building
+the structures it reports each structure and each field value to the callbacks.
+A callback returning non-zero stops the scan and its value is returned.
+*/
+/*----------------------------------------------------------------------------*/
+typedef enum
+	{
+	SCAN_SKIP,
+	SCAN_STRUCT,
+	SCAN_STRING,
+	SCAN_NAME,
+	SCAN_UNSIGNED,
+	SCAN_SIGNED,
+	SCAN_REAL,
+	SCAN_DIMMENSION,
+	SCAN_BOOLEAN,
+	SCAN_ENUM
+	} scankind_t;
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	scankind_t						Kind;
+	/* For SCAN_STRING and SCAN_NAME, valid only during the callback. */
+	const char						*String;
+	/* For all the other kinds. */
+	int64_t							Number;
+	} scanvalue_t;
+/*----------------------------------------------------------------------------*/
+typedef scankind_t (*scanclassify_t)( parsefunc_t ParseFunc );
+/*----------------------------------------------------------------------------*/
+typedef struct scanner_tag
+	{
+	int								(*BeginStruct)	( void *UserData, const parsefield_t *Field, const char *Tag );
+	int								(*FieldValue)	( void *UserData, const parsefield_t *Field, const char *Tag, const scanvalue_t *Value );
+	int								(*EndStruct)	( void *UserData, const parsefield_t *Field, const char *Tag );
+	void							*UserData;
+	} scanner_t;
+/*============================================================================*/
+/*
+Fingerprints: the same tables walk the parsed structures and fold every value
+into a 64-bit FNV-1a hash, so equal contents give equal fingerprints wherever
+they are in the heap. The lists that get sorted are hashed as sets, so that
+only those with FLAG_ORDERED depend on the order they were parsed in.
+*/
+/*----------------------------------------------------------------------------*/
+#define	HASH_INITIAL					UINT64_C( 14695981039346656037 )
+/*============================================================================*/
+/*
+The heap profile counts the allocations by kind and site, see
+PCADSchGetHeapProfile. The sites are kept in a hash table keyed by the contents
+of the strings, so the same tag in different tables counts as one. The strings
+must live as long as the profile.
+*/
+#define	MAX_HEAP_SITES					1024
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	const char						*Kind;
+	const char						*Site;
+	uint64_t						Count;
+	uint64_t						Bytes;
+	} heapsite_t;
+/*----------------------------------------------------------------------------*/
+typedef struct heapprofile_tag
+	{
+	unsigned						NumSites;
+	heapsite_t						Sites[MAX_HEAP_SITES];
+	/* What did not fit in the table. */
+	uint64_t						OtherCount;
+	uint64_t						OtherBytes;
+	} heapprofile_t;
+/*============================================================================*/
+/* Reports the elements of the lists of a structure, one by one, in the order they were parsed. */
+typedef int (*visitor_t)( void *UserData, const parsefield_t *Field, const void *Item );
+/*============================================================================*/
+void				*AllocateTagged		( cookie_t *Cookie, size_t Size, const char *Kind, const char *Site );
+/* For the heap profile the allocations are told apart by the kind named by the caller and the function making them. */
+#define	Allocate( Cookie, Size, Kind )	AllocateTagged( Cookie, Size, Kind, __func__ )
+void				ReleaseHeap			( struct heapblock_tag **Blocks );
+
+void				RecordAllocation	( heapprofile_t *Profile, const char *Kind, const char *Site, size_t Size );
+void				MergeHeapProfile	( heapprofile_t *Profile, const heapprofile_t *Sheet );
+/* Copies up to "Max" sites, the largest first, and returns how many there are or a negative value on error. */
+int					ListHeapProfile		( const heapprofile_t *Profile, pcadsch_heapsite_t *Sites, int Max );
 
 pcad_unsigned_t		GetUnsigned			( cookie_t *Cookie );
 int					GetName				( cookie_t *Cookie, char *Buffer, size_t BufferLength );
@@ -94,13 +189,46 @@ int					ParseName			( cookie_t *Cookie, const parsefield_t *ParseField, const pa
 int					ParseString			( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument );
 int					ParseGeneric		( cookie_t *Cookie, const parsefield_t *ParseField, const parsestruct_t *ParseStruct, void *Argument );
 
+int					ScanGeneric			( cookie_t *Cookie, const parsestruct_t *ParseStruct, const scanner_t *Scanner, scanclassify_t Classify );
+
+uint64_t			HashBytes			( uint64_t Hash, const void *Data, size_t Length );
+uint64_t			HashString			( uint64_t Hash, const char *String );
+/* "Classify" tells how the special cases store their values. */
+uint64_t			HashGeneric			( uint64_t Hash, const parsestruct_t *ParseStruct, const void *Object, scanclassify_t Classify );
+/* The same, leaving out the lists of the structure itself. */
+uint64_t			HashHeader			( uint64_t Hash, const parsestruct_t *ParseStruct, const void *Object, scanclassify_t Classify );
+
+/* A "Visit" returning non-zero stops the walk and its value is returned. */
+int					VisitLists			( const parsestruct_t *ParseStruct, const void *Object, visitor_t Visit, void *UserData );
+/* The order of the lists does not matter once they are sorted, so new elements go at their start. */
+void				PrependToList		( const parsestruct_t *ParseStruct, const parsefield_t *Field, void *Object, void *Item );
+/* Unlinks the elements for which "Remove" returns non-zero from all the lists of "Object". */
+void				FilterLists			( const parsestruct_t *ParseStruct, void *Object, int (*Remove)( void *UserData, const void *Item ), void *UserData );
+/*
+Copies "Size" bytes of "Source" over "Object", keeping the link to the next
+element and, if "Lists" is zero, the lists of "Object". Returns non-zero, with
+nothing copied, if the structure has more than MAX_LISTS lists.
+*/
+int					CopyStruct			( const parsestruct_t *ParseStruct, void *Object, const void *Source, size_t Size, int Lists );
+
+/* Skipped elements are counted by tag and reported once per tag, at the end. */
+void				RecordSkipped		( cookie_t *Cookie, const char *Tag );
+void				ReportSkipped		( cookie_t *Cookie );
+/* Adds the statistics of a sheet parsed apart to those of the whole file. */
+void				MergeStats			( pcadsch_stats_t *Stats, const pcadsch_stats_t *Sheet );
+#if			defined PCADSCH_COUNTERS
+/* A "qsort" counting the comparisons made sorting "Collection". */
+void				SortCounted			( const char *Collection, void *Base, size_t Num, size_t Size, int (*Compare)( const void *a, const void *b ));
+#endif	/*	defined PCADSCH_COUNTERS */
+
 pcad_enum_units_t	TranslateUnits		( cookie_t *Cookie, const char *Buffer );
 pcad_dimmension_t	ProcessDimmension	( cookie_t *Cookie, const char *Buffer, pcad_enum_units_t Unit );
 /*============================================================================*/
+int __attribute__((format(printf, 3, 4)))			RecordError		( cookie_t *Cookie, int ErrorCode, const char *Message, ... );
 int __attribute__((format(printf, 3, 4),noreturn))	Error			( cookie_t *Cookie, int ErrorCode, const char *Message, ... );
 int __attribute__((format(printf, 3, 4),noreturn))	ErrorOutput		( cookie_t *Cookie, int ErrorCode, const char *Message, ... );
 int __attribute__((format(printf, 2, 3)))			Warning			( const cookie_t *Cookie, const char *Message, ... );
-int __attribute__((format(printf, 1, 2)))			WarningOutput	( const char *Message, ... );
+int __attribute__((format(printf, 2, 3)))			WarningOutput	( const cookie_t *Cookie, const char *Message, ... );
 /*============================================================================*/
 #endif	/*	!defined __PARSER2_H__ */
 /*============================================================================*/
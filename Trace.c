@@ -0,0 +1,244 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#if			defined __linux__
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#endif	/*	defined __linux__ */
+#include "Trace.h"
+#include "OutputFile.h"
+/*============================================================================*/
+typedef struct
+	{
+	const char			*Category;
+	char				Name[64];
+	double				Start;
+	double				End;
+	long				Thread;
+	} tracespan_t;
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	long				Thread;
+	char				Name[32];
+	} tracethread_t;
+/*----------------------------------------------------------------------------*/
+/* The sheet workers, the lexer and the thread that called the library. */
+#define	MAX_TRACE_THREADS	80
+/*----------------------------------------------------------------------------*/
+struct trace_tag
+	{
+#if			defined __linux__
+	/* Guards the spans and the thread names, the sheet workers and the lexer thread end their spans while the caller ends its own. */
+	pthread_mutex_t		Mutex;
+#endif	/*	defined __linux__ */
+	double				Origin;
+	size_t				NumSpans;
+	size_t				Allocated;
+	tracespan_t			*Spans;
+	unsigned			NumThreads;
+	tracethread_t		Threads[MAX_TRACE_THREADS];
+	};
+/*============================================================================*/
+static double Clock( void )
+	{
+	struct timespec	Time;
+
+#if			defined __linux__
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+#else	/*	defined __linux__ */
+	timespec_get( &Time, TIME_UTC );
+#endif	/*	defined __linux__ */
+
+	return Time.tv_sec + Time.tv_nsec / 1.0e9;
+	}
+/*============================================================================*/
+/* The system's own ids, so the timeline can be matched with "perf" and the like. */
+static long ThreadId( void )
+	{
+#if			defined __linux__
+	return syscall( SYS_gettid );
+#else	/*	defined __linux__ */
+	return 1;
+#endif	/*	defined __linux__ */
+	}
+/*============================================================================*/
+static void Lock( trace_t *Trace )
+	{
+#if			defined __linux__
+	pthread_mutex_lock( &Trace->Mutex );
+#endif	/*	defined __linux__ */
+	}
+/*============================================================================*/
+static void Unlock( trace_t *Trace )
+	{
+#if			defined __linux__
+	pthread_mutex_unlock( &Trace->Mutex );
+#endif	/*	defined __linux__ */
+	}
+/*============================================================================*/
+trace_t *CreateTrace( void )
+	{
+	trace_t	*Trace;
+
+	if(( Trace = calloc( 1, sizeof( trace_t ))) == NULL )
+		return NULL;
+
+#if			defined __linux__
+	pthread_mutex_init( &Trace->Mutex, NULL );
+#endif	/*	defined __linux__ */
+	Trace->Origin	= Clock();
+
+	return Trace;
+	}
+/*============================================================================*/
+void ReleaseTrace( trace_t *Trace )
+	{
+	if( Trace == NULL )
+		return;
+
+#if			defined __linux__
+	pthread_mutex_destroy( &Trace->Mutex );
+#endif	/*	defined __linux__ */
+	free( Trace->Spans );
+	free( Trace );
+	}
+/*============================================================================*/
+void ResetTrace( trace_t *Trace )
+	{
+	Lock( Trace );
+	Trace->NumSpans		= 0;
+	Trace->NumThreads	= 0;
+	Trace->Origin		= Clock();
+	Unlock( Trace );
+	}
+/*============================================================================*/
+double TraceStart( const cookie_t *Cookie )
+	{
+	return Cookie->Trace != NULL ? Clock() : 0;
+	}
+/*============================================================================*/
+/* A span that cannot be kept for lack of memory is just left out. */
+void TraceSpan( const cookie_t *Cookie, double Start, const char *Category, const char *Format, ... )
+	{
+	trace_t		*Trace	= Cookie->Trace;
+	tracespan_t	*Span;
+	size_t		Allocated;
+	double		End;
+	va_list		ap;
+
+	if( Trace == NULL )
+		return;
+
+	End	= Clock();
+
+	Lock( Trace );
+
+	if( Trace->NumSpans >= Trace->Allocated )
+		{
+		Allocated	= Trace->Allocated > 0 ? 2 * Trace->Allocated : 1024;
+		if(( Span = realloc( Trace->Spans, Allocated * sizeof( tracespan_t ))) == NULL )
+			{
+			Unlock( Trace );
+			return;
+			}
+		Trace->Spans		= Span;
+		Trace->Allocated	= Allocated;
+		}
+
+	Span			= &Trace->Spans[Trace->NumSpans++];
+	Span->Category	= Category;
+	Span->Start		= Start;
+	Span->End		= End;
+	Span->Thread	= ThreadId();
+
+	va_start( ap, Format );
+	vsnprintf( Span->Name, sizeof Span->Name, Format, ap );
+	va_end( ap );
+
+	Unlock( Trace );
+	}
+/*============================================================================*/
+void TraceThread( const cookie_t *Cookie, const char *Name )
+	{
+	trace_t			*Trace	= Cookie->Trace;
+	tracethread_t	*Thread;
+
+	if( Trace == NULL )
+		return;
+
+	Lock( Trace );
+
+	if( Trace->NumThreads < MAX_TRACE_THREADS )
+		{
+		Thread			= &Trace->Threads[Trace->NumThreads++];
+		Thread->Thread	= ThreadId();
+		strncpy( Thread->Name, Name, sizeof Thread->Name );
+		Thread->Name[sizeof Thread->Name - 1]	= '\0';
+		}
+
+	Unlock( Trace );
+	}
+/*============================================================================*/
+/* The times of the events are in microseconds from the start of the parse. */
+int WriteTrace( const trace_t *Trace, FILE *File )
+	{
+	const tracespan_t	*Span;
+	const char			*Separator	= "";
+	size_t				i;
+#if			defined __linux__
+	long				Process		= getpid();
+#else	/*	defined __linux__ */
+	long				Process		= 1;
+#endif	/*	defined __linux__ */
+
+	fprintf( File, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+	for( i = 0; i < Trace->NumThreads; i++, Separator = "," )
+		{
+		fprintf( File, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":", Separator, Process, Trace->Threads[i].Thread );
+		WriteJSONString( File, Trace->Threads[i].Name );
+		fprintf( File, "}}" );
+		}
+
+	for( i = 0; i < Trace->NumSpans; i++, Separator = "," )
+		{
+		Span	= &Trace->Spans[i];
+		fprintf( File, "%s\n{\"name\":", Separator );
+		WriteJSONString( File, Span->Name );
+		fprintf( File, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld}", Span->Category, ( Span->Start - Trace->Origin ) * 1.0e6, ( Span->End - Span->Start ) * 1.0e6, Process, Span->Thread );
+		}
+
+	fprintf( File, "\n]}\n" );
+
+	return ferror( File ) ? -1 : 0;
+	}
+/*============================================================================*/
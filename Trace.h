@@ -0,0 +1,53 @@
+/*============================================================================*/
+/*
+ Copyright (c) 2024, Isaac Marino Bavaresco
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+	 * Redistributions of source code must retain the above copyright
+	   notice, this list of conditions and the following disclaimer.
+	 * Neither the name of the author nor the
+	   names of its contributors may be used to endorse or promote products
+	   derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY
+ EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*============================================================================*/
+#if			!defined __TRACE_H__
+#define __TRACE_H__
+/*============================================================================*/
+#include <stdio.h>
+#include "PCADParser.h"
+/*============================================================================*/
+/*
+A timeline of the conversion, made of the spans of time each thread spent in
+each part of it. It is written as Chrome trace events, to be loaded in Perfetto
+or in "chrome://tracing". Nothing is recorded while "Cookie->Trace" is NULL.
+*/
+typedef struct trace_tag	trace_t;
+/*============================================================================*/
+trace_t	*CreateTrace	( void );
+void	ReleaseTrace	( trace_t *Trace );
+/* Forgets the spans recorded so far, the times are counted from now on. */
+void	ResetTrace		( trace_t *Trace );
+
+/* Returns the time a span starts, to be given to "TraceSpan" when it ends. */
+double	TraceStart		( const cookie_t *Cookie );
+void __attribute__((format(printf, 4, 5)))	TraceSpan	( const cookie_t *Cookie, double Start, const char *Category, const char *Format, ... );
+/* Names the calling thread in the timeline. */
+void	TraceThread		( const cookie_t *Cookie, const char *Name );
+
+int		WriteTrace		( const trace_t *Trace, FILE *File );
+/*============================================================================*/
+#endif	/*	!defined __TRACE_H__ */
+/*============================================================================*/
@@ -27,100 +27,189 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
-#include "Parser.h"
-#include "PCADOutputSchematic.h"
-#include "KiCADOutputSchematic.h"
+#include <stddef.h>
+#include <time.h>
+#if			defined __linux__
+#include <unistd.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#endif	/*	defined __linux__ */
+#if			!defined __linux__
+#include <io.h>
+#include <fcntl.h>
+#endif	/*	!defined __linux__ */
+#include "PCADSch.h"
+#include "Daemon.h"
+
+#ifdef __GNUC__
+#define stricmp strcasecmp
+#endif
+/*============================================================================*/
+#define	OUTPUTFORMAT_INVALID	0
+#define	OUTPUTFORMAT_KICAD		1
+#define	OUTPUTFORMAT_PCAD		2
+/*============================================================================*/
+#define	OPTION_PIPELINE			1
+#define	OPTION_WATCH			2
+#define	OPTION_DIFF				4
+#define	OPTION_MERGE			8
+#define	OPTION_STATS			16
+#define	OPTION_STATS_JSON		32
+#define	OPTION_TRACE			64
+#define	OPTION_HEAPPROFILE		128
+#define	OPTION_DIAGNOSTICS_JSON	256
+/*============================================================================*/
+static const char KiCADExtension[]	= ".kicad_sch";
+static const char PCADExtension[]	= ".sch";
+//static const char BackUpExtension[]	= ".cvt_bak";
+/*============================================================================*/
+/*
+With "-" as the output name the P-CAD file goes straight to the standard output.
+The KiCAD sheets are more than one file, so they go as the members of a tar
+archive, named as the files would be.
+*/
+typedef struct
+	{
+	FILE				*Stream;
+	const char			*Prefix;
+	char				Name[100];
+	pcadsch_buffer_t	Buffer;
+	} tarwriter_t;
+/*----------------------------------------------------------------------------*/
+static const unsigned char	Zeros[1024];
+/*============================================================================*/
+static void SetBinaryMode( FILE *Stream )
+	{
+#if			!defined __linux__
+	_setmode( _fileno( Stream ), _O_BINARY );
+#endif	/*	!defined __linux__ */
+	}
+/*============================================================================*/
+static int WriteStream( void *UserData, const void *Data, size_t Length )
+	{
+	return fwrite( Data, 1, Length, (FILE*)UserData ) != Length ? -1 : 0;
+	}
 /*============================================================================*/
-void SplitPath( const char *pFullPath, char *pPath, char *pName, char *pExt )
+static int BeginTarMember( void *UserData, const char *Name )
 	{
-	char	FullPath[256], *p, *q;
+	tarwriter_t	*Tar	= UserData;
+	int			Length;
 
-	strncpy( FullPath, pFullPath, sizeof FullPath );
-	FullPath[sizeof FullPath - 1]	= '\0';
+	Length	= snprintf( Tar->Name, sizeof Tar->Name, "%s%s%s", Tar->Prefix, Name, KiCADExtension );
+	if( Length < 0 || Length >= sizeof Tar->Name )
+		return -1;
+
+	Tar->Buffer.Length	= 0;
+
+	return 0;
+	}
+/*============================================================================*/
+static int WriteTarMember( void *UserData, const void *Data, size_t Length )
+	{
+	tarwriter_t	*Tar	= UserData;
+
+	return PCADSchBufferWrite( &Tar->Buffer, Data, Length );
+	}
+/*============================================================================*/
+/* The size of the member goes in its header, so the whole sheet is buffered until here. */
+static int EndTarMember( void *UserData )
+	{
+	tarwriter_t		*Tar	= UserData;
+	unsigned char	Header[512];
+	unsigned		Checksum, i;
+	size_t			Padding;
+
+	memset( Header, 0, sizeof Header );
+	strcpy( (char*)&Header[0], Tar->Name );
+	strcpy( (char*)&Header[100], "0000644" );
+	strcpy( (char*)&Header[108], "0000000" );
+	strcpy( (char*)&Header[116], "0000000" );
+	sprintf( (char*)&Header[124], "%011llo", (unsigned long long)Tar->Buffer.Length );
+	sprintf( (char*)&Header[136], "%011llo", (unsigned long long)time( NULL ));
+	memset( &Header[148], ' ', 8 );
+	Header[156]	= '0';
+	memcpy( &Header[257], "ustar", 6 );
+	memcpy( &Header[263], "00", 2 );
+
+	/* The checksum is computed with its own field filled with spaces. */
+	for( Checksum = 0, i = 0; i < sizeof Header; i++ )
+		Checksum	+= Header[i];
+	sprintf( (char*)&Header[148], "%06o", Checksum );
+
+	Padding	= -Tar->Buffer.Length & ( sizeof Header - 1 );
+
+	if( fwrite( Header, 1, sizeof Header, Tar->Stream ) != sizeof Header || fwrite( Tar->Buffer.Data, 1, Tar->Buffer.Length, Tar->Stream ) != Tar->Buffer.Length || fwrite( Zeros, 1, Padding, Tar->Stream ) != Padding )
+		return -1;
 
-	if(( p = strrchr( FullPath, '\\' )) != NULL )
+	return 0;
+	}
+/*============================================================================*/
+static int OutputToStream( pcadsch_t *Context, FILE *Stream, const char *pNameIn, int OutputFormat )
+	{
+	pcadsch_writer_t	Writer;
+	tarwriter_t			Tar;
+	char				Prefix[256], Ext[256], *p;
+	int					Result;
+
+	SetBinaryMode( Stream );
+
+	if( OutputFormat == OUTPUTFORMAT_PCAD )
 		{
-		*p++	= '\0';
-		if( pPath != NULL )
-			{
-			strcpy( pPath, FullPath );
-			strcat( pPath, "\\" );
-			}
+		Writer.Begin		= NULL;
+		Writer.Write		= WriteStream;
+		Writer.End			= NULL;
+		Writer.UserData		= Stream;
+
+		Result	= PCADSchEmitPCAD( Context, &Writer );
 		}
-	else if(( p = strrchr( FullPath, ':' )) != NULL )
+	else
 		{
-		*p++	= '\0';
-		if( pPath != NULL )
+		strcpy( Prefix, "" );
+		if( pNameIn != NULL )
 			{
-			strcpy( pPath, FullPath );
-			strcat( pPath, ":" );
+			SplitPath( pNameIn, NULL, Prefix, Ext );
+			/* The members cannot carry the path, "SplitPath" leaves the '/' in it. */
+			if(( p = strrchr( Prefix, '/' )) != NULL )
+				memmove( Prefix, p + 1, strlen( p ));
+			strcat( Prefix, "-" );
 			}
-		}
-	else
-		{
-		p		= FullPath;
-		if( pPath != NULL )
-			strcpy( pPath, "" );
+
+		Tar.Stream			= Stream;
+		Tar.Prefix			= Prefix;
+		memset( &Tar.Buffer, 0, sizeof Tar.Buffer );
+
+		Writer.Begin		= BeginTarMember;
+		Writer.Write		= WriteTarMember;
+		Writer.End			= EndTarMember;
+		Writer.UserData		= &Tar;
+
+		/* The archive ends with two empty records. */
+		if(( Result = PCADSchEmitKiCAD( Context, &Writer )) == 0 && fwrite( Zeros, 1, sizeof Zeros, Stream ) != sizeof Zeros )
+			Result	= -1;
+
+		free( Tar.Buffer.Data );
 		}
 
-	if(( q = strrchr( p, '.' )) != NULL )
+	if( fflush( Stream ) != 0 && Result == 0 )
 		{
-		if( pExt != NULL )
-			strcpy( pExt, q );
-		*q		= '\0';
+		fprintf( stderr, "Error: Could not write the output\n" );
+		Result	= -1;
 		}
-	else
-		strcpy( pExt, "" );
 
-	if( pName != NULL )
-		strcpy( pName, p );
+	return Result;
 	}
 /*============================================================================*/
-#define	OUTPUTFORMAT_INVALID	0
-#define	OUTPUTFORMAT_KICAD		1
-#define	OUTPUTFORMAT_PCAD		2
-/*============================================================================*/
-static const char KiCADExtension[]	= ".kicad_sch";
-static const char PCADExtension[]	= ".sch";
-//static const char BackUpExtension[]	= ".cvt_bak";
-/*============================================================================*/
-static int Process( FILE *f, const char *pNameIn, const char *pNameOut, int OutputFormat )
+static int Process( pcadsch_t *Context, FILE *f, const char *pNameIn, const char *pNameOut, int OutputFormat )
 	{
-	pcad_schematicfile_t	*s;
-	char					NameIn[256], ExtIn[256], PathOut[256], NameOut[256], ExtOut[256] /*, PathBkp[256]*/;
-	cookie_t				Cookie;
-	size_t					size;
-	uint8_t					*heap;
-
-	fseek( f, 0, SEEK_END );
-	size					= sizeof( void* ) * ftell( f );
-	fseek( f, 0, SEEK_SET );
-
-	heap					= malloc( size );
-	if( heap == NULL )
-		{
-		printf( "\nError: Not enough memory.\n\n" );
-		return -1;
-		}
+	char		NameIn[256], ExtIn[256], PathOut[256], NameOut[256], ExtOut[256] /*, PathBkp[256]*/;
+	int			Result;
 
-	Cookie.File				= f;
-	Cookie.LineNumber		= 1;
-	Cookie.Column			= 1;
-	Cookie.TabSize			= 4;
-	Cookie.HeapSize			= size;
-	Cookie.HeapTop			= 0;
-	Cookie.Heap				= heap;
-	Cookie.FileUnits		= PCAD_UNITS_MIL;
-	Cookie.UngettedToken	= TOKEN_NONE;
-	Cookie.UngetBuffer[0]	= '\0';
-	Cookie.Sort				= 1;
-
-	if( setjmp( Cookie.JumpBuffer ) != 0 )
+	if( PCADSchParseFile( Context, f ) != 0 )
 		return -1;
 
-	memset( heap, 0x00, size );
-
-	s	= ParsePCAD( &Cookie, pNameIn, pNameOut );
+	if( pNameOut != NULL && strcmp( pNameOut, "-" ) == 0 )
+		return OutputToStream( Context, stdout, strcmp( pNameIn, "-" ) != 0 ? pNameIn : NULL, OutputFormat );
 
 	SplitPath( pNameIn, NULL, NameIn, ExtIn );
 
@@ -149,7 +238,10 @@ static int Process( FILE *f, const char *pNameIn, const char *pNameOut, int Outp
 			int len = strlen( pNameOut );
 			strcpy( Temp, &pNameOut[1] );
 			if( len >= 3 && Temp[len-2] != '\'' )
-				Error( &Cookie, -1, "Invalid File Name %s", pNameOut );
+				{
+				fprintf( stderr, "Error: Invalid File Name %s\n", pNameOut );
+				return -1;
+				}
 			Temp[len-2]	= '\0';
 			}
 
@@ -190,15 +282,590 @@ static int Process( FILE *f, const char *pNameIn, const char *pNameOut, int Outp
 */
 
 	if( OutputFormat == OUTPUTFORMAT_PCAD )
-		OutputPCAD( &Cookie, s, PathOut );
+		Result	= PCADSchWritePCAD( Context, PathOut );
 	else
-		OutputKiCAD( &Cookie, s, PathOut );
+		Result	= PCADSchWriteKiCAD( Context, PathOut );
+
+	return Result;
+	}
+/*============================================================================*/
+/*
+"--stats" reports to the standard error what the conversion went through: the
+time of each phase, the bytes read and written, the tokens by kind, how much of
+the heap set aside for the input was used, and the elements of each sheet.
+"--stats=json" reports the same as a JSON object.
+*/
+typedef struct
+	{
+	const char			*Name;
+	size_t				Offset;
+	} census_t;
+/*----------------------------------------------------------------------------*/
+static const census_t	SheetCensus[]	=
+	{
+	{ "wires",			offsetof( pcad_sheet_t, numwires )				},
+	{ "buses",			offsetof( pcad_sheet_t, numbuses )				},
+	{ "busentries",		offsetof( pcad_sheet_t, numbusentries )			},
+	{ "junctions",		offsetof( pcad_sheet_t, numjunctions )			},
+	{ "symbols",		offsetof( pcad_sheet_t, numsymbols )			},
+	{ "pins",			offsetof( pcad_sheet_t, numpins )				},
+	{ "ports",			offsetof( pcad_sheet_t, numports )				},
+	{ "texts",			offsetof( pcad_sheet_t, numtexts )				},
+	{ "lines",			offsetof( pcad_sheet_t, numlines )				},
+	{ "polys",			offsetof( pcad_sheet_t, numpolys )				},
+	{ "arcs",			offsetof( pcad_sheet_t, numtriplepointarcs )	},
+	{ "ieeesymbols",	offsetof( pcad_sheet_t, numieeesymbols )		},
+	{ "attrs",			offsetof( pcad_sheet_t, numattrs )				},
+	{ "fields",			offsetof( pcad_sheet_t, numfields )				},
+	{ "refpoints",		offsetof( pcad_sheet_t, numrefpoints )			}
+	};
+/*----------------------------------------------------------------------------*/
+static const char		*TokenNames[PCADSCH_NUM_TOKENS]	=
+	{
+	[PCADSCH_TOKEN_CLOSE_PAR]	= "close_par",
+	[PCADSCH_TOKEN_OPEN_PAR]	= "open_par",
+	[PCADSCH_TOKEN_NAME]		= "name",
+	[PCADSCH_TOKEN_STRING]		= "string",
+	[PCADSCH_TOKEN_UNSIGNED]	= "unsigned",
+	[PCADSCH_TOKEN_INTEGER]		= "integer",
+	[PCADSCH_TOKEN_FLOAT]		= "float"
+	};
+/*----------------------------------------------------------------------------*/
+static const char		*FindNames[PCADSCH_NUM_FINDS]	=
+	{
+	[PCADSCH_FIND_BUSENTRY]						= "FindBusEntry",
+	[PCADSCH_FIND_PIN]							= "FindPin",
+	[PCADSCH_FIND_COMPDEF]						= "FindCompDef",
+	[PCADSCH_FIND_SYMBOLDEF]					= "FindSymbolDef",
+	[PCADSCH_FIND_SYMBOLDEF_BY_ORIGINAL_NAME]	= "FindSymbolDefByOriginalName",
+	[PCADSCH_FIND_ATTR_IN_NETLIST]				= "FindAttrInNetList",
+	[PCADSCH_FIND_ATTR]							= "FindAttr",
+	[PCADSCH_FIND_COMPINST]						= "FindCompInst",
+	[PCADSCH_FIND_PREVIOUS]						= "FindPrevious"
+	};
+/*============================================================================*/
+static void PrintJSONString( const char *s )
+	{
+	fputc( '"', stderr );
+	for( ; *s != '\0'; s++ )
+		if( *s == '"' || *s == '\\' )
+			fprintf( stderr, "\\%c", *s );
+		else if( (unsigned char)*s < 0x20 )
+			fprintf( stderr, "\\u%04x", *s );
+		else
+			fputc( *s, stderr );
+	fputc( '"', stderr );
+	}
+/*============================================================================*/
+static void PrintStatsJSON( const pcadsch_stats_t *Stats, const pcad_schematicfile_t *Schematic )
+	{
+	const pcadsch_counters_t	*Counters	= &Stats->Counters;
+	const pcad_sheet_t			*Sheet;
+	size_t						i, j;
+
+	fprintf( stderr, "{\n  \"seconds\": { \"parse\": %.6f, \"process\": %.6f, \"output\": %.6f },\n", Stats->ParseSeconds, Stats->ProcessSeconds, Stats->OutputSeconds );
+	fprintf( stderr, "  \"bytes_read\": %llu,\n  \"bytes_written\": %llu,\n  \"tokens\": {", (unsigned long long)Stats->BytesRead, (unsigned long long)Stats->BytesWritten );
+	for( i = 0; i < PCADSCH_NUM_TOKENS; i++ )
+		fprintf( stderr, "%s \"%s\": %llu", i > 0 ? "," : "", TokenNames[i], (unsigned long long)Stats->Tokens[i] );
+	fprintf( stderr, " },\n  \"heap\": { \"size\": %llu, \"used\": %llu, \"more_blocks\": %u, \"strings\": %llu },\n", (unsigned long long)Stats->HeapSize, (unsigned long long)Stats->HeapUsed, Stats->HeapBlocks, (unsigned long long)Stats->StringBytes );
+	fprintf( stderr, "  \"library\": { \"symbols\": %zu, \"components\": %zu },\n", Schematic->library.numsymboldefs, Schematic->library.numcompdefs );
+	fprintf( stderr, "  \"netlist\": { \"components\": %zu, \"nets\": %zu },\n  \"sheets\": [", Schematic->netlist.numcompinsts, Schematic->netlist.numnets );
+	for( i = 0; i < Schematic->schematicdesign.numsheets; i++ )
+		{
+		Sheet	= Schematic->schematicdesign.viosheets[i];
+		fprintf( stderr, "%s\n    { \"name\": ", i > 0 ? "," : "" );
+		PrintJSONString( Sheet->name != NULL ? Sheet->name : "" );
+		for( j = 0; j < LENGTH( SheetCensus ); j++ )
+			fprintf( stderr, ", \"%s\": %zu", SheetCensus[j].Name, *(const size_t*)( (const char*)Sheet + SheetCensus[j].Offset ));
+		fprintf( stderr, " }" );
+		}
+	fprintf( stderr, "\n  ],\n  \"skipped\": {" );
+	for( i = 0; i < Stats->NumSkipped; i++ )
+		{
+		fprintf( stderr, "%s ", i > 0 ? "," : "" );
+		PrintJSONString( Stats->Skipped[i].Tag );
+		fprintf( stderr, ": %lu", Stats->Skipped[i].Count );
+		}
+	fprintf( stderr, " },\n  \"other_skipped\": %lu", Stats->OtherSkipped );
+
+	/* Only in the builds that count them. */
+	if( Counters->Enabled )
+		{
+		fprintf( stderr, ",\n  \"counters\": {\n    \"finds\": {" );
+		for( i = 0; i < PCADSCH_NUM_FINDS; i++ )
+			fprintf( stderr, "%s \"%s\": { \"calls\": %llu, \"probes\": %llu }", i > 0 ? "," : "", FindNames[i], (unsigned long long)Counters->Finds[i].Calls, (unsigned long long)Counters->Finds[i].Probes );
+		fprintf( stderr, " },\n    \"compare_names\": %llu,\n    \"unget_tokens\": %llu,\n    \"skip_alls\": %llu,\n    \"bytes_skipped\": %llu,\n    \"sorted\": {", (unsigned long long)Counters->CompareNames, (unsigned long long)Counters->UngetTokens, (unsigned long long)Counters->SkipAlls, (unsigned long long)Counters->BytesSkipped );
+		for( i = 0; i < Counters->NumSorted; i++ )
+			{
+			fprintf( stderr, "%s\n      ", i > 0 ? "," : "" );
+			PrintJSONString( Counters->Sorted[i].Collection );
+			fprintf( stderr, ": { \"sorts\": %llu, \"elements\": %llu, \"comparisons\": %llu }", (unsigned long long)Counters->Sorted[i].Sorts, (unsigned long long)Counters->Sorted[i].Elements, (unsigned long long)Counters->Sorted[i].Comparisons );
+			}
+		fprintf( stderr, "\n    },\n    \"other_comparisons\": %llu\n  }", (unsigned long long)Counters->OtherComparisons );
+		}
+
+	fprintf( stderr, "\n}\n" );
+	}
+/*============================================================================*/
+static void PrintStats( pcadsch_t *Context, int Json )
+	{
+	const pcad_schematicfile_t	*Schematic;
+	const pcad_sheet_t			*Sheet;
+	pcadsch_stats_t				Stats;
+	const pcadsch_counters_t	*Counters	= &Stats.Counters;
+	unsigned long long			Tokens;
+	size_t						i, j;
+
+	if(( Schematic = PCADSchGetSchematic( Context )) == NULL || PCADSchGetStats( Context, &Stats ) != 0 )
+		return;
+
+	if( Json )
+		{
+		PrintStatsJSON( &Stats, Schematic );
+		return;
+		}
+
+	for( Tokens = 0, i = 0; i < PCADSCH_NUM_TOKENS; i++ )
+		Tokens	+= Stats.Tokens[i];
+
+	fprintf( stderr, "Parse:     %.3f s\nProcess:   %.3f s\nOutput:    %.3f s\n", Stats.ParseSeconds, Stats.ProcessSeconds, Stats.OutputSeconds );
+	fprintf( stderr, "Read:      %llu bytes\nWritten:   %llu bytes\n", (unsigned long long)Stats.BytesRead, (unsigned long long)Stats.BytesWritten );
+	fprintf( stderr, "Tokens:    %llu", Tokens );
+	for( i = 0; i < PCADSCH_NUM_TOKENS; i++ )
+		fprintf( stderr, "%s %llu %s", i > 0 ? "," : ":", (unsigned long long)Stats.Tokens[i], TokenNames[i] );
+	fprintf( stderr, "\nHeap:      %llu of %llu bytes used (%.1f%%), %u more blocks, %llu bytes of strings\n", (unsigned long long)Stats.HeapUsed, (unsigned long long)Stats.HeapSize, Stats.HeapSize > 0 ? 100.0 * Stats.HeapUsed / Stats.HeapSize : 0.0, Stats.HeapBlocks, (unsigned long long)Stats.StringBytes );
+	fprintf( stderr, "Library:   %zu symbols, %zu components\n", Schematic->library.numsymboldefs, Schematic->library.numcompdefs );
+	fprintf( stderr, "Netlist:   %zu components, %zu nets\n", Schematic->netlist.numcompinsts, Schematic->netlist.numnets );
+	for( i = 0; i < Schematic->schematicdesign.numsheets; i++ )
+		{
+		Sheet	= Schematic->schematicdesign.viosheets[i];
+		fprintf( stderr, "Sheet \"%s\":", Sheet->name != NULL ? Sheet->name : "" );
+		for( j = 0; j < LENGTH( SheetCensus ); j++ )
+			fprintf( stderr, "%s %zu %s", j > 0 ? "," : "", *(const size_t*)( (const char*)Sheet + SheetCensus[j].Offset ), SheetCensus[j].Name );
+		fprintf( stderr, "\n" );
+		}
+
+	/* Only in the builds that count them. */
+	if( !Counters->Enabled )
+		return;
+
+	for( i = 0; i < PCADSCH_NUM_FINDS; i++ )
+		if( Counters->Finds[i].Calls > 0 )
+			fprintf( stderr, "%-27s %llu calls, %llu probes (%.1f per call)\n", FindNames[i], (unsigned long long)Counters->Finds[i].Calls, (unsigned long long)Counters->Finds[i].Probes, (double)Counters->Finds[i].Probes / Counters->Finds[i].Calls );
+	fprintf( stderr, "Calls:     %llu CompareNames, %llu UngetToken, %llu SkipAll, %llu bytes skipped\n", (unsigned long long)Counters->CompareNames, (unsigned long long)Counters->UngetTokens, (unsigned long long)Counters->SkipAlls, (unsigned long long)Counters->BytesSkipped );
+	for( i = 0; i < Counters->NumSorted; i++ )
+		fprintf( stderr, "Sorted \"%s\": %llu times, %llu elements, %llu comparisons\n", Counters->Sorted[i].Collection, (unsigned long long)Counters->Sorted[i].Sorts, (unsigned long long)Counters->Sorted[i].Elements, (unsigned long long)Counters->Sorted[i].Comparisons );
+	if( Counters->OtherComparisons > 0 )
+		fprintf( stderr, "Sorted others: %llu comparisons\n", (unsigned long long)Counters->OtherComparisons );
+	}
+/*============================================================================*/
+/* "--heap-profile" lists to the standard error what takes the heap of the schematic, the largest first. */
+static void PrintHeapProfile( pcadsch_t *Context )
+	{
+	pcadsch_heapsite_t	*Sites;
+	unsigned long long	Bytes = 0, Count = 0;
+	int					NumSites, i;
+
+	if(( NumSites = PCADSchGetHeapProfile( Context, NULL, 0 )) < 0 || ( Sites = malloc(( NumSites + 1 ) * sizeof( pcadsch_heapsite_t ))) == NULL )
+		return;
+
+	NumSites	= PCADSchGetHeapProfile( Context, Sites, NumSites );
+
+	for( i = 0; i < NumSites; i++ )
+		{
+		Bytes	+= Sites[i].Bytes;
+		Count	+= Sites[i].Count;
+		}
+
+	fprintf( stderr, "Heap: %llu bytes in %llu allocations\n%12s %6s %10s  %-30s %s\n", Bytes, Count, "Bytes", "%", "Count", "Kind", "Site" );
+	for( i = 0; i < NumSites; i++ )
+		fprintf( stderr, "%12llu %6.2f %10llu  %-30s %s\n", (unsigned long long)Sites[i].Bytes, Bytes > 0 ? 100.0 * Sites[i].Bytes / Bytes : 0.0, (unsigned long long)Sites[i].Count, Sites[i].Kind, Sites[i].Site );
+
+	free( Sites );
+	}
+/*============================================================================*/
+static int SaveTrace( pcadsch_t *Context, const char *Path )
+	{
+	FILE	*File;
+	int		Result;
+
+	if(( File = fopen( Path, "w" )) == NULL )
+		{
+		fprintf( stderr, "Error: Could not create \"%s\"\n", Path );
+		return -1;
+		}
+
+	Result	= PCADSchWriteTrace( Context, File );
+
+	if( fclose( File ) != 0 || Result != 0 )
+		{
+		fprintf( stderr, "Error: Could not write \"%s\"\n", Path );
+		return -1;
+		}
+
+	return 0;
+	}
+/*============================================================================*/
+/* The daemon passes the context of the worker serving the request in "Shared", kept for its next requests. */
+static void ReleaseContext( pcadsch_t *Context, pcadsch_t *Shared )
+	{
+	if( Context != Shared )
+		PCADSchDestroy( Context );
+	}
+/*============================================================================*/
+static pcadsch_t *CreateContext( int Options, pcadsch_t *Shared )
+	{
+	pcadsch_t	*Context	= Shared;
+
+	if( Context == NULL && ( Context = PCADSchCreate()) == NULL )
+		{
+		printf( "\nError: Not enough memory.\n\n" );
+		return NULL;
+		}
+
+	PCADSchSetOption( Context, PCADSCH_OPTION_PIPELINE, ( Options & OPTION_PIPELINE ) != 0 );
+	PCADSchSetOption( Context, PCADSCH_OPTION_DIAGNOSTICS, Options & OPTION_DIAGNOSTICS_JSON ? PCADSCH_DIAGNOSTICS_JSON : PCADSCH_DIAGNOSTICS_TEXT );
+	if( PCADSchSetOption( Context, PCADSCH_OPTION_TRACE, ( Options & OPTION_TRACE ) != 0 ) != 0 || PCADSchSetOption( Context, PCADSCH_OPTION_HEAPPROFILE, ( Options & OPTION_HEAPPROFILE ) != 0 ) != 0 )
+		{
+		ReleaseContext( Context, Shared );
+		printf( "\nError: Not enough memory.\n\n" );
+		return NULL;
+		}
+
+	return Context;
+	}
+/*============================================================================*/
+static int PrintDifference( void *UserData, pcadsch_change_t Change, const char *Container, const char *Kind, const char *Name )
+	{
+	static const char	Signs[]	= { [PCADSCH_ADDED] = '+', [PCADSCH_REMOVED] = '-', [PCADSCH_CHANGED] = '~' };
+
+	printf( "%c %s%s%s%s%s\n", Signs[Change], Container != NULL ? Container : "", Container != NULL ? ": " : "", Kind, Name[0] != '\0' ? " " : "", Name );
+
+	return 0;
+	}
+/*============================================================================*/
+/* Like "diff", the result is zero if the schematics are the same and one if they are different. */
+static int Diff( int Options, pcadsch_t *Shared, const char *PathOld, const char *PathNew )
+	{
+	pcadsch_t	*Old, *New;
+	int			Result;
 
-	free( heap );
+	if(( Old = CreateContext( Options, Shared )) == NULL )
+		return -1;
+
+	if(( New = CreateContext( Options, NULL )) == NULL )
+		{
+		ReleaseContext( Old, Shared );
+		return -1;
+		}
+
+	if( PCADSchParse( Old, PathOld ) != 0 || PCADSchParse( New, PathNew ) != 0 )
+		Result	= -1;
+	else if(( Result = PCADSchDiff( Old, New, PrintDifference, NULL )) > 0 )
+		Result	= 1;
+
+	if( fflush( stdout ) != 0 && Result >= 0 )
+		{
+		fprintf( stderr, "Error: Could not write the output\n" );
+		Result	= -1;
+		}
+
+	ReleaseContext( New, NULL );
+	ReleaseContext( Old, Shared );
+
+	return Result;
+	}
+/*============================================================================*/
+static int PrintConflict( void *UserData, pcadsch_change_t Ours, pcadsch_change_t Theirs, const char *Container, const char *Kind, const char *Name )
+	{
+	static const char	*Changes[]	= { [PCADSCH_ADDED] = "added", [PCADSCH_REMOVED] = "removed", [PCADSCH_CHANGED] = "changed" };
+
+	fprintf( stderr, "Conflict: %s%s%s%s%s, %s in ours and %s in theirs, kept ours.\n", Container != NULL ? Container : "", Container != NULL ? ": " : "", Kind, Name[0] != '\0' ? " " : "", Name, Changes[Ours], Changes[Theirs] );
 
 	return 0;
 	}
 /*============================================================================*/
+/*
+Usable as a git merge driver, "PCADSch2KiCAD --merge %O %A %B": the result goes
+to "PathOurs" unless "PathOut" is given. It is written even when there are
+conflicts, with those elements as in "PathOurs", but then the result is one.
+The result is parsed again before it replaces anything, if it does not parse
+nothing is written. It is written to a temporary file next to "PathOut" that is
+renamed over it, so an interrupted merge never leaves %A half written.
+*/
+static int Merge( int Options, pcadsch_t *Shared, const char *PathBase, const char *PathOurs, const char *PathTheirs, const char *PathOut )
+	{
+	pcadsch_t			*Contexts[3]	= { NULL, NULL, NULL }, *Check = NULL;
+	pcadsch_buffer_t	Merged			= { NULL, 0, 0 };
+	pcadsch_writer_t	Writer			= { NULL, PCADSchBufferWrite, NULL, &Merged };
+	FILE				*f				= NULL;
+	char				TmpPath[512+sizeof ".cvt_tmp"];
+	int					Result, i;
+
+	for( i = 0; i < 3; i++ )
+		if(( Contexts[i] = CreateContext( Options, i == 1 ? Shared : NULL )) == NULL )
+			break;
+
+	if( i < 3 || PCADSchParse( Contexts[0], PathBase ) != 0 || PCADSchParse( Contexts[1], PathOurs ) != 0 || PCADSchParse( Contexts[2], PathTheirs ) != 0 )
+		Result	= -1;
+	else if(( Result = PCADSchMerge( Contexts[0], Contexts[1], Contexts[2], PrintConflict, NULL )) < 0 || PCADSchEmitPCAD( Contexts[1], &Writer ) != 0 )
+		Result	= -1;
+	else if(( Check = CreateContext( Options, NULL )) == NULL || PCADSchParseBuffer( Check, Merged.Data, Merged.Length ) != 0 )
+		{
+		fprintf( stderr, "Error: The merged schematic does not parse again, nothing was written.\n" );
+		Result	= -1;
+		}
+	else
+		{
+		if( PathOut == NULL )
+			PathOut	= PathOurs;
+
+		if( strcmp( PathOut, "-" ) == 0 )
+			{
+			f	= stdout;
+			SetBinaryMode( f );
+			}
+		else if( snprintf( TmpPath, sizeof TmpPath, "%s.cvt_tmp", PathOut ) >= (int)sizeof TmpPath || ( f = fopen( TmpPath, "wb" )) == NULL )
+			{
+			fprintf( stderr, "Error creating file \"%s\".\n", PathOut );
+			Result	= -1;
+			}
+
+		if( Result >= 0 && fwrite( Merged.Data, 1, Merged.Length, f ) != Merged.Length )
+			Result	= -1;
+		else if( Result > 0 )
+			Result	= 1;
+
+		if( f != NULL && f != stdout )
+			{
+			/* Where "rename" does not replace an existing file it is removed first. */
+			if( fclose( f ) != 0 || Result < 0 || ( rename( TmpPath, PathOut ) != 0 && ( remove( PathOut ), rename( TmpPath, PathOut )) != 0 ))
+				{
+				fprintf( stderr, "Error writing file \"%s\".\n", PathOut );
+				remove( TmpPath );
+				Result	= -1;
+				}
+			}
+		}
+
+	if( Check != NULL )
+		ReleaseContext( Check, NULL );
+	free( Merged.Data );
+
+	for( i = 0; i < 3; i++ )
+		if( Contexts[i] != NULL )
+			ReleaseContext( Contexts[i], i == 1 ? Shared : NULL );
+
+	return Result;
+	}
+/*============================================================================*/
+#if			defined __linux__
+/*============================================================================*/
+/*
+Watch mode: the directories holding the files given, or the directories given,
+are watched and each schematic is converted again when it changes, always with
+the same context. P-CAD writes the file in several bursts when saving, so it is
+only converted after it stays quiet for WATCH_DEBOUNCE_MS.
+*/
+#define	WATCH_DEBOUNCE_MS		50
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	int					wd;
+	/* The directory, ending in '/'. */
+	char				Directory[256];
+	/* The only file of interest, or NULL for all the schematics in the directory. */
+	const char			*File;
+	} watch_t;
+/*----------------------------------------------------------------------------*/
+typedef struct
+	{
+	char				Path[512];
+	int64_t				Deadline;
+	} pending_t;
+/*============================================================================*/
+static int64_t Milliseconds( void )
+	{
+	struct timespec	Now;
+
+	clock_gettime( CLOCK_MONOTONIC, &Now );
+
+	return (int64_t)Now.tv_sec * 1000 + Now.tv_nsec / 1000000;
+	}
+/*============================================================================*/
+/* Our own P-CAD output ("<name>.sort.sch") must not trigger a new conversion. */
+static int IsSchematic( const char *Name )
+	{
+	size_t	Length	= strlen( Name );
+
+	if( Length < 4 || stricmp( &Name[Length-4], PCADExtension ) != 0 )
+		return 0;
+
+	return Length < 9 || stricmp( &Name[Length-9], ".sort.sch" ) != 0;
+	}
+/*============================================================================*/
+static void ConvertFile( pcadsch_t *Context, const char *Path, int OutputFormat )
+	{
+	FILE	*f;
+	int64_t	Start	= Milliseconds();
+	int		Result;
+
+	if(( f = fopen( Path, "rb" )) == NULL )
+		{
+		fprintf( stderr, "Error opening file \"%s\".\n", Path );
+		return;
+		}
+
+	Result	= Process( Context, f, Path, NULL, OutputFormat );
+
+	fclose( f );
+
+	if( Result == 0 )
+		fprintf( stderr, "Converted \"%s\" in %lld ms.\n", Path, (long long)( Milliseconds() - Start ));
+	}
+/*============================================================================*/
+static int Watch( pcadsch_t *Context, int NumPaths, char *Paths[], int OutputFormat )
+	{
+	/* Aligned for the "struct inotify_event" records. */
+	char				Buffer[4096] __attribute__((aligned( __alignof__( struct inotify_event ))));
+	const struct inotify_event	*Event;
+	struct stat			Status;
+	struct pollfd		Poll;
+	watch_t				*Watches;
+	pending_t			*Pending	= NULL, *p;
+	size_t				NumPending	= 0, AllocatedPending = 0;
+	int64_t				Now, Timeout;
+	ssize_t				Length;
+	char				Path[512], *Slash;
+	size_t				j;
+	int					Fd, i;
+
+	if(( Fd = inotify_init1( IN_CLOEXEC )) < 0 )
+		{
+		fprintf( stderr, "\nError: Could not start watching the files.\n\n" );
+		return -1;
+		}
+
+	if(( Watches = calloc( NumPaths, sizeof( watch_t ))) == NULL )
+		{
+		printf( "\nError: Not enough memory.\n\n" );
+		close( Fd );
+		return -1;
+		}
+
+	for( i = 0; i < NumPaths; i++ )
+		{
+		if( stat( Paths[i], &Status ) != 0 || strlen( Paths[i] ) >= sizeof Watches[i].Directory - 2 )
+			{
+			fprintf( stderr, "\nError opening \"%s\".\n\n", Paths[i] );
+			free( Watches );
+			close( Fd );
+			return -1;
+			}
+
+		if( S_ISDIR( Status.st_mode ))
+			{
+			strcpy( Watches[i].Directory, Paths[i] );
+			if( Watches[i].Directory[strlen( Watches[i].Directory ) - 1] != '/' )
+				strcat( Watches[i].Directory, "/" );
+			Watches[i].File	= NULL;
+			}
+		else
+			{
+			if(( Slash = strrchr( Paths[i], '/' )) != NULL )
+				{
+				memcpy( Watches[i].Directory, Paths[i], Slash + 1 - Paths[i] );
+				Watches[i].Directory[Slash + 1 - Paths[i]]	= '\0';
+				Watches[i].File	= Slash + 1;
+				}
+			else
+				{
+				strcpy( Watches[i].Directory, "./" );
+				Watches[i].File	= Paths[i];
+				}
+			ConvertFile( Context, Paths[i], OutputFormat );
+			}
+
+		/* The directory is watched because saving may replace the file instead of rewriting it. */
+		if(( Watches[i].wd = inotify_add_watch( Fd, Watches[i].Directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_MODIFY )) < 0 )
+			{
+			fprintf( stderr, "\nError watching \"%s\".\n\n", Watches[i].Directory );
+			free( Watches );
+			close( Fd );
+			return -1;
+			}
+		}
+
+	Poll.fd		= Fd;
+	Poll.events	= POLLIN;
+
+	while( 1 )
+		{
+		Now		= Milliseconds();
+		Timeout	= -1;
+		for( p = Pending; p < Pending + NumPending; p++ )
+			if( Timeout < 0 || p->Deadline - Now < Timeout )
+				Timeout	= p->Deadline > Now ? p->Deadline - Now : 0;
+
+		if( poll( &Poll, 1, (int)Timeout ) > 0 && ( Length = read( Fd, Buffer, sizeof Buffer )) > 0 )
+			{
+			Now	= Milliseconds();
+
+			for( Event = (const struct inotify_event*)Buffer; (char*)Event < Buffer + Length; Event = (const struct inotify_event*)( (char*)Event + sizeof( struct inotify_event ) + Event->len ))
+				{
+				if( Event->len == 0 )
+					continue;
+
+				for( i = 0; i < NumPaths; i++ )
+					{
+					if( Watches[i].wd != Event->wd || ( Watches[i].File != NULL ? strcmp( Watches[i].File, Event->name ) != 0 : !IsSchematic( Event->name )))
+						continue;
+
+					snprintf( Path, sizeof Path, "%s%s", strcmp( Watches[i].Directory, "./" ) != 0 ? Watches[i].Directory : "", Event->name );
+
+					/* Each new event postpones the conversion. */
+					for( p = Pending; p < Pending + NumPending && strcmp( p->Path, Path ) != 0; p++ )
+						;
+					if( p == Pending + NumPending )
+						{
+						if( NumPending >= AllocatedPending )
+							{
+							AllocatedPending	= AllocatedPending == 0 ? 16 : 2 * AllocatedPending;
+							if(( p = realloc( Pending, AllocatedPending * sizeof( pending_t ))) == NULL )
+								{
+								printf( "\nError: Not enough memory.\n\n" );
+								free( Pending );
+								free( Watches );
+								close( Fd );
+								return -1;
+								}
+							Pending	= p;
+							}
+						p	= &Pending[NumPending++];
+						strcpy( p->Path, Path );
+						}
+					p->Deadline	= Now + WATCH_DEBOUNCE_MS;
+					break;
+					}
+				}
+			}
+
+		Now	= Milliseconds();
+		for( j = 0; j < NumPending; )
+			{
+			if( Pending[j].Deadline > Now )
+				{
+				j++;
+				continue;
+				}
+			ConvertFile( Context, Pending[j].Path, OutputFormat );
+			Pending[j]	= Pending[--NumPending];
+			}
+		}
+	}
+/*============================================================================*/
+#endif	/*	defined __linux__ */
+/*============================================================================*/
 static void PrintUsage( int OutputFormat )
 	{
 #if			defined __linux__
@@ -211,9 +878,42 @@ static void PrintUsage( int OutputFormat )
 		"Copyright(c) 2024-2026, Isaac Marino Bavaresco\n"
 		__DATE__ " " __TIME__ "\n\n"
 		"%2$s.\n\n"
-		"Usage: %1$s [--kicadout|--pcadout] [<pathin>]<filenamein>[.<extin>] [<pathout>][<filenameout|*>[.<extout|*>]]\n\n"
+		"Usage: %1$s [--kicadout|--pcadout] [--pipeline] [--stats[=json]] [--heap-profile] [--trace <trace>] [--diagnostics=json] [<pathin>]<filenamein>[.<extin>] [<pathout>][<filenameout|*>[.<extout|*>]]\n"
+#if			defined __linux__
+		"       %1$s --watch [--kicadout|--pcadout] [--pipeline] <file|directory>...\n"
+		"       %1$s --daemon\n"
+		"       %1$s --local <arguments>\n"
+#endif	/*	defined __linux__ */
+		"       %1$s --diff <old> <new>\n"
+		"       %1$s --merge <base> <ours> <theirs> [<output>]\n"
+		"\n"
 		"\"--pcadout\"	forces the output file to be in P-CAD format.\n"
 		"\"--kicadout\" forces the output file to be in KiCAD format.\n"
+		"\"--stats\"	reports to the standard error the time of each phase, the bytes read and written,\n"
+		"			the tokens by kind, the use of the heap and the elements of each sheet. With\n"
+		"			\"--stats=json\" the report is a JSON object.\n"
+		"\"--heap-profile\" lists to the standard error the bytes and the number of the allocations in the\n"
+		"			heap of the schematic, by kind of element and by the site that allocated them.\n"
+		"\"--trace\"	writes to <trace> a timeline of the conversion, in the Chrome trace event format\n"
+		"			read by Perfetto (ui.perfetto.dev) and \"chrome://tracing\".\n"
+		"\"--diagnostics=json\" writes the warnings and errors to the standard error as one JSON object\n"
+		"			per line, with their line, column, message and count.\n"
+		"\"--diff\"	compares two schematics element by element and lists the elements added (+),\n"
+		"			removed (-) and changed (~), whatever their order in the files. The exit code is\n"
+		"			0 if there are no differences and 1 if there are.\n"
+		"\"--merge\"	merges into <ours> (or into <output>) the changes from <base> to <theirs>, element\n"
+		"			by element, and writes the result as sorted P-CAD. The elements changed in different\n"
+		"			ways on both sides are kept as in <ours> and listed, then the exit code is 1. As a\n"
+		"			git merge driver: \"driver = PCADSch2KiCAD --merge %%O %%A %%B\".\n"
+#if			defined __linux__
+		"\"--pipeline\"	runs the lexical analysis in a separate thread, feeding the parser.\n"
+		"\"--watch\"	takes any number of files or directories and converts each schematic again when\n"
+		"			it changes, until interrupted.\n"
+		"\"--daemon\"	serves the conversions requested by other instances of the program through the\n"
+		"			socket in $PCADSCH_SOCKET, $XDG_RUNTIME_DIR/PCADSch2KiCAD.socket or\n"
+		"			/tmp/PCADSch2KiCAD-<uid>.socket. While it runs the other instances only forward\n"
+		"			their arguments to it, unless \"--local\" is given.\n"
+#endif	/*	defined __linux__ */
 #if			!defined __linux__
 		"If the executable file name is \"PCADSch2KiCAD.exe\", the default output format is KiCAD.\n"
 		"If it is \"PCADSchSort.exe\", the default output format is P-CAD.\n\n"
@@ -223,7 +923,13 @@ static void PrintUsage( int OutputFormat )
 		"If <filenameout> is omitted or it is \'*\', the program will use <filenamein>. If <extout> is\n"
 		"%3$s.\n"
 		"If any \'*\' is used, the entire output name and extension must be enclosed in \' (single quotes)\n"
-		"to prevent the C startup code to expand the \'*\' into a file name list.\n\n",
+		"to prevent the C startup code to expand the \'*\' into a file name list.\n\n"
+		"If <filenamein> is \"-\", the schematic is read from the standard input and, if no output is given,\n"
+		"the output goes to the standard output.\n"
+		"If the output is \"-\", it goes to the standard output. KiCAD sheets go as the members of a tar archive.\n\n"
+		"The KiCAD sheets whose contents did not change since they were last converted are not written\n"
+		"again, their fingerprints are kept in \"<filenameout>.<extout>.cvt_manifest\". An output file whose\n"
+		"contents would be the same is not replaced, it keeps its time stamps.\n\n",
 
 		OutputFormat == OUTPUTFORMAT_KICAD ? "PCADSch2KiCAD" : "PCADSchSort",
 		OutputFormat == OUTPUTFORMAT_KICAD ? "Converts a P-CAD 2006 ASCII schematic file to KiCAD v8.0 format" : "Reads a P-CAD 2006 ASCII schematic file and outputs it with all the fields sorted\nin order to help with version control",
@@ -235,21 +941,45 @@ static void PrintUsage( int OutputFormat )
 /* Black magic, necessary so C runtime won't expand the '*' in the command-line arguments.	*/
 int	_CRT_glob	= 0;
 /*============================================================================*/
-int main( int ArgC, char *ArgV[] )
+static int Run( int ArgC, char *ArgV[], pcadsch_t *Shared )
 	{
-	char	PathIn[256];
-	FILE	*f;
-	int		Result, OutputFormat	= OUTPUTFORMAT_INVALID, FirstArg	= 1;
+	pcadsch_t	*Context;
+	char		PathIn[256];
+	const char	*PathTrace	= NULL;
+	FILE		*f;
+	int			Result, OutputFormat	= OUTPUTFORMAT_INVALID, FirstArg, Options = 0;
 
-	if( ArgC > 1 )
+	for( FirstArg = 1; FirstArg < ArgC && strncmp( ArgV[FirstArg], "--", 2 ) == 0; FirstArg++ )
 		{
-		FirstArg	= 2;
-		if( stricmp( ArgV[1], "--kicadout" ) == 0 )
+		if( stricmp( ArgV[FirstArg], "--kicadout" ) == 0 )
 			OutputFormat	= OUTPUTFORMAT_KICAD;
-		else if( stricmp( ArgV[1], "--pcadout" ) == 0 )
+		else if( stricmp( ArgV[FirstArg], "--pcadout" ) == 0 )
 			OutputFormat	= OUTPUTFORMAT_PCAD;
+#if			defined __linux__
+		else if( stricmp( ArgV[FirstArg], "--pipeline" ) == 0 )
+			Options			|= OPTION_PIPELINE;
+		else if( stricmp( ArgV[FirstArg], "--watch" ) == 0 )
+			Options			|= OPTION_WATCH;
+#endif	/*	defined __linux__ */
+		else if( stricmp( ArgV[FirstArg], "--diff" ) == 0 )
+			Options			|= OPTION_DIFF;
+		else if( stricmp( ArgV[FirstArg], "--merge" ) == 0 )
+			Options			|= OPTION_MERGE;
+		else if( stricmp( ArgV[FirstArg], "--stats" ) == 0 )
+			Options			|= OPTION_STATS;
+		else if( stricmp( ArgV[FirstArg], "--stats=json" ) == 0 )
+			Options			|= OPTION_STATS | OPTION_STATS_JSON;
+		else if( stricmp( ArgV[FirstArg], "--diagnostics=json" ) == 0 )
+			Options			|= OPTION_DIAGNOSTICS_JSON;
+		else if( stricmp( ArgV[FirstArg], "--heap-profile" ) == 0 )
+			Options			|= OPTION_HEAPPROFILE;
+		else if( stricmp( ArgV[FirstArg], "--trace" ) == 0 && FirstArg + 1 < ArgC )
+			{
+			Options			|= OPTION_TRACE;
+			PathTrace		 = ArgV[++FirstArg];
+			}
 		else
-			FirstArg	= 1;
+			break;
 		}
 
 	if( OutputFormat == OUTPUTFORMAT_INVALID )
@@ -270,7 +1000,24 @@ int main( int ArgC, char *ArgV[] )
 		}
 #endif	/*	defined __linux__ */
 
-	if( ArgC - FirstArg < 1 || ArgC - FirstArg > 2 )
+#if			defined __linux__
+	if(( Options & OPTION_WATCH ) && ArgC - FirstArg >= 1 )
+		{
+		if(( Context = CreateContext( Options, Shared )) == NULL )
+			return -1;
+		Result	= Watch( Context, ArgC - FirstArg, &ArgV[FirstArg], OutputFormat );
+		ReleaseContext( Context, Shared );
+		return Result;
+		}
+#endif	/*	defined __linux__ */
+
+	if(( Options & OPTION_DIFF ) && ArgC - FirstArg == 2 )
+		return Diff( Options, Shared, ArgV[FirstArg], ArgV[FirstArg+1] );
+
+	if(( Options & OPTION_MERGE ) && ( ArgC - FirstArg == 3 || ArgC - FirstArg == 4 ))
+		return Merge( Options, Shared, ArgV[FirstArg], ArgV[FirstArg+1], ArgV[FirstArg+2], ArgC - FirstArg == 4 ? ArgV[FirstArg+3] : NULL );
+
+	if( ArgC - FirstArg < 1 || ArgC - FirstArg > 2 || ( Options & ( OPTION_DIFF | OPTION_MERGE )))
 		{
 		PrintUsage( OutputFormat );
 		if( ArgC != 1 )
@@ -280,7 +1027,12 @@ int main( int ArgC, char *ArgV[] )
 
 	strcpy( PathIn, ArgV[FirstArg] );
 
-	if(( f = fopen( PathIn, "rb" )) == NULL )
+	if( strcmp( PathIn, "-" ) == 0 )
+		{
+		f	= stdin;
+		SetBinaryMode( f );
+		}
+	else if(( f = fopen( PathIn, "rb" )) == NULL )
 		{
 		char	ExtIn[256];
 
@@ -295,10 +1047,50 @@ int main( int ArgC, char *ArgV[] )
 			}
 		}
 
-	Result	= Process( f, PathIn, ArgC - FirstArg == 2 ? ArgV[FirstArg+1] : NULL, OutputFormat );
+	if(( Context = CreateContext( Options, Shared )) == NULL )
+		Result	= -1;
+	else
+		{
+		/* Read from a pipe, the output goes to one too, unless it is named. */
+		Result	= Process( Context, f, PathIn, ArgC - FirstArg == 2 ? ArgV[FirstArg+1] : f == stdin ? "-" : NULL, OutputFormat );
+		if( Result == 0 && ( Options & OPTION_STATS ))
+			PrintStats( Context, ( Options & OPTION_STATS_JSON ) != 0 );
+		if( Result == 0 && ( Options & OPTION_HEAPPROFILE ))
+			PrintHeapProfile( Context );
+		/* Even a failed conversion has its timeline, up to where it stopped. */
+		if(( Options & OPTION_TRACE ) && SaveTrace( Context, PathTrace ) != 0 && Result == 0 )
+			Result	= -1;
+		ReleaseContext( Context, Shared );
+		}
 
-	fclose( f );
+	if( f != stdin )
+		fclose( f );
 
 	return Result;
 	}
 /*============================================================================*/
+/*============================================================================*/
+int main( int ArgC, char *ArgV[] )
+	{
+#if			defined __linux__
+	int	Result, i;
+
+	if( ArgC >= 2 && stricmp( ArgV[1], "--daemon" ) == 0 )
+		return RunDaemon( ArgV[0], Run );
+
+	if( ArgC >= 2 && stricmp( ArgV[1], "--local" ) == 0 )
+		{
+		ArgV[1]	= ArgV[0];
+		return Run( ArgC - 1, &ArgV[1], NULL );
+		}
+
+	/* The watch mode never ends, it would hold one of the workers of the daemon for good. */
+	for( i = 1; i < ArgC && stricmp( ArgV[i], "--watch" ) != 0; i++ )
+		;
+	if( i == ArgC && ForwardToDaemon( ArgC, ArgV, &Result ) == 0 )
+		return Result;
+#endif	/*	defined __linux__ */
+
+	return Run( ArgC, ArgV, NULL );
+	}
+/*============================================================================*/